@@ -23,11 +23,43 @@ The following options are available for the ``read`` subcommand:
 
     The mode in which to open the file. Valid modes are identical to those
     accepted by :func:`gsd.fl.open`.
+
+The ``copy`` subcommand copies frames to a new file with :func:`gsd.fl.copy`::
+
+    $ gsd copy trajectory.gsd subset.gsd --frames ::10 --names particles/
+
+.. program:: copy
+
+.. option:: -f frames, --frames frames
+
+    The frames to copy as a Python slice ``start:stop:step``. Copies all
+    frames by default.
+
+.. option:: -n names, --names names
+
+    Copy only the chunks with names that start with one of the given strings.
+
+.. option:: -c codec, --compression codec
+
+    The codec to compress the copied chunks with. Chunks are stored
+    uncompressed by default.
+
+The ``upgrade`` subcommand upgrades files in place to the current file layer
+version::
+
+    $ gsd upgrade -j 8 archive/*.gsd
+
+.. program:: upgrade
+
+.. option:: -j jobs, --jobs jobs
+
+    The number of files to upgrade at the same time.
 """
 
 import sys
 import argparse
 import code
+import concurrent.futures
 
 from .version import __version__
 from .hoomd import open as hoomd_open
@@ -86,6 +118,49 @@ def main_read(args):
                                              extras=extras + "\n"))
 
 
+def _parse_slice(text):
+    """Parse a slice given as ``start:stop:step``."""
+    parts = text.split(':')
+    if len(parts) > 3:
+        raise argparse.ArgumentTypeError("invalid slice: " + text)
+    try:
+        values = [int(part) if part else None for part in parts]
+    except ValueError:
+        raise argparse.ArgumentTypeError("invalid slice: " + text)
+    if len(values) == 1:
+        return slice(values[0], values[0] + 1 if values[0] != -1 else None)
+    return slice(*values)
+
+
+def main_copy(args):
+    """Main function to copy frames to a new GSD file."""
+    n_frames = fl.copy(args.source,
+                       args.destination,
+                       frames=args.frames,
+                       names=args.names,
+                       compression=args.compression)
+    print("Copied {} frames to {}".format(n_frames, args.destination))
+
+
+def _upgrade(name):
+    with fl.open(name, 'rb+') as f:
+        f.upgrade()
+
+
+def main_upgrade(args):
+    """Main function to upgrade GSD files in place."""
+    if args.jobs < 1:
+        raise ValueError("The number of jobs must be positive.")
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        for name, future in [(name, pool.submit(_upgrade, name))
+                             for name in args.files]:
+            try:
+                future.result()
+            except Exception as error:
+                raise RuntimeError("{}: {}".format(name, error)) from error
+
+
 def main():
     """Entry point to the GSD command-line interface.
 
@@ -94,6 +169,8 @@ def main():
     command line. At present the following commands are supported:
 
         * read
+        * copy
+        * upgrade
     """
     parser = argparse.ArgumentParser(
         description="The gsd package encodes canonical readers and writers "
@@ -126,6 +203,43 @@ def main():
         help="The file mode.")
     parser_read.set_defaults(func=main_read)
 
+    parser_copy = subparsers.add_parser('copy')
+    parser_copy.add_argument('source', type=str, help="GSD file to copy.")
+    parser_copy.add_argument('destination',
+                             type=str,
+                             help="GSD file to create.")
+    parser_copy.add_argument('-f',
+                             '--frames',
+                             type=_parse_slice,
+                             default=None,
+                             help="The frames to copy (start:stop:step).")
+    parser_copy.add_argument(
+        '-n',
+        '--names',
+        type=str,
+        nargs='+',
+        default=None,
+        help="Copy chunks with names that start with these strings.")
+    parser_copy.add_argument('-c',
+                             '--compression',
+                             type=str,
+                             default=None,
+                             choices=list(fl.codecs),
+                             help="The codec to compress chunks with.")
+    parser_copy.set_defaults(func=main_copy)
+
+    parser_upgrade = subparsers.add_parser('upgrade')
+    parser_upgrade.add_argument('files',
+                                type=str,
+                                nargs='+',
+                                help="GSD files to upgrade.")
+    parser_upgrade.add_argument('-j',
+                                '--jobs',
+                                type=int,
+                                default=1,
+                                help="The number of files to upgrade at once.")
+    parser_upgrade.set_defaults(func=main_upgrade)
+
     # This is a hack, as argparse itself does not
     # allow to parse only --version without any
     # of the other required arguments.
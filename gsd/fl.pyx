@@ -10,9 +10,12 @@ See :ref:`fl-examples` for detailed example code.
 
 * :py:class:`GSDFile` - Class interface to read and write gsd files.
 * :py:func:`open` - Open a gsd file.
+* :py:func:`copy` - Copy frames to a new gsd file.
 
 """
 
+import collections
+import concurrent.futures
 import logging
 import numpy
 import os
@@ -20,11 +23,27 @@ from pickle import PickleError
 from libc.stdint cimport uint8_t, int8_t, uint16_t, int16_t, uint32_t, int32_t,\
     uint64_t, int64_t
 from libc.errno cimport errno
+from libc.stdlib cimport malloc, free
+from cpython.buffer cimport PyBuffer_FillInfo
+cimport cython
 cimport gsd.libgsd as libgsd
 cimport numpy
 
 logger = logging.getLogger('gsd.fl')
 
+_codec_flags = {'zstd': libgsd.GSD_FLAG_CODEC_ZSTD,
+                'deflate': libgsd.GSD_FLAG_CODEC_DEFLATE}
+
+_sync_policies = {'always': libgsd.GSD_SYNC_ALWAYS,
+                  'close': libgsd.GSD_SYNC_ON_CLOSE,
+                  'frames': libgsd.GSD_SYNC_EVERY_N_FRAMES,
+                  'seconds': libgsd.GSD_SYNC_EVERY_N_SECONDS}
+
+codecs = tuple(name for name, flag in _codec_flags.items()
+               if libgsd.gsd_is_encoding_available(flag))
+"""tuple[str]: Compression codecs available to \
+:py:meth:`GSDFile.write_chunk()` in this build."""
+
 ####################
 # Helper functions #
 
@@ -55,6 +74,8 @@ cdef __raise_on_error(retval, extra):
         raise RuntimeError("File must be writable: " + extra)
     elif retval == libgsd.GSD_ERROR_FILE_MUST_BE_READABLE:
         raise RuntimeError("File must be readable: " + extra)
+    elif retval == libgsd.GSD_ERROR_UNSUPPORTED_ENCODING:
+        raise RuntimeError("Unsupported chunk encoding: " + extra)
     elif retval == libgsd.GSD_ERROR_INVALID_ARGUMENT:
         raise RuntimeError("Invalid gsd argument: " + extra)
     elif retval != 0:
@@ -145,9 +166,117 @@ cdef void * __get_ptr_float64(data):
     else:
         return <void*>&data_array_float64[0, 0]
 
+cdef __get_dtype(libgsd.gsd_type gsd_type):
+    """Return the numpy dtype for a gsd type, or None when it is invalid."""
+    if gsd_type == libgsd.GSD_TYPE_UINT8:
+        return numpy.uint8
+    elif gsd_type == libgsd.GSD_TYPE_UINT16:
+        return numpy.uint16
+    elif gsd_type == libgsd.GSD_TYPE_UINT32:
+        return numpy.uint32
+    elif gsd_type == libgsd.GSD_TYPE_UINT64:
+        return numpy.uint64
+    elif gsd_type == libgsd.GSD_TYPE_INT8:
+        return numpy.int8
+    elif gsd_type == libgsd.GSD_TYPE_INT16:
+        return numpy.int16
+    elif gsd_type == libgsd.GSD_TYPE_INT32:
+        return numpy.int32
+    elif gsd_type == libgsd.GSD_TYPE_INT64:
+        return numpy.int64
+    elif gsd_type == libgsd.GSD_TYPE_FLOAT:
+        return numpy.float32
+    elif gsd_type == libgsd.GSD_TYPE_DOUBLE:
+        return numpy.float64
+    else:
+        return None
+
+cdef int __get_type(dtype):
+    """Return the gsd type for a numpy dtype, or 0 when it has none."""
+    if dtype == numpy.uint8:
+        return libgsd.GSD_TYPE_UINT8
+    elif dtype == numpy.uint16:
+        return libgsd.GSD_TYPE_UINT16
+    elif dtype == numpy.uint32:
+        return libgsd.GSD_TYPE_UINT32
+    elif dtype == numpy.uint64:
+        return libgsd.GSD_TYPE_UINT64
+    elif dtype == numpy.int8:
+        return libgsd.GSD_TYPE_INT8
+    elif dtype == numpy.int16:
+        return libgsd.GSD_TYPE_INT16
+    elif dtype == numpy.int32:
+        return libgsd.GSD_TYPE_INT32
+    elif dtype == numpy.int64:
+        return libgsd.GSD_TYPE_INT64
+    elif dtype == numpy.float32:
+        return libgsd.GSD_TYPE_FLOAT
+    elif dtype == numpy.float64:
+        return libgsd.GSD_TYPE_DOUBLE
+    else:
+        return 0
+
+cdef void * __get_ptr(libgsd.gsd_type gsd_type, data):
+    """Dispatch to the getter method for the given gsd type."""
+    if gsd_type == libgsd.GSD_TYPE_UINT8:
+        return __get_ptr_uint8(data)
+    elif gsd_type == libgsd.GSD_TYPE_UINT16:
+        return __get_ptr_uint16(data)
+    elif gsd_type == libgsd.GSD_TYPE_UINT32:
+        return __get_ptr_uint32(data)
+    elif gsd_type == libgsd.GSD_TYPE_UINT64:
+        return __get_ptr_uint64(data)
+    elif gsd_type == libgsd.GSD_TYPE_INT8:
+        return __get_ptr_int8(data)
+    elif gsd_type == libgsd.GSD_TYPE_INT16:
+        return __get_ptr_int16(data)
+    elif gsd_type == libgsd.GSD_TYPE_INT32:
+        return __get_ptr_int32(data)
+    elif gsd_type == libgsd.GSD_TYPE_INT64:
+        return __get_ptr_int64(data)
+    elif gsd_type == libgsd.GSD_TYPE_FLOAT:
+        return __get_ptr_float32(data)
+    elif gsd_type == libgsd.GSD_TYPE_DOUBLE:
+        return __get_ptr_float64(data)
+    else:
+        return NULL
+
+
+@cython.no_gc_clear
+cdef class _MappedChunk:
+    """Own chunk data provided by gsd_map_chunk.
+
+    Expose the data to numpy with the buffer protocol and release it when the
+    last array that views it is garbage collected. The garbage collector must
+    not clear ``file`` first, which owns the handle that releases the data.
+    """
+
+    cdef object file
+    cdef libgsd.gsd_handle* handle
+    cdef libgsd.gsd_index_entry entry
+    cdef const void* data
+    cdef Py_ssize_t size
+
+    def __getbuffer__(self, Py_buffer *buffer, int flags):
+        PyBuffer_FillInfo(buffer, self, <void*>self.data, self.size, 1, flags)
+
+    def __releasebuffer__(self, Py_buffer *buffer):
+        pass
+
+    def __dealloc__(self):
+        if self.data != NULL:
+            libgsd.gsd_unmap_chunk(self.handle, self.data, &self.entry)
+            self.data = NULL
+
 
-def open(name, mode, application=None, schema=None, schema_version=None):
-    """open(name, mode, application=None, schema=None, schema_version=None)
+def open(name,
+         mode,
+         application=None,
+         schema=None,
+         schema_version=None,
+         write_behind=False):
+    """open(name, mode, application=None, schema=None, schema_version=None, \
+write_behind=False)
 
     :py:func:`open` opens a GSD file and returns a :py:class:`GSDFile` instance.
     The return value of :py:func:`open` can be used as a context manager.
@@ -164,6 +293,9 @@ def open(name, mode, application=None, schema=None, schema_version=None):
         schema_version (`typing.Tuple` [int, int]): Schema version number
             (major, minor).
 
+        write_behind (bool): Set to ``True`` to write data on a background
+            thread (see :py:meth:`GSDFile.flush()`).
+
     Valid values for mode:
 
     +------------------+---------------------------------------------+
@@ -233,7 +365,133 @@ def open(name, mode, application=None, schema=None, schema_version=None):
             f.close()
     """
 
-    return GSDFile(str(name), mode, application, schema, schema_version)
+    return GSDFile(str(name),
+                   mode,
+                   application,
+                   schema,
+                   schema_version,
+                   write_behind)
+
+
+# Number of frames that copy() reads ahead of the frame it writes
+_COPY_READ_AHEAD = 4
+
+
+def copy(source, destination, frames=None, names=None, compression=None):
+    """copy(source, destination, frames=None, names=None, compression=None)
+
+    Copy frames from one GSD file to a new GSD file.
+
+    Args:
+        source (str): Name of the file to copy from.
+
+        destination (str): Name of the file to create. An existing file is
+            overwritten.
+
+        frames: Indices of the frames to copy, in the order to write them, or
+            a `slice` of the source frames. Set to ``None`` to copy all
+            frames.
+
+        names (list[str]): Copy only the chunks with names that start with
+            one of these strings. Set to ``None`` to copy all chunks.
+
+        compression (str): Codec to compress the copied chunks with (see
+            :py:meth:`GSDFile.write_chunk()`). Set to ``None`` to store the
+            chunks uncompressed.
+
+    Returns:
+        int: Number of frames in the destination file.
+
+    :py:func:`copy` reads frames on a background thread while it writes
+    earlier frames, and the destination file writes its data on another
+    thread (see :py:meth:`GSDFile.flush()`). The destination has the
+    application, schema, and schema version of the source and is a current
+    version file. Chunks are decoded when read and stored with *compression*.
+
+    Note:
+        Frames in which no chunk is copied are not stored in the
+        destination, so the following frames move up to take their place.
+
+    Example:
+        .. ipython:: python
+
+            with gsd.fl.open(name='file.gsd', mode='wb',
+                             application="My application", schema="My Schema",
+                             schema_version=[1,0]) as f:
+                for i in range(10):
+                    f.write_chunk(name='chunk1',
+                                  data=numpy.array([i], dtype=numpy.int64))
+                    f.write_chunk(name='chunk2',
+                                  data=numpy.array([i], dtype=numpy.int64))
+                    f.end_frame()
+
+            gsd.fl.copy(source='file.gsd', destination='copy.gsd',
+                        frames=range(0, 10, 2), names=['chunk1'])
+
+            with gsd.fl.open(name='copy.gsd', mode='rb') as f:
+                f.nframes
+                f.read_chunk(frame=4, name='chunk1')
+                f.chunk_exists(frame=4, name='chunk2')
+    """
+
+    if compression is not None and compression not in codecs:
+        raise ValueError("Codec " + str(compression) + " is not available")
+
+    with open(name=source, mode='rb') as src:
+        if frames is None:
+            frames = range(src.nframes)
+        elif isinstance(frames, slice):
+            frames = range(*frames.indices(src.nframes))
+        frames = list(frames)
+        for frame in frames:
+            if frame < 0 or frame >= src.nframes:
+                raise IndexError("Frame " + str(frame) + " is not in "
+                                 + str(source))
+
+        if names is None:
+            names = ['']
+        chunk_names = sorted(
+            set(chunk_name for match in names
+                for chunk_name in src.find_matching_chunk_names(match)))
+
+        def read(frame):
+            present = [
+                chunk_name for chunk_name in chunk_names
+                if src.chunk_exists(frame=frame, name=chunk_name)
+            ]
+            return present, src.read_chunks(frame=frame, names=present)
+
+        logger.info('copying file: ' + str(source) + ' to '
+                    + str(destination))
+
+        with open(name=destination,
+                  mode='wb',
+                  application=src.application,
+                  schema=src.schema,
+                  schema_version=src.schema_version,
+                  write_behind=True) as dst, \
+                concurrent.futures.ThreadPoolExecutor(max_workers=1) as reader:
+            frame_iter = iter(frames)
+            pending = collections.deque(
+                reader.submit(read, frame)
+                for _, frame in zip(range(_COPY_READ_AHEAD), frame_iter))
+
+            while len(pending) > 0:
+                present, data = pending.popleft().result()
+                frame = next(frame_iter, None)
+                if frame is not None:
+                    pending.append(reader.submit(read, frame))
+
+                if len(present) == 0:
+                    continue
+
+                for chunk_name, chunk_data in zip(present, data):
+                    dst.write_chunk(name=chunk_name,
+                                    data=chunk_data,
+                                    compression=compression)
+                dst.end_frame()
+
+            return dst.nframes
 
 
 cdef class GSDFile:
@@ -245,6 +503,12 @@ cdef class GSDFile:
     layer. Use :py:func:`open` to open a GSD file and obtain a GSDFile instance.
     :py:class:`GSDFile` can be used as a context manager.
 
+    Several threads may call :py:meth:`read_chunk`, :py:meth:`read_chunks`,
+    :py:meth:`read_chunk_series`, :py:meth:`chunk_exists`, and
+    :py:meth:`prefetch_frames` concurrently on a file opened in ``'rb'`` mode.
+    These methods release the GIL while they read. The caller must serialize
+    all calls on files opened in other modes.
+
     Attributes:
 
         name (str): Name of the open file.
@@ -268,13 +532,16 @@ cdef class GSDFile:
     cdef bint __is_open
     cdef str mode
     cdef str name
+    cdef dict __name_ids
+    cdef int __n_readers
 
     def __init__(self,
                  name,
                  mode,
                  application,
                  schema,
-                 schema_version):
+                 schema_version,
+                 write_behind=False):
         cdef libgsd.gsd_open_flag c_flags
         cdef int exclusive_create = 0
         cdef int overwrite = 0
@@ -303,8 +570,12 @@ cdef class GSDFile:
             raise ValueError("mode must be 'wb', 'wb+', 'rb', 'rb+', "
                              "'xb', 'xb+', or 'ab'")
 
+        if write_behind and c_flags == libgsd.GSD_OPEN_READONLY:
+            raise ValueError("write_behind requires a writable mode")
+
         self.name = name
         self.mode = mode
+        self.__name_ids = {}
 
         cdef char * c_name
         cdef char * c_application
@@ -356,6 +627,14 @@ cdef class GSDFile:
 
         __raise_on_error(retval, name)
 
+        if write_behind:
+            with nogil:
+                retval = libgsd.gsd_set_write_behind(&self.__handle, 1)
+
+            if retval != 0:
+                libgsd.gsd_close(&self.__handle)
+            __raise_on_error(retval, name)
+
         # validate schema
         if schema is not None:
             schema_truncated = schema
@@ -395,10 +674,15 @@ cdef class GSDFile:
 
         """
         if self.__is_open:
+            if self.__n_readers > 0:
+                raise RuntimeError("Cannot close a file while other threads "
+                                   "read from it: " + self.name)
+
             logger.info('closing file: ' + self.name)
             with nogil:
                 retval = libgsd.gsd_close(&self.__handle)
             self.__is_open = False
+            self.__name_ids.clear()
 
             __raise_on_error(retval, self.name)
 
@@ -438,9 +722,84 @@ cdef class GSDFile:
         logger.info('truncating file: ' + self.name)
         with nogil:
             retval = libgsd.gsd_truncate(&self.__handle)
+        self.__name_ids.clear()
 
         __raise_on_error(retval, self.name)
 
+    def refresh(self):
+        """refresh()
+
+        Load the frames that another process added to the file since it was
+        opened or last refreshed.
+
+        Use :py:meth:`refresh()` to follow a file that a running simulation
+        writes. The cost is proportional to the number of new frames. The last
+        frame may be partially written while the file is refreshed, in which
+        case the next call loads the rest of it. Only files opened in ``'rb'``
+        mode can be refreshed.
+
+        Example:
+            .. ipython:: python
+
+                writer = gsd.fl.open(name='file.gsd', mode='wb',
+                                     application="My application",
+                                     schema="My Schema", schema_version=[1,0])
+                reader = gsd.fl.open(name='file.gsd', mode='rb')
+                writer.write_chunk(name='chunk1',
+                                   data=numpy.array([1,2,3,4],
+                                                    dtype=numpy.float32))
+                writer.end_frame()
+                reader.nframes
+                reader.refresh()
+                reader.nframes
+                writer.close()
+                reader.close()
+        """
+
+        if not self.__is_open:
+            raise ValueError("File is not open")
+
+        if self.mode != 'rb':
+            raise RuntimeError("File must be opened in 'rb' mode to refresh: "
+                               + self.name)
+
+        if self.__n_readers > 0:
+            raise RuntimeError("Cannot refresh a file while other threads "
+                               "read from it: " + self.name)
+
+        with nogil:
+            retval = libgsd.gsd_refresh(&self.__handle)
+        self.__name_ids.clear()
+
+        __raise_on_error(retval, self.name)
+
+    cdef uint32_t __get_name_id(self, name, bint append) except? 0xffffffff:
+        """Get the id of a chunk name, caching the id in the file object.
+
+        Returns ``UINT32_MAX`` when the file does not contain *name* and
+        *append* is ``False`` or the file is read-only.
+        """
+        cdef uint32_t c_id
+        cdef char * c_name
+
+        c_id = self.__name_ids.get(name, 0xffffffff)
+        if c_id != 0xffffffff:
+            return c_id
+
+        name_e = name.encode('utf-8')
+        c_name = name_e
+        with nogil:
+            retval = libgsd.gsd_get_name_id(&self.__handle,
+                                            c_name,
+                                            &c_id,
+                                            append)
+
+        __raise_on_error(retval, self.name)
+
+        if c_id != 0xffffffff:
+            self.__name_ids[name] = c_id
+        return c_id
+
     def end_frame(self):
         """end_frame()
 
@@ -487,8 +846,132 @@ cdef class GSDFile:
 
         __raise_on_error(retval, self.name)
 
-    def write_chunk(self, name, data):
-        """write_chunk(name, data)
+    def flush(self):
+        """flush()
+
+        Wait for all writes queued on the background thread to complete.
+
+        When the file is opened with ``write_behind=True``,
+        :py:meth:`write_chunk()` and :py:meth:`end_frame()` queue data to be
+        written by a background thread and return without waiting for the
+        write to complete. Errors in these writes are raised by the next call
+        to :py:meth:`write_chunk()`, :py:meth:`end_frame()`,
+        :py:meth:`flush()`, or :py:meth:`close()`. :py:meth:`flush()` returns
+        immediately when ``write_behind`` is ``False``.
+
+        Example:
+            .. ipython:: python
+
+                f = gsd.fl.open(name='file.gsd', mode='wb',
+                                application="My application",
+                                schema="My Schema", schema_version=[1,0],
+                                write_behind=True)
+
+                f.write_chunk(name='chunk1',
+                              data=numpy.array([1,2,3,4], dtype=numpy.float32))
+                f.end_frame()
+                f.flush()
+                f.close()
+
+        """
+
+        if not self.__is_open:
+            raise ValueError("File is not open")
+
+        logger.debug('flush: ' + self.name)
+
+        with nogil:
+            retval = libgsd.gsd_flush(&self.__handle)
+
+        __raise_on_error(retval, self.name)
+
+    def set_sync_policy(self, policy, interval=0):
+        """set_sync_policy(policy, interval=0)
+
+        Set when the file is synced to the storage device.
+
+        Args:
+            policy (str): ``'always'``, ``'close'``, ``'frames'``, or
+              ``'seconds'``.
+            interval (int): Number of frames (``'frames'``) or seconds
+              (``'seconds'``) between syncs.
+
+        ``'always'`` (the default) syncs each time the file is about to refer
+        to a new or moved name list, index, or header, so that the file is
+        consistent after a crash. The other policies skip these syncs, which
+        are slow on parallel file systems, and sync only at the end of a frame
+        once *interval* frames or seconds have passed since the last sync and
+        in :py:meth:`close()`. After a crash, all frames completed before the
+        last sync are on disk. Later frames may be lost and the file may not
+        open when the name list or index moved after the last sync.
+        """
+
+        if not self.__is_open:
+            raise ValueError("File is not open")
+
+        if policy not in _sync_policies:
+            raise ValueError("Unknown sync policy " + str(policy))
+
+        if policy in ('frames', 'seconds') and interval < 1:
+            raise ValueError("interval must be positive")
+
+        cdef libgsd.gsd_sync_policy c_policy = _sync_policies[policy]
+        cdef uint64_t c_interval = interval
+        with nogil:
+            retval = libgsd.gsd_set_sync_policy(&self.__handle,
+                                                c_policy,
+                                                c_interval)
+
+        __raise_on_error(retval, self.name)
+
+    def write_frame_table(self):
+        """write_frame_table()
+
+        Write a table that locates the chunks of each frame.
+
+        The frame table records where the index entries of each committed frame
+        start. Opening a file with a frame table takes the number of index
+        entries from the table and chunk lookups find the entries of a frame
+        without searching the index. Once a file has a frame table,
+        :py:meth:`close()` updates it when frames were added.
+
+        Example:
+            .. ipython:: python
+
+                f = gsd.fl.open(name='file.gsd', mode='wb',
+                                application="My application",
+                                schema="My Schema", schema_version=[1,0])
+
+                for i in range(10):
+                    f.write_chunk(name='chunk1',
+                                  data=numpy.array([i], dtype=numpy.int64))
+                    f.end_frame()
+                f.write_frame_table()
+                f.close()
+
+                f = gsd.fl.open(name='file.gsd', mode='rb')
+                f.has_frame_table
+                f.close()
+        """
+
+        if not self.__is_open:
+            raise ValueError("File is not open")
+
+        logger.debug('write frame table: ' + self.name)
+
+        with nogil:
+            retval = libgsd.gsd_write_frame_table(&self.__handle)
+
+        __raise_on_error(retval, self.name)
+
+    def write_chunk(self,
+                    name,
+                    data,
+                    compression=None,
+                    precision=None,
+                    delta=False):
+        """write_chunk(name, data, compression=None, precision=None, \
+                       delta=False)
 
         Write a data chunk to the file. After writing all chunks in the
         current frame, call :py:meth:`end_frame()`.
@@ -498,6 +981,32 @@ cdef class GSDFile:
             data: Data to write into the chunk. Must be a numpy
                   array, or array-like, with 2 or fewer
                   dimensions.
+            compression (str): Codec to compress the chunk with: ``None``,
+                  ``'zstd'``, or ``'deflate'``. Multi-byte types are byte
+                  shuffled before compression. See :py:data:`codecs` for
+                  the codecs available in this build.
+            precision (float): Maximum absolute error of the stored values.
+                  When set, *data* must be a ``float32`` array and is stored
+                  as bit packed multiples of ``2 * precision`` (lossy).
+            delta (bool): Set to ``True`` to store the chunk as the
+                  difference from its most recent keyframe. Requires
+                  *compression*. See :py:attr:`keyframe_interval`.
+
+        Note:
+            The chunk is stored uncompressed when compression does not reduce
+            its size. Readers of compressed chunks must also be built with
+            the codec.
+
+        Note:
+            Quantized values read back differ from *data* by at most
+            *precision* plus the rounding error of the conversion to
+            ``float32``.
+
+        Note:
+            With ``delta=True``, the first chunk of each name, chunks that
+            change shape or type, and chunks :py:attr:`keyframe_interval`
+            frames after the previous keyframe are stored in full as
+            keyframes. Reading any other chunk also reads its keyframe.
 
         Warning:
             :py:meth:`write_chunk()` will implicitly converts array-like and
@@ -532,6 +1041,23 @@ cdef class GSDFile:
         if not self.__is_open:
             raise ValueError("File is not open")
 
+        cdef uint8_t flags = 0
+        if compression is not None:
+            if compression not in _codec_flags:
+                raise ValueError("Unknown compression codec: "
+                                 + str(compression))
+            flags = _codec_flags[compression]
+            if not libgsd.gsd_is_encoding_available(flags):
+                raise ValueError("Compression codec not available: "
+                                 + compression)
+
+        if delta:
+            if compression is None:
+                raise ValueError("delta requires compression: " + name)
+            if precision is not None:
+                raise ValueError("delta cannot be used with precision: "
+                                 + name)
+
         data_array = numpy.ascontiguousarray(data)
         if data_array is not data:
             logger.warning('implicit data copy when writing chunk: ' + name)
@@ -585,19 +1111,44 @@ cdef class GSDFile:
         else:
             raise ValueError("invalid type for chunk: " + name)
 
+        cdef double c_precision = 0
+        if precision is not None:
+            if gsd_type != libgsd.GSD_TYPE_FLOAT:
+                raise ValueError("precision requires float32 data: " + name)
+            c_precision = precision
+            if not c_precision > 0:
+                raise ValueError("precision must be positive: " + name)
+        elif flags != 0 and data_array.dtype.itemsize > 1:
+            flags |= libgsd.GSD_FLAG_SHUFFLE
+
+        if delta:
+            flags |= libgsd.GSD_FLAG_DELTA
+
         logger.debug('write chunk: ' + self.name + ' - ' + name)
 
         cdef char * c_name
-        name_e = name.encode('utf-8')
-        c_name = name_e
-        with nogil:
-            retval = libgsd.gsd_write_chunk(&self.__handle,
-                                            c_name,
-                                            gsd_type,
-                                            N,
-                                            M,
-                                            0,
-                                            data_ptr)
+        cdef uint32_t c_id
+        if precision is not None:
+            name_e = name.encode('utf-8')
+            c_name = name_e
+            with nogil:
+                retval = libgsd.gsd_write_quantized_chunk(&self.__handle,
+                                                          c_name,
+                                                          N,
+                                                          M,
+                                                          flags,
+                                                          c_precision,
+                                                          <float *>data_ptr)
+        else:
+            c_id = self.__get_name_id(name, True)
+            with nogil:
+                retval = libgsd.gsd_write_chunk_by_id(&self.__handle,
+                                                      c_id,
+                                                      gsd_type,
+                                                      N,
+                                                      M,
+                                                      flags,
+                                                      data_ptr)
 
         __raise_on_error(retval, self.name)
 
@@ -646,33 +1197,45 @@ cdef class GSDFile:
         """
 
         cdef const libgsd.gsd_index_entry* index_entry
-        cdef char * c_name
-        name_e = name.encode('utf-8')
-        c_name = name_e
+        cdef uint32_t c_id
         cdef int64_t c_frame
         c_frame = frame
 
         logger.debug('chunk exists: ' + self.name + ' - ' + name)
 
-        with nogil:
-            index_entry = libgsd.gsd_find_chunk(&self.__handle, c_frame, c_name)
+        self.__n_readers += 1
+        try:
+            c_id = self.__get_name_id(name, False)
+            with nogil:
+                index_entry = libgsd.gsd_find_chunk_by_id(&self.__handle,
+                                                          c_frame,
+                                                          c_id)
+        finally:
+            self.__n_readers -= 1
 
         return index_entry != NULL
 
-    def read_chunk(self, frame, name):
-        """read_chunk(frame, name)
+    def read_chunk(self, frame, name, copy=True, dtype=None):
+        """read_chunk(frame, name, copy=True, dtype=None)
 
         Read a data chunk from the file and return it as a numpy array.
 
         Args:
             frame (int): Index of the frame to read
             name (str): Name of the chunk
+            copy (bool): Set to ``False`` to return a read-only view of the
+                file contents instead of a copy.
+            dtype (numpy.dtype): Type of the returned array. Set to convert
+                the values as they are read, without a second pass over the
+                array. Floating point chunks convert only to floating point
+                types. Integer chunks convert to floating point types and to
+                integer types that hold every value of the chunk type.
 
         Returns:
             ``numpy.ndarray[type, ndim=?, mode='c']``: Data read from file.
-            ``type`` is determined by the chunk metadata. If the data is
-            NxM in the file and M > 1, return a 2D array. If the data is
-            Nx1, return a 1D array.
+            ``type`` is *dtype*, or determined by the chunk metadata when
+            *dtype* is ``None``. If the data is NxM in the file and M > 1,
+            return a 2D array. If the data is Nx1, return a 1D array.
 
         .. tip::
             Each call invokes a disk read and allocation of a
@@ -680,6 +1243,15 @@ cdef class GSDFile:
             :py:meth:`read_chunk()` on the same chunk repeatedly. Cache the
             arrays instead.
 
+        .. tip::
+            With ``copy=False``, the array views a memory mapping of the file
+            (on systems that support it) and pages are read from disk only as
+            they are accessed. The view remains valid after the file is closed.
+
+        .. tip::
+            :py:meth:`read_chunk()` releases the GIL while it reads. Threads
+            may read from one file opened in ``'rb'`` mode concurrently.
+
         Example:
             .. ipython:: python
 
@@ -715,95 +1287,382 @@ cdef class GSDFile:
             raise ValueError("File is not open")
 
         cdef const libgsd.gsd_index_entry* index_entry
-        cdef char * c_name
-        name_e = name.encode('utf-8')
-        c_name = name_e
+        cdef uint32_t c_id
         cdef int64_t c_frame
         c_frame = frame
+        cdef libgsd.gsd_type gsd_type
+        cdef libgsd.gsd_type out_type
+        cdef void *data_ptr
+        cdef const void *mapped_ptr
+        cdef _MappedChunk mapped_chunk
 
-        with nogil:
-            index_entry = libgsd.gsd_find_chunk(&self.__handle, c_frame, c_name)
+        # close() must not free the index while this thread reads from it
+        self.__n_readers += 1
+        try:
+            c_id = self.__get_name_id(name, False)
+            with nogil:
+                index_entry = libgsd.gsd_find_chunk_by_id(&self.__handle,
+                                                          c_frame,
+                                                          c_id)
 
-        if index_entry == NULL:
-            raise KeyError("frame " + str(frame) + " / chunk " + name
-                           + " not found in: " + self.name)
+            if index_entry == NULL:
+                raise KeyError("frame " + str(frame) + " / chunk " + name
+                               + " not found in: " + self.name)
 
-        cdef libgsd.gsd_type gsd_type
-        gsd_type = <libgsd.gsd_type>index_entry.type
+            gsd_type = <libgsd.gsd_type>index_entry.type
 
-        cdef void *data_ptr
-        if gsd_type == libgsd.GSD_TYPE_UINT8:
-            data_array = numpy.empty(dtype=numpy.uint8,
-                                     shape=[index_entry.N, index_entry.M])
-        elif gsd_type == libgsd.GSD_TYPE_UINT16:
-            data_array = numpy.empty(dtype=numpy.uint16,
-                                     shape=[index_entry.N, index_entry.M])
-        elif gsd_type == libgsd.GSD_TYPE_UINT32:
-            data_array = numpy.empty(dtype=numpy.uint32,
-                                     shape=[index_entry.N, index_entry.M])
-        elif gsd_type == libgsd.GSD_TYPE_UINT64:
-            data_array = numpy.empty(dtype=numpy.uint64,
-                                     shape=[index_entry.N, index_entry.M])
-        elif gsd_type == libgsd.GSD_TYPE_INT8:
-            data_array = numpy.empty(dtype=numpy.int8,
-                                     shape=[index_entry.N, index_entry.M])
-        elif gsd_type == libgsd.GSD_TYPE_INT16:
-            data_array = numpy.empty(dtype=numpy.int16,
-                                     shape=[index_entry.N, index_entry.M])
-        elif gsd_type == libgsd.GSD_TYPE_INT32:
-            data_array = numpy.empty(dtype=numpy.int32,
-                                     shape=[index_entry.N, index_entry.M])
-        elif gsd_type == libgsd.GSD_TYPE_INT64:
-            data_array = numpy.empty(dtype=numpy.int64,
-                                     shape=[index_entry.N, index_entry.M])
-        elif gsd_type == libgsd.GSD_TYPE_FLOAT:
-            data_array = numpy.empty(dtype=numpy.float32,
-                                     shape=[index_entry.N, index_entry.M])
-        elif gsd_type == libgsd.GSD_TYPE_DOUBLE:
-            data_array = numpy.empty(dtype=numpy.float64,
-                                     shape=[index_entry.N, index_entry.M])
-        else:
-            raise ValueError("invalid type for chunk: " + name)
+            chunk_dtype = __get_dtype(gsd_type)
+            if chunk_dtype is None:
+                raise ValueError("invalid type for chunk: " + name)
 
-        logger.debug('read chunk: ' + self.name + ' - '
-                     + str(frame) + ' - ' + name)
-
-        # only read chunk if we have data
-        if index_entry.N != 0 and index_entry.M != 0:
-            if gsd_type == libgsd.GSD_TYPE_UINT8:
-                data_ptr = __get_ptr_uint8(data_array)
-            elif gsd_type == libgsd.GSD_TYPE_UINT16:
-                data_ptr = __get_ptr_uint16(data_array)
-            elif gsd_type == libgsd.GSD_TYPE_UINT32:
-                data_ptr = __get_ptr_uint32(data_array)
-            elif gsd_type == libgsd.GSD_TYPE_UINT64:
-                data_ptr = __get_ptr_uint64(data_array)
-            elif gsd_type == libgsd.GSD_TYPE_INT8:
-                data_ptr = __get_ptr_int8(data_array)
-            elif gsd_type == libgsd.GSD_TYPE_INT16:
-                data_ptr = __get_ptr_int16(data_array)
-            elif gsd_type == libgsd.GSD_TYPE_INT32:
-                data_ptr = __get_ptr_int32(data_array)
-            elif gsd_type == libgsd.GSD_TYPE_INT64:
-                data_ptr = __get_ptr_int64(data_array)
-            elif gsd_type == libgsd.GSD_TYPE_FLOAT:
-                data_ptr = __get_ptr_float32(data_array)
-            elif gsd_type == libgsd.GSD_TYPE_DOUBLE:
-                data_ptr = __get_ptr_float64(data_array)
+            if dtype is None or numpy.dtype(dtype) == chunk_dtype:
+                dtype = chunk_dtype
+                out_type = gsd_type
             else:
-                raise ValueError("invalid type for chunk: " + name)
+                if not copy:
+                    raise ValueError("dtype requires copy=True: " + name)
+                out_type = <libgsd.gsd_type>__get_type(numpy.dtype(dtype))
+                if out_type == 0:
+                    raise ValueError("invalid dtype: " + str(dtype))
+                if (chunk_dtype.kind == 'f'
+                        and numpy.dtype(dtype).kind != 'f'):
+                    raise ValueError("floating point chunk " + name
+                                     + " cannot be read as " + str(dtype))
+                if (chunk_dtype.kind in 'iu'
+                        and numpy.dtype(dtype).kind in 'iu'
+                        and not numpy.can_cast(chunk_dtype, dtype, 'safe')):
+                    raise ValueError("integer chunk " + name
+                                     + " cannot be read as " + str(dtype)
+                                     + " without losing values")
+
+            logger.debug('read chunk: ' + self.name + ' - '
+                         + str(frame) + ' - ' + name)
+
+            if not copy and index_entry.N != 0 and index_entry.M != 0:
+                with nogil:
+                    retval = libgsd.gsd_map_chunk(&self.__handle,
+                                                  &mapped_ptr,
+                                                  index_entry)
+
+                __raise_on_error(retval, self.name)
+
+                mapped_chunk = _MappedChunk()
+                mapped_chunk.file = self
+                mapped_chunk.handle = &self.__handle
+                mapped_chunk.entry = index_entry[0]
+                mapped_chunk.data = mapped_ptr
+                mapped_chunk.size = (index_entry.N * index_entry.M
+                                     * libgsd.gsd_sizeof_type(gsd_type))
+
+                data_array = numpy.frombuffer(mapped_chunk, dtype=dtype)
+                data_array = data_array.reshape([index_entry.N, index_entry.M])
+            else:
+                data_array = numpy.empty(dtype=dtype,
+                                         shape=[index_entry.N, index_entry.M])
+
+            # only read chunk if we have data
+            if copy and index_entry.N != 0 and index_entry.M != 0:
+                data_ptr = __get_ptr(out_type, data_array)
+
+                with nogil:
+                    retval = libgsd.gsd_read_chunk_as(&self.__handle,
+                                                      data_ptr,
+                                                      index_entry,
+                                                      out_type)
+
+                __raise_on_error(retval, self.name)
+
+            if not copy:
+                data_array.flags.writeable = False
+
+            if index_entry.M == 1:
+                return data_array.reshape([index_entry.N])
+            else:
+                return data_array
+        finally:
+            self.__n_readers -= 1
+
+    def read_chunks(self, frame, names):
+        """read_chunks(frame, names)
+
+        Read several data chunks from one frame and return them as numpy arrays.
+
+        Args:
+            frame (int): Index of the frame to read
+            names (list[str]): Names of the chunks
+
+        Returns:
+            list[``numpy.ndarray``]: Data read from file, in the same order as
+            *names*. Each array has the type and shape that
+            :py:meth:`read_chunk()` would return.
+
+        .. tip::
+            Chunks that are stored next to each other in the file are read
+            with a single system call. Reading all the chunks needed from a
+            frame with one call is faster than calling :py:meth:`read_chunk()`
+            for each, especially on network file systems.
+
+        Example:
+            .. ipython:: python
+
+                with gsd.fl.open(name='file.gsd', mode='wb',
+                                 application="My application",
+                                 schema="My Schema", schema_version=[1,0]) as f:
+                    f.write_chunk(name='chunk1',
+                                  data=numpy.array([1,2,3,4],
+                                                   dtype=numpy.float32))
+                    f.write_chunk(name='chunk2',
+                                  data=numpy.array([[5,6],[7,8]],
+                                                   dtype=numpy.float32))
+                    f.end_frame()
+
+                f = gsd.fl.open(name='file.gsd', mode='rb',
+                                application="My application",
+                                schema="My Schema", schema_version=[1,0])
+                f.read_chunks(frame=0, names=['chunk1', 'chunk2'])
+                f.close()
+        """
+
+        if not self.__is_open:
+            raise ValueError("File is not open")
+
+        cdef const libgsd.gsd_index_entry* index_entry
+        cdef uint32_t c_id
+        cdef int64_t c_frame
+        c_frame = frame
+        cdef libgsd.gsd_type gsd_type
+        cdef size_t n_read = 0
+        cdef size_t n = len(names)
+        cdef const libgsd.gsd_index_entry** entries
+        cdef void** data_ptrs
+
+        if n == 0:
+            return []
+
+        entries = <const libgsd.gsd_index_entry**>malloc(
+            sizeof(libgsd.gsd_index_entry*) * n)
+        data_ptrs = <void**>malloc(sizeof(void*) * n)
+        if entries == NULL or data_ptrs == NULL:
+            free(entries)
+            free(data_ptrs)
+            raise MemoryError("Memory allocation failed: " + self.name)
+
+        result = []
+        self.__n_readers += 1
+        try:
+            for name in names:
+                c_id = self.__get_name_id(name, False)
+
+                with nogil:
+                    index_entry = libgsd.gsd_find_chunk_by_id(&self.__handle,
+                                                              c_frame,
+                                                              c_id)
+
+                if index_entry == NULL:
+                    raise KeyError("frame " + str(frame) + " / chunk " + name
+                                   + " not found in: " + self.name)
+
+                gsd_type = <libgsd.gsd_type>index_entry.type
+                dtype = __get_dtype(gsd_type)
+                if dtype is None:
+                    raise ValueError("invalid type for chunk: " + name)
+
+                data_array = numpy.empty(dtype=dtype,
+                                         shape=[index_entry.N, index_entry.M])
+
+                # only read chunks that have data
+                if index_entry.N != 0 and index_entry.M != 0:
+                    entries[n_read] = index_entry
+                    data_ptrs[n_read] = __get_ptr(gsd_type, data_array)
+                    n_read += 1
+
+                if index_entry.M == 1:
+                    result.append(data_array.reshape([index_entry.N]))
+                else:
+                    result.append(data_array)
+
+            logger.debug('read chunks: ' + self.name + ' - '
+                         + str(frame) + ' - ' + str(names))
 
             with nogil:
-                retval = libgsd.gsd_read_chunk(&self.__handle,
-                                               data_ptr,
-                                               index_entry)
+                retval = libgsd.gsd_read_chunks(&self.__handle,
+                                                n_read,
+                                                entries,
+                                                data_ptrs)
 
             __raise_on_error(retval, self.name)
+        finally:
+            self.__n_readers -= 1
+            free(entries)
+            free(data_ptrs)
 
-        if index_entry.M == 1:
-            return data_array.reshape([index_entry.N])
-        else:
-            return data_array
+        return result
+
+    def read_chunk_series(self, name, first=0, last=None, stride=1):
+        """read_chunk_series(name, first=0, last=None, stride=1)
+
+        Read one data chunk from a range of frames into a single numpy array.
+
+        Args:
+            name (str): Name of the chunk
+            first (int): Index of the first frame to read
+            last (int): Index one past the last frame to read (``None`` reads
+                to the end of the file)
+            stride (int): Read every *stride* frames
+
+        Returns:
+            ``numpy.ndarray[type, ndim=?, mode='c']``: Data read from file.
+            The first dimension indexes the frames ``range(nframes)[first:
+            last:stride]``. The remaining dimensions have the shape that
+            :py:meth:`read_chunk()` would return.
+
+        Every frame in the range must contain the chunk with the same type and
+        shape. An empty range returns an array with no frames and the type and
+        shape of the chunk in frame *first*, or in the last frame when *first*
+        is past the end of the file. :py:meth:`read_chunk_series()` combines
+        reads of chunks that are close together in the file, which makes
+        reading a time series of logged quantities much faster than calling
+        :py:meth:`read_chunk()` on each frame.
+
+        Raises:
+            KeyError: A frame in the range does not contain the chunk.
+            ValueError: The chunk does not have the same type and shape in
+                every frame.
+
+        Example:
+            .. ipython:: python
+
+                f = gsd.fl.open(name='file.gsd', mode='rb')
+                f.read_chunk_series(name='chunk1')
+                f.read_chunk_series(name='chunk1', first=1)
+                f.close()
+        """
+
+        if not self.__is_open:
+            raise ValueError("File is not open")
+
+        if stride <= 0:
+            raise ValueError("stride must be positive")
+
+        cdef uint64_t c_first
+        cdef uint64_t c_last
+        cdef uint64_t c_stride
+        c_first, c_last, c_stride = slice(first, last, stride).indices(
+            self.nframes)
+        cdef size_t n = len(range(c_first, c_last, c_stride))
+
+        # an empty range takes the type and shape from the nearest frame
+        cdef uint64_t c_shape_frame = c_first
+        if n == 0 and self.nframes > 0 and c_shape_frame >= self.nframes:
+            c_shape_frame = self.nframes - 1
+
+        cdef const libgsd.gsd_index_entry* index_entry
+        cdef uint32_t c_id
+        cdef libgsd.gsd_type gsd_type
+        cdef void *data_ptr
+        cdef char * c_name
+        cdef size_t c_size
+
+        self.__n_readers += 1
+        try:
+            # the first frame determines the type and shape of the series
+            c_id = self.__get_name_id(name, False)
+            with nogil:
+                index_entry = libgsd.gsd_find_chunk_by_id(&self.__handle,
+                                                          c_shape_frame,
+                                                          c_id)
+
+            if index_entry == NULL:
+                raise KeyError("frame " + str(c_shape_frame) + " / chunk "
+                               + name + " not found in: " + self.name)
+
+            gsd_type = <libgsd.gsd_type>index_entry.type
+            dtype = __get_dtype(gsd_type)
+            if dtype is None:
+                raise ValueError("invalid type for chunk: " + name)
+
+            logger.debug('read chunk series: ' + self.name + ' - ' + name)
+
+            data_array = numpy.empty(
+                dtype=dtype, shape=[n, index_entry.N, index_entry.M])
+
+            # only read chunks if we have data
+            if n != 0 and index_entry.N != 0 and index_entry.M != 0:
+                data_ptr = __get_ptr(
+                    gsd_type,
+                    data_array.reshape([n * index_entry.N, index_entry.M]))
+                c_size = data_array.nbytes
+                name_e = name.encode('utf-8')
+                c_name = name_e
+
+                with nogil:
+                    retval = libgsd.gsd_read_chunk_series(&self.__handle,
+                                                          c_name,
+                                                          c_first,
+                                                          c_last,
+                                                          c_stride,
+                                                          data_ptr,
+                                                          c_size)
+
+                if retval == libgsd.GSD_ERROR_INVALID_ARGUMENT:
+                    for frame in range(c_first, c_last, c_stride):
+                        if not self.chunk_exists(frame, name):
+                            raise KeyError("frame " + str(frame) + " / chunk "
+                                           + name + " not found in: "
+                                           + self.name)
+                    raise ValueError("chunk " + name + " does not have the "
+                                     "same type and shape in every frame: "
+                                     + self.name)
+                __raise_on_error(retval, self.name)
+
+            if index_entry.M == 1:
+                return data_array.reshape([n, index_entry.N])
+            else:
+                return data_array
+        finally:
+            self.__n_readers -= 1
+
+    def prefetch_frames(self, first, count):
+        """prefetch_frames(first, count)
+
+        Start reading frames into the operating system's page cache.
+
+        Args:
+            first (int): Index of the first frame to prefetch
+            count (int): Number of frames to prefetch
+
+        :py:meth:`prefetch_frames()` returns without waiting for the data.
+        Later reads of these frames find the data in memory instead of waiting
+        on storage. Frames past the end of the file are ignored.
+
+        Example:
+            .. ipython:: python
+
+                f = gsd.fl.open(name='file.gsd', mode='rb')
+                f.prefetch_frames(first=0, count=2)
+                f.read_chunk(frame=1, name='chunk1')
+                f.close()
+        """
+
+        if not self.__is_open:
+            raise ValueError("File is not open")
+
+        if first < 0 or count < 0:
+            raise ValueError("first and count must be non-negative")
+
+        cdef uint64_t c_first = first
+        cdef uint64_t c_count = count
+
+        self.__n_readers += 1
+        try:
+            with nogil:
+                retval = libgsd.gsd_prefetch_frames(&self.__handle,
+                                                    c_first,
+                                                    c_count)
+        finally:
+            self.__n_readers -= 1
+
+        __raise_on_error(retval, self.name)
 
     def find_matching_chunk_names(self, match):
         """find_matching_chunk_names(match)
@@ -939,6 +1798,181 @@ cdef class GSDFile:
 
             return libgsd.gsd_get_nframes(&self.__handle)
 
+    property compression_level:
+        """int: Compression level passed to the codec by \
+        :py:meth:`write_chunk()`. 0 selects the codec's default level."""
+        def __get__(self):
+            return self.__handle.compression_level
+
+        def __set__(self, level):
+            if not self.__is_open:
+                raise ValueError("File is not open")
+
+            retval = libgsd.gsd_set_compression_level(&self.__handle, level)
+            __raise_on_error(retval, self.name)
+
+    property write_buffer_size:
+        """int: Size of the write buffer in bytes.
+
+        :py:meth:`write_chunk()` copies chunks smaller than half of the write
+        buffer to the buffer and writes larger chunks directly to the file.
+        Setting the size writes the buffered chunks to the file.
+        """
+        def __get__(self):
+            return self.__handle.write_buffer_size
+
+        def __set__(self, size):
+            if not self.__is_open:
+                raise ValueError("File is not open")
+
+            if size < 1:
+                raise ValueError("write_buffer_size must be positive")
+
+            cdef size_t c_size = size
+            with nogil:
+                retval = libgsd.gsd_set_write_buffer_size(&self.__handle,
+                                                          c_size)
+            __raise_on_error(retval, self.name)
+
+    property direct_io:
+        """bool: Write chunks larger than half of the write buffer with \
+        direct I/O so that they bypass the page cache.
+
+        Direct I/O is available on Linux. On other systems, setting
+        :py:attr:`direct_io` has no effect.
+        """
+        def __get__(self):
+            return self.__handle.direct_io != 0
+
+        def __set__(self, enable):
+            if not self.__is_open:
+                raise ValueError("File is not open")
+
+            retval = libgsd.gsd_set_direct_io(&self.__handle, bool(enable))
+            __raise_on_error(retval, self.name)
+
+    property write_map_size:
+        """int: Size of the mapped write region in bytes (0 to disable).
+
+        When non-zero, :py:meth:`write_chunk()` copies the chunk data directly
+        into a memory mapping of the end of the file, preallocated
+        :py:attr:`write_map_size` bytes at a time, instead of the write buffer.
+        This avoids a copy and a write call for frames of many small chunks.
+        Closing the file releases the preallocated space that was not used.
+        On systems without ``mmap``, chunks are written normally.
+        """
+        def __get__(self):
+            return self.__handle.write_map_size
+
+        def __set__(self, size):
+            if not self.__is_open:
+                raise ValueError("File is not open")
+
+            if size < 0:
+                raise ValueError("write_map_size must be non-negative")
+
+            cdef size_t c_size = size
+            with nogil:
+                retval = libgsd.gsd_set_write_map_size(&self.__handle, c_size)
+            __raise_on_error(retval, self.name)
+
+    property keyframe_interval:
+        """int: Maximum number of frames between keyframes of chunks written \
+        with ``delta=True``."""
+        def __get__(self):
+            return self.__handle.keyframe_interval
+
+        def __set__(self, interval):
+            if not self.__is_open:
+                raise ValueError("File is not open")
+
+            if interval < 1:
+                raise ValueError("keyframe_interval must be positive")
+
+            retval = libgsd.gsd_set_keyframe_interval(&self.__handle,
+                                                      interval)
+            __raise_on_error(retval, self.name)
+
+    property sync_policy:
+        """str: When the file is synced to the storage device (read only).
+
+        See :py:meth:`set_sync_policy()`.
+        """
+        def __get__(self):
+            for name, policy in _sync_policies.items():
+                if self.__handle.sync_policy == policy:
+                    return name
+
+    property stats:
+        """dict: I/O statistics of the file since it was opened (read only).
+
+        The keys are:
+
+        * ``read_calls``, ``read_bytes``: Number of reads and bytes read.
+        * ``write_calls``, ``write_bytes``: Number of writes and bytes
+          written, including those made by the write-behind thread.
+        * ``fsync_calls``, ``fsync_seconds``: Number of syncs and the time
+          spent in them.
+        * ``index_expansions``: Number of times the index grew.
+        * ``write_buffer_flushes``: Number of times the write buffer was
+          written to the file.
+        * ``name_lookups``, ``name_probes``, ``name_max_probes``: Number of
+          chunk name lookups, the total and largest number of hash table slots
+          probed by them.
+        * ``end_frame_calls``, ``end_frame_seconds``: Number of calls to
+          :py:meth:`end_frame()` and the time spent in them.
+        """
+        def __get__(self):
+            if not self.__is_open:
+                raise ValueError("File is not open")
+
+            cdef libgsd.gsd_stats c_stats
+            with nogil:
+                retval = libgsd.gsd_get_stats(&self.__handle, &c_stats)
+
+            __raise_on_error(retval, self.name)
+
+            return dict(read_calls=c_stats.read_calls,
+                        read_bytes=c_stats.read_bytes,
+                        write_calls=c_stats.write_calls,
+                        write_bytes=c_stats.write_bytes,
+                        fsync_calls=c_stats.fsync_calls,
+                        fsync_seconds=c_stats.fsync_ns / 1e9,
+                        index_expansions=c_stats.index_expansions,
+                        write_buffer_flushes=c_stats.write_buffer_flushes,
+                        name_lookups=c_stats.name_lookups,
+                        name_probes=c_stats.name_probes,
+                        name_max_probes=c_stats.name_max_probes,
+                        end_frame_calls=c_stats.end_frame_calls,
+                        end_frame_seconds=c_stats.end_frame_ns / 1e9)
+
+    property has_frame_table:
+        """bool: True when the file has a frame table (read only).
+
+        See :py:meth:`write_frame_table()`.
+        """
+        def __get__(self):
+            return self.__handle.frame_table.location != 0
+
+    property chained_index:
+        """bool: Grow the index by appending segments instead of copying it.
+
+        The first segment appended converts a version 2.0 file to version 3.0.
+        Version 3.1 files, which hold more than 65535 chunk names, keep their
+        version. Version 1.0 files do not chain their index. Files that
+        already have a chained index always append segments.
+        """
+        def __get__(self):
+            return (self.__handle.chained_index != 0
+                    or self.__handle.n_index_segments > 0)
+
+        def __set__(self, enable):
+            if not self.__is_open:
+                raise ValueError("File is not open")
+
+            retval = libgsd.gsd_set_chained_index(&self.__handle, bool(enable))
+            __raise_on_error(retval, self.name)
+
     def __dealloc__(self):
         if self.__is_open:
             logger.info('closing file: ' + self.name)
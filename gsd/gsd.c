@@ -2,6 +2,11 @@
 // This file is part of the General Simulation Data (GSD) project, released under the BSD 2-Clause
 // License.
 
+#ifdef __linux__
+// O_DIRECT is a GNU extension, select it before including any system header
+#define _GNU_SOURCE
+#endif
+
 #include <sys/stat.h>
 #ifdef _WIN32
 
@@ -9,14 +14,18 @@
 #pragma warning(disable : 4996)
 
 #define GSD_USE_MMAP 0
+#define GSD_USE_PTHREADS 0
+#include <intrin.h>
 #include <io.h>
 
 #else // linux / mac
 
-#define _XOPEN_SOURCE 500
+#define _XOPEN_SOURCE 700
+#include <pthread.h>
 #include <sys/mman.h>
 #include <unistd.h>
 #define GSD_USE_MMAP 1
+#define GSD_USE_PTHREADS 1
 
 #endif
 
@@ -26,12 +35,33 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <float.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
+
+#ifdef GSD_USE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef GSD_USE_ZSTD
+#include <zstd.h>
+#endif
 
 #include "gsd.h"
 
+#if defined(O_DIRECT) && defined(__linux__)
+#define GSD_USE_DIRECT_IO 1
+#else
+#define GSD_USE_DIRECT_IO 0
+#endif
+
+// count I/O operations in gsd_handle::stats unless the build disables it
+#ifndef GSD_ENABLE_STATS
+#define GSD_ENABLE_STATS 1
+#endif
+
 /** @file gsd.c
     @brief Implements the GSD C API
 */
@@ -63,16 +93,84 @@ enum
     GSD_WRITE_BUFFER_SIZE = 16 * 1024 * 1024
     };
 
+/// Maximum number of bytes queued for the background writer (at least two write buffers)
+enum
+    {
+    GSD_WRITE_BEHIND_QUEUE_SIZE = 2 * GSD_WRITE_BUFFER_SIZE
+    };
+
+/// Alignment of file offsets, sizes, and memory in direct I/O writes
+enum
+    {
+    GSD_DIRECT_IO_ALIGNMENT = 4096
+    };
+
+/// Size of the staging buffer for direct I/O writes of unaligned data
+enum
+    {
+    GSD_DIRECT_IO_BUFFER_SIZE = 8 * 1024 * 1024
+    };
+
+/// Maximum size of a coalesced read
+enum
+    {
+    GSD_READ_BUFFER_SIZE = 16 * 1024 * 1024
+    };
+
+/// Largest gap between chunks that a coalesced read reads through
+enum
+    {
+    GSD_READ_GAP_SIZE = 64 * 1024
+    };
+
 /// Size of copy buffer
 enum
     {
     GSD_COPY_BUFFER_SIZE = 128 * 1024
     };
 
-/// Size of hash map
+/// Initial number of slots in the hash map
+enum
+    {
+    GSD_INITIAL_NAME_MAP_SIZE = 1024
+    };
+
+/// Default size of a block in a name arena
+enum
+    {
+    GSD_ARENA_BLOCK_SIZE = 64 * 1024
+    };
+
+/// Number of index entries in a page of a paged file index
+enum
+    {
+    GSD_INDEX_PAGE_SIZE = 1024
+    };
+
+/// Bits of gsd_index_entry::flags that have a defined meaning
+enum
+    {
+    GSD_FLAG_DEFINED = GSD_FLAG_CODEC_MASK | GSD_FLAG_SHUFFLE | GSD_FLAG_QUANTIZE | GSD_FLAG_DELTA
+    };
+
+/// Use of gsd_chunk_header::parameters in quantized chunks
+enum
+    {
+    GSD_QUANTIZE_PARAMETER_STEP = 0,
+    GSD_QUANTIZE_PARAMETER_MIN = 1,
+    GSD_QUANTIZE_PARAMETER_BITS = 2
+    };
+
+/// Use of gsd_chunk_header::parameters in delta encoded chunks
+enum
+    {
+    GSD_DELTA_PARAMETER_FRAME = 0
+    };
+
+/// Default maximum number of frames between keyframes
 enum
     {
-    GSD_NAME_MAP_SIZE = 57557
+    GSD_DEFAULT_KEYFRAME_INTERVAL = 100
     };
 
 /// Current GSD file specification
@@ -81,11 +179,24 @@ enum
     GSD_CURRENT_FILE_VERSION = 2
     };
 
+/// GSD file specification of files with a chained index
+enum
+    {
+    GSD_CHAINED_INDEX_FILE_VERSION = 3
+    };
+
+/// GSD file specification of files with 32-bit name ids
+enum
+    {
+    GSD_WIDE_ID_FILE_VERSION = 3,
+    GSD_WIDE_ID_FILE_VERSION_MINOR = 1
+    };
+
 // define windows wrapper functions
 #ifdef _WIN32
 #define lseek _lseeki64
 #define open _open
-#define ftruncate _chsize
+#define ftruncate _chsize_s
 #define fsync _commit
 typedef int64_t ssize_t;
 
@@ -132,6 +243,221 @@ inline static void gsd_util_zero_memory(void* d, size_t size_to_zero)
     memset(d, 0, size_to_zero);
     }
 
+/** @internal
+    @brief Allocate memory with the C library
+*/
+static void* gsd_default_allocate(size_t size, void* context)
+    {
+    (void)context;
+    return malloc(size);
+    }
+
+/** @internal
+    @brief Allocate zeroed memory with the C library
+*/
+static void* gsd_default_allocate_zeroed(size_t count, size_t size, void* context)
+    {
+    (void)context;
+    return calloc(count, size);
+    }
+
+/** @internal
+    @brief Reallocate memory with the C library
+*/
+static void* gsd_default_reallocate(void* ptr, size_t size, void* context)
+    {
+    (void)context;
+    return realloc(ptr, size);
+    }
+
+/** @internal
+    @brief Free memory with the C library
+*/
+static void gsd_default_deallocate(void* ptr, void* context)
+    {
+    (void)context;
+    free(ptr);
+    }
+
+/// Allocator used for all memory that GSD allocates, see gsd_set_allocator()
+static struct gsd_allocator gsd_allocator = {gsd_default_allocate,
+                                             gsd_default_allocate_zeroed,
+                                             gsd_default_reallocate,
+                                             gsd_default_deallocate,
+                                             NULL};
+
+/// Number of allocations made with gsd_allocator that are not yet freed
+static int64_t gsd_n_allocations = 0;
+
+/** @internal
+    @brief Count allocations made or freed with the configured allocator
+
+    @param delta Number of allocations made (positive) or freed (negative).
+
+    The write-behind thread frees memory while other threads allocate, so the count is atomic.
+*/
+inline static void gsd_count_allocations(int64_t delta)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_fetch_add(&gsd_n_allocations, delta, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+    _InterlockedExchangeAdd64((volatile long long*)&gsd_n_allocations, delta);
+#else
+    gsd_n_allocations += delta;
+#endif
+    }
+
+/** @internal
+    @brief Read the number of allocations that are not yet freed
+*/
+inline static int64_t gsd_load_allocations(void)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(&gsd_n_allocations, __ATOMIC_RELAXED);
+#else
+    return *(const volatile int64_t*)&gsd_n_allocations;
+#endif
+    }
+
+/** @internal
+    @brief Allocate memory with the configured allocator (see malloc)
+*/
+inline static void* gsd_malloc(size_t size)
+    {
+    void* ptr = gsd_allocator.allocate(size, gsd_allocator.context);
+    if (ptr != NULL)
+        {
+        gsd_count_allocations(1);
+        }
+    return ptr;
+    }
+
+/** @internal
+    @brief Allocate zeroed memory with the configured allocator (see calloc)
+*/
+inline static void* gsd_calloc(size_t count, size_t size)
+    {
+    void* ptr = gsd_allocator.allocate_zeroed(count, size, gsd_allocator.context);
+    if (ptr != NULL)
+        {
+        gsd_count_allocations(1);
+        }
+    return ptr;
+    }
+
+/** @internal
+    @brief Reallocate memory with the configured allocator (see realloc)
+*/
+inline static void* gsd_realloc(void* ptr, size_t size)
+    {
+    void* new_ptr = gsd_allocator.reallocate(ptr, size, gsd_allocator.context);
+    if (ptr == NULL && new_ptr != NULL)
+        {
+        gsd_count_allocations(1);
+        }
+    return new_ptr;
+    }
+
+/** @internal
+    @brief Free memory with the configured allocator (see free)
+*/
+inline static void gsd_free(void* ptr)
+    {
+    if (ptr != NULL)
+        {
+        gsd_allocator.deallocate(ptr, gsd_allocator.context);
+        gsd_count_allocations(-1);
+        }
+    }
+
+/** @internal
+    @brief Block of an arena
+
+    The block data follows the header.
+*/
+struct gsd_arena_block
+    {
+    /// Block allocated before this one (NULL for the first block)
+    struct gsd_arena_block* previous;
+
+    /// Number of bytes of data in the block
+    size_t size;
+    };
+
+/** @internal
+    @brief Make room for an allocation in an arena
+
+    @param arena Arena to reserve space in.
+    @param n_bytes Number of bytes needed.
+
+    Allocates a new block when the current one cannot hold *n_bytes* more bytes. The block holds
+    at least GSD_ARENA_BLOCK_SIZE bytes so that later allocations can share it.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_arena_reserve(struct gsd_arena* arena, size_t n_bytes)
+    {
+    if (arena->blocks != NULL && arena->used + n_bytes <= arena->reserved)
+        {
+        return GSD_SUCCESS;
+        }
+
+    size_t block_size = n_bytes > GSD_ARENA_BLOCK_SIZE ? n_bytes : GSD_ARENA_BLOCK_SIZE;
+    struct gsd_arena_block* block = gsd_malloc(sizeof(struct gsd_arena_block) + block_size);
+    if (block == NULL)
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    block->previous = arena->blocks;
+    block->size = block_size;
+    arena->blocks = block;
+    arena->used = 0;
+    arena->reserved = block_size;
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Copy a string into an arena
+
+    @param arena Arena to copy into.
+    @param str String to copy.
+    @param len Length of the string including the null terminator.
+
+    @returns Pointer to the copy, or NULL when memory allocation fails.
+*/
+inline static char* gsd_arena_copy_str(struct gsd_arena* arena, const char* str, size_t len)
+    {
+    if (gsd_arena_reserve(arena, len) != GSD_SUCCESS)
+        {
+        return NULL;
+        }
+
+    char* dest = (char*)(arena->blocks + 1) + arena->used;
+    memcpy(dest, str, len);
+    arena->used += len;
+    return dest;
+    }
+
+/** @internal
+    @brief Free all blocks of an arena
+
+    @param arena Arena to free.
+*/
+inline static void gsd_arena_free(struct gsd_arena* arena)
+    {
+    struct gsd_arena_block* block = arena->blocks;
+    while (block != NULL)
+        {
+        struct gsd_arena_block* previous = block->previous;
+        gsd_free(block);
+        block = previous;
+        }
+
+    gsd_util_zero_memory(arena, sizeof(struct gsd_arena));
+    }
+
 /** @internal
     @brief Write large data buffer to file
 
@@ -221,1916 +547,7967 @@ inline static ssize_t gsd_io_pread_retry(int fd, void* buf, size_t count, int64_
     return total_bytes_read;
     }
 
+#if GSD_USE_DIRECT_IO
 /** @internal
-    @brief Allocate a name/id map
+    @brief Write a large data buffer to file with direct I/O
 
-    @param map Map to allocate.
-    @param size Number of entries in the map.
+    @param fd File descriptor.
+    @param direct_fd File descriptor of the same file opened with O_DIRECT.
+    @param buf Data buffer.
+    @param count Number of bytes to write.
+    @param offset Location in the file to start writing.
 
-    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+    Writes the whole GSD_DIRECT_IO_ALIGNMENT blocks of the range with *direct_fd*, bypassing the
+    page cache, and the partial blocks at either end with *fd*. The blocks are written from *buf*
+    when it is aligned like the file offset and copied through an aligned staging buffer otherwise.
+
+    @returns The total number of bytes written or a negative value on error.
 */
-inline static int gsd_name_id_map_allocate(struct gsd_name_id_map* map, size_t size)
+inline static ssize_t
+gsd_io_pwrite_direct(int fd, int direct_fd, const void* buf, size_t count, int64_t offset)
     {
-    if (map == NULL || map->v || size == 0 || map->size != 0)
+    const char* ptr = (const char*)buf;
+    const uint64_t align = GSD_DIRECT_IO_ALIGNMENT;
+    uint64_t body_start = ((offset + align - 1) / align) * align;
+    uint64_t body_end = ((offset + count) / align) * align;
+    if (body_end <= body_start)
         {
-        return GSD_ERROR_INVALID_ARGUMENT;
+        return gsd_io_pwrite_retry(fd, buf, count, offset);
         }
 
-    map->v = calloc(size, sizeof(struct gsd_name_id_pair));
-    if (map->v == NULL)
+    size_t head = body_start - offset;
+    size_t body_size = body_end - body_start;
+    size_t tail = count - head - body_size;
+
+    ssize_t bytes_written = gsd_io_pwrite_retry(fd, ptr, head, offset);
+    if (bytes_written == -1 || bytes_written != head)
         {
-        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        return GSD_ERROR_IO;
         }
 
-    map->size = size;
-
-    return GSD_SUCCESS;
-    }
-
-/** @internal
-    @brief Free a name/id map
-
-    @param map Map to free.
-
-    @returns GSD_SUCCESS on success, GSD_* error codes on error.
-*/
-inline static int gsd_name_id_map_free(struct gsd_name_id_map* map)
-    {
-    if (map == NULL || map->v == NULL || map->size == 0)
+    const char* body = ptr + head;
+    char* staging = NULL;
+    if ((uintptr_t)body % GSD_DIRECT_IO_ALIGNMENT != 0)
         {
-        return GSD_ERROR_INVALID_ARGUMENT;
+        if (posix_memalign((void**)&staging, GSD_DIRECT_IO_ALIGNMENT, GSD_DIRECT_IO_BUFFER_SIZE)
+            != 0)
+            {
+            return GSD_ERROR_IO;
+            }
         }
 
-    // free all of the linked lists
-    size_t i;
-    for (i = 0; i < map->size; i++)
+    size_t total_bytes_written = 0;
+    while (total_bytes_written < body_size)
         {
-        free(map->v[i].name);
+        size_t to_write = body_size - total_bytes_written;
+        const char* data = body + total_bytes_written;
+        if (staging != NULL)
+            {
+            if (to_write > GSD_DIRECT_IO_BUFFER_SIZE)
+                {
+                to_write = GSD_DIRECT_IO_BUFFER_SIZE;
+                }
+            memcpy(staging, data, to_write);
+            data = staging;
+            }
 
-        struct gsd_name_id_pair* cur = map->v[i].next;
-        while (cur != NULL)
+        bytes_written
+            = gsd_io_pwrite_retry(direct_fd, data, to_write, body_start + total_bytes_written);
+        if (bytes_written == -1 || bytes_written != to_write)
             {
-            struct gsd_name_id_pair* prev = cur;
-            cur = cur->next;
-            free(prev->name);
-            free(prev);
+            free(staging);
+            return GSD_ERROR_IO;
             }
-        }
 
-    // free the main map
-    free(map->v);
+        total_bytes_written += to_write;
+        }
+    free(staging);
 
-    map->v = 0;
-    map->size = 0;
+    bytes_written = gsd_io_pwrite_retry(fd, body + body_size, tail, body_end);
+    if (bytes_written == -1 || bytes_written != tail)
+        {
+        return GSD_ERROR_IO;
+        }
 
-    return GSD_SUCCESS;
+    return count;
     }
+#endif
 
 /** @internal
-    @brief Hash a string
+    @brief Add to a statistics counter
 
-    @param str String to hash
+    @param counter Counter to add to.
+    @param value Value to add.
 
-    @returns Hashed value of the string.
+    Readers that share a read-only handle count concurrently, so the addition is a relaxed atomic.
 */
-inline static unsigned long gsd_hash_str(const unsigned char* str)
+inline static void gsd_stats_add(uint64_t* counter, uint64_t value)
     {
-    unsigned long hash = 5381; // NOLINT
-    int c;
-
-    while ((c = *str++))
-        {
-        hash = ((hash << 5) + hash) + c; /* hash * 33 + c NOLINT */
-        }
-
-    return hash;
+#if GSD_ENABLE_STATS
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+#else
+    *counter += value;
+#endif
+#else
+    (void)counter;
+    (void)value;
+#endif
     }
 
 /** @internal
-    @brief Insert a string into a name/id map
-
-    @param map Map to insert into.
-    @param str String to insert.
-    @param id ID to associate with the string.
+    @brief Raise a statistics counter to a value
 
-    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+    @param counter Counter to raise.
+    @param value Value to raise the counter to.
 */
-inline static int gsd_name_id_map_insert(struct gsd_name_id_map* map, const char* str, uint16_t id)
+inline static void gsd_stats_max(uint64_t* counter, uint64_t value)
     {
-    if (map == NULL || map->v == NULL || map->size == 0)
+#if GSD_ENABLE_STATS
+#if defined(__GNUC__) || defined(__clang__)
+    uint64_t current = __atomic_load_n(counter, __ATOMIC_RELAXED);
+    while (value > current
+           && !__atomic_compare_exchange_n(counter,
+                                           &current,
+                                           value,
+                                           true,
+                                           __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
         {
-        return GSD_ERROR_INVALID_ARGUMENT;
         }
-
-    size_t hash = gsd_hash_str((const unsigned char*)str) % map->size;
-
-    // base case: no conflict
-    if (map->v[hash].name == NULL)
+#else
+    if (value > *counter)
         {
-        map->v[hash].name = calloc(strlen(str) + 1, sizeof(char));
-        if (map->v[hash].name == NULL)
-            {
-            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
-            }
-        memcpy(map->v[hash].name, str, strlen(str) + 1);
-        map->v[hash].id = id;
-        map->v[hash].next = NULL;
+        *counter = value;
         }
-    else
-        {
-        // go to the end of the conflict list
-        struct gsd_name_id_pair* insert_point = map->v + hash;
-
-        while (insert_point->next != NULL)
-            {
-            insert_point = insert_point->next;
-            }
+#endif
+#else
+    (void)counter;
+    (void)value;
+#endif
+    }
 
-        // allocate and insert a new entry
-        insert_point->next = malloc(sizeof(struct gsd_name_id_pair));
-        if (insert_point->next == NULL)
-            {
-            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
-            }
+/** @internal
+    @brief Read a statistics counter
 
-        insert_point->next->name = calloc(strlen(str) + 1, sizeof(char));
-        if (insert_point->next->name == NULL)
-            {
-            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
-            }
-        memcpy(insert_point->next->name, str, strlen(str) + 1);
-        insert_point->next->id = id;
-        insert_point->next->next = NULL;
-        }
+    @param counter Counter to read.
 
-    return GSD_SUCCESS;
+    @returns The value of the counter.
+*/
+inline static uint64_t gsd_stats_load(const uint64_t* counter)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+#else
+    return *(const volatile uint64_t*)counter;
+#endif
     }
 
 /** @internal
-    @brief Find an ID in a name/id mapping
+    @brief Read a monotonic clock for the statistics
 
-    @param map Map to search.
-    @param str String to search.
+    @returns The time in nanoseconds, or 0 when the build disables statistics.
+*/
+inline static uint64_t gsd_stats_now(void)
+    {
+#if GSD_ENABLE_STATS && !defined(_WIN32)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#elif GSD_ENABLE_STATS
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#else
+    return 0;
+#endif
+    }
+
+/** @internal
+    @brief Count a read or write request
 
-    @returns The ID if found, or UINT16_MAX if not found.
+    @param stats Statistics to update.
+    @param is_write Non-zero for a write request.
+    @param result Return value of the request.
 */
-inline static uint16_t gsd_name_id_map_find(struct gsd_name_id_map* map, const char* str)
+inline static void gsd_stats_count_io(struct gsd_stats* stats, int is_write, ssize_t result)
     {
-    if (map == NULL || map->v == NULL || map->size == 0)
+    uint64_t bytes = result > 0 ? (uint64_t)result : 0;
+    if (is_write)
+        {
+        gsd_stats_add(&stats->write_calls, 1);
+        gsd_stats_add(&stats->write_bytes, bytes);
+        }
+    else
         {
-        return UINT16_MAX;
+        gsd_stats_add(&stats->read_calls, 1);
+        gsd_stats_add(&stats->read_bytes, bytes);
         }
+    }
 
-    size_t hash = gsd_hash_str((const unsigned char*)str) % map->size;
+/** @internal
+    @brief Read bytes from the file of a handle and count the request
 
-    struct gsd_name_id_pair* cur = map->v + hash;
+    @param handle Handle to the open gsd file.
+    @param buf Buffer to read into.
+    @param count Number of bytes to read.
+    @param offset Location in the file to start reading.
 
-    while (cur != NULL)
-        {
-        if (cur->name == NULL)
-            {
-            // not found
-            return UINT16_MAX;
-            }
+    @returns The total number of bytes read or a negative value on error.
+*/
+inline static ssize_t
+gsd_handle_pread(struct gsd_handle* handle, void* buf, size_t count, int64_t offset)
+    {
+    ssize_t result = gsd_io_pread_retry(handle->fd, buf, count, offset);
+    gsd_stats_count_io(&handle->stats, 0, result);
+    return result;
+    }
 
-        if (strcmp(str, cur->name) == 0)
-            {
-            // found
-            return cur->id;
-            }
+/** @internal
+    @brief Write bytes to the file of a handle and count the request
 
-        // keep looking
-        cur = cur->next;
-        }
+    @param handle Handle to the open gsd file.
+    @param buf Data to write.
+    @param count Number of bytes to write.
+    @param offset Location in the file to start writing.
 
-    // not found in any conflict
-    return UINT16_MAX;
+    @returns The total number of bytes written or a negative value on error.
+*/
+inline static ssize_t
+gsd_handle_pwrite(struct gsd_handle* handle, const void* buf, size_t count, int64_t offset)
+    {
+    ssize_t result = gsd_io_pwrite_retry(handle->fd, buf, count, offset);
+    gsd_stats_count_io(&handle->stats, 1, result);
+    return result;
     }
 
 /** @internal
-    @brief Utility function to validate index entry
-    @param handle handle to the open gsd file
-    @param idx index of entry to validate
+    @brief Advise the OS that a range of the file will be read soon
 
-    @returns 1 if the entry is valid, 0 if it is not
+    Starts reading the range into the page cache without waiting for it. Does nothing on systems
+    that do not provide read ahead advice.
+
+    @param fd File descriptor.
+    @param offset Location in the file where the range starts.
+    @param length Number of bytes in the range.
 */
-inline static int gsd_is_entry_valid(struct gsd_handle* handle, size_t idx)
+inline static void gsd_io_advise_willneed(int fd, int64_t offset, int64_t length)
     {
-    const struct gsd_index_entry entry = handle->file_index.data[idx];
+#if defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(fd, offset, length, POSIX_FADV_WILLNEED);
+#elif defined(F_RDADVISE)
+    // apple provides read ahead advice through fcntl
+    struct radvisory advice;
+    advice.ra_offset = offset;
+    advice.ra_count = length > INT_MAX ? INT_MAX : (int)length;
+    fcntl(fd, F_RDADVISE, &advice);
+#else
+    (void)fd;
+    (void)offset;
+    (void)length;
+#endif
+    }
 
-    // check for valid type
-    if (gsd_sizeof_type((enum gsd_type)entry.type) == 0)
-        {
-        return 0;
-        }
+#if GSD_USE_MMAP
+/** @internal
+    @brief Allocate space in a file
 
-    // validate that we don't read past the end of the file
-    size_t size = entry.N * entry.M * gsd_sizeof_type((enum gsd_type)entry.type);
-    if ((entry.location + size) > (uint64_t)handle->file_size)
+    @param fd File descriptor.
+    @param offset Location in the file where the range starts.
+    @param length Number of bytes in the range.
+
+    Allocates the blocks of the range with posix_fallocate() on Linux and extends the file to the
+    end of the range on other systems or file systems that do not support it. The file grows to at
+    least the end of the range and the new space reads back as zeros.
+
+    @returns GSD_SUCCESS on success, GSD_ERROR_IO on error.
+*/
+inline static int gsd_io_preallocate(int fd, int64_t offset, int64_t length)
+    {
+#if defined(__linux__)
+    int retval = posix_fallocate(fd, offset, length);
+    if (retval == 0)
         {
-        return 0;
+        return GSD_SUCCESS;
         }
-
-    // check for valid frame (frame cannot be more than the number of index entries)
-    if (entry.frame >= handle->header.index_allocated_entries)
+    if (retval != EOPNOTSUPP && retval != EINVAL)
         {
-        return 0;
+        errno = retval;
+        return GSD_ERROR_IO;
         }
+#endif
 
-    // check for valid id
-    if (entry.id >= (handle->file_names.n_names + handle->frame_names.n_names))
+    struct stat st;
+    if (fstat(fd, &st) != 0)
         {
-        return 0;
+        return GSD_ERROR_IO;
         }
-
-    // check for valid flags
-    if (entry.flags != 0)
+    if (st.st_size < offset + length && ftruncate(fd, offset + length) != 0)
         {
-        return 0;
+        return GSD_ERROR_IO;
         }
 
-    return 1;
+    return GSD_SUCCESS;
     }
+#endif
 
 /** @internal
-    @brief Allocate a write buffer
+    @brief Allocate a name/id map
 
-    @param buf Buffer to allocate.
-    @param reserve Number of bytes to allocate.
+    @param map Map to allocate.
+    @param size Initial number of slots in the map (rounded up to a power of 2).
 
     @returns GSD_SUCCESS on success, GSD_* error codes on error.
 */
-inline static int gsd_byte_buffer_allocate(struct gsd_byte_buffer* buf, size_t reserve)
+inline static int gsd_name_id_map_allocate(struct gsd_name_id_map* map, size_t size)
     {
-    if (buf == NULL || buf->data || reserve == 0 || buf->reserved != 0 || buf->size != 0)
+    if (map == NULL || map->v || size == 0 || map->size != 0)
         {
         return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    buf->data = calloc(reserve, sizeof(char));
-    if (buf->data == NULL)
+    size_t n_slots = 1;
+    while (n_slots < size)
+        {
+        n_slots *= 2;
+        }
+
+    map->v = gsd_malloc(n_slots * sizeof(struct gsd_name_id_pair));
+    if (map->v == NULL)
         {
         return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
         }
 
-    buf->size = 0;
-    buf->reserved = reserve;
+    size_t i;
+    for (i = 0; i < n_slots; i++)
+        {
+        map->v[i].id = UINT32_MAX;
+        }
+
+    map->size = n_slots;
+    map->n_names = 0;
+    gsd_util_zero_memory(&map->names, sizeof(struct gsd_arena));
 
     return GSD_SUCCESS;
     }
 
 /** @internal
-    @brief Append bytes to a byte buffer
+    @brief Free a name/id map
 
-    @param buf Buffer to append to.
-    @param data Data to append.
-    @param size Number of bytes in *data*.
+    @param map Map to free.
 
     @returns GSD_SUCCESS on success, GSD_* error codes on error.
 */
-inline static int gsd_byte_buffer_append(struct gsd_byte_buffer* buf, const char* data, size_t size)
+inline static int gsd_name_id_map_free(struct gsd_name_id_map* map)
     {
-    if (buf == NULL || buf->data == NULL || size == 0 || buf->reserved == 0)
+    if (map == NULL || map->v == NULL || map->size == 0)
         {
         return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    if (buf->size + size > buf->reserved)
-        {
-        // reallocate by doubling
-        size_t new_reserved = buf->reserved * 2;
-        while (buf->size + size >= new_reserved)
-            {
-            new_reserved = new_reserved * 2;
-            }
+    gsd_free(map->v);
+    gsd_arena_free(&map->names);
+    gsd_util_zero_memory(map, sizeof(struct gsd_name_id_map));
 
-        char* old_data = buf->data;
-        buf->data = realloc(buf->data, sizeof(char) * new_reserved);
-        if (buf->data == NULL)
-            {
-            // this free should not be necessary, but clang-tidy disagrees
-            free(old_data);
-            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
-            }
+    return GSD_SUCCESS;
+    }
 
-        // zero the new memory, but only the portion after the end of the new section to be appended
-        gsd_util_zero_memory(buf->data + (buf->size + size),
-                             sizeof(char) * (new_reserved - (buf->size + size)));
-        buf->reserved = new_reserved;
-        }
+/** @internal
+    @brief Hash a string
 
-    memcpy(buf->data + buf->size, data, size);
-    buf->size += size;
+    @param str String to hash
 
-    return GSD_SUCCESS;
+    @returns Hashed value of the string (32-bit FNV-1a).
+*/
+inline static uint32_t gsd_hash_str(const unsigned char* str)
+    {
+    uint32_t hash = 2166136261U; // NOLINT
+    int c;
+
+    while ((c = *str++))
+        {
+        hash = (hash ^ (uint32_t)c) * 16777619U; // NOLINT
+        }
+
+    return hash;
     }
 
 /** @internal
-    @brief Free the memory allocated by the write buffer or unmap the mapped memory.
+    @brief Grow the number of slots in a name/id map
 
-    @param buf Buffer to free.
+    @param map Map to grow.
+    @param new_size New number of slots (a power of 2 larger than the current size).
 
     @returns GSD_SUCCESS on success, GSD_* error codes on error.
 */
-inline static int gsd_byte_buffer_free(struct gsd_byte_buffer* buf)
+inline static int gsd_name_id_map_grow(struct gsd_name_id_map* map, size_t new_size)
     {
-    if (buf == NULL || buf->data == NULL)
+    struct gsd_name_id_pair* new_v = gsd_malloc(new_size * sizeof(struct gsd_name_id_pair));
+    if (new_v == NULL)
         {
-        return GSD_ERROR_INVALID_ARGUMENT;
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
         }
 
-    free(buf->data);
+    size_t i;
+    for (i = 0; i < new_size; i++)
+        {
+        new_v[i].id = UINT32_MAX;
+        }
+
+    // reinsert the existing entries using the stored hashes
+    for (i = 0; i < map->size; i++)
+        {
+        if (map->v[i].id != UINT32_MAX)
+            {
+            size_t slot = map->v[i].hash & (new_size - 1);
+            while (new_v[slot].id != UINT32_MAX)
+                {
+                slot = (slot + 1) & (new_size - 1);
+                }
+            new_v[slot] = map->v[i];
+            }
+        }
+
+    gsd_free(map->v);
+    map->v = new_v;
+    map->size = new_size;
 
-    gsd_util_zero_memory(buf, sizeof(struct gsd_byte_buffer));
     return GSD_SUCCESS;
     }
 
 /** @internal
-    @brief Allocate a buffer of index entries
+    @brief Reserve space in a name/id map for names that are about to be inserted
 
-    @param buf Buffer to allocate.
-    @param reserve Number of entries to allocate.
+    @param map Map to reserve space in.
+    @param n_names Number of names to insert.
+    @param n_bytes Total length of the names, including the null terminators.
 
-    @post The buffer's data element has *reserve* elements allocated in memory.
+    Grows the slots and the name storage once so that the insertions do not grow them
+    repeatedly.
 
     @returns GSD_SUCCESS on success, GSD_* error codes on error.
 */
-inline static int gsd_index_buffer_allocate(struct gsd_index_buffer* buf, size_t reserve)
+inline static int
+gsd_name_id_map_reserve(struct gsd_name_id_map* map, size_t n_names, size_t n_bytes)
     {
-    if (buf == NULL || buf->mapped_data || buf->data || reserve == 0 || buf->reserved != 0
-        || buf->size != 0)
+    if (map == NULL || map->v == NULL || map->size == 0)
         {
         return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    buf->data = calloc(reserve, sizeof(struct gsd_index_entry));
-    if (buf->data == NULL)
+    size_t new_size = map->size;
+    while ((map->n_names + n_names) * 2 > new_size)
         {
-        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        new_size *= 2;
         }
 
-    buf->size = 0;
-    buf->reserved = reserve;
-    buf->mapped_data = NULL;
-    buf->mapped_len = 0;
+    if (new_size != map->size)
+        {
+        int retval = gsd_name_id_map_grow(map, new_size);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    if (n_bytes > 0)
+        {
+        return gsd_arena_reserve(&map->names, n_bytes);
+        }
 
     return GSD_SUCCESS;
     }
 
 /** @internal
-    @brief Map index entries from the file
-
-    @param buf Buffer to map.
-    @param handle GSD file handle to map.
-
-    @post The buffer's data element contains the index data from the file.
+    @brief Insert a string into a name/id map
 
-    On some systems, this will use mmap to efficiently access the file. On others, it may result in
-    an allocation and read of the entire index from the file.
+    @param map Map to insert into.
+    @param str String to insert.
+    @param id ID to associate with the string.
 
     @returns GSD_SUCCESS on success, GSD_* error codes on error.
 */
-inline static int gsd_index_buffer_map(struct gsd_index_buffer* buf, struct gsd_handle* handle)
+inline static int gsd_name_id_map_insert(struct gsd_name_id_map* map, const char* str, uint32_t id)
     {
-    if (buf == NULL || buf->mapped_data || buf->data || buf->reserved != 0 || buf->size != 0)
+    if (map == NULL || map->v == NULL || map->size == 0 || id == UINT32_MAX)
         {
         return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    // validate that the index block exists inside the file
-    if (handle->header.index_location
-            + sizeof(struct gsd_index_entry) * handle->header.index_allocated_entries
-        > (uint64_t)handle->file_size)
+    // keep the load factor at or below 1/2 so that probe sequences stay short
+    if ((map->n_names + 1) * 2 > map->size)
         {
-        return GSD_ERROR_FILE_CORRUPT;
+        int retval = gsd_name_id_map_grow(map, map->size * 2);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
         }
 
-#if GSD_USE_MMAP
-    // map the index in read only mode
-    size_t page_size = getpagesize();
-    size_t index_size = sizeof(struct gsd_index_entry) * handle->header.index_allocated_entries;
-    size_t offset = (handle->header.index_location / page_size) * page_size;
-    buf->mapped_data = mmap(NULL,
-                            index_size + (handle->header.index_location - offset),
-                            PROT_READ,
-                            MAP_SHARED,
-                            handle->fd,
-                            offset);
-
-    if (buf->mapped_data == MAP_FAILED)
+    // copy the name into the name storage
+    size_t len = strlen(str) + 1;
+    const char* name = gsd_arena_copy_str(&map->names, str, len);
+    if (name == NULL)
         {
-        return GSD_ERROR_IO;
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
         }
 
-    buf->data = (struct gsd_index_entry*)(((char*)buf->mapped_data)
-                                          + (handle->header.index_location - offset));
-
-    buf->mapped_len = index_size + (handle->header.index_location - offset);
-    buf->reserved = handle->header.index_allocated_entries;
-#else
-    // mmap not supported, read the data from the disk
-    int retval = gsd_index_buffer_allocate(buf, handle->header.index_allocated_entries);
-    if (retval != GSD_SUCCESS)
+    // linear probe for an empty slot
+    uint32_t hash = gsd_hash_str((const unsigned char*)str);
+    size_t slot = hash & (map->size - 1);
+    while (map->v[slot].id != UINT32_MAX)
         {
-        return retval;
+        slot = (slot + 1) & (map->size - 1);
         }
 
-    ssize_t bytes_read = gsd_io_pread_retry(handle->fd,
-                                            buf->data,
-                                            sizeof(struct gsd_index_entry)
-                                                * handle->header.index_allocated_entries,
-                                            handle->header.index_location);
+    map->v[slot].name = name;
+    map->v[slot].hash = hash;
+    map->v[slot].id = id;
+    map->n_names++;
 
-    if (bytes_read == -1
-        || bytes_read != sizeof(struct gsd_index_entry) * handle->header.index_allocated_entries)
-        {
-        return GSD_ERROR_IO;
-        }
-#endif
+    return GSD_SUCCESS;
+    }
 
-    // determine the number of index entries in the list
-    // file is corrupt if first index entry is invalid
-    if (buf->data[0].location != 0 && !gsd_is_entry_valid(handle, 0))
+/** @internal
+    @brief Find an ID in a name/id mapping
+
+    @param map Map to search.
+    @param str String to search.
+    @param stats Statistics to count the lookup in.
+
+    @returns The ID if found, or UINT32_MAX if not found.
+*/
+inline static uint32_t
+gsd_name_id_map_find(struct gsd_name_id_map* map, const char* str, struct gsd_stats* stats)
+    {
+    if (map == NULL || map->v == NULL || map->size == 0)
         {
-        return GSD_ERROR_FILE_CORRUPT;
+        return UINT32_MAX;
         }
 
-    if (buf->data[0].location == 0)
+    uint32_t hash = gsd_hash_str((const unsigned char*)str);
+    size_t slot = hash & (map->size - 1);
+    uint32_t id = UINT32_MAX;
+    uint64_t probes = 1;
+
+    // the load factor limit guarantees an empty slot that ends the probe sequence
+    while (map->v[slot].id != UINT32_MAX)
         {
-        buf->size = 0;
+        if (map->v[slot].hash == hash && strcmp(str, map->v[slot].name) == 0)
+            {
+            // found
+            id = map->v[slot].id;
+            break;
+            }
+
+        // keep looking
+        slot = (slot + 1) & (map->size - 1);
+        probes++;
         }
-    else
-        {
-        // determine the number of index entries (marked by location = 0)
-        // binary search for the first index entry with location 0
-        size_t L = 0;
-        size_t R = buf->reserved;
 
-        // progressively narrow the search window by halves
-        do
-            {
-            size_t m = (L + R) / 2;
-
-            // file is corrupt if any index entry is invalid or frame does not increase
-            // monotonically
-            if (buf->data[m].location != 0
-                && (!gsd_is_entry_valid(handle, m) || buf->data[m].frame < buf->data[L].frame))
-                {
-                return GSD_ERROR_FILE_CORRUPT;
-                }
-
-            if (buf->data[m].location != 0)
-                {
-                L = m;
-                }
-            else
-                {
-                R = m;
-                }
-            } while ((R - L) > 1);
-
-        // this finds R = the first index entry with location = 0
-        buf->size = R;
-        }
-
-    return GSD_SUCCESS;
+    gsd_stats_add(&stats->name_lookups, 1);
+    gsd_stats_add(&stats->name_probes, probes);
+    gsd_stats_max(&stats->name_max_probes, probes);
+    return id;
     }
 
 /** @internal
-    @brief Free the memory allocated by the index buffer or unmap the mapped memory.
+    @brief Test if encoding flags are well formed
 
-    @param buf Buffer to free.
+    @param flags Encoding flags.
 
-    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+    @returns 1 if *flags* uses only defined bits and selects a known codec, 0 if not.
 */
-inline static int gsd_index_buffer_free(struct gsd_index_buffer* buf)
+inline static int gsd_is_encoding_valid(uint8_t flags)
     {
-    if (buf == NULL || buf->data == NULL)
+    if ((flags & ~GSD_FLAG_DEFINED) != 0)
         {
-        return GSD_ERROR_INVALID_ARGUMENT;
+        return 0;
         }
 
-#if GSD_USE_MMAP
-    if (buf->mapped_data)
+    uint8_t codec = flags & GSD_FLAG_CODEC_MASK;
+    if (codec != 0 && codec != GSD_FLAG_CODEC_ZSTD && codec != GSD_FLAG_CODEC_DEFLATE)
         {
-        int retval = munmap(buf->mapped_data, buf->mapped_len);
-
-        if (retval != 0)
-            {
-            return GSD_ERROR_IO;
-            }
+        return 0;
         }
-    else
-#endif
+
+    // the shuffle filter and delta encoding only apply to compressed chunks of unquantized values
+    uint8_t lossless_filters = GSD_FLAG_SHUFFLE | GSD_FLAG_DELTA;
+    if ((flags & lossless_filters) && (codec == 0 || (flags & GSD_FLAG_QUANTIZE)))
         {
-        free(buf->data);
+        return 0;
         }
 
-    gsd_util_zero_memory(buf, sizeof(struct gsd_index_buffer));
-    return GSD_SUCCESS;
+    return 1;
     }
 
 /** @internal
-    @brief Add a new index entry and provide a pointer to it.
-
-    @param buf Buffer to add too.
-    @param entry [out] Pointer to set to the new entry.
+    @brief Byte shuffle an array
 
-    Double the size of the reserved space as needed to hold the new entry. Does not accept mapped
-    indices.
+    @param out Output buffer.
+    @param in Input buffer.
+    @param n Number of elements.
+    @param element_size Size of each element (in bytes).
 
-    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+    Groups byte *b* of every element together. Slowly varying values have similar high order bytes,
+    so shuffled data compresses better.
 */
-inline static int gsd_index_buffer_add(struct gsd_index_buffer* buf, struct gsd_index_entry** entry)
+inline static void gsd_byte_shuffle(char* out, const char* in, size_t n, size_t element_size)
     {
-    if (buf == NULL || buf->mapped_data || entry == NULL || buf->reserved == 0)
+    size_t i, b;
+    for (i = 0; i < n; i++)
         {
-        return GSD_ERROR_INVALID_ARGUMENT;
+        for (b = 0; b < element_size; b++)
+            {
+            out[b * n + i] = in[i * element_size + b];
+            }
         }
+    }
 
-    if (buf->size == buf->reserved)
+/** @internal
+    @brief Reverse gsd_byte_shuffle() one output element at a time
+
+    @param out Output buffer.
+    @param in Shuffled input buffer.
+    @param n Number of elements.
+    @param element_size Size of each element (in bytes).
+*/
+inline static void
+gsd_byte_unshuffle_elements(char* out, const char* in, size_t n, size_t element_size)
+    {
+    size_t i, b;
+    for (i = 0; i < n; i++)
         {
-        // grow the array
-        size_t new_reserved = buf->reserved * 2;
-        buf->data = realloc(buf->data, sizeof(struct gsd_index_entry) * new_reserved);
-        if (buf->data == NULL)
+        for (b = 0; b < element_size; b++)
             {
-            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+            out[i * element_size + b] = in[b * n + i];
             }
-
-        // zero the new memory
-        gsd_util_zero_memory(buf->data + buf->reserved,
-                             sizeof(struct gsd_index_entry) * (new_reserved - buf->reserved));
-        buf->reserved = new_reserved;
         }
+    }
 
-    size_t insert_pos = buf->size;
-    buf->size++;
-    *entry = buf->data + insert_pos;
+/** @internal
+    @brief Reverse gsd_byte_shuffle()
 
-    return GSD_SUCCESS;
+    @param out Output buffer.
+    @param in Shuffled input buffer.
+    @param n Number of elements.
+    @param element_size Size of each element (in bytes).
+*/
+inline static void gsd_byte_unshuffle(char* out, const char* in, size_t n, size_t element_size)
+    {
+    // write each output element once, constant element sizes let the compiler vectorize the loop
+    switch (element_size)
+        {
+    case 2:
+        gsd_byte_unshuffle_elements(out, in, n, 2);
+        break;
+    case 4:
+        gsd_byte_unshuffle_elements(out, in, n, 4);
+        break;
+    case 8:
+        gsd_byte_unshuffle_elements(out, in, n, 8);
+        break;
+    default:
+        gsd_byte_unshuffle_elements(out, in, n, element_size);
+        break;
+        }
     }
 
-inline static int gsd_cmp_index_entry(const struct gsd_index_entry* a,
-                                      const struct gsd_index_entry* b)
+/// Number of elements that gsd_convert() converts at a time
+enum
     {
-    int result = 0;
+    GSD_CONVERT_BLOCK_SIZE = 512
+    };
 
-    if (a->frame < b->frame)
-        {
-        result = -1;
-        }
+/// Convert n elements of type FROM in in_ptr to type TO in out_ptr
+#define GSD_CONVERT_LOOP(TO, FROM, out_ptr, in_ptr, n) \
+    {                                                  \
+        TO* out_typed = (TO*)(out_ptr);                \
+        const FROM* in_typed = (const FROM*)(in_ptr);  \
+        size_t k;                                      \
+        for (k = 0; k < (n); k++)                      \
+            {                                          \
+            out_typed[k] = (TO)in_typed[k];            \
+            }                                          \
+    }
 
-    if (a->frame > b->frame)
-        {
-        result = 1;
+/// Convert n elements of type in_type in in_ptr to type TO in out_ptr
+#define GSD_CONVERT_TO(TO, out_ptr, in_type, in_ptr, n)           \
+    switch (in_type)                                              \
+        {                                                         \
+    case GSD_TYPE_UINT8:                                          \
+        GSD_CONVERT_LOOP(TO, uint8_t, out_ptr, in_ptr, n) break;  \
+    case GSD_TYPE_UINT16:                                         \
+        GSD_CONVERT_LOOP(TO, uint16_t, out_ptr, in_ptr, n) break; \
+    case GSD_TYPE_UINT32:                                         \
+        GSD_CONVERT_LOOP(TO, uint32_t, out_ptr, in_ptr, n) break; \
+    case GSD_TYPE_UINT64:                                         \
+        GSD_CONVERT_LOOP(TO, uint64_t, out_ptr, in_ptr, n) break; \
+    case GSD_TYPE_INT8:                                           \
+        GSD_CONVERT_LOOP(TO, int8_t, out_ptr, in_ptr, n) break;   \
+    case GSD_TYPE_INT16:                                          \
+        GSD_CONVERT_LOOP(TO, int16_t, out_ptr, in_ptr, n) break;  \
+    case GSD_TYPE_INT32:                                          \
+        GSD_CONVERT_LOOP(TO, int32_t, out_ptr, in_ptr, n) break;  \
+    case GSD_TYPE_INT64:                                          \
+        GSD_CONVERT_LOOP(TO, int64_t, out_ptr, in_ptr, n) break;  \
+    case GSD_TYPE_FLOAT:                                          \
+        GSD_CONVERT_LOOP(TO, float, out_ptr, in_ptr, n) break;    \
+    case GSD_TYPE_DOUBLE:                                         \
+        GSD_CONVERT_LOOP(TO, double, out_ptr, in_ptr, n) break;   \
+    default:                                                      \
+        break;                                                    \
         }
 
-    if (a->frame == b->frame)
-        {
-        if (a->id < b->id)
-            {
-            result = -1;
-            }
-
-        if (a->id > b->id)
-            {
-            result = 1;
-            }
+/** @internal
+    @brief Convert a block of elements between types
 
-        if (a->id == b->id)
-            {
-            result = 0;
-            }
+    @param out Output buffer.
+    @param out_type Type of the output elements.
+    @param in Input buffer, which must not overlap *out*.
+    @param in_type Type of the input elements.
+    @param n Number of elements.
+*/
+inline static void gsd_convert_block(void* out,
+                                     enum gsd_type out_type,
+                                     const void* in,
+                                     enum gsd_type in_type,
+                                     size_t n)
+    {
+    switch (out_type)
+        {
+    case GSD_TYPE_UINT8:
+        GSD_CONVERT_TO(uint8_t, out, in_type, in, n) break;
+    case GSD_TYPE_UINT16:
+        GSD_CONVERT_TO(uint16_t, out, in_type, in, n) break;
+    case GSD_TYPE_UINT32:
+        GSD_CONVERT_TO(uint32_t, out, in_type, in, n) break;
+    case GSD_TYPE_UINT64:
+        GSD_CONVERT_TO(uint64_t, out, in_type, in, n) break;
+    case GSD_TYPE_INT8:
+        GSD_CONVERT_TO(int8_t, out, in_type, in, n) break;
+    case GSD_TYPE_INT16:
+        GSD_CONVERT_TO(int16_t, out, in_type, in, n) break;
+    case GSD_TYPE_INT32:
+        GSD_CONVERT_TO(int32_t, out, in_type, in, n) break;
+    case GSD_TYPE_INT64:
+        GSD_CONVERT_TO(int64_t, out, in_type, in, n) break;
+    case GSD_TYPE_FLOAT:
+        GSD_CONVERT_TO(float, out, in_type, in, n) break;
+    case GSD_TYPE_DOUBLE:
+        GSD_CONVERT_TO(double, out, in_type, in, n) break;
+    default:
+        break;
         }
-
-    return result;
     }
 
 /** @internal
-    @brief Compute heap parent node.
-    @param i Node index.
+    @brief Convert an array between types
+
+    @param out Output buffer.
+    @param out_type Type of the output elements.
+    @param in Input buffer.
+    @param in_type Type of the input elements.
+    @param n Number of elements.
+
+    Each block of input elements is copied to a buffer on the stack before it is converted, so
+    *in* may overlap *out* when it starts at or after `out + n * (out_size - in_size)` for output
+    elements at least as large as the input elements, or at *out* for smaller output elements.
+    The blocks stay in the cache and the conversion loops do not alias, so the compiler vectorizes
+    them.
 */
-inline static size_t gsd_heap_parent(size_t i)
+inline static void
+gsd_convert(void* out, enum gsd_type out_type, const void* in, enum gsd_type in_type, size_t n)
     {
-    return (i - 1) / 2;
+    // double aligns the buffer for every type
+    double block[GSD_CONVERT_BLOCK_SIZE];
+    size_t in_size = gsd_sizeof_type(in_type);
+    size_t out_size = gsd_sizeof_type(out_type);
+    size_t i;
+    for (i = 0; i < n; i += GSD_CONVERT_BLOCK_SIZE)
+        {
+        size_t block_n = n - i;
+        if (block_n > GSD_CONVERT_BLOCK_SIZE)
+            {
+            block_n = GSD_CONVERT_BLOCK_SIZE;
+            }
+
+        memcpy(block, (const char*)in + i * in_size, block_n * in_size);
+        gsd_convert_block((char*)out + i * out_size, out_type, block, in_type, block_n);
+        }
     }
 
 /** @internal
-    @brief Compute heap left child.
-    @param i Node index.
+    @brief Get the maximum compressed size of a buffer
+
+    @param size Number of bytes to compress.
+    @param codec Codec bits of the encoding flags.
+
+    @returns The maximum number of bytes *codec* produces, or 0 when *codec* is not available.
 */
-inline static size_t gsd_heap_left_child(size_t i)
+inline static size_t gsd_compress_bound(size_t size, uint8_t codec)
     {
-    return 2 * i + 1;
+    size_t bound = 0;
+#if !defined(GSD_USE_ZSTD) && !defined(GSD_USE_ZLIB)
+    (void)size;
+    (void)codec;
+#endif
+#ifdef GSD_USE_ZSTD
+    if (codec == GSD_FLAG_CODEC_ZSTD)
+        {
+        bound = ZSTD_compressBound(size);
+        }
+#endif
+#ifdef GSD_USE_ZLIB
+    if (codec == GSD_FLAG_CODEC_DEFLATE)
+        {
+        bound = compressBound(size);
+        }
+#endif
+    return bound;
     }
 
 /** @internal
-    @brief Swap the nodes *a* and *b* in the buffer
-    @param buf Buffer.
-    @param a First index to swap.
-    @param b Second index to swap.
+    @brief Compress a buffer
+
+    @param output Output buffer with at least gsd_compress_bound() bytes.
+    @param output_size [out] Set to the number of bytes written to *output*.
+    @param input Input buffer.
+    @param size Number of bytes in *input*.
+    @param codec Codec bits of the encoding flags.
+    @param level Compression level (0 selects the codec default).
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
 */
-inline static void gsd_heap_swap(struct gsd_index_buffer* buf, size_t a, size_t b)
+inline static int gsd_compress(char* output,
+                               size_t* output_size,
+                               const char* input,
+                               size_t size,
+                               uint8_t codec,
+                               int level)
     {
-    struct gsd_index_entry tmp = buf->data[a];
-    buf->data[a] = buf->data[b];
-    buf->data[b] = tmp;
+    size_t bound = gsd_compress_bound(size, codec);
+    int retval = GSD_ERROR_UNSUPPORTED_ENCODING;
+#if !defined(GSD_USE_ZSTD) && !defined(GSD_USE_ZLIB)
+    (void)output;
+    (void)output_size;
+    (void)input;
+    (void)level;
+    (void)bound;
+#endif
+#ifdef GSD_USE_ZSTD
+    if (codec == GSD_FLAG_CODEC_ZSTD)
+        {
+        size_t result
+            = ZSTD_compress(output, bound, input, size, level == 0 ? ZSTD_CLEVEL_DEFAULT : level);
+        if (ZSTD_isError(result))
+            {
+            retval = GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+        else
+            {
+            *output_size = result;
+            retval = GSD_SUCCESS;
+            }
+        }
+#endif
+#ifdef GSD_USE_ZLIB
+    if (codec == GSD_FLAG_CODEC_DEFLATE)
+        {
+        uLongf dest_len = bound;
+        int zlib_level = level;
+        if (zlib_level <= 0)
+            {
+            zlib_level = Z_DEFAULT_COMPRESSION;
+            }
+        else if (zlib_level > Z_BEST_COMPRESSION)
+            {
+            zlib_level = Z_BEST_COMPRESSION;
+            }
+        int result = compress2((Bytef*)output, &dest_len, (const Bytef*)input, size, zlib_level);
+        if (result == Z_MEM_ERROR)
+            {
+            retval = GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+        else if (result != Z_OK)
+            {
+            retval = GSD_ERROR_INVALID_ARGUMENT;
+            }
+        else
+            {
+            *output_size = dest_len;
+            retval = GSD_SUCCESS;
+            }
+        }
+#endif
+    return retval;
     }
 
 /** @internal
-    @brief Shift heap node downward
-    @param buf Buffer.
-    @param start First index of the valid heap in *buf*.
-    @param end Last index of the valid hep in *buf*.
+    @brief Decompress a buffer
+
+    @param output Output buffer.
+    @param size Expected number of decompressed bytes.
+    @param input Compressed input buffer.
+    @param input_size Number of bytes in *input*.
+    @param codec Codec bits of the encoding flags.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
 */
-inline static void gsd_heap_shift_down(struct gsd_index_buffer* buf, size_t start, size_t end)
+inline static int
+gsd_decompress(char* output, size_t size, const char* input, size_t input_size, uint8_t codec)
     {
-    size_t root = start;
-
-    while (gsd_heap_left_child(root) <= end)
+    int retval = GSD_ERROR_UNSUPPORTED_ENCODING;
+#if !defined(GSD_USE_ZSTD) && !defined(GSD_USE_ZLIB)
+    (void)output;
+    (void)size;
+    (void)input;
+    (void)input_size;
+    (void)codec;
+#endif
+#ifdef GSD_USE_ZSTD
+    if (codec == GSD_FLAG_CODEC_ZSTD)
         {
-        size_t child = gsd_heap_left_child(root);
-        size_t swap = root;
-
-        if (gsd_cmp_index_entry(buf->data + swap, buf->data + child) < 0)
+        size_t result = ZSTD_decompress(output, size, input, input_size);
+        if (ZSTD_isError(result) || result != size)
             {
-            swap = child;
+            retval = GSD_ERROR_FILE_CORRUPT;
             }
-        if (child + 1 <= end && gsd_cmp_index_entry(buf->data + swap, buf->data + child + 1) < 0)
+        else
             {
-            swap = child + 1;
+            retval = GSD_SUCCESS;
             }
-
-        if (swap == root)
+        }
+#endif
+#ifdef GSD_USE_ZLIB
+    if (codec == GSD_FLAG_CODEC_DEFLATE)
+        {
+        uLongf dest_len = size;
+        int result = uncompress((Bytef*)output, &dest_len, (const Bytef*)input, input_size);
+        if (result == Z_MEM_ERROR)
             {
-            return;
+            retval = GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+        else if (result != Z_OK || dest_len != size)
+            {
+            retval = GSD_ERROR_FILE_CORRUPT;
+            }
+        else
+            {
+            retval = GSD_SUCCESS;
             }
-
-        gsd_heap_swap(buf, root, swap);
-        root = swap;
         }
+#endif
+    return retval;
     }
 
 /** @internal
-    @brief Convert unordered index buffer to a heap
-    @param buf Buffer.
+    @brief Round to the nearest integer, with halfway cases away from zero
+
+    @param x Value to round, must be in the range of int64_t.
+
+    @returns The rounded value.
 */
-inline static void gsd_heapify(struct gsd_index_buffer* buf)
+inline static int64_t gsd_round_to_int64(double x)
     {
-    ssize_t start = gsd_heap_parent(buf->size - 1);
-
-    while (start >= 0)
-        {
-        gsd_heap_shift_down(buf, start, buf->size - 1);
-        start--;
-        }
+    return (int64_t)(x >= 0 ? x + 0.5 : x - 0.5);
     }
 
 /** @internal
-    @brief Sort the index buffer.
+    @brief Quantize floats to bit packed integers
 
-    @param buf Buffer to sort.
+    @param packed [out] Set to a newly allocated buffer with the packed values, or NULL when
+    quantization does not reduce the size of the data.
+    @param packed_size [out] Set to the number of bytes in *packed*.
+    @param header Chunk header to store the quantization parameters in.
+    @param data Values to quantize.
+    @param n Number of values in *data*.
+    @param precision Maximum absolute error of the quantized values.
 
-    Sorts an in-memory index buffer. Does not accept mapped indices.
+    Each value is rounded to the nearest multiple of `2 * precision`. The multiples are offset by
+    their minimum and stored in the smallest number of bits that holds the range.
 
     @returns GSD_SUCCESS on success, GSD_* error codes on error.
 */
-inline static int gsd_index_buffer_sort(struct gsd_index_buffer* buf)
+inline static int gsd_quantize(char** packed,
+                               size_t* packed_size,
+                               struct gsd_chunk_header* header,
+                               const float* data,
+                               size_t n,
+                               double precision)
     {
-    if (buf == NULL || buf->mapped_data || buf->reserved == 0)
+    *packed = NULL;
+    *packed_size = 0;
+
+    double step = 2.0 * precision;
+    int64_t q_min = INT64_MAX;
+    int64_t q_max = INT64_MIN;
+    size_t i;
+    for (i = 0; i < n; i++)
         {
-        return GSD_ERROR_INVALID_ARGUMENT;
+        double scaled = (double)data[i] / step;
+
+        // store non-finite values and values that overflow int64_t without encoding
+        if (!(scaled > -4.0e18 && scaled < 4.0e18))
+            {
+            return GSD_SUCCESS;
+            }
+
+        int64_t q = gsd_round_to_int64(scaled);
+        if (q < q_min)
+            {
+            q_min = q;
+            }
+        if (q > q_max)
+            {
+            q_max = q;
+            }
         }
 
-    // arrays of size 0 or 1 are already sorted
-    if (buf->size <= 1)
+    uint64_t range = (uint64_t)(q_max - q_min);
+    unsigned int bits = 0;
+    while (bits < 64 && (range >> bits) != 0)
+        {
+        bits++;
+        }
+
+    // quantized values with 32 or more bits are no smaller than the floats
+    if (bits >= 32)
         {
         return GSD_SUCCESS;
         }
 
-    gsd_heapify(buf);
+    size_t size = (n * bits + 7) / 8;
+    char* buf = gsd_malloc(size + 1);
+    if (buf == NULL)
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
 
-    size_t end = buf->size - 1;
-    while (end > 0)
+    // pack the values into a little endian bit stream
+    uint64_t accumulator = 0;
+    unsigned int n_accumulated = 0;
+    size_t out = 0;
+    for (i = 0; i < n; i++)
         {
-        gsd_heap_swap(buf, end, 0);
-        end = end - 1;
-        gsd_heap_shift_down(buf, 0, end);
+        uint64_t value = (uint64_t)(gsd_round_to_int64((double)data[i] / step) - q_min);
+        accumulator |= value << n_accumulated;
+        n_accumulated += bits;
+        while (n_accumulated >= 8)
+            {
+            buf[out++] = (char)(accumulator & 0xff);
+            accumulator >>= 8;
+            n_accumulated -= 8;
+            }
+        }
+    if (n_accumulated > 0)
+        {
+        buf[out++] = (char)(accumulator & 0xff);
         }
 
+    memcpy(&header->parameters[GSD_QUANTIZE_PARAMETER_STEP], &step, sizeof(double));
+    header->parameters[GSD_QUANTIZE_PARAMETER_MIN] = (uint64_t)q_min;
+    header->parameters[GSD_QUANTIZE_PARAMETER_BITS] = bits;
+
+    *packed = buf;
+    *packed_size = size;
     return GSD_SUCCESS;
     }
 
 /** @internal
-    @brief Utility function to expand the memory space for the index block in the file.
+    @brief Get the size of the packed values of a quantized chunk
 
-    @param handle Handle to the open gsd file.
-    @param size_required The new index must be able to hold at least this many elements.
+    @param header Chunk header.
+    @param n Number of values in the chunk.
 
-    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+    @returns The number of bytes of packed values, or SIZE_MAX when *header* is invalid.
 */
-inline static int gsd_expand_file_index(struct gsd_handle* handle, size_t size_required)
+inline static size_t gsd_quantized_size(const struct gsd_chunk_header* header, size_t n)
     {
-    if (handle->open_flags == GSD_OPEN_READONLY)
+    uint64_t bits = header->parameters[GSD_QUANTIZE_PARAMETER_BITS];
+    if (bits >= 32)
         {
-        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        return SIZE_MAX;
         }
+    return (n * bits + 7) / 8;
+    }
 
-    // multiply the index size each time it grows
-    // this allows the index to grow rapidly to accommodate new frames
-    const int multiplication_factor = 2;
-
-    // save the old size and update the new size
-    size_t size_old = handle->header.index_allocated_entries;
-    size_t size_new = size_old * multiplication_factor;
+/** @internal
+    @brief Reverse gsd_quantize()
 
-    while (size_new <= size_required)
+    @param data Output values.
+    @param packed Packed values with at least gsd_quantized_size() bytes.
+    @param header Chunk header with the quantization parameters.
+    @param n Number of values.
+*/
+inline static void gsd_dequantize(float* data,
+                                  const char* packed,
+                                  const struct gsd_chunk_header* header,
+                                  size_t n)
+    {
+    double step;
+    memcpy(&step, &header->parameters[GSD_QUANTIZE_PARAMETER_STEP], sizeof(double));
+    int64_t q_min = (int64_t)header->parameters[GSD_QUANTIZE_PARAMETER_MIN];
+    unsigned int bits = (unsigned int)header->parameters[GSD_QUANTIZE_PARAMETER_BITS];
+    uint64_t mask = (((uint64_t)1) << bits) - 1;
+
+    uint64_t accumulator = 0;
+    unsigned int n_accumulated = 0;
+    size_t in = 0;
+    size_t i;
+    for (i = 0; i < n; i++)
         {
-        size_new *= multiplication_factor;
+        while (n_accumulated < bits)
+            {
+            accumulator |= ((uint64_t)(unsigned char)packed[in++]) << n_accumulated;
+            n_accumulated += 8;
+            }
+        int64_t q = q_min + (int64_t)(accumulator & mask);
+        accumulator >>= bits;
+        n_accumulated -= bits;
+        data[i] = (float)((double)q * step);
         }
+    }
 
-    // Mac systems deadlock when writing from a mapped region into the tail end of that same region
-    // unmap the index first and copy it over by chunks
-    int retval = gsd_index_buffer_free(&handle->file_index);
-    if (retval != 0)
-        {
-        return retval;
-        }
+/** @internal
+    @brief Encode chunk data
 
-    // allocate the copy buffer
-    char* buf = malloc(GSD_COPY_BUFFER_SIZE);
+    @param encoded [out] Set to a newly allocated buffer with the chunk header and the encoded data,
+    or NULL when encoding does not reduce the size of the chunk.
+    @param encoded_size [out] Set to the number of bytes in *encoded*.
+    @param encoded_flags [out] Set to the encoding flags that apply to *encoded*.
+    @param data Chunk data.
+    @param size Number of bytes in *data*.
+    @param type Type of the elements in *data*.
+    @param flags Encoding flags.
+    @param level Compression level (0 selects the codec default).
+    @param precision Maximum absolute error of quantized values (used with GSD_FLAG_QUANTIZE).
 
-    // write the current index to the end of the file
-    int64_t new_index_location = lseek(handle->fd, 0, SEEK_END);
-    int64_t old_index_location = handle->header.index_location;
-    size_t total_bytes_written = 0;
-    size_t old_index_bytes = size_old * sizeof(struct gsd_index_entry);
-    while (total_bytes_written < old_index_bytes)
+    Each stage of the encoding that does not reduce the size of the chunk is skipped, so
+    *encoded_flags* may have fewer bits set than *flags*.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_encode_chunk(char** encoded,
+                                   size_t* encoded_size,
+                                   uint8_t* encoded_flags,
+                                   const void* data,
+                                   size_t size,
+                                   enum gsd_type type,
+                                   uint8_t flags,
+                                   int level,
+                                   double precision)
+    {
+    *encoded = NULL;
+    *encoded_size = 0;
+    *encoded_flags = 0;
+
+    uint8_t codec = flags & GSD_FLAG_CODEC_MASK;
+    size_t bound = 0;
+    if (codec != 0)
         {
-        size_t bytes_to_copy = GSD_COPY_BUFFER_SIZE;
-        if (old_index_bytes - total_bytes_written < GSD_COPY_BUFFER_SIZE)
+        bound = gsd_compress_bound(size, codec);
+        if (bound == 0)
             {
-            bytes_to_copy = old_index_bytes - total_bytes_written;
+            return GSD_ERROR_UNSUPPORTED_ENCODING;
             }
+        }
 
-        ssize_t bytes_read = gsd_io_pread_retry(handle->fd,
-                                                buf,
-                                                bytes_to_copy,
-                                                old_index_location + total_bytes_written);
+    struct gsd_chunk_header header;
+    gsd_util_zero_memory(&header, sizeof(struct gsd_chunk_header));
 
-        if (bytes_read == -1 || bytes_read != bytes_to_copy)
+    const char* input = (const char*)data;
+    size_t input_size = size;
+    uint8_t input_flags = 0;
+    char* quantized = NULL;
+    if (flags & GSD_FLAG_QUANTIZE)
+        {
+        size_t quantized_size = 0;
+        int retval = gsd_quantize(&quantized,
+                                  &quantized_size,
+                                  &header,
+                                  (const float*)data,
+                                  size / sizeof(float),
+                                  precision);
+        if (retval != GSD_SUCCESS)
             {
-            free(buf);
-            return GSD_ERROR_IO;
+            return retval;
             }
 
-        ssize_t bytes_written = gsd_io_pwrite_retry(handle->fd,
-                                                    buf,
-                                                    bytes_to_copy,
-                                                    new_index_location + total_bytes_written);
-
-        if (bytes_written == -1 || bytes_written != bytes_to_copy)
+        if (quantized == NULL)
             {
-            free(buf);
-            return GSD_ERROR_IO;
+            return GSD_SUCCESS;
             }
 
-        total_bytes_written += bytes_written;
+        input = quantized;
+        input_size = quantized_size;
+        input_flags = GSD_FLAG_QUANTIZE;
+        bound = gsd_compress_bound(input_size, codec);
         }
 
-    // fill the new index space with 0s
-    gsd_util_zero_memory(buf, GSD_COPY_BUFFER_SIZE);
+    char* buf
+        = gsd_malloc(sizeof(struct gsd_chunk_header) + (bound > input_size ? bound : input_size));
+    if (buf == NULL)
+        {
+        gsd_free(quantized);
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+    char* output = buf + sizeof(struct gsd_chunk_header);
+    size_t output_size = 0;
 
-    size_t new_index_bytes = size_new * sizeof(struct gsd_index_entry);
-    while (total_bytes_written < new_index_bytes)
+    if (codec != 0)
         {
-        size_t bytes_to_copy = GSD_COPY_BUFFER_SIZE;
-        if (new_index_bytes - total_bytes_written < GSD_COPY_BUFFER_SIZE)
+        // apply the shuffle filter
+        const char* compress_input = input;
+        char* shuffled = NULL;
+        size_t element_size = gsd_sizeof_type(type);
+        if ((flags & GSD_FLAG_SHUFFLE) && element_size > 1)
             {
-            bytes_to_copy = new_index_bytes - total_bytes_written;
+            shuffled = gsd_malloc(input_size);
+            if (shuffled == NULL)
+                {
+                gsd_free(quantized);
+                gsd_free(buf);
+                return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+                }
+            gsd_byte_shuffle(shuffled, input, input_size / element_size, element_size);
+            compress_input = shuffled;
             }
 
-        ssize_t bytes_written = gsd_io_pwrite_retry(handle->fd,
-                                                    buf,
-                                                    bytes_to_copy,
-                                                    new_index_location + total_bytes_written);
-
-        if (bytes_written == -1 || bytes_written != bytes_to_copy)
+        int retval = gsd_compress(output, &output_size, compress_input, input_size, codec, level);
+        gsd_free(shuffled);
+        if (retval != GSD_SUCCESS)
             {
-            free(buf);
-            return GSD_ERROR_IO;
+            gsd_free(quantized);
+            gsd_free(buf);
+            return retval;
             }
-
-        total_bytes_written += bytes_written;
         }
 
-    // sync the expanded index
-    retval = fsync(handle->fd);
-    if (retval != 0)
+    if (codec != 0 && output_size < input_size)
         {
-        free(buf);
-        return GSD_ERROR_IO;
+        *encoded_flags
+            = (uint8_t)(input_flags | (flags & (GSD_FLAG_CODEC_MASK | GSD_FLAG_SHUFFLE)));
         }
-
-    // free the copy buffer
-    free(buf);
-
-    // update the header
-    handle->header.index_location = new_index_location;
-    handle->file_size = handle->header.index_location + total_bytes_written;
-    handle->header.index_allocated_entries = size_new;
-
-    // write the new header out
-    ssize_t bytes_written
-        = gsd_io_pwrite_retry(handle->fd, &(handle->header), sizeof(struct gsd_header), 0);
-    if (bytes_written != sizeof(struct gsd_header))
+    else
         {
-        return GSD_ERROR_IO;
+        // store the quantized values without compression
+        memcpy(output, input, input_size);
+        output_size = input_size;
+        *encoded_flags = input_flags;
         }
 
-    // sync the updated header
-    retval = fsync(handle->fd);
-    if (retval != 0)
-        {
-        return GSD_ERROR_IO;
-        }
+    gsd_free(quantized);
 
-    // remap the file index
-    retval = gsd_index_buffer_map(&handle->file_index, handle);
-    if (retval != 0)
+    // store the chunk without encoding when it does not help
+    if (*encoded_flags == 0 || sizeof(struct gsd_chunk_header) + output_size >= size)
         {
-        return retval;
+        gsd_free(buf);
+        *encoded_flags = 0;
+        return GSD_SUCCESS;
         }
 
+    header.encoded_size = output_size;
+    memcpy(buf, &header, sizeof(struct gsd_chunk_header));
+
+    *encoded = buf;
+    *encoded_size = sizeof(struct gsd_chunk_header) + output_size;
     return GSD_SUCCESS;
     }
 
 /** @internal
-    @brief Flush the write buffer.
+    @brief Read and decode an encoded chunk
 
-    gsd_write_frame() writes small data chunks into the write buffer. It adds index entries for
-    these chunks to gsd_handle::buffer_index with locations offset from the start of the write
-    buffer. gsd_flush_write_buffer() writes the buffer to the end of the file, moves the index
-    entries to gsd_handle::frame_index and updates the location to reference the beginning of the
-    file.
+    @param handle Handle to the open gsd file.
+    @param data Data buffer to read into.
+    @param chunk Chunk to read (with non-zero flags).
+    @param header [out] Set to the chunk header.
 
-    @param handle Handle to flush the write buffer.
-    @returns GSD_SUCCESS on success or GSD_* error codes on error
+    Delta encoded chunks are not combined with their keyframe, see gsd_read_encoded_chunk().
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
 */
-inline static int gsd_flush_write_buffer(struct gsd_handle* handle)
+inline static int gsd_decode_chunk(struct gsd_handle* handle,
+                                   void* data,
+                                   const struct gsd_index_entry* chunk,
+                                   struct gsd_chunk_header* header_out)
     {
-    if (handle == NULL)
+    if (!gsd_is_encoding_valid(chunk->flags)
+        || ((chunk->flags & GSD_FLAG_QUANTIZE) && chunk->type != GSD_TYPE_FLOAT))
         {
-        return GSD_ERROR_INVALID_ARGUMENT;
+        return GSD_ERROR_FILE_CORRUPT;
         }
 
-    if (handle->write_buffer.size == 0 && handle->buffer_index.size == 0)
-        {
-        // nothing to do
-        return GSD_SUCCESS;
-        }
+    size_t element_size = gsd_sizeof_type((enum gsd_type)chunk->type);
+    size_t n = chunk->N * chunk->M;
+    size_t size = n * element_size;
 
-    if (handle->write_buffer.size > 0 && handle->buffer_index.size == 0)
+    // read the chunk header
+    struct gsd_chunk_header header;
+    if (chunk->location + sizeof(struct gsd_chunk_header) > (uint64_t)handle->file_size)
         {
-        // error: bytes in buffer, but no index for them
-        return GSD_ERROR_INVALID_ARGUMENT;
+        return GSD_ERROR_FILE_CORRUPT;
         }
 
-    // write the buffer to the end of the file
-    uint64_t offset = handle->file_size;
-    ssize_t bytes_written = gsd_io_pwrite_retry(handle->fd,
-                                                handle->write_buffer.data,
-                                                handle->write_buffer.size,
-                                                offset);
-
-    if (bytes_written == -1 || bytes_written != handle->write_buffer.size)
+    ssize_t bytes_read
+        = gsd_handle_pread(handle, &header, sizeof(struct gsd_chunk_header), chunk->location);
+    if (bytes_read == -1 || bytes_read != sizeof(struct gsd_chunk_header))
         {
         return GSD_ERROR_IO;
         }
 
-    handle->file_size += handle->write_buffer.size;
-
-    // reset write_buffer for new data
-    handle->write_buffer.size = 0;
-
-    // move buffer_index entries to file_index
-    size_t i;
-    for (i = 0; i < handle->buffer_index.size; i++)
-        {
-        struct gsd_index_entry* new_index;
-        int retval = gsd_index_buffer_add(&handle->frame_index, &new_index);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
-
-        *new_index = handle->buffer_index.data[i];
-        new_index->location += offset;
-        }
-
-    // clear the buffer index for new entries
-    handle->buffer_index.size = 0;
-
-    return GSD_SUCCESS;
-    }
-
-/** @internal
-    @brief Flush the name buffer.
-
-    gsd_write_frame() adds new names to the frame_names buffer. gsd_flush_name_buffer() flushes
-    this buffer at the end of a frame write and commits the new names to the file. If necessary,
-    the namelist is written to a new location in the file.
-
-    @param handle Handle to flush the write buffer.
-    @returns GSD_SUCCESS on success or GSD_* error codes on error
-*/
-inline static int gsd_flush_name_buffer(struct gsd_handle* handle)
-    {
-    if (handle == NULL)
+    int64_t encoded_location = chunk->location + sizeof(struct gsd_chunk_header);
+    if (header.encoded_size > (uint64_t)(handle->file_size - encoded_location))
         {
-        return GSD_ERROR_INVALID_ARGUMENT;
+        return GSD_ERROR_FILE_CORRUPT;
         }
+    *header_out = header;
 
-    if (handle->frame_names.n_names == 0)
+    // size of the data before compression
+    bool quantized = (chunk->flags & GSD_FLAG_QUANTIZE) != 0;
+    size_t stage_size = size;
+    if (quantized)
         {
-        // nothing to do
-        return GSD_SUCCESS;
+        stage_size = gsd_quantized_size(&header, n);
+        if (stage_size == SIZE_MAX)
+            {
+            return GSD_ERROR_FILE_CORRUPT;
+            }
         }
 
-    if (handle->frame_names.data.size == 0)
+    uint8_t codec = chunk->flags & GSD_FLAG_CODEC_MASK;
+    if (codec == 0 && header.encoded_size != stage_size)
         {
-        // error: bytes in buffer, but no names for them
-        return GSD_ERROR_INVALID_ARGUMENT;
+        return GSD_ERROR_FILE_CORRUPT;
         }
 
-    size_t old_reserved = handle->file_names.data.reserved;
-    size_t old_size = handle->file_names.data.size;
-
-    // add the new names to the file name list and zero the frame list
-    int retval = gsd_byte_buffer_append(&handle->file_names.data,
-                                        handle->frame_names.data.data,
-                                        handle->frame_names.data.size);
-    if (retval != GSD_SUCCESS)
+    // read the encoded data
+    char* encoded = gsd_malloc(header.encoded_size + 1);
+    if (encoded == NULL)
         {
-        return retval;
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
         }
 
-    handle->file_names.n_names += handle->frame_names.n_names;
-    handle->frame_names.n_names = 0;
-    handle->frame_names.data.size = 0;
-    gsd_util_zero_memory(handle->frame_names.data.data, handle->frame_names.data.reserved);
-
-    // reserved space must be a multiple of the GSD name size
-    if (handle->file_names.data.reserved % GSD_NAME_SIZE != 0)
+    bytes_read = gsd_handle_pread(handle, encoded, header.encoded_size, encoded_location);
+    if (bytes_read == -1 || (size_t)bytes_read != header.encoded_size)
         {
-        return GSD_ERROR_INVALID_ARGUMENT;
+        gsd_free(encoded);
+        return GSD_ERROR_IO;
         }
 
-    if (handle->file_names.data.reserved > old_reserved)
+    char* stage = encoded;
+    int retval = GSD_SUCCESS;
+    if (codec != 0)
         {
-        // write the new name list to the end of the file
-        uint64_t offset = handle->file_size;
-        ssize_t bytes_written = gsd_io_pwrite_retry(handle->fd,
-                                                    handle->file_names.data.data,
-                                                    handle->file_names.data.reserved,
-                                                    offset);
-
-        if (bytes_written == -1 || bytes_written != handle->file_names.data.reserved)
-            {
-            return GSD_ERROR_IO;
-            }
-
-        // sync the updated name list
-        retval = fsync(handle->fd);
-        if (retval != 0)
+        // decompress into a temporary buffer when further decoding is needed
+        bool shuffled = (chunk->flags & GSD_FLAG_SHUFFLE) && element_size > 1;
+        stage = (char*)data;
+        if (shuffled || quantized)
             {
-            return GSD_ERROR_IO;
+            stage = gsd_malloc(stage_size + 1);
+            if (stage == NULL)
+                {
+                gsd_free(encoded);
+                return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+                }
             }
 
-        handle->file_size += handle->file_names.data.reserved;
-        handle->header.namelist_location = offset;
-        handle->header.namelist_allocated_entries
-            = handle->file_names.data.reserved / GSD_NAME_SIZE;
+        retval = gsd_decompress(stage, stage_size, encoded, header.encoded_size, codec);
+        gsd_free(encoded);
+        encoded = NULL;
 
-        // write the new header out
-        bytes_written
-            = gsd_io_pwrite_retry(handle->fd, &(handle->header), sizeof(struct gsd_header), 0);
-        if (bytes_written != sizeof(struct gsd_header))
+        if (retval == GSD_SUCCESS && shuffled)
             {
-            return GSD_ERROR_IO;
+            gsd_byte_unshuffle((char*)data, stage, size / element_size, element_size);
             }
         }
-    else
+
+    if (retval == GSD_SUCCESS && quantized)
         {
-        // write the new name list to the old index location
-        uint64_t offset = handle->header.namelist_location;
-        ssize_t bytes_written = gsd_io_pwrite_retry(handle->fd,
-                                                    handle->file_names.data.data + old_size,
-                                                    handle->file_names.data.reserved - old_size,
-                                                    offset + old_size);
-        if (bytes_written != (handle->file_names.data.reserved - old_size))
-            {
-            return GSD_ERROR_IO;
-            }
+        gsd_dequantize((float*)data, stage, &header, n);
         }
 
-    // sync the updated name list or header
-    retval = fsync(handle->fd);
-    if (retval != 0)
+    if (stage != (char*)data)
         {
-        return GSD_ERROR_IO;
+        gsd_free(stage);
         }
 
-    return GSD_SUCCESS;
+    return retval;
     }
 
 /** @internal
-    @brief utility function to append a name to the namelist
+    @brief Index entry in the layout of v3.1 files
 
-    @param id [out] ID of the new name
-    @param handle handle to the open gsd file
-    @param name string name
+    v3.1 files store a 32-bit id followed by a 16-bit M. The entry has the size of gsd_index_entry
+    and the other members are at the same offsets.
+*/
+struct gsd_wide_id_entry
+    {
+    uint64_t frame;
+    uint64_t N;
+    int64_t location;
+    uint32_t id;
+    uint16_t M;
+    uint8_t type;
+    uint8_t flags;
+    };
 
-    Append a name to the names in the current frame. gsd_end_frame() will add this list to the
-    file names.
+/** @internal
+    @brief Test if the file stores 32-bit name ids
 
-    @return
-      - GSD_SUCCESS (0) on success. Negative value on failure:
-      - GSD_ERROR_IO: IO error (check errno).
-      - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
-      - GSD_ERROR_FILE_MUST_BE_WRITABLE: File must not be read only.
+    @param handle handle to the open gsd file
+
+    @returns 1 if the file stores index entries in the v3.1 layout, 0 if it does not
 */
-inline static int gsd_append_name(uint16_t* id, struct gsd_handle* handle, const char* name)
+inline static int gsd_has_wide_ids(const struct gsd_handle* handle)
     {
+    return handle->header.gsd_version
+           >= gsd_make_version(GSD_WIDE_ID_FILE_VERSION, GSD_WIDE_ID_FILE_VERSION_MINOR);
+    }
+
+/** @internal
+    @brief Get the name id of an index entry
+
+    @param handle handle to the open gsd file
+    @param entry Entry of an index buffer of *handle*.
+
+    Every id fits in gsd_index_entry::id in files without 32-bit name ids, whose file index may be
+    mapped. The index buffers of other files hold gsd_index_record values.
+
+    @returns The name id, which gsd_index_entry::id holds only when it fits in 16 bits.
+*/
+inline static uint32_t gsd_entry_id(const struct gsd_handle* handle,
+                                    const struct gsd_index_entry* entry)
+    {
+    if (!gsd_has_wide_ids(handle))
+        {
+        return entry->id;
+        }
+    return ((const struct gsd_index_record*)entry)->id;
+    }
+
+/** @internal
+    @brief Set the name id of an index record
+
+    @param record Record to update.
+    @param id Name id.
+*/
+inline static void gsd_index_record_set_id(struct gsd_index_record* record, uint32_t id)
+    {
+    record->id = id;
+    record->entry.id = id < UINT16_MAX ? (uint16_t)id : UINT16_MAX;
+    }
+
+/** @internal
+    @brief Convert index entries read from the file to index records in place
+
+    @param records Records to convert, the first `n * sizeof(struct gsd_index_entry)` bytes hold
+    the entries as read from the file.
+    @param n Number of entries.
+    @param wide Set to non-zero when the entries are in the layout of v3.1 files.
+
+    Converts the entries from last to first, so that each entry is read before a record overwrites
+    it.
+*/
+inline static void gsd_index_records_from_file(struct gsd_index_record* records, size_t n, int wide)
+    {
+    const char* raw = (const char*)records;
+    size_t i;
+    for (i = n; i > 0; i--)
+        {
+        struct gsd_index_record* record = &records[i - 1];
+        if (wide)
+            {
+            struct gsd_wide_id_entry file_entry;
+            memcpy(&file_entry, raw + sizeof(struct gsd_index_entry) * (i - 1), sizeof(file_entry));
+            record->entry.frame = file_entry.frame;
+            record->entry.N = file_entry.N;
+            record->entry.location = file_entry.location;
+            record->entry.M = file_entry.M;
+            record->entry.type = file_entry.type;
+            record->entry.flags = file_entry.flags;
+            gsd_index_record_set_id(record, file_entry.id);
+            }
+        else
+            {
+            struct gsd_index_entry file_entry;
+            memcpy(&file_entry, raw + sizeof(struct gsd_index_entry) * (i - 1), sizeof(file_entry));
+            record->entry = file_entry;
+            record->id = file_entry.id;
+            }
+        }
+    }
+
+/** @internal
+    @brief Convert index records to the layout of index entries in the file
+
+    @param dest Destination for `n * sizeof(struct gsd_index_entry)` bytes, which may be *records*.
+    @param records Records to convert.
+    @param n Number of records.
+    @param wide Set to non-zero to convert to the layout of v3.1 files.
+
+    @pre Every id fits in the layout, and every M fits in the layout of v3.1 files when *wide* is
+    set.
+*/
+inline static void gsd_index_records_to_file(char* dest,
+                                             const struct gsd_index_record* records,
+                                             size_t n,
+                                             int wide)
+    {
+    size_t i;
+    for (i = 0; i < n; i++)
+        {
+        if (wide)
+            {
+            struct gsd_wide_id_entry file_entry;
+            file_entry.frame = records[i].entry.frame;
+            file_entry.N = records[i].entry.N;
+            file_entry.location = records[i].entry.location;
+            file_entry.id = records[i].id;
+            file_entry.M = (uint16_t)records[i].entry.M;
+            file_entry.type = records[i].entry.type;
+            file_entry.flags = records[i].entry.flags;
+            memcpy(dest + sizeof(struct gsd_index_entry) * i, &file_entry, sizeof(file_entry));
+            }
+        else
+            {
+            struct gsd_index_entry file_entry = records[i].entry;
+            memcpy(dest + sizeof(struct gsd_index_entry) * i, &file_entry, sizeof(file_entry));
+            }
+        }
+    }
+
+/** @internal
+    @brief Utility function to validate index entry
+    @param handle handle to the open gsd file
+    @param entry entry of the file index to validate
+
+    @returns 1 if the entry is valid, 0 if it is not
+*/
+inline static int gsd_is_entry_valid(struct gsd_handle* handle,
+                                     const struct gsd_index_entry* entry)
+    {
+    // check for valid type
+    if (gsd_sizeof_type((enum gsd_type)entry->type) == 0)
+        {
+        return 0;
+        }
+
+    // validate that we don't read past the end of the file
+    size_t size = entry->N * entry->M * gsd_sizeof_type((enum gsd_type)entry->type);
+    if (entry->flags != 0)
+        {
+        // encoded chunks start with a header that gives the encoded size
+        size = sizeof(struct gsd_chunk_header);
+        }
+    if ((entry->location + size) > (uint64_t)handle->file_size)
+        {
+        return 0;
+        }
+
+    // check for valid frame (frame cannot be more than the number of index entries)
+    if (entry->frame >= handle->file_index.reserved)
+        {
+        return 0;
+        }
+
+    // check for valid id
+    if (gsd_entry_id(handle, entry) >= (handle->file_names.n_names + handle->frame_names.n_names))
+        {
+        return 0;
+        }
+
+    // check for valid flags
+    if (!gsd_is_encoding_valid(entry->flags))
+        {
+        return 0;
+        }
+    if ((entry->flags & GSD_FLAG_QUANTIZE) && entry->type != GSD_TYPE_FLOAT)
+        {
+        return 0;
+        }
+
+    return 1;
+    }
+
+/** @internal
+    @brief Allocate a write buffer
+
+    @param buf Buffer to allocate.
+    @param reserve Number of bytes to allocate.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_byte_buffer_allocate(struct gsd_byte_buffer* buf, size_t reserve)
+    {
+    if (buf == NULL || buf->data || reserve == 0 || buf->reserved != 0 || buf->size != 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    buf->data = gsd_calloc(reserve, sizeof(char));
+    if (buf->data == NULL)
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    buf->size = 0;
+    buf->reserved = reserve;
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Append bytes to a byte buffer
+
+    @param buf Buffer to append to.
+    @param data Data to append.
+    @param size Number of bytes in *data*.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_byte_buffer_append(struct gsd_byte_buffer* buf, const char* data, size_t size)
+    {
+    if (buf == NULL || buf->data == NULL || size == 0 || buf->reserved == 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    if (buf->size + size > buf->reserved)
+        {
+        // reallocate by doubling
+        size_t new_reserved = buf->reserved * 2;
+        while (buf->size + size >= new_reserved)
+            {
+            new_reserved = new_reserved * 2;
+            }
+
+        char* old_data = buf->data;
+        buf->data = gsd_realloc(buf->data, sizeof(char) * new_reserved);
+        if (buf->data == NULL)
+            {
+            // this free should not be necessary, but clang-tidy disagrees
+            gsd_free(old_data);
+            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+
+        // zero the new memory, but only the portion after the end of the new section to be appended
+        gsd_util_zero_memory(buf->data + (buf->size + size),
+                             sizeof(char) * (new_reserved - (buf->size + size)));
+        buf->reserved = new_reserved;
+        }
+
+    memcpy(buf->data + buf->size, data, size);
+    buf->size += size;
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Free the memory allocated by the write buffer or unmap the mapped memory.
+
+    @param buf Buffer to free.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_byte_buffer_free(struct gsd_byte_buffer* buf)
+    {
+    if (buf == NULL || buf->data == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    gsd_free(buf->data);
+
+    gsd_util_zero_memory(buf, sizeof(struct gsd_byte_buffer));
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Allocate a buffer of index entries
+
+    @param buf Buffer to allocate.
+    @param reserve Number of entries to allocate.
+
+    @post The buffer's data element has *reserve* elements allocated in memory.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_index_buffer_allocate(struct gsd_index_buffer* buf, size_t reserve)
+    {
+    if (buf == NULL || buf->mapped_data || buf->data || buf->pages || reserve == 0
+        || buf->reserved != 0 || buf->size != 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    buf->data = gsd_calloc(reserve, sizeof(struct gsd_index_record));
+    if (buf->data == NULL)
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    buf->size = 0;
+    buf->reserved = reserve;
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Validate the index segment table
+
+    @param handle GSD file handle.
+    @param header File header that gives the location of the table.
+    @param segments Segment table read from the file.
+    @param n_segments [out] Number of segments in the table.
+
+    @pre gsd_handle::file_size is set.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_check_index_segments(struct gsd_handle* handle,
+                                           const struct gsd_header* header,
+                                           const struct gsd_index_segment* segments,
+                                           size_t* n_segments)
+    {
+    // the first segment is the index block in the header
+    if (segments[0].location != header->index_location
+        || segments[0].allocated_entries != header->index_allocated_entries)
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    // a segment with location 0 ends the table
+    uint64_t total_entries = 0;
+    size_t n = 0;
+    while (n < GSD_INDEX_SEGMENT_TABLE_SIZE && segments[n].location != 0)
+        {
+        const struct gsd_index_segment segment = segments[n];
+        if (segment.allocated_entries == 0
+            || segment.allocated_entries > SIZE_MAX / sizeof(struct gsd_index_entry)
+            || segment.location
+                       + sizeof(struct gsd_index_entry) * segment.allocated_entries
+                   > (uint64_t)handle->file_size)
+            {
+            return GSD_ERROR_FILE_CORRUPT;
+            }
+
+        total_entries += segment.allocated_entries;
+        if (total_entries > SIZE_MAX / sizeof(struct gsd_index_entry))
+            {
+            return GSD_ERROR_FILE_CORRUPT;
+            }
+        n++;
+        }
+
+    *n_segments = n;
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Read the index segment table from the file
+
+    @param handle GSD file handle.
+    @param header File header that gives the location of the table.
+    @param segments [out] Segments of the index.
+    @param n_segments [out] Number of segments, 0 when the index is one block.
+
+    @pre gsd_handle::file_size is set.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_read_index_segments(struct gsd_handle* handle,
+                                          const struct gsd_header* header,
+                                          struct gsd_index_segment* segments,
+                                          size_t* n_segments)
+    {
+    *n_segments = 0;
+    if (header->gsd_version < gsd_make_version(GSD_CHAINED_INDEX_FILE_VERSION, 0)
+        || header->index_segments_location == 0)
+        {
+        return GSD_SUCCESS;
+        }
+
+    // validate that the segment table exists inside the file
+    size_t table_size = sizeof(struct gsd_index_segment) * GSD_INDEX_SEGMENT_TABLE_SIZE;
+    if (header->index_segments_location + table_size > (uint64_t)handle->file_size)
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    ssize_t bytes_read
+        = gsd_handle_pread(handle, segments, table_size, header->index_segments_location);
+    if (bytes_read == -1 || bytes_read != table_size)
+        {
+        return GSD_ERROR_IO;
+        }
+
+    return gsd_check_index_segments(handle, header, segments, n_segments);
+    }
+
+/** @internal
+    @brief Read a range of index entries from the file
+
+    @param dest Destination for the entries.
+    @param handle GSD file handle.
+    @param segments Segments of the index in the file.
+    @param n_segments Number of segments.
+    @param position Position of the first entry to read.
+    @param n Number of entries to read.
+
+    Splits the read at segment boundaries. The entries are not converted to index records.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_read_index_entries(char* dest,
+                                         struct gsd_handle* handle,
+                                         const struct gsd_index_segment* segments,
+                                         size_t n_segments,
+                                         size_t position,
+                                         size_t n)
+    {
+    // find the segment that holds position
+    size_t segment_begin = 0;
+    size_t i = 0;
+    while (i < n_segments && position >= segment_begin + segments[i].allocated_entries)
+        {
+        segment_begin += segments[i].allocated_entries;
+        i++;
+        }
+
+    while (n > 0)
+        {
+        if (i >= n_segments)
+            {
+            return GSD_ERROR_INVALID_ARGUMENT;
+            }
+
+        size_t n_to_read = segment_begin + segments[i].allocated_entries - position;
+        if (n_to_read > n)
+            {
+            n_to_read = n;
+            }
+        size_t bytes_to_read = sizeof(struct gsd_index_entry) * n_to_read;
+
+        ssize_t bytes_read = gsd_handle_pread(handle,
+                                              dest,
+                                              bytes_to_read,
+                                              segments[i].location
+                                                  + sizeof(struct gsd_index_entry)
+                                                        * (position - segment_begin));
+        if (bytes_read == -1 || bytes_read != bytes_to_read)
+            {
+            return GSD_ERROR_IO;
+            }
+
+        dest += bytes_to_read;
+        n -= n_to_read;
+        position += n_to_read;
+        segment_begin += segments[i].allocated_entries;
+        i++;
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Get the number of pages that hold the entries of a paged index buffer
+
+    @param reserved Number of entries in the buffer.
+
+    @returns The number of pages.
+*/
+inline static size_t gsd_index_buffer_page_count(size_t reserved)
+    {
+    return (reserved + GSD_INDEX_PAGE_SIZE - 1) / GSD_INDEX_PAGE_SIZE;
+    }
+
+/** @internal
+    @brief Page an index buffer
+
+    @param buf Buffer to page, either empty or already paged.
+    @param reserved Number of entries in the index in the file.
+
+    Allocates the page table of an empty buffer, or grows the page table of a paged buffer and
+    keeps the pages that are loaded. No page is read.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_index_buffer_page(struct gsd_index_buffer* buf, size_t reserved)
+    {
+    if (buf == NULL || buf->data || buf->mapped_data || reserved == 0 || reserved < buf->reserved)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    size_t n_pages_old = buf->pages != NULL ? gsd_index_buffer_page_count(buf->reserved) : 0;
+    size_t n_pages = gsd_index_buffer_page_count(reserved);
+    if (buf->pages == NULL || n_pages > n_pages_old)
+        {
+        struct gsd_index_record** pages
+            = gsd_realloc(buf->pages, sizeof(struct gsd_index_record*) * n_pages);
+        if (pages == NULL)
+            {
+            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+
+        gsd_util_zero_memory(pages + n_pages_old,
+                             sizeof(struct gsd_index_record*) * (n_pages - n_pages_old));
+        buf->pages = pages;
+        }
+
+    buf->reserved = reserved;
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Load a page table slot.
+
+    @param slot Slot to load.
+
+    Readers that share a read-only handle load pages concurrently. The acquire pairs with the
+    release in gsd_index_page_publish() so that the entries of a page are visible to the readers
+    that find it.
+
+    @returns The page in the slot, NULL when the page is not loaded.
+*/
+inline static struct gsd_index_record* gsd_index_page_load(struct gsd_index_record* const* slot)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+#else
+    return *(struct gsd_index_record* const volatile*)slot;
+#endif
+    }
+
+/** @internal
+    @brief Store a page in an empty page table slot.
+
+    @param slot Slot to store the page in.
+    @param page Page to store.
+
+    When another reader stored a page in the slot first, that page is kept.
+
+    @returns The page in the slot.
+*/
+inline static struct gsd_index_record* gsd_index_page_publish(struct gsd_index_record** slot,
+                                                              struct gsd_index_record* page)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+    struct gsd_index_record* expected = NULL;
+    if (!__atomic_compare_exchange_n(slot,
+                                     &expected,
+                                     page,
+                                     false,
+                                     __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE))
+        {
+        return expected;
+        }
+    return page;
+#elif defined(_MSC_VER)
+    struct gsd_index_record* expected
+        = _InterlockedCompareExchangePointer((void* volatile*)slot, page, NULL);
+    return expected != NULL ? expected : page;
+#else
+    *(struct gsd_index_record* volatile*)slot = page;
+    return page;
+#endif
+    }
+
+/** @internal
+    @brief Read a page of a paged index buffer from the file
+
+    @param buf Paged buffer.
+    @param handle GSD file handle with *buf* as its file index.
+    @param page_index Page to read.
+    @param page [out] Set to the page.
+
+    Converts the entries to index records and stores the page in the page table.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_index_buffer_read_page(struct gsd_index_buffer* buf,
+                                             struct gsd_handle* handle,
+                                             size_t page_index,
+                                             struct gsd_index_record** page)
+    {
+    // the part of the last page past the end of the index reads as empty entries
+    struct gsd_index_record* data
+        = gsd_calloc(GSD_INDEX_PAGE_SIZE, sizeof(struct gsd_index_record));
+    if (data == NULL)
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    size_t position = page_index * GSD_INDEX_PAGE_SIZE;
+    size_t n = buf->reserved - position;
+    if (n > GSD_INDEX_PAGE_SIZE)
+        {
+        n = GSD_INDEX_PAGE_SIZE;
+        }
+
+    struct gsd_index_segment block;
+    const struct gsd_index_segment* segments = handle->index_segments;
+    size_t n_segments = handle->n_index_segments;
+    if (n_segments == 0)
+        {
+        block.location = handle->header.index_location;
+        block.allocated_entries = handle->header.index_allocated_entries;
+        segments = &block;
+        n_segments = 1;
+        }
+
+    int retval = gsd_read_index_entries((char*)data, handle, segments, n_segments, position, n);
+    if (retval != GSD_SUCCESS)
+        {
+        gsd_free(data);
+        return retval;
+        }
+    gsd_index_records_from_file(data, n, gsd_has_wide_ids(handle));
+
+    *page = gsd_index_page_publish(&buf->pages[page_index], data);
+    if (*page != data)
+        {
+        gsd_free(data);
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Get an entry of an index buffer
+
+    @param buf Buffer to access.
+    @param handle GSD file handle with *buf* as its file index.
+    @param position Position of the entry.
+    @param entry [out] Set to point to the entry.
+
+    Reads the page that holds the entry when the buffer is paged and the page is not yet loaded.
+    Loaded pages stay in memory until the buffer is freed, so *entry* remains valid as long as the
+    entries of a mapped buffer do. *entry* is the entry of a gsd_index_record unless the buffer is
+    mapped. Safe to call from several threads on a read-only handle.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_index_buffer_get(struct gsd_index_buffer* buf,
+                                       struct gsd_handle* handle,
+                                       size_t position,
+                                       const struct gsd_index_entry** entry)
+    {
+    if (position >= buf->reserved)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    if (buf->mapped_entries != NULL)
+        {
+        *entry = &buf->mapped_entries[position];
+        return GSD_SUCCESS;
+        }
+
+    if (buf->pages == NULL)
+        {
+        *entry = &buf->data[position].entry;
+        return GSD_SUCCESS;
+        }
+
+    size_t page_index = position / GSD_INDEX_PAGE_SIZE;
+    struct gsd_index_record* page = gsd_index_page_load(&buf->pages[page_index]);
+    if (page == NULL)
+        {
+        int retval = gsd_index_buffer_read_page(buf, handle, page_index, &page);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    *entry = &page[position % GSD_INDEX_PAGE_SIZE].entry;
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Store entries in an index buffer
+
+    @param buf Buffer to update.
+    @param position Position of the first entry.
+    @param entries Entries to store.
+    @param n Number of entries.
+
+    Copies the entries into the loaded pages of a paged buffer, the other pages read the entries
+    from the file when they are loaded. A mapped buffer shows the entries once they are written to
+    the file.
+
+    @pre The entries are written to the file, or queued to be written before the next read.
+    @pre `position + n <= buf->reserved`
+*/
+inline static void gsd_index_buffer_store(struct gsd_index_buffer* buf,
+                                          size_t position,
+                                          const struct gsd_index_record* entries,
+                                          size_t n)
+    {
+    if (buf->mapped_entries != NULL)
+        {
+        return;
+        }
+
+    if (buf->pages == NULL)
+        {
+        memcpy(buf->data + position, entries, sizeof(struct gsd_index_record) * n);
+        return;
+        }
+
+    while (n > 0)
+        {
+        size_t offset = position % GSD_INDEX_PAGE_SIZE;
+        size_t n_page = GSD_INDEX_PAGE_SIZE - offset;
+        if (n_page > n)
+            {
+            n_page = n;
+            }
+
+        struct gsd_index_record* page = buf->pages[position / GSD_INDEX_PAGE_SIZE];
+        if (page != NULL)
+            {
+            memcpy(page + offset, entries, sizeof(struct gsd_index_record) * n_page);
+            }
+
+        position += n_page;
+        entries += n_page;
+        n -= n_page;
+        }
+    }
+
+/** @internal
+    @brief Forget the loaded pages of a paged index buffer
+
+    @param buf Paged buffer.
+    @param position Position of the first entry to forget.
+
+    The pages that hold the entries from *position* on are read from the file again when they are
+    next accessed.
+*/
+inline static void gsd_index_buffer_drop_pages(struct gsd_index_buffer* buf, size_t position)
+    {
+    if (buf->pages == NULL)
+        {
+        return;
+        }
+
+    size_t n_pages = gsd_index_buffer_page_count(buf->reserved);
+    size_t i;
+    for (i = position / GSD_INDEX_PAGE_SIZE; i < n_pages; i++)
+        {
+        gsd_free(buf->pages[i]);
+        buf->pages[i] = NULL;
+        }
+    }
+
+/** @internal
+    @brief Map index entries from the file
+
+    @param buf Buffer to map.
+    @param handle GSD file handle to map.
+    @param size_hint Number of index entries recorded by a frame table, 0 when unknown.
+
+    @post The buffer's entries map the index data from the file, or the buffer is paged.
+
+    On some systems, this will use mmap to efficiently access the file. On others, it pages the
+    buffer so that the entries are read on demand with gsd_index_buffer_get(), and memory grows
+    with the entries accessed rather than with the space allocated for the index. A chained index
+    and the index of a v3.1 file are always paged, and the pages are converted to index records as
+    they are read. The number of entries is *size_hint* when the entries confirm it and is found by
+    a binary search of the index otherwise.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int
+gsd_index_buffer_map(struct gsd_index_buffer* buf, struct gsd_handle* handle, size_t size_hint)
+    {
+    if (buf == NULL || buf->mapped_data || buf->data || buf->pages || buf->reserved != 0
+        || buf->size != 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    size_t reserved = 0;
+    if (handle->n_index_segments > 0)
+        {
+        size_t i;
+        for (i = 0; i < handle->n_index_segments; i++)
+            {
+            reserved += handle->index_segments[i].allocated_entries;
+            }
+        }
+    else
+        {
+        // validate that the index block exists inside the file
+        if (handle->header.index_location
+                + sizeof(struct gsd_index_entry) * handle->header.index_allocated_entries
+            > (uint64_t)handle->file_size)
+            {
+            return GSD_ERROR_FILE_CORRUPT;
+            }
+        reserved = handle->header.index_allocated_entries;
+
+#if GSD_USE_MMAP
+        if (!gsd_has_wide_ids(handle) && reserved > 0)
+            {
+            // map the index in read only mode
+            size_t page_size = sysconf(_SC_PAGESIZE);
+            size_t index_size = sizeof(struct gsd_index_entry) * reserved;
+            size_t offset = (handle->header.index_location / page_size) * page_size;
+            buf->mapped_data = mmap(NULL,
+                                    index_size + (handle->header.index_location - offset),
+                                    PROT_READ,
+                                    MAP_SHARED,
+                                    handle->fd,
+                                    offset);
+
+            if (buf->mapped_data == MAP_FAILED)
+                {
+                buf->mapped_data = NULL;
+                return GSD_ERROR_IO;
+                }
+
+            buf->mapped_entries
+                = (const struct gsd_index_entry*)(((char*)buf->mapped_data)
+                                                  + (handle->header.index_location - offset));
+            buf->mapped_len = index_size + (handle->header.index_location - offset);
+            buf->reserved = reserved;
+            }
+#endif
+        }
+
+    if (reserved == 0)
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    int retval = GSD_SUCCESS;
+    if (buf->mapped_data == NULL)
+        {
+        // mmap not supported or entries need conversion, read the entries from the disk on demand
+        retval = gsd_index_buffer_page(buf, reserved);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    // determine the number of index entries in the list
+    // file is corrupt if first index entry is invalid
+    const struct gsd_index_entry* first;
+    retval = gsd_index_buffer_get(buf, handle, 0, &first);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    if (first->location != 0 && !gsd_is_entry_valid(handle, first))
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    // the last entry must be valid and the next one empty, as recorded by the frame table
+    int hint_valid = 0;
+    if (first->location != 0 && size_hint > 0 && size_hint <= buf->reserved)
+        {
+        const struct gsd_index_entry* entry;
+        retval = gsd_index_buffer_get(buf, handle, size_hint - 1, &entry);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        hint_valid = entry->location != 0 && gsd_is_entry_valid(handle, entry);
+
+        if (hint_valid && size_hint < buf->reserved)
+            {
+            retval = gsd_index_buffer_get(buf, handle, size_hint, &entry);
+            if (retval != GSD_SUCCESS)
+                {
+                return retval;
+                }
+            hint_valid = entry->location == 0;
+            }
+        }
+
+    if (first->location == 0)
+        {
+        buf->size = 0;
+        }
+    else if (hint_valid)
+        {
+        buf->size = size_hint;
+        }
+    else
+        {
+        // determine the number of index entries (marked by location = 0)
+        // binary search for the first index entry with location 0
+        size_t L = 0;
+        size_t R = buf->reserved;
+        const struct gsd_index_entry* entry_L = first;
+
+        // progressively narrow the search window by halves
+        do
+            {
+            size_t m = (L + R) / 2;
+            const struct gsd_index_entry* entry_m;
+            retval = gsd_index_buffer_get(buf, handle, m, &entry_m);
+            if (retval != GSD_SUCCESS)
+                {
+                return retval;
+                }
+
+            // file is corrupt if any index entry is invalid or frame does not increase
+            // monotonically
+            if (entry_m->location != 0
+                && (!gsd_is_entry_valid(handle, entry_m) || entry_m->frame < entry_L->frame))
+                {
+                return GSD_ERROR_FILE_CORRUPT;
+                }
+
+            if (entry_m->location != 0)
+                {
+                L = m;
+                entry_L = entry_m;
+                }
+            else
+                {
+                R = m;
+                }
+            } while ((R - L) > 1);
+
+        // this finds R = the first index entry with location = 0
+        buf->size = R;
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Free the memory allocated by the index buffer or unmap the mapped memory.
+
+    @param buf Buffer to free.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_index_buffer_free(struct gsd_index_buffer* buf)
+    {
+    if (buf == NULL || (buf->data == NULL && buf->pages == NULL && buf->mapped_data == NULL))
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+#if GSD_USE_MMAP
+    if (buf->mapped_data)
+        {
+        int retval = munmap(buf->mapped_data, buf->mapped_len);
+
+        if (retval != 0)
+            {
+            return GSD_ERROR_IO;
+            }
+        }
+    else
+#endif
+        {
+        if (buf->pages != NULL)
+            {
+            gsd_index_buffer_drop_pages(buf, 0);
+            gsd_free(buf->pages);
+            }
+        gsd_free(buf->data);
+        }
+
+    gsd_util_zero_memory(buf, sizeof(struct gsd_index_buffer));
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Add a new index entry and provide a pointer to it.
+
+    @param buf Buffer to add too.
+    @param entry [out] Pointer to set to the new entry.
+
+    Double the size of the reserved space as needed to hold the new entry. Does not accept paged
+    indices.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_index_buffer_add(struct gsd_index_buffer* buf,
+                                       struct gsd_index_record** entry)
+    {
+    if (buf == NULL || buf->mapped_data || buf->pages || entry == NULL || buf->reserved == 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    if (buf->size == buf->reserved)
+        {
+        // grow the array
+        size_t new_reserved = buf->reserved * 2;
+        buf->data = gsd_realloc(buf->data, sizeof(struct gsd_index_record) * new_reserved);
+        if (buf->data == NULL)
+            {
+            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+
+        // zero the new memory
+        gsd_util_zero_memory(buf->data + buf->reserved,
+                             sizeof(struct gsd_index_record) * (new_reserved - buf->reserved));
+        buf->reserved = new_reserved;
+        }
+
+    size_t insert_pos = buf->size;
+    buf->size++;
+    *entry = buf->data + insert_pos;
+
+    return GSD_SUCCESS;
+    }
+
+inline static int gsd_cmp_index_entry(const struct gsd_index_record* a,
+                                      const struct gsd_index_record* b)
+    {
+    int result = 0;
+
+    if (a->entry.frame < b->entry.frame)
+        {
+        result = -1;
+        }
+
+    if (a->entry.frame > b->entry.frame)
+        {
+        result = 1;
+        }
+
+    if (a->entry.frame == b->entry.frame)
+        {
+        if (a->id < b->id)
+            {
+            result = -1;
+            }
+
+        if (a->id > b->id)
+            {
+            result = 1;
+            }
+
+        if (a->id == b->id)
+            {
+            result = 0;
+            }
+        }
+
+    return result;
+    }
+
+/** @internal
+    @brief Compute heap parent node.
+    @param i Node index.
+*/
+inline static size_t gsd_heap_parent(size_t i)
+    {
+    return (i - 1) / 2;
+    }
+
+/** @internal
+    @brief Compute heap left child.
+    @param i Node index.
+*/
+inline static size_t gsd_heap_left_child(size_t i)
+    {
+    return 2 * i + 1;
+    }
+
+/** @internal
+    @brief Swap the nodes *a* and *b* in the buffer
+    @param buf Buffer.
+    @param a First index to swap.
+    @param b Second index to swap.
+*/
+inline static void gsd_heap_swap(struct gsd_index_buffer* buf, size_t a, size_t b)
+    {
+    struct gsd_index_record tmp = buf->data[a];
+    buf->data[a] = buf->data[b];
+    buf->data[b] = tmp;
+    }
+
+/** @internal
+    @brief Shift heap node downward
+    @param buf Buffer.
+    @param start First index of the valid heap in *buf*.
+    @param end Last index of the valid hep in *buf*.
+*/
+inline static void gsd_heap_shift_down(struct gsd_index_buffer* buf, size_t start, size_t end)
+    {
+    size_t root = start;
+
+    while (gsd_heap_left_child(root) <= end)
+        {
+        size_t child = gsd_heap_left_child(root);
+        size_t swap = root;
+
+        if (gsd_cmp_index_entry(buf->data + swap, buf->data + child) < 0)
+            {
+            swap = child;
+            }
+        if (child + 1 <= end && gsd_cmp_index_entry(buf->data + swap, buf->data + child + 1) < 0)
+            {
+            swap = child + 1;
+            }
+
+        if (swap == root)
+            {
+            return;
+            }
+
+        gsd_heap_swap(buf, root, swap);
+        root = swap;
+        }
+    }
+
+/** @internal
+    @brief Convert unordered index buffer to a heap
+    @param buf Buffer.
+*/
+inline static void gsd_heapify(struct gsd_index_buffer* buf)
+    {
+    ssize_t start = gsd_heap_parent(buf->size - 1);
+
+    while (start >= 0)
+        {
+        gsd_heap_shift_down(buf, start, buf->size - 1);
+        start--;
+        }
+    }
+
+/** @internal
+    @brief Sort index entries that all belong to the same frame.
+
+    @param buf Buffer to sort.
+
+    Stable LSD radix sort on the four bytes of gsd_index_record::id. Skips the pass over a byte
+    when all entries have the same value in it.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_index_buffer_radix_sort(struct gsd_index_buffer* buf)
+    {
+    struct gsd_index_record* tmp = gsd_malloc(sizeof(struct gsd_index_record) * buf->size);
+    if (tmp == NULL)
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    // count the occurrences of each value of every byte in one pass
+    size_t count[4][256];
+    gsd_util_zero_memory(count, sizeof(count));
+    size_t i;
+    unsigned int pass;
+    for (i = 0; i < buf->size; i++)
+        {
+        for (pass = 0; pass < 4; pass++)
+            {
+            count[pass][(buf->data[i].id >> (pass * 8)) & 0xff]++;
+            }
+        }
+
+    struct gsd_index_record* src = buf->data;
+    struct gsd_index_record* dst = tmp;
+    for (pass = 0; pass < 4; pass++)
+        {
+        unsigned int shift = pass * 8;
+        if (count[pass][(src[0].id >> shift) & 0xff] == buf->size)
+            {
+            // all entries share this byte
+            continue;
+            }
+
+        // convert the counts to the first output position of each value
+        size_t offset[256];
+        size_t total = 0;
+        size_t v;
+        for (v = 0; v < 256; v++)
+            {
+            offset[v] = total;
+            total += count[pass][v];
+            }
+
+        for (i = 0; i < buf->size; i++)
+            {
+            dst[offset[(src[i].id >> shift) & 0xff]++] = src[i];
+            }
+
+        struct gsd_index_record* swap = src;
+        src = dst;
+        dst = swap;
+        }
+
+    if (src != buf->data)
+        {
+        memcpy(buf->data, src, sizeof(struct gsd_index_record) * buf->size);
+        }
+
+    gsd_free(tmp);
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Sort the index buffer.
+
+    @param buf Buffer to sort.
+
+    Sorts an in-memory index buffer. Does not accept paged indices. Returns immediately when the
+    buffer is already sorted, as is typical when a program writes chunks in the same order every
+    frame. Sorts entries of a single frame with gsd_index_buffer_radix_sort() and other buffers
+    with heapsort.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_index_buffer_sort(struct gsd_index_buffer* buf)
+    {
+    if (buf == NULL || buf->mapped_data || buf->pages || buf->reserved == 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    // arrays of size 0 or 1 are already sorted
+    if (buf->size <= 1)
+        {
+        return GSD_SUCCESS;
+        }
+
+    int sorted = 1;
+    int single_frame = 1;
+    size_t i;
+    for (i = 1; i < buf->size; i++)
+        {
+        if (gsd_cmp_index_entry(buf->data + i - 1, buf->data + i) > 0)
+            {
+            sorted = 0;
+            }
+        if (buf->data[i].entry.frame != buf->data[0].entry.frame)
+            {
+            single_frame = 0;
+            }
+        }
+
+    if (sorted)
+        {
+        return GSD_SUCCESS;
+        }
+
+    // fall back to heapsort, which needs no memory, when the radix sort fails to allocate
+    if (single_frame && gsd_index_buffer_radix_sort(buf) == GSD_SUCCESS)
+        {
+        return GSD_SUCCESS;
+        }
+
+    gsd_heapify(buf);
+
+    size_t end = buf->size - 1;
+    while (end > 0)
+        {
+        gsd_heap_swap(buf, end, 0);
+        end = end - 1;
+        gsd_heap_shift_down(buf, 0, end);
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/// Pending read in gsd_read_chunks()
+struct gsd_read_request
+    {
+    /// Location of the chunk in the file
+    int64_t location;
+
+    /// Size of the chunk (in bytes)
+    size_t size;
+
+    /// Destination buffer
+    void* data;
+    };
+
+/** @internal
+    @brief Compare two read requests by location
+
+    @param a Pointer to a gsd_read_request
+    @param b Pointer to a gsd_read_request
+
+    @return -1 if *a* is located before *b*, 1 if after, and 0 if they are at the same location.
+*/
+static int gsd_cmp_read_request(const void* a, const void* b)
+    {
+    const struct gsd_read_request* ra = (const struct gsd_read_request*)a;
+    const struct gsd_read_request* rb = (const struct gsd_read_request*)b;
+
+    if (ra->location < rb->location)
+        {
+        return -1;
+        }
+    if (ra->location > rb->location)
+        {
+        return 1;
+        }
+    return 0;
+    }
+
+/** @internal
+    @brief Find the first index entry at or after a given frame.
+
+    @param buf Buffer to search (ordered by frame).
+    @param handle GSD file handle with *buf* as its file index.
+    @param frame Frame to find.
+    @param L Lower bound of the search window.
+    @param R Upper bound of the search window (one past the end).
+    @param pos [out] The position of the first entry in [L, R) with a frame greater than or equal
+    to *frame*, or R when there is none.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_index_buffer_lower_bound(struct gsd_index_buffer* buf,
+                                               struct gsd_handle* handle,
+                                               uint64_t frame,
+                                               size_t L,
+                                               size_t R,
+                                               size_t* pos)
+    {
+    while (L < R)
+        {
+        size_t m = L + (R - L) / 2;
+        const struct gsd_index_entry* entry;
+        int retval = gsd_index_buffer_get(buf, handle, m, &entry);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+
+        if (entry->frame < frame)
+            {
+            L = m + 1;
+            }
+        else
+            {
+            R = m;
+            }
+        }
+
+    *pos = L;
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Allocate the frame directory.
+
+    @param dir Directory to allocate.
+    @param size Number of frame positions to hold.
+
+    All positions are initially unknown.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_frame_directory_allocate(struct gsd_frame_directory* dir, size_t size)
+    {
+    if (dir == NULL || dir->data || size == 0 || dir->size != 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    // calloc provides zero (unknown) positions and lets the OS commit pages only as they are used
+    dir->data = gsd_calloc(size, sizeof(size_t));
+    if (dir->data == NULL)
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    dir->size = size;
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Free the frame directory.
+
+    @param dir Directory to free.
+*/
+inline static void gsd_frame_directory_free(struct gsd_frame_directory* dir)
+    {
+    gsd_free(dir->data);
+    gsd_util_zero_memory(dir, sizeof(struct gsd_frame_directory));
+    }
+
+/** @internal
+    @brief Record the index positions of a newly committed frame.
+
+    @param dir Directory to update.
+    @param frame Frame that was committed.
+    @param first Position of the first index entry in *frame*.
+    @param last Position one past the last index entry in *frame*.
+
+    Does nothing when the directory has not been allocated. On failure, the directory is freed and
+    will be rebuilt on demand.
+*/
+inline static void gsd_frame_directory_commit(struct gsd_frame_directory* dir,
+                                              uint64_t frame,
+                                              size_t first,
+                                              size_t last)
+    {
+    if (dir->data == NULL)
+        {
+        return;
+        }
+
+    if (frame + 2 > dir->size)
+        {
+        // grow the directory by doubling
+        size_t new_size = dir->size * 2;
+        while (frame + 2 > new_size)
+            {
+            new_size *= 2;
+            }
+
+        size_t* new_data = gsd_realloc(dir->data, sizeof(size_t) * new_size);
+        if (new_data == NULL)
+            {
+            gsd_frame_directory_free(dir);
+            return;
+            }
+
+        gsd_util_zero_memory(new_data + dir->size, sizeof(size_t) * (new_size - dir->size));
+        dir->data = new_data;
+        dir->size = new_size;
+        }
+
+    dir->data[frame] = first + 1;
+    dir->data[frame + 1] = last + 1;
+    }
+
+/** @internal
+    @brief Prepare the frame directory for index entries loaded by gsd_refresh().
+
+    @param dir Directory to update.
+    @param first First frame whose position may have changed.
+    @param size Number of frame positions to hold.
+
+    Forgets the positions of the frames from *first* on and grows the directory to hold *size*
+    positions. On failure, the directory is freed and gsd_frame_directory_get() searches the
+    index.
+*/
+inline static void
+gsd_frame_directory_reset(struct gsd_frame_directory* dir, uint64_t first, size_t size)
+    {
+    if (dir->data == NULL)
+        {
+        gsd_frame_directory_allocate(dir, size);
+        return;
+        }
+
+    if (first < dir->size)
+        {
+        gsd_util_zero_memory(dir->data + first, sizeof(size_t) * (dir->size - first));
+        }
+
+    if (size > dir->size)
+        {
+        size_t* new_data = gsd_realloc(dir->data, sizeof(size_t) * size);
+        if (new_data == NULL)
+            {
+            gsd_frame_directory_free(dir);
+            return;
+            }
+
+        gsd_util_zero_memory(new_data + dir->size, sizeof(size_t) * (size - dir->size));
+        dir->data = new_data;
+        dir->size = size;
+        }
+    }
+
+/** @internal
+    @brief Load a frame directory slot.
+
+    @param slot Slot to load.
+
+    Readers that share a read-only handle fill the directory concurrently. Every reader stores the
+    same position in a given slot, so relaxed atomic access is sufficient.
+
+    @returns The value of the slot.
+*/
+inline static size_t gsd_frame_directory_load(const size_t* slot)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(slot, __ATOMIC_RELAXED);
+#else
+    return *(const volatile size_t*)slot;
+#endif
+    }
+
+/** @internal
+    @brief Store a frame directory slot.
+
+    @param slot Slot to store.
+    @param value Value to store.
+*/
+inline static void gsd_frame_directory_store(size_t* slot, size_t value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(slot, value, __ATOMIC_RELAXED);
+#else
+    *(volatile size_t*)slot = value;
+#endif
+    }
+
+/** @internal
+    @brief Release the frame table of a handle.
+
+    @param table Frame table to release.
+
+    Unmaps the table when it is mapped.
+*/
+inline static void gsd_frame_table_free(struct gsd_frame_table* table)
+    {
+#if GSD_USE_MMAP
+    if (table->mapped_data != NULL)
+        {
+        munmap(table->mapped_data, table->mapped_len);
+        }
+#endif
+    gsd_util_zero_memory(table, sizeof(struct gsd_frame_table));
+    }
+
+/** @internal
+    @brief Read the header of the frame table of a file.
+
+    @param handle Handle to the open gsd file.
+
+    @pre The file header, file size, and index segments are set in the handle.
+
+    @post gsd_handle::frame_table describes the table when the file has one that matches the index
+    in the header, and is zero otherwise. A table that fails to read is ignored.
+*/
+inline static void gsd_frame_table_read(struct gsd_handle* handle)
+    {
+    gsd_util_zero_memory(&handle->frame_table, sizeof(struct gsd_frame_table));
+
+    uint64_t location = handle->header.frame_table_location;
+    if (location == 0
+        || location + sizeof(struct gsd_frame_table_header) > (uint64_t)handle->file_size)
+        {
+        return;
+        }
+
+    struct gsd_frame_table_header table_header;
+    ssize_t bytes_read = gsd_handle_pread(handle,
+                                            &table_header,
+                                            sizeof(struct gsd_frame_table_header),
+                                            location);
+    if (bytes_read != sizeof(struct gsd_frame_table_header))
+        {
+        return;
+        }
+
+    // the table applies only to the index it was written for
+    uint64_t index_segments_location
+        = handle->n_index_segments > 0 ? handle->header.index_segments_location : 0;
+    if (table_header.index_location != handle->header.index_location
+        || table_header.index_allocated_entries != handle->header.index_allocated_entries
+        || table_header.index_segments_location != index_segments_location
+        || table_header.n_entries > SIZE_MAX / sizeof(struct gsd_index_entry)
+        || table_header.n_frames > table_header.n_entries
+        || (table_header.n_frames == 0) != (table_header.n_entries == 0)
+        || table_header.n_frames
+               > ((uint64_t)handle->file_size - location - sizeof(struct gsd_frame_table_header))
+                     / sizeof(uint64_t))
+        {
+        return;
+        }
+
+    handle->frame_table.location = location;
+    handle->frame_table.n_entries = table_header.n_entries;
+    handle->frame_table.n_frames = table_header.n_frames;
+    }
+
+/** @internal
+    @brief Check the frame table against the file index and map it.
+
+    @param handle Handle to the open gsd file.
+
+    @pre gsd_frame_table_read() and gsd_index_buffer_map() have been called on the handle.
+
+    Discards the table when the index does not end with the last frame in the table. The table is
+    read with pread when it cannot be mapped.
+*/
+inline static void gsd_frame_table_open(struct gsd_handle* handle)
+    {
+    struct gsd_frame_table* table = &handle->frame_table;
+    if (table->location == 0)
+        {
+        return;
+        }
+
+    const struct gsd_index_entry* last = NULL;
+    if (handle->file_index.size != table->n_entries
+        || (table->n_entries > 0
+            && (gsd_index_buffer_get(&handle->file_index, handle, table->n_entries - 1, &last)
+                    != GSD_SUCCESS
+                || last->frame != table->n_frames - 1)))
+        {
+        gsd_frame_table_free(table);
+        return;
+        }
+
+#if GSD_USE_MMAP
+    if (table->n_frames > 0)
+        {
+        size_t page_size = sysconf(_SC_PAGESIZE);
+        uint64_t positions_location = table->location + sizeof(struct gsd_frame_table_header);
+        size_t offset = (positions_location / page_size) * page_size;
+        size_t mapped_len = sizeof(uint64_t) * table->n_frames + (positions_location - offset);
+        void* mapped_data = mmap(NULL, mapped_len, PROT_READ, MAP_SHARED, handle->fd, offset);
+        if (mapped_data != MAP_FAILED)
+            {
+            table->mapped_data = mapped_data;
+            table->mapped_len = mapped_len;
+            table->data = (const uint64_t*)((char*)mapped_data + (positions_location - offset));
+            }
+        }
+#endif
+    }
+
+/** @internal
+    @brief Get the position of the first index entry of a frame from the frame table.
+
+    @param handle Handle to the open gsd file.
+    @param frame Frame to locate, at most gsd_frame_table::n_frames.
+    @param pos [out] Position of the first entry in gsd_handle::file_index with a frame greater
+    than or equal to *frame*.
+
+    Safe to call from several threads on a read-only handle.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_frame_table_get(struct gsd_handle* handle, uint64_t frame, size_t* pos)
+    {
+    const struct gsd_frame_table* table = &handle->frame_table;
+    if (frame == table->n_frames)
+        {
+        *pos = table->n_entries;
+        return GSD_SUCCESS;
+        }
+
+    uint64_t value = 0;
+    if (table->data != NULL)
+        {
+        value = table->data[frame];
+        }
+    else
+        {
+        ssize_t bytes_read
+            = gsd_handle_pread(handle,
+                                 &value,
+                                 sizeof(uint64_t),
+                                 table->location + sizeof(struct gsd_frame_table_header)
+                                     + sizeof(uint64_t) * frame);
+        if (bytes_read != sizeof(uint64_t))
+            {
+            return GSD_ERROR_IO;
+            }
+        }
+
+    if (value > table->n_entries)
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    *pos = value;
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Get the position of the first index entry of a frame.
+
+    @param handle Handle to the open gsd file.
+    @param frame Frame to locate (may be equal to the number of frames).
+    @param pos [out] The position of the first entry in gsd_handle::file_index with a frame greater
+    than or equal to *frame*.
+
+    Takes the position from the frame table, or searches the file index for it, when it is not yet
+    in the directory and stores the result for later calls. Safe to call from several threads on a
+    read-only handle.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_frame_directory_get(struct gsd_handle* handle, uint64_t frame, size_t* pos)
+    {
+    struct gsd_frame_directory* dir = &handle->frame_directory;
+
+    size_t slot = frame < dir->size ? gsd_frame_directory_load(&dir->data[frame]) : 0;
+    if (slot != 0)
+        {
+        *pos = slot - 1;
+        return GSD_SUCCESS;
+        }
+
+    if (handle->frame_table.location != 0 && frame <= handle->frame_table.n_frames
+        && gsd_frame_table_get(handle, frame, pos) == GSD_SUCCESS)
+        {
+        if (frame < dir->size)
+            {
+            gsd_frame_directory_store(&dir->data[frame], *pos + 1);
+            }
+        return GSD_SUCCESS;
+        }
+
+    // narrow the search window with the positions of neighboring frames when they are known
+    size_t L = 0;
+    size_t R = handle->file_index.size;
+    if (frame > 0 && frame - 1 < dir->size)
+        {
+        slot = gsd_frame_directory_load(&dir->data[frame - 1]);
+        if (slot != 0)
+            {
+            L = slot - 1;
+            }
+        }
+    if (frame + 1 < dir->size)
+        {
+        slot = gsd_frame_directory_load(&dir->data[frame + 1]);
+        if (slot != 0)
+            {
+            R = slot - 1;
+            }
+        }
+
+    int retval = gsd_index_buffer_lower_bound(&handle->file_index, handle, frame, L, R, pos);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    if (frame < dir->size)
+        {
+        gsd_frame_directory_store(&dir->data[frame], *pos + 1);
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Locate the index entries of a frame
+
+    @param handle Handle to the open gsd file.
+    @param frame Frame to locate.
+    @param first [out] Position of the first entry of the frame in gsd_handle::file_index.
+    @param last [out] Position one past the last entry of the frame.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int
+gsd_find_frame_entries(struct gsd_handle* handle, uint64_t frame, size_t* first, size_t* last)
+    {
+    // build the frame directory on first use, read-only handles allocate it when opened so that
+    // concurrent readers never race to allocate it
+    if (handle->frame_directory.data == NULL && handle->open_flags != GSD_OPEN_READONLY)
+        {
+        // failure to allocate is not fatal, gsd_frame_directory_get falls back to searching
+        gsd_frame_directory_allocate(&handle->frame_directory, handle->cur_frame + 1);
+        }
+
+    int retval = gsd_frame_directory_get(handle, frame, first);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+    return gsd_frame_directory_get(handle, frame + 1, last);
+    }
+
+/** @internal
+    @brief Find the index entry of a chunk
+
+    @param handle Handle to the open gsd file.
+    @param frame Frame to look for the chunk in.
+    @param match_id Id of the chunk name.
+
+    @pre Writes queued for the background writer are complete.
+
+    @returns A pointer to the entry in gsd_handle::file_index, or NULL when there is no such chunk
+    or the index entries of the frame cannot be read.
+*/
+inline static const struct gsd_index_entry*
+gsd_find_entry(struct gsd_handle* handle, uint64_t frame, uint32_t match_id)
+    {
+    // locate the index entries of the requested frame
+    size_t first = 0;
+    size_t last = 0;
+    if (gsd_find_frame_entries(handle, frame, &first, &last) != GSD_SUCCESS)
+        {
+        return NULL;
+        }
+
+    if (handle->header.gsd_version >= gsd_make_version(2, 0))
+        {
+        // gsd 2.0 files sort the entire index
+        // binary search for the id within the frame
+        size_t L = first;
+        size_t R = last;
+
+        while (L < R)
+            {
+            size_t m = L + (R - L) / 2;
+            const struct gsd_index_entry* entry;
+            if (gsd_index_buffer_get(&handle->file_index, handle, m, &entry) != GSD_SUCCESS)
+                {
+                return NULL;
+                }
+
+            uint32_t id = gsd_entry_id(handle, entry);
+            if (id < match_id)
+                {
+                L = m + 1;
+                }
+            else if (id > match_id)
+                {
+                R = m;
+                }
+            else
+                {
+                return entry;
+                }
+            }
+        }
+    else
+        {
+        // gsd 1.0 file: entries within a frame are not sorted, use linear search to find the entry
+        size_t cur_index;
+
+        // search all index entries with the matching frame
+        for (cur_index = first; cur_index < last; cur_index++)
+            {
+            const struct gsd_index_entry* entry;
+            if (gsd_index_buffer_get(&handle->file_index, handle, cur_index, &entry)
+                != GSD_SUCCESS)
+                {
+                return NULL;
+                }
+
+            // if the frame matches, check the id
+            if (match_id == gsd_entry_id(handle, entry))
+                {
+                return entry;
+                }
+            }
+        }
+
+    // if we got here, we didn't find the specified chunk
+    return NULL;
+    }
+
+/** @internal
+    @brief Get the name id of a chunk
+
+    @param handle Handle to the open gsd file.
+    @param chunk Index entry of the chunk, which may be a copy of an entry of the file index.
+
+    gsd_index_entry::id holds UINT16_MAX when the id does not fit in 16 bits. The id is then read
+    from the entry of the file index at the location of the chunk.
+
+    @pre Writes queued for the background writer are complete.
+
+    @returns The name id, or UINT32_MAX when the file index has no entry for the chunk.
+*/
+inline static uint32_t gsd_chunk_id(struct gsd_handle* handle, const struct gsd_index_entry* chunk)
+    {
+    if (chunk->id != UINT16_MAX)
+        {
+        return chunk->id;
+        }
+
+    size_t first = 0;
+    size_t last = 0;
+    if (gsd_find_frame_entries(handle, chunk->frame, &first, &last) != GSD_SUCCESS)
+        {
+        return UINT32_MAX;
+        }
+
+    size_t i;
+    for (i = first; i < last; i++)
+        {
+        const struct gsd_index_entry* entry;
+        if (gsd_index_buffer_get(&handle->file_index, handle, i, &entry) != GSD_SUCCESS)
+            {
+            return UINT32_MAX;
+            }
+        if (entry->location == chunk->location)
+            {
+            return gsd_entry_id(handle, entry);
+            }
+        }
+
+    return UINT32_MAX;
+    }
+
+/** @internal
+    @brief Read and decode an encoded chunk, applying delta encoding
+
+    @param handle Handle to the open gsd file.
+    @param data Data buffer to read into.
+    @param chunk Chunk to read (with non-zero flags).
+
+    @pre Writes queued for the background writer are complete.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int
+gsd_read_encoded_chunk(struct gsd_handle* handle, void* data, const struct gsd_index_entry* chunk)
+    {
+    struct gsd_chunk_header header;
+    int retval = gsd_decode_chunk(handle, data, chunk, &header);
+    if (retval != GSD_SUCCESS || !(chunk->flags & GSD_FLAG_DELTA))
+        {
+        return retval;
+        }
+
+    // locate the keyframe, which must be an earlier chunk with the same name and shape
+    uint64_t keyframe_frame = header.parameters[GSD_DELTA_PARAMETER_FRAME];
+    if (keyframe_frame >= chunk->frame)
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    uint32_t id = gsd_chunk_id(handle, chunk);
+    if (id == UINT32_MAX)
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    const struct gsd_index_entry* keyframe = gsd_find_entry(handle, keyframe_frame, id);
+    if (keyframe == NULL || keyframe->type != chunk->type || keyframe->N != chunk->N
+        || keyframe->M != chunk->M || (keyframe->flags & GSD_FLAG_DELTA))
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    size_t size = chunk->N * chunk->M * gsd_sizeof_type((enum gsd_type)chunk->type);
+    char* keyframe_data = gsd_malloc(size);
+    if (keyframe_data == NULL)
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    if (keyframe->flags != 0)
+        {
+        retval = gsd_decode_chunk(handle, keyframe_data, keyframe, &header);
+        }
+    else if (keyframe->location + size > (uint64_t)handle->file_size)
+        {
+        retval = GSD_ERROR_FILE_CORRUPT;
+        }
+    else
+        {
+        ssize_t bytes_read = gsd_handle_pread(handle, keyframe_data, size, keyframe->location);
+        if (bytes_read == -1 || (size_t)bytes_read != size)
+            {
+            retval = GSD_ERROR_IO;
+            }
+        }
+
+    if (retval == GSD_SUCCESS)
+        {
+        char* out = (char*)data;
+        size_t i;
+        for (i = 0; i < size; i++)
+            {
+            out[i] ^= keyframe_data[i];
+            }
+        }
+
+    gsd_free(keyframe_data);
+    return retval;
+    }
+
+/** @internal
+    @brief Get the keyframe of a chunk
+
+    @param cache Keyframe cache.
+    @param id Id of the chunk name.
+
+    @returns The keyframe, or NULL when the cache has no keyframe for *id*.
+*/
+inline static const struct gsd_keyframe* gsd_keyframe_cache_find(struct gsd_keyframe_cache* cache,
+                                                                  uint32_t id)
+    {
+    if (id >= cache->size || cache->data[id].data == NULL)
+        {
+        return NULL;
+        }
+
+    return &cache->data[id];
+    }
+
+/** @internal
+    @brief Store the keyframe of a chunk
+
+    @param cache Keyframe cache.
+    @param id Id of the chunk name.
+    @param entry Index entry of the keyframe chunk.
+    @param data Chunk data.
+    @param size Number of bytes in *data*.
+
+    @post The cache holds a copy of *data* for *entry*, or no keyframe for the chunk when memory
+    allocation fails. The next delta encoded chunk stores a keyframe in the latter case.
+*/
+inline static void gsd_keyframe_cache_update(struct gsd_keyframe_cache* cache,
+                                             uint32_t id,
+                                             const struct gsd_index_entry* entry,
+                                             const void* data,
+                                             size_t size)
+    {
+    if (id >= cache->size)
+        {
+        size_t new_size = (size_t)id + 1;
+        struct gsd_keyframe* new_data
+            = gsd_realloc(cache->data, sizeof(struct gsd_keyframe) * new_size);
+        if (new_data == NULL)
+            {
+            return;
+            }
+        gsd_util_zero_memory(new_data + cache->size,
+                             sizeof(struct gsd_keyframe) * (new_size - cache->size));
+        cache->data = new_data;
+        cache->size = new_size;
+        }
+
+    struct gsd_keyframe* keyframe = &cache->data[id];
+    gsd_free(keyframe->data);
+    keyframe->data = gsd_malloc(size);
+    if (keyframe->data == NULL)
+        {
+        return;
+        }
+
+    memcpy(keyframe->data, data, size);
+    keyframe->entry = *entry;
+    }
+
+/** @internal
+    @brief Free the keyframe cache
+
+    @param cache Keyframe cache to free.
+*/
+inline static void gsd_keyframe_cache_free(struct gsd_keyframe_cache* cache)
+    {
+    size_t i;
+    for (i = 0; i < cache->size; i++)
+        {
+        gsd_free(cache->data[i].data);
+        }
+    gsd_free(cache->data);
+    cache->data = NULL;
+    cache->size = 0;
+    }
+
+#if GSD_USE_MMAP
+
+/// Read-only mapping of the file that gsd_map_chunk() provides chunk data from
+struct gsd_read_map
+    {
+    /// Mapped memory, starting at the beginning of the file
+    char* data;
+
+    /// Number of bytes mapped
+    size_t size;
+
+    /// Number of mapped chunks that point into the mapping, plus one while the handle is open
+    uint64_t n_users;
+
+    /// Mapping that this one replaced (NULL for the first mapping of the handle)
+    struct gsd_read_map* next;
+    };
+
+/** @internal
+    @brief Get a mapping of the file that holds a range of bytes.
+
+    @param handle Handle to an open gsd file.
+    @param end Position one past the last byte to map.
+    @param map [out] Mapping that holds the bytes before *end*.
+
+    Maps the file again when *end* is past the end of the current mapping. The new mapping covers
+    the whole file and at least twice the size of the one it replaces, so a file that grows is
+    mapped only a logarithmic number of times. Replaced mappings stay valid until gsd_close() as
+    other threads may be about to use them. Counts a user of *map*, which gsd_read_map_release()
+    releases.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_read_map_acquire(struct gsd_handle* handle,
+                                       uint64_t end,
+                                       struct gsd_read_map** map)
+    {
+    struct gsd_read_map* current = __atomic_load_n(&handle->read_map, __ATOMIC_ACQUIRE);
+    while (current == NULL || current->size < end)
+        {
+        size_t size = (size_t)handle->file_size;
+        if (current != NULL && current->size * 2 > size)
+            {
+            size = current->size * 2;
+            }
+
+        void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, handle->fd, 0);
+        if (data == MAP_FAILED)
+            {
+            return GSD_ERROR_IO;
+            }
+
+        struct gsd_read_map* new_map = gsd_malloc(sizeof(struct gsd_read_map));
+        if (new_map == NULL)
+            {
+            munmap(data, size);
+            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+        new_map->data = data;
+        new_map->size = size;
+        new_map->n_users = 1;
+        new_map->next = current;
+
+        // another thread may have replaced the mapping first, use that one instead
+        if (__atomic_compare_exchange_n(&handle->read_map,
+                                        &current,
+                                        new_map,
+                                        0,
+                                        __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE))
+            {
+            current = new_map;
+            }
+        else
+            {
+            munmap(data, size);
+            gsd_free(new_map);
+            }
+        }
+
+    __atomic_fetch_add(&current->n_users, 1, __ATOMIC_RELAXED);
+    *map = current;
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Release a user of a mapping.
+
+    @param handle Handle that holds the mapping.
+    @param map Mapping to release.
+
+    Unmaps *map* and removes it from the mappings of *handle* once it has no users left, which
+    happens only after gsd_close() released the user that the handle counts.
+*/
+inline static void gsd_read_map_release(struct gsd_handle* handle, struct gsd_read_map* map)
+    {
+    if (__atomic_sub_fetch(&map->n_users, 1, __ATOMIC_ACQ_REL) != 0)
+        {
+        return;
+        }
+
+    struct gsd_read_map** link = &handle->read_map;
+    while (*link != map)
+        {
+        link = &(*link)->next;
+        }
+    *link = map->next;
+
+    munmap(map->data, map->size);
+    gsd_free(map);
+    }
+
+/** @internal
+    @brief Test if mapped chunks point into the mappings of a handle.
+
+    @param handle Handle to an open gsd file.
+
+    @returns 1 when a chunk mapped by gsd_map_chunk() has not been released, 0 otherwise.
+*/
+inline static int gsd_read_map_in_use(struct gsd_handle* handle)
+    {
+    struct gsd_read_map* map = __atomic_load_n(&handle->read_map, __ATOMIC_ACQUIRE);
+    while (map != NULL)
+        {
+        if (__atomic_load_n(&map->n_users, __ATOMIC_ACQUIRE) > 1)
+            {
+            return 1;
+            }
+        map = map->next;
+        }
+    return 0;
+    }
+
+/** @internal
+    @brief Release the mappings of a closing handle.
+
+    @param handle Handle to close.
+
+    Mappings that mapped chunks still point into remain in gsd_handle::read_map until the chunks
+    are released with gsd_unmap_chunk().
+*/
+inline static void gsd_read_map_close(struct gsd_handle* handle)
+    {
+    struct gsd_read_map* map = handle->read_map;
+    while (map != NULL)
+        {
+        struct gsd_read_map* next = map->next;
+        gsd_read_map_release(handle, map);
+        map = next;
+        }
+    }
+
+#endif
+
+#if GSD_USE_PTHREADS
+
+/// Write queued for the background writer
+struct gsd_write_job
+    {
+    /// Data to write (owned by the job)
+    char* data;
+
+    /// Position of the first byte to write in *data*
+    size_t start;
+
+    /// Number of bytes to write
+    size_t size;
+
+    /// Allocated size of a reusable write buffer (0 when *data* is not a write buffer)
+    size_t reserved;
+
+    /// Location in the file to write to
+    int64_t offset;
+
+    /// File descriptor opened for direct I/O to write with, -1 to write with the buffered one
+    int direct_fd;
+
+    /// Next job in the queue
+    struct gsd_write_job* next;
+    };
+
+/** @internal
+    @brief Free the data of a write job
+
+    @param data Data to free.
+    @param direct_fd File descriptor of the job, data for direct I/O is from posix_memalign().
+*/
+inline static void gsd_write_job_free_data(char* data, int direct_fd)
+    {
+    if (direct_fd != -1)
+        {
+        free(data);
+        }
+    else
+        {
+        gsd_free(data);
+        }
+    }
+
+/// Background writer state
+struct gsd_write_behind
+    {
+    /// File descriptor to write to
+    int fd;
+
+    /// Statistics of the handle that owns the writer
+    struct gsd_stats* stats;
+
+    /// The writer thread
+    pthread_t thread;
+
+    /// Protects all of the fields below
+    pthread_mutex_t mutex;
+
+    /// Signaled when a job is queued or the writer should stop
+    pthread_cond_t job_ready;
+
+    /// Signaled when a job completes
+    pthread_cond_t job_done;
+
+    /// First job in the queue (the writer holds it in the queue until it completes)
+    struct gsd_write_job* head;
+
+    /// Last job in the queue
+    struct gsd_write_job* tail;
+
+    /// Number of bytes in the queue
+    size_t queued_bytes;
+
+    /// A completed write buffer available for reuse
+    char* spare_buffer;
+
+    /// Allocated size of *spare_buffer*
+    size_t spare_reserved;
+
+    /// Set to stop the writer after the queue is empty
+    bool shutdown;
+
+    /// First error that occurred in the writer (GSD_SUCCESS when there is none)
+    int error;
+
+    /// Value of errno when *error* occurred
+    int error_errno;
+    };
+
+/** @internal
+    @brief Background writer thread
+
+    @param arg The gsd_write_behind state.
+
+    Writes queued jobs in order. After an error, discards queued jobs until the error is reported so
+    that index entries are never written for data that failed to write.
+
+    @returns NULL
+*/
+static void* gsd_write_behind_main(void* arg)
+    {
+    struct gsd_write_behind* wb = (struct gsd_write_behind*)arg;
+
+    pthread_mutex_lock(&wb->mutex);
+    while (true)
+        {
+        while (wb->head == NULL && !wb->shutdown)
+            {
+            pthread_cond_wait(&wb->job_ready, &wb->mutex);
+            }
+
+        if (wb->head == NULL)
+            {
+            break;
+            }
+
+        struct gsd_write_job* job = wb->head;
+        bool skip = (wb->error != GSD_SUCCESS);
+        pthread_mutex_unlock(&wb->mutex);
+
+        int error = GSD_SUCCESS;
+        int error_errno = 0;
+        if (!skip)
+            {
+            ssize_t bytes_written;
+#if GSD_USE_DIRECT_IO
+            if (job->direct_fd != -1)
+                {
+                bytes_written = gsd_io_pwrite_direct(wb->fd,
+                                                     job->direct_fd,
+                                                     job->data + job->start,
+                                                     job->size,
+                                                     job->offset);
+                }
+            else
+#endif
+                {
+                bytes_written = gsd_io_pwrite_retry(wb->fd,
+                                                    job->data + job->start,
+                                                    job->size,
+                                                    job->offset);
+                }
+            gsd_stats_count_io(wb->stats, 1, bytes_written);
+            if (bytes_written == -1 || bytes_written != job->size)
+                {
+                error = GSD_ERROR_IO;
+                error_errno = errno;
+                }
+            }
+
+        pthread_mutex_lock(&wb->mutex);
+        if (error != GSD_SUCCESS && wb->error == GSD_SUCCESS)
+            {
+            wb->error = error;
+            wb->error_errno = error_errno;
+            }
+
+        // remove the completed job from the queue
+        wb->head = job->next;
+        if (wb->head == NULL)
+            {
+            wb->tail = NULL;
+            }
+        wb->queued_bytes -= job->size;
+
+        // keep one write buffer for reuse
+        if (job->reserved > 0 && wb->spare_buffer == NULL)
+            {
+            wb->spare_buffer = job->data;
+            wb->spare_reserved = job->reserved;
+            }
+        else
+            {
+            gsd_write_job_free_data(job->data, job->direct_fd);
+            }
+        gsd_free(job);
+
+        pthread_cond_broadcast(&wb->job_done);
+        }
+    pthread_mutex_unlock(&wb->mutex);
+
+    return NULL;
+    }
+
+/** @internal
+    @brief Take the pending background writer error
+
+    @param wb Background writer state.
+
+    @pre wb->mutex is locked.
+    @post The pending error is cleared and errno is set to its value.
+
+    @returns The pending error, or GSD_SUCCESS when there is none.
+*/
+inline static int gsd_write_behind_take_error(struct gsd_write_behind* wb)
+    {
+    int retval = wb->error;
+    if (retval != GSD_SUCCESS)
+        {
+        wb->error = GSD_SUCCESS;
+        errno = wb->error_errno;
+        }
+    return retval;
+    }
+
+#endif
+
+/** @internal
+    @brief Start the background writer
+
+    @param handle Handle to start the writer for.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_write_behind_start(struct gsd_handle* handle)
+    {
+#if GSD_USE_PTHREADS
+    struct gsd_write_behind* wb = gsd_calloc(1, sizeof(struct gsd_write_behind));
+    if (wb == NULL)
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    wb->fd = handle->fd;
+    wb->stats = &handle->stats;
+    wb->error = GSD_SUCCESS;
+
+    if (pthread_mutex_init(&wb->mutex, NULL) != 0)
+        {
+        gsd_free(wb);
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+    if (pthread_cond_init(&wb->job_ready, NULL) != 0)
+        {
+        pthread_mutex_destroy(&wb->mutex);
+        gsd_free(wb);
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+    if (pthread_cond_init(&wb->job_done, NULL) != 0)
+        {
+        pthread_cond_destroy(&wb->job_ready);
+        pthread_mutex_destroy(&wb->mutex);
+        gsd_free(wb);
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+    if (pthread_create(&wb->thread, NULL, gsd_write_behind_main, wb) != 0)
+        {
+        pthread_cond_destroy(&wb->job_done);
+        pthread_cond_destroy(&wb->job_ready);
+        pthread_mutex_destroy(&wb->mutex);
+        gsd_free(wb);
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    handle->write_behind = wb;
+#endif
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Stop the background writer
+
+    @param handle Handle to stop the writer for.
+
+    @post All queued writes are complete and the writer is freed.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes from queued writes on error.
+*/
+inline static int gsd_write_behind_stop(struct gsd_handle* handle)
+    {
+    int retval = GSD_SUCCESS;
+
+#if GSD_USE_PTHREADS
+    struct gsd_write_behind* wb = handle->write_behind;
+    if (wb == NULL)
+        {
+        return GSD_SUCCESS;
+        }
+
+    // the writer completes all queued jobs before it exits
+    pthread_mutex_lock(&wb->mutex);
+    wb->shutdown = true;
+    pthread_cond_signal(&wb->job_ready);
+    pthread_mutex_unlock(&wb->mutex);
+
+    pthread_join(wb->thread, NULL);
+
+    pthread_cond_destroy(&wb->job_done);
+    pthread_cond_destroy(&wb->job_ready);
+    pthread_mutex_destroy(&wb->mutex);
+
+    retval = wb->error;
+    int error_errno = wb->error_errno;
+    gsd_free(wb->spare_buffer);
+    gsd_free(wb);
+    handle->write_behind = NULL;
+
+    if (retval != GSD_SUCCESS)
+        {
+        errno = error_errno;
+        }
+#endif
+
+    return retval;
+    }
+
+/** @internal
+    @brief Wait for all queued writes to complete
+
+    @param handle Handle to wait on.
+
+    Does nothing when write-behind is disabled. Call before reading data or index entries that may
+    not yet be written to the file.
+*/
+inline static void gsd_write_behind_drain(struct gsd_handle* handle)
+    {
+#if GSD_USE_PTHREADS
+    struct gsd_write_behind* wb = handle->write_behind;
+    if (wb == NULL)
+        {
+        return;
+        }
+
+    pthread_mutex_lock(&wb->mutex);
+    while (wb->head != NULL)
+        {
+        pthread_cond_wait(&wb->job_done, &wb->mutex);
+        }
+    pthread_mutex_unlock(&wb->mutex);
+#endif
+    }
+
+/** @internal
+    @brief Report errors from the background writer
+
+    @param handle Handle to check.
+
+    @returns GSD_SUCCESS when no error occurred since the last check, GSD_* error codes otherwise.
+*/
+inline static int gsd_write_behind_check(struct gsd_handle* handle)
+    {
+    int retval = GSD_SUCCESS;
+
+#if GSD_USE_PTHREADS
+    struct gsd_write_behind* wb = handle->write_behind;
+    if (wb == NULL)
+        {
+        return GSD_SUCCESS;
+        }
+
+    pthread_mutex_lock(&wb->mutex);
+    retval = gsd_write_behind_take_error(wb);
+    pthread_mutex_unlock(&wb->mutex);
+#endif
+
+    return retval;
+    }
+
+/** @internal
+    @brief Wait for all queued writes to complete and report errors
+
+    @param handle Handle to wait on.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes from queued writes on error.
+*/
+inline static int gsd_write_behind_wait(struct gsd_handle* handle)
+    {
+    gsd_write_behind_drain(handle);
+    return gsd_write_behind_check(handle);
+    }
+
+/** @internal
+    @brief Queue a write for the background writer
+
+    @param handle Handle with write-behind enabled.
+    @param data Data to write. The writer takes ownership and frees it.
+    @param start Position of the first byte to write in *data*.
+    @param size Number of bytes to write.
+    @param reserved Allocated size of *data* when it is a write buffer that can be reused, 0
+    otherwise.
+    @param offset Location in the file to write to.
+    @param direct_fd File descriptor opened for direct I/O to write with, -1 to write with the
+    buffered file descriptor.
+
+    Blocks while the queue is full.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_write_behind_queue(struct gsd_handle* handle,
+                                         char* data,
+                                         size_t start,
+                                         size_t size,
+                                         size_t reserved,
+                                         int64_t offset,
+                                         int direct_fd)
+    {
+#if GSD_USE_PTHREADS
+    struct gsd_write_behind* wb = handle->write_behind;
+
+    struct gsd_write_job* job = gsd_malloc(sizeof(struct gsd_write_job));
+    if (job == NULL)
+        {
+        gsd_write_job_free_data(data, direct_fd);
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    job->data = data;
+    job->start = start;
+    job->size = size;
+    job->reserved = reserved;
+    job->offset = offset;
+    job->direct_fd = direct_fd;
+    job->next = NULL;
+
+    // the queue holds at least two write buffers
+    size_t queue_size = GSD_WRITE_BEHIND_QUEUE_SIZE;
+    if (queue_size < 2 * handle->write_buffer_size)
+        {
+        queue_size = 2 * handle->write_buffer_size;
+        }
+
+    pthread_mutex_lock(&wb->mutex);
+
+    // bound the amount of queued data, but always accept a job when the queue is empty
+    while (wb->head != NULL && wb->queued_bytes + size > queue_size
+           && wb->error == GSD_SUCCESS)
+        {
+        pthread_cond_wait(&wb->job_done, &wb->mutex);
+        }
+
+    int retval = gsd_write_behind_take_error(wb);
+    if (retval != GSD_SUCCESS)
+        {
+        pthread_mutex_unlock(&wb->mutex);
+        gsd_write_job_free_data(job->data, job->direct_fd);
+        gsd_free(job);
+        return retval;
+        }
+
+    if (wb->tail == NULL)
+        {
+        wb->head = job;
+        }
+    else
+        {
+        wb->tail->next = job;
+        }
+    wb->tail = job;
+    wb->queued_bytes += size;
+
+    pthread_cond_signal(&wb->job_ready);
+    pthread_mutex_unlock(&wb->mutex);
+
+    return GSD_SUCCESS;
+#else
+    gsd_free(data);
+    return GSD_ERROR_INVALID_ARGUMENT;
+#endif
+    }
+
+/** @internal
+    @brief Obtain a write buffer to replace one handed to the background writer
+
+    @param handle Handle with write-behind enabled.
+    @param reserved Size of the buffer.
+
+    @returns A buffer of *reserved* bytes, or NULL when allocation fails.
+*/
+inline static char* gsd_write_behind_get_buffer(struct gsd_handle* handle, size_t reserved)
+    {
+    char* buffer = NULL;
+
+#if GSD_USE_PTHREADS
+    struct gsd_write_behind* wb = handle->write_behind;
+    pthread_mutex_lock(&wb->mutex);
+    if (wb->spare_buffer != NULL && wb->spare_reserved == reserved)
+        {
+        buffer = wb->spare_buffer;
+        wb->spare_buffer = NULL;
+        wb->spare_reserved = 0;
+        }
+    pthread_mutex_unlock(&wb->mutex);
+#endif
+
+    if (buffer == NULL)
+        {
+        buffer = gsd_malloc(reserved);
+        }
+
+    return buffer;
+    }
+
+/** @internal
+    @brief Sync the file to the storage device
+
+    @param handle Handle to the open gsd file.
+
+    @returns GSD_SUCCESS on success, GSD_ERROR_IO on error.
+*/
+inline static int gsd_sync(struct gsd_handle* handle)
+    {
+    uint64_t start = gsd_stats_now();
+    int retval = 0;
+#if GSD_USE_MMAP
+    // fsync does not cover data written through a mapping on all systems
+    if (handle->write_map.data != NULL)
+        {
+        retval = msync(handle->write_map.data, handle->write_map.size, MS_SYNC);
+        }
+#endif
+    if (retval == 0)
+        {
+        retval = fsync(handle->fd);
+        }
+    gsd_stats_add(&handle->stats.fsync_calls, 1);
+    gsd_stats_add(&handle->stats.fsync_ns, gsd_stats_now() - start);
+    if (retval != 0)
+        {
+        return GSD_ERROR_IO;
+        }
+
+    handle->sync_frame = handle->cur_frame;
+    handle->sync_time = (int64_t)time(NULL);
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Sync the file before it refers to newly written metadata
+
+    @param handle Handle to the open gsd file.
+
+    Only GSD_SYNC_ALWAYS syncs here, the other policies defer to gsd_sync_end_frame() and
+    gsd_close().
+
+    @returns GSD_SUCCESS on success, GSD_ERROR_IO on error.
+*/
+inline static int gsd_sync_barrier(struct gsd_handle* handle)
+    {
+    if (handle->sync_policy != GSD_SYNC_ALWAYS)
+        {
+        return GSD_SUCCESS;
+        }
+
+    return gsd_sync(handle);
+    }
+
+/** @internal
+    @brief Sync the file at the end of a frame when the sync interval has passed
+
+    @param handle Handle to the open gsd file.
+
+    @returns GSD_SUCCESS on success, GSD_ERROR_IO on error.
+*/
+inline static int gsd_sync_end_frame(struct gsd_handle* handle)
+    {
+    if (handle->sync_policy == GSD_SYNC_EVERY_N_FRAMES
+        && handle->cur_frame - handle->sync_frame >= handle->sync_interval)
+        {
+        return gsd_sync(handle);
+        }
+    if (handle->sync_policy == GSD_SYNC_EVERY_N_SECONDS
+        && (int64_t)time(NULL) - handle->sync_time >= (int64_t)handle->sync_interval)
+        {
+        return gsd_sync(handle);
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Unmap the mapped write region
+
+    @param handle Handle to the open gsd file.
+    @param trim Non-zero to truncate the preallocated space past the end of the written data.
+
+    @returns GSD_SUCCESS on success, GSD_ERROR_IO on error.
+*/
+inline static int gsd_write_map_release(struct gsd_handle* handle, int trim)
+    {
+#if GSD_USE_MMAP
+    struct gsd_write_map* map = &handle->write_map;
+    if (map->data != NULL)
+        {
+        munmap(map->data, map->size);
+        map->data = NULL;
+        map->offset = 0;
+        map->size = 0;
+        }
+
+    if (trim && map->allocated > handle->file_size)
+        {
+        if (ftruncate(handle->fd, handle->file_size) != 0)
+            {
+            return GSD_ERROR_IO;
+            }
+        map->allocated = 0;
+        }
+#else
+    (void)handle;
+    (void)trim;
+#endif
+
+    return GSD_SUCCESS;
+    }
+
+#if GSD_USE_MMAP
+/** @internal
+    @brief Map space for a chunk at the end of the file
+
+    @param handle Handle to the open gsd file.
+    @param size Number of bytes to write at gsd_handle::file_size.
+
+    Maps a new region when the current one does not hold the chunk. The region starts at the page
+    that contains the end of the file and holds at least gsd_handle::write_map_size bytes.
+
+    @returns GSD_SUCCESS on success, GSD_ERROR_IO on error.
+*/
+inline static int gsd_write_map_reserve(struct gsd_handle* handle, size_t size)
+    {
+    struct gsd_write_map* map = &handle->write_map;
+    int64_t begin = handle->file_size;
+    int64_t end = begin + (int64_t)size;
+    if (map->data != NULL && begin >= map->offset && end <= map->offset + (int64_t)map->size)
+        {
+        return GSD_SUCCESS;
+        }
+
+    int retval = gsd_write_map_release(handle, 0);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    int64_t page_size = sysconf(_SC_PAGESIZE);
+    int64_t offset = begin - begin % page_size;
+    int64_t length = (int64_t)handle->write_map_size;
+    if (end - offset > length)
+        {
+        length = end - offset;
+        }
+    length = ((length + page_size - 1) / page_size) * page_size;
+
+    if (offset + length > map->allocated)
+        {
+        retval = gsd_io_preallocate(handle->fd, offset, length);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        map->allocated = offset + length;
+        }
+
+    void* data = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, handle->fd, offset);
+    if (data == MAP_FAILED)
+        {
+        return GSD_ERROR_IO;
+        }
+
+    map->data = (char*)data;
+    map->offset = offset;
+    map->size = length;
+    return GSD_SUCCESS;
+    }
+#endif
+
+/** @internal
+    @brief Grow a chained index by appending a segment to the file.
+
+    @param handle Handle to the open gsd file.
+    @param segment_size Number of entries in the new segment.
+
+    The new segment is allocated by extending the file, which reads back as zeros, and existing
+    index entries stay in place. The first segment appended writes the segment table and converts
+    the file to a v3.0 file.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_append_index_segment(struct gsd_handle* handle, size_t segment_size)
+    {
+    int first_segment = (handle->n_index_segments == 0);
+    size_t n_segments = first_segment ? 1 : handle->n_index_segments;
+
+    if (n_segments == GSD_INDEX_SEGMENT_TABLE_SIZE)
+        {
+        // unreachable in practice: each segment doubles the space in the index
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    uint64_t table_location = handle->header.index_segments_location;
+    size_t table_size = sizeof(struct gsd_index_segment) * GSD_INDEX_SEGMENT_TABLE_SIZE;
+    int64_t end = lseek(handle->fd, 0, SEEK_END);
+    if (end == -1)
+        {
+        return GSD_ERROR_IO;
+        }
+
+    if (first_segment)
+        {
+        // the first segment is the existing index block
+        gsd_util_zero_memory(handle->index_segments, table_size);
+        handle->index_segments[0].location = handle->header.index_location;
+        handle->index_segments[0].allocated_entries = handle->header.index_allocated_entries;
+        table_location = end;
+        end += table_size;
+        }
+
+    struct gsd_index_segment* segment = handle->index_segments + n_segments;
+    segment->location = end;
+    segment->allocated_entries = segment_size;
+    end += sizeof(struct gsd_index_entry) * segment_size;
+
+    // the existing entries stay in place, page the index so that they are read on demand
+    struct gsd_index_buffer buf;
+    gsd_util_zero_memory(&buf, sizeof(struct gsd_index_buffer));
+    int retval = gsd_index_buffer_page(&buf, handle->file_index.reserved + segment_size);
+    if (retval != GSD_SUCCESS)
+        {
+        segment->location = 0;
+        return retval;
+        }
+    buf.size = handle->file_index.size;
+
+    // extend the file, the segment reads back as zeros without writing them
+    retval = ftruncate(handle->fd, end);
+    if (retval != 0)
+        {
+        segment->location = 0;
+        gsd_index_buffer_free(&buf);
+        return GSD_ERROR_IO;
+        }
+
+    if (first_segment)
+        {
+        ssize_t bytes_written
+            = gsd_handle_pwrite(handle, handle->index_segments, table_size, table_location);
+        if (bytes_written == -1 || bytes_written != table_size)
+            {
+            segment->location = 0;
+            gsd_index_buffer_free(&buf);
+            return GSD_ERROR_IO;
+            }
+        }
+
+    // the new segment must be on disk before the file refers to it
+    retval = gsd_sync_barrier(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        segment->location = 0;
+        gsd_index_buffer_free(&buf);
+        return retval;
+        }
+
+    if (first_segment)
+        {
+        // point the header at the segment table
+        struct gsd_header header = handle->header;
+        if (header.gsd_version < gsd_make_version(GSD_CHAINED_INDEX_FILE_VERSION, 0))
+            {
+            header.gsd_version = gsd_make_version(GSD_CHAINED_INDEX_FILE_VERSION, 0);
+            }
+        header.index_segments_location = table_location;
+
+        ssize_t bytes_written
+            = gsd_handle_pwrite(handle, &header, sizeof(struct gsd_header), 0);
+        if (bytes_written != sizeof(struct gsd_header))
+            {
+            segment->location = 0;
+            gsd_index_buffer_free(&buf);
+            return GSD_ERROR_IO;
+            }
+        handle->header = header;
+        }
+    else
+        {
+        ssize_t bytes_written
+            = gsd_handle_pwrite(handle,
+                                  segment,
+                                  sizeof(struct gsd_index_segment),
+                                  table_location + sizeof(struct gsd_index_segment) * n_segments);
+        if (bytes_written != sizeof(struct gsd_index_segment))
+            {
+            segment->location = 0;
+            gsd_index_buffer_free(&buf);
+            return GSD_ERROR_IO;
+            }
+        }
+
+    // replace the file index with the larger buffer
+    retval = gsd_index_buffer_free(&handle->file_index);
+    if (retval != GSD_SUCCESS)
+        {
+        gsd_index_buffer_free(&buf);
+        return retval;
+        }
+    handle->file_index = buf;
+    handle->n_index_segments = n_segments + 1;
+    handle->file_size = end;
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Utility function to expand the memory space for the index block in the file.
+
+    @param handle Handle to the open gsd file.
+    @param size_required The new index must be able to hold at least this many elements.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_expand_file_index(struct gsd_handle* handle, size_t size_required)
+    {
+    if (handle->open_flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+
+    // the old index is copied from the file, complete all pending writes first
+    int retval = gsd_write_behind_wait(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // place the index right after the data rather than after the preallocated space
+    retval = gsd_write_map_release(handle, 1);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // multiply the index size each time it grows
+    // this allows the index to grow rapidly to accommodate new frames
+    const int multiplication_factor = 2;
+
+    // save the old size and update the new size
+    size_t size_old = handle->file_index.reserved;
+    size_t n_entries = handle->file_index.size;
+    size_t size_new = size_old * multiplication_factor;
+
+    while (size_new <= size_required)
+        {
+        size_new *= multiplication_factor;
+        }
+
+    gsd_stats_add(&handle->stats.index_expansions, 1);
+
+    // v1 files cannot chain segments as their index is not sorted
+    if (handle->n_index_segments > 0
+        || (handle->chained_index && handle->header.gsd_version >= gsd_make_version(2, 0)))
+        {
+        return gsd_append_index_segment(handle, size_new - size_old);
+        }
+
+    // Mac systems deadlock when writing from a mapped region into the tail end of that same region
+    // unmap the index first and copy it over by chunks
+    retval = gsd_index_buffer_free(&handle->file_index);
+    if (retval != 0)
+        {
+        return retval;
+        }
+
+    // allocate the copy buffer
+    char* buf = gsd_malloc(GSD_COPY_BUFFER_SIZE);
+
+    // write the current index to the end of the file
+    int64_t new_index_location = lseek(handle->fd, 0, SEEK_END);
+    int64_t old_index_location = handle->header.index_location;
+    size_t total_bytes_written = 0;
+    size_t old_index_bytes = size_old * sizeof(struct gsd_index_entry);
+    while (total_bytes_written < old_index_bytes)
+        {
+        size_t bytes_to_copy = GSD_COPY_BUFFER_SIZE;
+        if (old_index_bytes - total_bytes_written < GSD_COPY_BUFFER_SIZE)
+            {
+            bytes_to_copy = old_index_bytes - total_bytes_written;
+            }
+
+        ssize_t bytes_read = gsd_handle_pread(handle,
+                                                buf,
+                                                bytes_to_copy,
+                                                old_index_location + total_bytes_written);
+
+        if (bytes_read == -1 || bytes_read != bytes_to_copy)
+            {
+            gsd_free(buf);
+            return GSD_ERROR_IO;
+            }
+
+        ssize_t bytes_written = gsd_handle_pwrite(handle,
+                                                    buf,
+                                                    bytes_to_copy,
+                                                    new_index_location + total_bytes_written);
+
+        if (bytes_written == -1 || bytes_written != bytes_to_copy)
+            {
+            gsd_free(buf);
+            return GSD_ERROR_IO;
+            }
+
+        total_bytes_written += bytes_written;
+        }
+
+    // fill the new index space with 0s
+    gsd_util_zero_memory(buf, GSD_COPY_BUFFER_SIZE);
+
+    size_t new_index_bytes = size_new * sizeof(struct gsd_index_entry);
+    while (total_bytes_written < new_index_bytes)
+        {
+        size_t bytes_to_copy = GSD_COPY_BUFFER_SIZE;
+        if (new_index_bytes - total_bytes_written < GSD_COPY_BUFFER_SIZE)
+            {
+            bytes_to_copy = new_index_bytes - total_bytes_written;
+            }
+
+        ssize_t bytes_written = gsd_handle_pwrite(handle,
+                                                    buf,
+                                                    bytes_to_copy,
+                                                    new_index_location + total_bytes_written);
+
+        if (bytes_written == -1 || bytes_written != bytes_to_copy)
+            {
+            gsd_free(buf);
+            return GSD_ERROR_IO;
+            }
+
+        total_bytes_written += bytes_written;
+        }
+
+    // sync the expanded index
+    retval = gsd_sync_barrier(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        gsd_free(buf);
+        return retval;
+        }
+
+    // free the copy buffer
+    gsd_free(buf);
+
+    // update the header
+    handle->header.index_location = new_index_location;
+    handle->file_size = handle->header.index_location + total_bytes_written;
+    handle->header.index_allocated_entries = size_new;
+
+    // write the new header out
+    ssize_t bytes_written
+        = gsd_handle_pwrite(handle, &(handle->header), sizeof(struct gsd_header), 0);
+    if (bytes_written != sizeof(struct gsd_header))
+        {
+        return GSD_ERROR_IO;
+        }
+
+    // sync the updated header
+    retval = gsd_sync_barrier(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // remap the file index, which holds the same entries
+    retval = gsd_index_buffer_map(&handle->file_index, handle, n_entries);
+    if (retval != 0)
+        {
+        return retval;
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Write index entries to the file index.
+
+    @param handle Handle to the open gsd file.
+    @param entries Entries to write.
+    @param n Number of entries to write.
+    @param position Position of the first entry in the file index.
+
+    Converts the entries to the layout of the file and splits the write at segment boundaries when
+    the index is chained. Queues the writes when write-behind is enabled.
+
+    @pre The file index has space for *n* entries after *position*.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_write_index_entries(struct gsd_handle* handle,
+                                          const struct gsd_index_record* entries,
+                                          size_t n,
+                                          size_t position)
+    {
+    struct gsd_index_segment single_segment;
+    const struct gsd_index_segment* segments = handle->index_segments;
+    size_t n_segments = handle->n_index_segments;
+    if (n_segments == 0)
+        {
+        single_segment.location = handle->header.index_location;
+        single_segment.allocated_entries = handle->header.index_allocated_entries;
+        segments = &single_segment;
+        n_segments = 1;
+        }
+
+    // find the segment that holds position
+    size_t segment_begin = 0;
+    size_t i = 0;
+    while (i < n_segments && position >= segment_begin + segments[i].allocated_entries)
+        {
+        segment_begin += segments[i].allocated_entries;
+        i++;
+        }
+
+    while (n > 0)
+        {
+        if (i >= n_segments)
+            {
+            return GSD_ERROR_INVALID_ARGUMENT;
+            }
+
+        size_t n_to_write = segment_begin + segments[i].allocated_entries - position;
+        if (n_to_write > n)
+            {
+            n_to_write = n;
+            }
+        int64_t write_pos = segments[i].location
+                            + sizeof(struct gsd_index_entry) * (position - segment_begin);
+        size_t bytes_to_write = sizeof(struct gsd_index_entry) * n_to_write;
+
+        char* copy = gsd_malloc(bytes_to_write);
+        if (copy == NULL)
+            {
+            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+        gsd_index_records_to_file(copy, entries, n_to_write, gsd_has_wide_ids(handle));
+
+        if (handle->write_behind != NULL)
+            {
+            // queue the index entries after the data they refer to
+            int retval = gsd_write_behind_queue(handle, copy, 0, bytes_to_write, 0, write_pos, -1);
+            if (retval != GSD_SUCCESS)
+                {
+                return retval;
+                }
+            }
+        else
+            {
+            ssize_t bytes_written = gsd_handle_pwrite(handle, copy, bytes_to_write, write_pos);
+            gsd_free(copy);
+
+            if (bytes_written == -1 || bytes_written != bytes_to_write)
+                {
+                return GSD_ERROR_IO;
+                }
+            }
+
+        entries += n_to_write;
+        n -= n_to_write;
+        position += n_to_write;
+        segment_begin += segments[i].allocated_entries;
+        i++;
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Flush the write buffer.
+
+    gsd_write_frame() writes small data chunks into the write buffer. It adds index entries for
+    these chunks to gsd_handle::buffer_index with locations offset from the start of the write
+    buffer. gsd_flush_write_buffer() writes the buffer to the end of the file, moves the index
+    entries to gsd_handle::frame_index and updates the location to reference the beginning of the
+    file.
+
+    @param handle Handle to flush the write buffer.
+    @returns GSD_SUCCESS on success or GSD_* error codes on error
+*/
+inline static int gsd_flush_write_buffer(struct gsd_handle* handle)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    if (handle->write_buffer.size == 0 && handle->buffer_index.size == 0)
+        {
+        // nothing to do
+        return GSD_SUCCESS;
+        }
+
+    if (handle->write_buffer.size > 0 && handle->buffer_index.size == 0)
+        {
+        // error: bytes in buffer, but no index for them
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    gsd_stats_add(&handle->stats.write_buffer_flushes, 1);
+
+    // write the buffer to the end of the file
+    uint64_t offset = handle->file_size;
+    if (handle->write_behind != NULL)
+        {
+        // hand the buffer to the background writer and continue with a new one
+        char* new_data = gsd_write_behind_get_buffer(handle, handle->write_buffer.reserved);
+        if (new_data == NULL)
+            {
+            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+
+        char* old_data = handle->write_buffer.data;
+        handle->write_buffer.data = new_data;
+
+        int retval = gsd_write_behind_queue(handle,
+                                            old_data,
+                                            0,
+                                            handle->write_buffer.size,
+                                            handle->write_buffer.reserved,
+                                            offset,
+                                            -1);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+    else
+        {
+        ssize_t bytes_written = gsd_handle_pwrite(handle,
+                                                    handle->write_buffer.data,
+                                                    handle->write_buffer.size,
+                                                    offset);
+
+        if (bytes_written == -1 || bytes_written != handle->write_buffer.size)
+            {
+            return GSD_ERROR_IO;
+            }
+        }
+
+    handle->file_size += handle->write_buffer.size;
+
+    // reset write_buffer for new data
+    handle->write_buffer.size = 0;
+
+    // move buffer_index entries to file_index
+    size_t i;
+    for (i = 0; i < handle->buffer_index.size; i++)
+        {
+        struct gsd_index_record* new_index;
+        int retval = gsd_index_buffer_add(&handle->frame_index, &new_index);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+
+        *new_index = handle->buffer_index.data[i];
+        new_index->entry.location += offset;
+        }
+
+    // clear the buffer index for new entries
+    handle->buffer_index.size = 0;
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Write chunk data and add its index entry
+
+    @param handle Handle to the open gsd file.
+    @param entry Index record for the chunk (the location is set by this function).
+    @param data Data to store in the file.
+    @param size Number of bytes in *data*.
+
+    Small chunks are added to the write buffer. Large chunks are written directly to the end of
+    the file. With a mapped write region (see gsd_set_write_map_size()), all chunks are copied into
+    the mapping at the end of the file.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_write_entry(struct gsd_handle* handle,
+                                  struct gsd_index_record* entry,
+                                  const char* data,
+                                  size_t size)
+    {
+#if GSD_USE_MMAP
+    if (handle->write_map_size > 0)
+        {
+        // copy the data straight into the file
+        int retval = gsd_write_map_reserve(handle, size);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+
+        struct gsd_index_record* index_entry;
+        retval = gsd_index_buffer_add(&handle->frame_index, &index_entry);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        *index_entry = *entry;
+        index_entry->entry.location = handle->file_size;
+
+        if (size > 0)
+            {
+            memcpy(handle->write_map.data + (handle->file_size - handle->write_map.offset),
+                   data,
+                   size);
+            }
+        handle->file_size += size;
+        return GSD_SUCCESS;
+        }
+#endif
+
+    // decide whether to write this chunk to the buffer or straight to disk
+    if (size < handle->write_buffer.reserved / 2)
+        {
+        // flush the buffer if this entry won't fit
+        if (size > (handle->write_buffer.reserved - handle->write_buffer.size))
+            {
+            int retval = gsd_flush_write_buffer(handle);
+            if (retval != GSD_SUCCESS)
+                {
+                return retval;
+                }
+            }
+
+        entry->entry.location = handle->write_buffer.size;
+
+        // add an entry to the buffer index
+        struct gsd_index_record* index_entry;
+
+        int retval = gsd_index_buffer_add(&handle->buffer_index, &index_entry);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        *index_entry = *entry;
+
+        // add the data to the write buffer
+        if (size > 0)
+            {
+            retval = gsd_byte_buffer_append(&handle->write_buffer, data, size);
+            if (retval != GSD_SUCCESS)
+                {
+                return retval;
+                }
+            }
+        }
+    else
+        {
+        // add an entry to the frame index
+        struct gsd_index_record* index_entry;
+
+        int retval = gsd_index_buffer_add(&handle->frame_index, &index_entry);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        *index_entry = *entry;
+
+        // find the location at the end of the file for the chunk
+        index_entry->entry.location = handle->file_size;
+
+        // write the data
+        if (handle->write_behind != NULL)
+            {
+            // the caller may reuse data after this call returns, queue a copy
+            char* copy = NULL;
+            size_t start = 0;
+            int direct_fd = -1;
+#if GSD_USE_DIRECT_IO
+            if (handle->direct_io)
+                {
+                // place the copy so that the blocks of the file are aligned in memory
+                start = index_entry->entry.location % GSD_DIRECT_IO_ALIGNMENT;
+                direct_fd = handle->direct_io_fd;
+                if (posix_memalign((void**)&copy, GSD_DIRECT_IO_ALIGNMENT, start + size) != 0)
+                    {
+                    copy = NULL;
+                    }
+                }
+            else
+#endif
+                {
+                copy = gsd_malloc(size);
+                }
+            if (copy == NULL)
+                {
+                return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+                }
+            memcpy(copy + start, data, size);
+
+            retval = gsd_write_behind_queue(handle,
+                                            copy,
+                                            start,
+                                            size,
+                                            0,
+                                            index_entry->entry.location,
+                                            direct_fd);
+            if (retval != GSD_SUCCESS)
+                {
+                return retval;
+                }
+            }
+        else
+            {
+            ssize_t bytes_written;
+#if GSD_USE_DIRECT_IO
+            if (handle->direct_io)
+                {
+                bytes_written = gsd_io_pwrite_direct(handle->fd,
+                                                     handle->direct_io_fd,
+                                                     data,
+                                                     size,
+                                                     index_entry->entry.location);
+                gsd_stats_count_io(&handle->stats, 1, bytes_written);
+                }
+            else
+#endif
+                {
+                bytes_written = gsd_handle_pwrite(handle, data, size, index_entry->entry.location);
+                }
+            if (bytes_written == -1 || bytes_written != size)
+                {
+                return GSD_ERROR_IO;
+                }
+            }
+
+        // update the file_size in the handle
+        handle->file_size += size;
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Write the file index to a new index block at the end of the file.
+
+    @param handle Handle to the open gsd file.
+    @param version File version to label the file with.
+    @param sort Set to non-zero to sort the entries, which v1 files do not.
+
+    Writes the entries in the layout of *version* as a single index block, then points the header
+    at the new block. The index segment table and the frame table are no longer used.
+
+    @pre Writes queued for the background writer are complete.
+    @pre Every entry fits in the layout of *version*.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_rewrite_index(struct gsd_handle* handle, uint32_t version, int sort)
+    {
+    // make a copy of the file index
+    struct gsd_index_buffer buf;
+    gsd_util_zero_memory(&buf, sizeof(struct gsd_index_buffer));
+    int retval = gsd_index_buffer_allocate(&buf, handle->file_index.reserved);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+    size_t i;
+    for (i = 0; i < handle->file_index.size; i++)
+        {
+        const struct gsd_index_entry* entry;
+        retval = gsd_index_buffer_get(&handle->file_index, handle, i, &entry);
+        if (retval != GSD_SUCCESS)
+            {
+            gsd_index_buffer_free(&buf);
+            return retval;
+            }
+        buf.data[i].entry = *entry;
+        buf.data[i].id = gsd_entry_id(handle, entry);
+        }
+    buf.size = handle->file_index.size;
+
+    if (sort)
+        {
+        retval = gsd_index_buffer_sort(&buf);
+        if (retval != GSD_SUCCESS)
+            {
+            gsd_index_buffer_free(&buf);
+            return retval;
+            }
+        }
+
+    // place the index right after the data, chunks reserved by gsd_reserve_chunk() may extend
+    // past the end of the file
+    retval = gsd_write_map_release(handle, 1);
+    if (retval != GSD_SUCCESS)
+        {
+        gsd_index_buffer_free(&buf);
+        return retval;
+        }
+    int64_t new_index_location = handle->file_size;
+
+    // convert the copy in place and write it as a single index block
+    int wide
+        = version >= gsd_make_version(GSD_WIDE_ID_FILE_VERSION, GSD_WIDE_ID_FILE_VERSION_MINOR);
+    gsd_index_records_to_file((char*)buf.data, buf.data, buf.reserved, wide);
+    size_t index_bytes = sizeof(struct gsd_index_entry) * buf.reserved;
+    ssize_t bytes_written = gsd_handle_pwrite(handle, buf.data, index_bytes, new_index_location);
+    size_t new_index_allocated_entries = buf.reserved;
+    gsd_index_buffer_free(&buf);
+
+    if (bytes_written == -1 || bytes_written != index_bytes)
+        {
+        return GSD_ERROR_IO;
+        }
+
+    // sync the new index, and a name list written before it, before the header refers to them
+    retval = gsd_sync_barrier(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // label the file with the new version and point it at the new index
+    struct gsd_header header = handle->header;
+    header.gsd_version = version;
+    header.index_location = new_index_location;
+    header.index_allocated_entries = new_index_allocated_entries;
+    header.index_segments_location = 0;
+    header.frame_table_location = 0;
+
+    // write the new header out
+    bytes_written = gsd_handle_pwrite(handle, &header, sizeof(struct gsd_header), 0);
+    if (bytes_written != sizeof(struct gsd_header))
+        {
+        return GSD_ERROR_IO;
+        }
+
+    // sync the updated header
+    retval = gsd_sync_barrier(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    size_t n_entries = handle->file_index.size;
+    handle->header = header;
+    handle->n_index_segments = 0;
+    handle->file_size = new_index_location + index_bytes;
+
+    // remap the file index
+    gsd_frame_directory_free(&handle->frame_directory);
+    gsd_frame_table_free(&handle->frame_table);
+    retval = gsd_index_buffer_free(&handle->file_index);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    return gsd_index_buffer_map(&handle->file_index, handle, n_entries);
+    }
+
+/** @internal
+    @brief Test if the index entries of a buffer fit in the layout of v3.1 files
+
+    @param buf Buffer to test.
+    @param handle GSD file handle with *buf* as its file index, or an in-memory buffer.
+
+    @returns GSD_SUCCESS when every entry has M <= UINT16_MAX, GSD_ERROR_NAMELIST_FULL when an
+    entry has a larger M, and other GSD_* error codes when the entries cannot be read.
+*/
+inline static int gsd_index_buffer_check_wide(struct gsd_index_buffer* buf,
+                                              struct gsd_handle* handle)
+    {
+    size_t i;
+    for (i = 0; i < buf->size; i++)
+        {
+        const struct gsd_index_entry* entry;
+        int retval = gsd_index_buffer_get(buf, handle, i, &entry);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        if (entry->M > UINT16_MAX)
+            {
+            return GSD_ERROR_NAMELIST_FULL;
+            }
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Convert the file to a v3.1 file, which stores 32-bit name ids.
+
+    @param handle Handle to the open gsd file.
+
+    Rewrites the index in the v3.1 layout at the end of the file. The entries of the current frame
+    are written in the v3.1 layout by gsd_end_frame().
+
+    @returns GSD_SUCCESS on success, GSD_ERROR_NAMELIST_FULL when a chunk in the file or in the
+    current frame has more than UINT16_MAX columns, other GSD_* error codes on error.
+*/
+inline static int gsd_widen_ids(struct gsd_handle* handle)
+    {
+    // the index is copied from the file, complete all pending writes first
+    int retval = gsd_write_behind_wait(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    retval = gsd_index_buffer_check_wide(&handle->file_index, handle);
+    if (retval == GSD_SUCCESS)
+        {
+        retval = gsd_index_buffer_check_wide(&handle->frame_index, handle);
+        }
+    if (retval == GSD_SUCCESS)
+        {
+        retval = gsd_index_buffer_check_wide(&handle->buffer_index, handle);
+        }
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    return gsd_rewrite_index(
+        handle,
+        gsd_make_version(GSD_WIDE_ID_FILE_VERSION, GSD_WIDE_ID_FILE_VERSION_MINOR),
+        0);
+    }
+
+/** @internal
+    @brief Flush the name buffer.
+
+    gsd_write_frame() adds new names to the frame_names buffer. gsd_flush_name_buffer() flushes
+    this buffer at the end of a frame write and commits the new names to the file. If necessary,
+    the namelist is written to a new location in the file.
+
+    @param handle Handle to flush the write buffer.
+    @returns GSD_SUCCESS on success or GSD_* error codes on error
+*/
+inline static int gsd_flush_name_buffer(struct gsd_handle* handle)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    if (handle->frame_names.n_names == 0)
+        {
+        // nothing to do
+        return GSD_SUCCESS;
+        }
+
+    if (handle->frame_names.data.size == 0)
+        {
+        // error: bytes in buffer, but no names for them
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    size_t old_reserved = handle->file_names.data.reserved;
+    size_t old_size = handle->file_names.data.size;
+
+    // add the new names to the file name list and zero the frame list
+    int retval = gsd_byte_buffer_append(&handle->file_names.data,
+                                        handle->frame_names.data.data,
+                                        handle->frame_names.data.size);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    handle->file_names.n_names += handle->frame_names.n_names;
+    handle->frame_names.n_names = 0;
+    handle->frame_names.data.size = 0;
+    gsd_util_zero_memory(handle->frame_names.data.data, handle->frame_names.data.reserved);
+
+    // reserved space must be a multiple of the GSD name size
+    if (handle->file_names.data.reserved % GSD_NAME_SIZE != 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    if (handle->file_names.data.reserved > old_reserved)
+        {
+        // write the new name list to the end of the file
+        uint64_t offset = handle->file_size;
+        ssize_t bytes_written = gsd_handle_pwrite(handle,
+                                                    handle->file_names.data.data,
+                                                    handle->file_names.data.reserved,
+                                                    offset);
+
+        if (bytes_written == -1 || bytes_written != handle->file_names.data.reserved)
+            {
+            return GSD_ERROR_IO;
+            }
+
+        // sync the updated name list
+        retval = gsd_sync_barrier(handle);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+
+        handle->file_size += handle->file_names.data.reserved;
+        handle->header.namelist_location = offset;
+        handle->header.namelist_allocated_entries
+            = handle->file_names.data.reserved / GSD_NAME_SIZE;
+
+        // write the new header out
+        bytes_written
+            = gsd_handle_pwrite(handle, &(handle->header), sizeof(struct gsd_header), 0);
+        if (bytes_written != sizeof(struct gsd_header))
+            {
+            return GSD_ERROR_IO;
+            }
+        }
+    else
+        {
+        // write the new name list to the old index location
+        uint64_t offset = handle->header.namelist_location;
+        ssize_t bytes_written = gsd_handle_pwrite(handle,
+                                                    handle->file_names.data.data + old_size,
+                                                    handle->file_names.data.reserved - old_size,
+                                                    offset + old_size);
+        if (bytes_written != (handle->file_names.data.reserved - old_size))
+            {
+            return GSD_ERROR_IO;
+            }
+        }
+
+    // sync the updated name list or header
+    retval = gsd_sync_barrier(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief utility function to append a name to the namelist
+
+    @param id [out] ID of the new name
+    @param handle handle to the open gsd file
+    @param name string name
+
+    Append a name to the names in the current frame. gsd_end_frame() will add this list to the
+    file names.
+
+    @return
+      - GSD_SUCCESS (0) on success. Negative value on failure:
+      - GSD_ERROR_IO: IO error (check errno).
+      - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+      - GSD_ERROR_FILE_MUST_BE_WRITABLE: File must not be read only.
+*/
+inline static int gsd_append_name(uint32_t* id, struct gsd_handle* handle, const char* name)
+    {
+    if (handle->open_flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+
+    // files before v3.1 store 16-bit ids
+    size_t max_names = UINT32_MAX;
+    if (!gsd_has_wide_ids(handle))
+        {
+        max_names = UINT16_MAX;
+        }
+
+    if (handle->file_names.n_names + handle->frame_names.n_names == max_names)
+        {
+        if (gsd_has_wide_ids(handle) || handle->header.gsd_version < gsd_make_version(2, 0))
+            {
+            // no more names may be added
+            return GSD_ERROR_NAMELIST_FULL;
+            }
+
+        // store 32-bit ids from now on
+        int retval = gsd_widen_ids(handle);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    // Provide the ID of the new name
+    *id = (uint32_t)(handle->file_names.n_names + handle->frame_names.n_names);
+
+    if (handle->header.gsd_version < gsd_make_version(2, 0))
+        {
+        // v1 files always allocate GSD_NAME_SIZE bytes for each name and put a NULL terminator
+        // at address 63
+        char name_v1[GSD_NAME_SIZE];
+        strncpy(name_v1, name, GSD_NAME_SIZE - 1);
+        name_v1[GSD_NAME_SIZE - 1] = 0;
+        gsd_byte_buffer_append(&handle->frame_names.data, name_v1, GSD_NAME_SIZE);
+        handle->frame_names.n_names++;
+
+        // update the name/id mapping with the truncated name
+        int retval = gsd_name_id_map_insert(&handle->name_map, name_v1, *id);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+    else
+        {
+        gsd_byte_buffer_append(&handle->frame_names.data, name, strlen(name) + 1);
+        handle->frame_names.n_names++;
+
+        // update the name/id mapping
+        int retval = gsd_name_id_map_insert(&handle->name_map, name, *id);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Encode and write a data chunk to the current frame
+
+    @param handle Handle to the open gsd file.
+    @param name Name of the data chunk, or NULL to write the chunk with id *id*.
+    @param id Id of the chunk name (used when *name* is NULL).
+    @param type Type ID of the data in *data*.
+    @param N Number of rows in the data.
+    @param M Number of columns in the data.
+    @param flags Encoding flags.
+    @param precision Maximum absolute error of quantized values (used with GSD_FLAG_QUANTIZE).
+    @param data Data buffer.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_write_encoded_chunk(struct gsd_handle* handle,
+                                          const char* name,
+                                          uint32_t id,
+                                          enum gsd_type type,
+                                          uint64_t N,
+                                          uint32_t M,
+                                          uint8_t flags,
+                                          double precision,
+                                          const void* data)
+    {
+    // validate input
+    if (N > 0 && data == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (M == 0 || (M > UINT16_MAX && gsd_has_wide_ids(handle)))
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (handle->open_flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+    if (!gsd_is_encoding_valid(flags))
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    // report errors from the background writer
+    int retval = gsd_write_behind_check(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    if (name != NULL)
+        {
+        id = gsd_name_id_map_find(&handle->name_map, name, &handle->stats);
+        if (id == UINT32_MAX)
+            {
+            // v3.1 files cannot store the chunk, keep the file from converting to add its name
+            if (M > UINT16_MAX
+                && handle->file_names.n_names + handle->frame_names.n_names >= UINT16_MAX)
+                {
+                return GSD_ERROR_NAMELIST_FULL;
+                }
+
+            // not found, append to the index
+            retval = gsd_append_name(&id, handle, name);
+            if (retval != GSD_SUCCESS)
+                {
+                return retval;
+                }
+
+            if (id == UINT32_MAX)
+                {
+                // this should never happen
+                return GSD_ERROR_NAMELIST_FULL;
+                }
+            }
+        }
+    else if (id >= handle->file_names.n_names + handle->frame_names.n_names)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    struct gsd_index_record record;
+    struct gsd_index_entry* entry = &record.entry;
+    // populate fields in the entry's data
+    gsd_util_zero_memory(&record, sizeof(struct gsd_index_record));
+    entry->frame = handle->cur_frame;
+    gsd_index_record_set_id(&record, id);
+    entry->type = (uint8_t)type;
+    entry->N = N;
+    entry->M = M;
+    size_t size = N * M * gsd_sizeof_type(type);
+
+    // XOR delta encoded chunks with a recent keyframe of the same shape, or start a new keyframe
+    const void* encode_data = data;
+    char* delta = NULL;
+    uint64_t keyframe_frame = 0;
+    bool is_keyframe = false;
+    if ((flags & GSD_FLAG_DELTA) && size > 0)
+        {
+        const struct gsd_keyframe* keyframe = gsd_keyframe_cache_find(&handle->keyframe_cache, id);
+        if (keyframe != NULL && keyframe->entry.type == entry->type && keyframe->entry.N == N
+            && keyframe->entry.M == M
+            && handle->cur_frame - keyframe->entry.frame < handle->keyframe_interval)
+            {
+            delta = gsd_malloc(size);
+            if (delta == NULL)
+                {
+                return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+                }
+
+            const char* in = (const char*)data;
+            size_t i;
+            for (i = 0; i < size; i++)
+                {
+                delta[i] = (char)(in[i] ^ keyframe->data[i]);
+                }
+            encode_data = delta;
+            keyframe_frame = keyframe->entry.frame;
+            }
+        else
+            {
+            is_keyframe = true;
+            }
+        }
+
+    // encode the chunk
+    const char* write_data = (const char*)data;
+    size_t write_size = size;
+    char* encoded = NULL;
+    if (flags != 0 && size > 0)
+        {
+        size_t encoded_size = 0;
+        uint8_t encoded_flags = 0;
+        retval = gsd_encode_chunk(&encoded,
+                                  &encoded_size,
+                                  &encoded_flags,
+                                  encode_data,
+                                  size,
+                                  type,
+                                  (uint8_t)(flags & ~GSD_FLAG_DELTA),
+                                  handle->compression_level,
+                                  precision);
+        if (retval != GSD_SUCCESS)
+            {
+            gsd_free(delta);
+            return retval;
+            }
+
+        // chunks that do not compress are stored in full, not as a delta
+        if (encoded != NULL)
+            {
+            entry->flags = encoded_flags;
+            write_data = encoded;
+            write_size = encoded_size;
+
+            if (delta != NULL)
+                {
+                struct gsd_chunk_header header;
+                memcpy(&header, encoded, sizeof(struct gsd_chunk_header));
+                header.parameters[GSD_DELTA_PARAMETER_FRAME] = keyframe_frame;
+                memcpy(encoded, &header, sizeof(struct gsd_chunk_header));
+                entry->flags |= GSD_FLAG_DELTA;
+                }
+            }
+        }
+    gsd_free(delta);
+
+    retval = gsd_write_entry(handle, &record, write_data, write_size);
+    gsd_free(encoded);
+
+    if (retval == GSD_SUCCESS && is_keyframe)
+        {
+        gsd_keyframe_cache_update(&handle->keyframe_cache, id, entry, data, size);
+        }
+
+    return retval;
+    }
+
+/** @internal
+    @brief Truncate the file and write a new gsd header.
+
+    @param fd file descriptor to initialize
+    @param application Generating application name (truncated to 63 chars)
+    @param schema Schema name for data to be written in this GSD file (truncated to 63 chars)
+    @param schema_version Version of the scheme data to be written (make with gsd_make_version())
+*/
+inline static int
+gsd_initialize_file(int fd, const char* application, const char* schema, uint32_t schema_version)
+    {
+    // check if the file was created
+    if (fd == -1)
+        {
+        return GSD_ERROR_IO;
+        }
+
+    int retval = ftruncate(fd, 0);
+    if (retval != 0)
+        {
+        return GSD_ERROR_IO;
+        }
+
+    // populate header fields
+    struct gsd_header header;
+    gsd_util_zero_memory(&header, sizeof(header));
+
+    header.magic = GSD_MAGIC_ID;
+    header.gsd_version = gsd_make_version(GSD_CURRENT_FILE_VERSION, 0);
+    strncpy(header.application, application, sizeof(header.application) - 1);
+    header.application[sizeof(header.application) - 1] = 0;
+    strncpy(header.schema, schema, sizeof(header.schema) - 1);
+    header.schema[sizeof(header.schema) - 1] = 0;
+    header.schema_version = schema_version;
+    header.index_location = sizeof(header);
+    header.index_allocated_entries = GSD_INITIAL_INDEX_SIZE;
+    header.namelist_location
+        = header.index_location + sizeof(struct gsd_index_entry) * header.index_allocated_entries;
+    header.namelist_allocated_entries = GSD_INITIAL_NAME_BUFFER_SIZE / GSD_NAME_SIZE;
+    gsd_util_zero_memory(header.reserved, sizeof(header.reserved));
+
+    // write the header out
+    ssize_t bytes_written = gsd_io_pwrite_retry(fd, &header, sizeof(header), 0);
+    if (bytes_written != sizeof(header))
+        {
+        return GSD_ERROR_IO;
+        }
+
+    // allocate and zero default index memory
+    struct gsd_index_entry index[GSD_INITIAL_INDEX_SIZE];
+    gsd_util_zero_memory(index, sizeof(index));
+
+    // write the empty index out
+    bytes_written = gsd_io_pwrite_retry(fd, index, sizeof(index), sizeof(header));
+    if (bytes_written != sizeof(index))
+        {
+        return GSD_ERROR_IO;
+        }
+
+    // allocate and zero the namelist memory
+    char names[GSD_INITIAL_NAME_BUFFER_SIZE];
+    gsd_util_zero_memory(names, sizeof(char) * GSD_INITIAL_NAME_BUFFER_SIZE);
+
+    // write the namelist out
+    bytes_written = gsd_io_pwrite_retry(fd, names, sizeof(names), sizeof(header) + sizeof(index));
+    if (bytes_written != sizeof(names))
+        {
+        return GSD_ERROR_IO;
+        }
+
+    // sync file
+    retval = fsync(fd);
+    if (retval != 0)
+        {
+        return GSD_ERROR_IO;
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Find the next name in the name list
+
+    @param handle Handle to the open gsd file.
+    @param name_start Offset of a name in gsd_handle::file_names.
+
+    @returns The offset of the name that follows.
+*/
+inline static size_t gsd_name_list_next(struct gsd_handle* handle, size_t name_start)
+    {
+    if (handle->header.gsd_version < gsd_make_version(2, 0))
+        {
+        // gsd v1 stores names in fixed 64 byte segments
+        return name_start + GSD_NAME_SIZE;
+        }
+
+    const char* name = handle->file_names.data.data + name_start;
+    return name_start + strnlen(name, handle->file_names.data.reserved - name_start) + 1;
+    }
+
+/** @internal
+    @brief Add names from the name list to the name/id map
+
+    @param handle Handle to the open gsd file.
+    @param max_names Stop once the handle holds this many names.
+
+    Scans gsd_handle::file_names from the end of the names that are already in the map and
+    updates the number of used bytes in the name list. Counts the new names first so that the map
+    grows at most once.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_scan_names(struct gsd_handle* handle, size_t max_names)
+    {
+    size_t n_new_names = 0;
+    size_t n_new_bytes = 0;
+    size_t name_start = handle->file_names.data.size;
+    while (name_start < handle->file_names.data.reserved
+           && handle->file_names.n_names + n_new_names < max_names)
+        {
+        const char* name = handle->file_names.data.data + name_start;
+
+        // an empty name notes the end of the list
+        if (name[0] == 0)
+            {
+            break;
+            }
+
+        size_t next = gsd_name_list_next(handle, name_start);
+        n_new_names++;
+        n_new_bytes += strnlen(name, next - name_start) + 1;
+        name_start = next;
+        }
+
+    if (n_new_names == 0)
+        {
+        return GSD_SUCCESS;
+        }
+
+    int retval = gsd_name_id_map_reserve(&handle->name_map, n_new_names, n_new_bytes);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    name_start = handle->file_names.data.size;
+    size_t i;
+    for (i = 0; i < n_new_names; i++)
+        {
+        char* name = handle->file_names.data.data + name_start;
+        retval
+            = gsd_name_id_map_insert(&handle->name_map, name, (uint32_t)handle->file_names.n_names);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        handle->file_names.n_names++;
+
+        name_start = gsd_name_list_next(handle, name_start);
+        handle->file_names.data.size = name_start;
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Read in the file index and initialize the handle.
+
+    @param handle Handle to read the header
+
+    @pre handle->fd is an open file.
+    @pre handle->open_flags is set.
+
+    @note The handle may hold allocated buffers on failure, see gsd_initialize_handle().
+*/
+inline static int gsd_load_handle(struct gsd_handle* handle)
+    {
+    // check if the file was created
+    if (handle->fd == -1)
+        {
+        return GSD_ERROR_IO;
+        }
+
+    // read the header
+    ssize_t bytes_read
+        = gsd_handle_pread(handle, &handle->header, sizeof(struct gsd_header), 0);
+    if (bytes_read == -1)
+        {
+        return GSD_ERROR_IO;
+        }
+    if (bytes_read != sizeof(struct gsd_header))
+        {
+        return GSD_ERROR_NOT_A_GSD_FILE;
+        }
+
+    // validate the header
+    if (handle->header.magic != GSD_MAGIC_ID)
+        {
+        return GSD_ERROR_NOT_A_GSD_FILE;
+        }
+
+    if (handle->header.gsd_version < gsd_make_version(1, 0)
+        && handle->header.gsd_version != gsd_make_version(0, 3))
+        {
+        return GSD_ERROR_INVALID_GSD_FILE_VERSION;
+        }
+
+    if (handle->header.gsd_version
+        > gsd_make_version(GSD_WIDE_ID_FILE_VERSION, GSD_WIDE_ID_FILE_VERSION_MINOR))
+        {
+        return GSD_ERROR_INVALID_GSD_FILE_VERSION;
+        }
+
+    // determine the file size
+    handle->file_size = lseek(handle->fd, 0, SEEK_END);
+
+    // validate that the namelist block exists inside the file
+    if (handle->header.namelist_location
+            + (GSD_NAME_SIZE * handle->header.namelist_allocated_entries)
+        > (uint64_t)handle->file_size)
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    // allocate the hash map
+    int retval = gsd_name_id_map_allocate(&handle->name_map, GSD_INITIAL_NAME_MAP_SIZE);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // read the namelist block
+    size_t namelist_n_bytes = GSD_NAME_SIZE * handle->header.namelist_allocated_entries;
+    retval = gsd_byte_buffer_allocate(&handle->file_names.data, namelist_n_bytes);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+    bytes_read = gsd_handle_pread(handle,
+                                    handle->file_names.data.data,
+                                    namelist_n_bytes,
+                                    handle->header.namelist_location);
+
+    if (bytes_read == -1 || bytes_read != namelist_n_bytes)
+        {
+        return GSD_ERROR_IO;
+        }
+
+    // The name buffer must end in a NULL terminator or else the file is corrupt
+    if (handle->file_names.data.data[handle->file_names.data.reserved - 1] != 0)
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    // Add the names to the hash map. Also determine the number of used bytes in the namelist.
+    handle->file_names.n_names = 0;
+    handle->file_names.data.size = 0;
+    retval = gsd_scan_names(handle, SIZE_MAX);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // read in the file index
+    retval = gsd_read_index_segments(handle,
+                                     &handle->header,
+                                     handle->index_segments,
+                                     &handle->n_index_segments);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // a valid frame table records the number of index entries
+    gsd_frame_table_read(handle);
+
+    retval = gsd_index_buffer_map(&handle->file_index, handle, handle->frame_table.n_entries);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    gsd_frame_table_open(handle);
+
+    // determine the current frame counter
+    if (handle->file_index.size == 0)
+        {
+        handle->cur_frame = 0;
+        }
+    else
+        {
+        const struct gsd_index_entry* last;
+        retval = gsd_index_buffer_get(&handle->file_index,
+                                      handle,
+                                      handle->file_index.size - 1,
+                                      &last);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        handle->cur_frame = last->frame + 1;
+        }
+    handle->sync_frame = handle->cur_frame;
+    handle->sync_time = (int64_t)time(NULL);
+
+    // read-only handles may be shared by concurrent readers, allocate the frame directory up front
+    // failure to allocate is not fatal, gsd_frame_directory_get falls back to searching
+    if (handle->open_flags == GSD_OPEN_READONLY)
+        {
+        gsd_frame_directory_allocate(&handle->frame_directory, handle->cur_frame + 1);
+        }
+
+    // if this is a write mode, allocate the initial frame index and the name buffer
+    if (handle->open_flags != GSD_OPEN_READONLY)
+        {
+        retval = gsd_index_buffer_allocate(&handle->frame_index, GSD_INITIAL_FRAME_INDEX_SIZE);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+
+        retval = gsd_index_buffer_allocate(&handle->buffer_index, GSD_INITIAL_FRAME_INDEX_SIZE);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+
+        retval = gsd_byte_buffer_allocate(&handle->write_buffer, handle->write_buffer_size);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+
+        handle->frame_names.n_names = 0;
+        retval = gsd_byte_buffer_allocate(&handle->frame_names.data, GSD_NAME_SIZE);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Release the file state that gsd_load_handle() loads into a handle.
+
+    @param handle Handle to release, which may be partially initialized.
+
+    Frees the names, the name/id map, the file index, the frame directory, the frame table, the
+    keyframe cache, and the buffers of write mode handles. Buffers that are not allocated are
+    skipped, so the state may be released more than once.
+*/
+inline static void gsd_release_file_state(struct gsd_handle* handle)
+    {
+    if (handle->file_index.data != NULL || handle->file_index.pages != NULL
+        || handle->file_index.mapped_data != NULL)
+        {
+        gsd_index_buffer_free(&handle->file_index);
+        }
+    if (handle->name_map.v != NULL)
+        {
+        gsd_name_id_map_free(&handle->name_map);
+        }
+    if (handle->file_names.data.data != NULL)
+        {
+        gsd_byte_buffer_free(&handle->file_names.data);
+        }
+    handle->file_names.n_names = 0;
+
+    gsd_frame_directory_free(&handle->frame_directory);
+    gsd_frame_table_free(&handle->frame_table);
+    gsd_keyframe_cache_free(&handle->keyframe_cache);
+
+    if (handle->frame_index.data != NULL)
+        {
+        gsd_index_buffer_free(&handle->frame_index);
+        }
+    if (handle->buffer_index.data != NULL)
+        {
+        gsd_index_buffer_free(&handle->buffer_index);
+        }
+    if (handle->write_buffer.data != NULL)
+        {
+        gsd_byte_buffer_free(&handle->write_buffer);
+        }
+    if (handle->frame_names.data.data != NULL)
+        {
+        gsd_byte_buffer_free(&handle->frame_names.data);
+        }
+    handle->frame_names.n_names = 0;
+    }
+
+/** @internal
+    @brief Read in the file index and initialize the handle.
+
+    @param handle Handle to read the header
+
+    @pre handle->fd is an open file.
+    @pre handle->open_flags is set.
+
+    @post On failure, the handle holds no allocated buffers.
+*/
+inline static int gsd_initialize_handle(struct gsd_handle* handle)
+    {
+    int retval = gsd_load_handle(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        gsd_release_file_state(handle);
+        }
+    return retval;
+    }
+
+/** @internal
+    @brief Load the file state of a read-only handle from scratch.
+
+    @param handle Handle to reload.
+
+    Initializes a copy of *handle* from the file and replaces the state of *handle* with the copy.
+    *handle* is unchanged on failure, except for its statistics.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_reload_handle(struct gsd_handle* handle)
+    {
+    struct gsd_handle fresh = *handle;
+    gsd_util_zero_memory(&fresh.file_index, sizeof(struct gsd_index_buffer));
+    gsd_util_zero_memory(&fresh.file_names, sizeof(struct gsd_name_buffer));
+    gsd_util_zero_memory(&fresh.name_map, sizeof(struct gsd_name_id_map));
+    gsd_util_zero_memory(&fresh.frame_directory, sizeof(struct gsd_frame_directory));
+    gsd_util_zero_memory(&fresh.frame_table, sizeof(struct gsd_frame_table));
+    gsd_util_zero_memory(&fresh.keyframe_cache, sizeof(struct gsd_keyframe_cache));
+
+    int retval = gsd_initialize_handle(&fresh);
+    if (retval != GSD_SUCCESS)
+        {
+        handle->stats = fresh.stats;
+        return retval;
+        }
+
+    gsd_release_file_state(handle);
+    *handle = fresh;
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Load the index entries that were appended to the file.
+
+    @param handle Handle to the open gsd file.
+    @param header Header read from the file.
+    @param segments Segment table read from the file when the index is chained, unused otherwise.
+    @param end [out] Position one past the last non-empty entry.
+    @param reload [out] Set to 1 when the index in the file does not hold the entries of the handle.
+
+    Pages an index that grew and forgets the pages after the known entries, then searches
+    the entries after gsd_index_buffer::size for the first empty entry. The new entries are not
+    validated and gsd_index_buffer::size is unchanged.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_refresh_index(struct gsd_handle* handle,
+                                    const struct gsd_header* header,
+                                    struct gsd_index_segment* segments,
+                                    size_t* end,
+                                    int* reload)
+    {
+    struct gsd_index_buffer* buf = &handle->file_index;
+    size_t size = buf->size;
+    *end = size;
+    *reload = 0;
+
+    // locate the index in the file
+    int chained = header->gsd_version >= gsd_make_version(GSD_CHAINED_INDEX_FILE_VERSION, 0)
+                  && header->index_segments_location != 0;
+    size_t n_segments = 0;
+    size_t reserved = 0;
+    int moved = 0;
+    if (chained)
+        {
+        // a chained index grows by appending segments to the table, the first segment is the
+        // index block of a file that starts to chain its index
+        int retval = gsd_check_index_segments(handle, header, segments, &n_segments);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+
+        if (n_segments < handle->n_index_segments || n_segments == 0
+            || header->index_location != handle->header.index_location
+            || header->index_allocated_entries != handle->header.index_allocated_entries
+            || memcmp(segments,
+                      handle->index_segments,
+                      sizeof(struct gsd_index_segment) * handle->n_index_segments)
+                   != 0)
+            {
+            *reload = 1;
+            return GSD_SUCCESS;
+            }
+
+        size_t i;
+        for (i = 0; i < n_segments; i++)
+            {
+            reserved += segments[i].allocated_entries;
+            }
+        }
+    else
+        {
+        // validate that the index block exists inside the file
+        if (header->index_location
+                + sizeof(struct gsd_index_entry) * header->index_allocated_entries
+            > (uint64_t)handle->file_size)
+            {
+            return GSD_ERROR_FILE_CORRUPT;
+            }
+
+        reserved = header->index_allocated_entries;
+
+        // a single block index grows by moving it to the end of the file
+        moved = header->index_location != handle->header.index_location;
+        if ((moved && reserved <= buf->reserved) || (!moved && reserved != buf->reserved))
+            {
+            *reload = 1;
+            return GSD_SUCCESS;
+            }
+        }
+
+    int retval = GSD_SUCCESS;
+    if (buf->mapped_data != NULL)
+        {
+#if GSD_USE_MMAP
+        if (chained)
+            {
+            // a chained index is paged
+            struct gsd_index_buffer paged;
+            gsd_util_zero_memory(&paged, sizeof(struct gsd_index_buffer));
+            retval = gsd_index_buffer_page(&paged, reserved);
+            if (retval != GSD_SUCCESS)
+                {
+                return retval;
+                }
+            paged.size = size;
+
+            munmap(buf->mapped_data, buf->mapped_len);
+            *buf = paged;
+            }
+        else if (moved)
+            {
+            // map the new index block
+            size_t page_size = sysconf(_SC_PAGESIZE);
+            size_t index_size = sizeof(struct gsd_index_entry) * reserved;
+            size_t offset = (header->index_location / page_size) * page_size;
+            size_t mapped_len = index_size + (header->index_location - offset);
+            void* mapped_data = mmap(NULL, mapped_len, PROT_READ, MAP_SHARED, handle->fd, offset);
+            if (mapped_data == MAP_FAILED)
+                {
+                return GSD_ERROR_IO;
+                }
+            const struct gsd_index_entry* entries
+                = (const struct gsd_index_entry*)((char*)mapped_data
+                                                  + (header->index_location - offset));
+
+            // the moved index starts with a copy of the known entries
+            if (size > 0
+                && memcmp(&entries[size - 1],
+                          &buf->mapped_entries[size - 1],
+                          sizeof(struct gsd_index_entry))
+                       != 0)
+                {
+                munmap(mapped_data, mapped_len);
+                *reload = 1;
+                return GSD_SUCCESS;
+                }
+
+            munmap(buf->mapped_data, buf->mapped_len);
+            buf->mapped_data = mapped_data;
+            buf->mapped_len = mapped_len;
+            buf->mapped_entries = entries;
+            buf->reserved = reserved;
+            }
+#endif
+        }
+    else
+        {
+        if (moved && size > 0)
+            {
+            // the moved index starts with a copy of the known entries
+            struct gsd_index_entry last;
+            int64_t last_location
+                = header->index_location + sizeof(struct gsd_index_entry) * (size - 1);
+            ssize_t bytes_read
+                = gsd_handle_pread(handle, &last, sizeof(struct gsd_index_entry), last_location);
+            if (bytes_read == -1 || bytes_read != sizeof(struct gsd_index_entry))
+                {
+                return GSD_ERROR_IO;
+                }
+
+            const struct gsd_index_entry* known;
+            retval = gsd_index_buffer_get(buf, handle, size - 1, &known);
+            if (retval != GSD_SUCCESS)
+                {
+                return retval;
+                }
+
+            struct gsd_index_entry known_in_file;
+            gsd_index_records_to_file((char*)&known_in_file,
+                                      (const struct gsd_index_record*)known,
+                                      1,
+                                      gsd_has_wide_ids(handle));
+            if (memcmp(&last, &known_in_file, sizeof(struct gsd_index_entry)) != 0)
+                {
+                *reload = 1;
+                return GSD_SUCCESS;
+                }
+            }
+
+        // the pages after the known entries may hold entries that were being written
+        gsd_index_buffer_drop_pages(buf, size);
+        retval = gsd_index_buffer_page(buf, reserved);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    handle->header.gsd_version = header->gsd_version;
+    handle->header.index_location = header->index_location;
+    handle->header.index_allocated_entries = header->index_allocated_entries;
+    handle->header.index_segments_location = header->index_segments_location;
+    if (chained)
+        {
+        memcpy(handle->index_segments,
+               segments,
+               sizeof(struct gsd_index_segment) * GSD_INDEX_SEGMENT_TABLE_SIZE);
+        handle->n_index_segments = n_segments;
+        }
+
+    // the pages read from now on show the entries as the writer adds them
+    while (*end < buf->reserved)
+        {
+        const struct gsd_index_entry* entry;
+        retval = gsd_index_buffer_get(buf, handle, *end, &entry);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        if (entry->location == 0)
+            {
+            break;
+            }
+        (*end)++;
+        }
+
+    return GSD_SUCCESS;
+    }
+
+/** @internal
+    @brief Load the names that were appended to the name list of the file.
+
+    @param handle Handle to the open gsd file.
+    @param header Header read from the file.
+    @param max_names Stop once the handle holds this many names.
+    @param reload [out] Set to 1 when the name list in the file does not start with the names of
+    the handle.
+
+    Reads the part of the name list after the known names, or all of a name list that moved.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_refresh_names(struct gsd_handle* handle,
+                                    const struct gsd_header* header,
+                                    size_t max_names,
+                                    int* reload)
+    {
+    struct gsd_byte_buffer* names = &handle->file_names.data;
+    size_t n_bytes = GSD_NAME_SIZE * header->namelist_allocated_entries;
+    *reload = 0;
+
+    // validate that the namelist block exists inside the file
+    if (header->namelist_location + n_bytes > (uint64_t)handle->file_size)
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    if (handle->file_names.n_names >= max_names)
+        {
+        return GSD_SUCCESS;
+        }
+
+    if (header->namelist_location == handle->header.namelist_location && n_bytes == names->reserved)
+        {
+        // the writer appends names in place
+        ssize_t bytes_read = gsd_handle_pread(handle,
+                                              names->data + names->size,
+                                              names->reserved - names->size,
+                                              header->namelist_location + names->size);
+        if (bytes_read == -1 || bytes_read != names->reserved - names->size)
+            {
+            return GSD_ERROR_IO;
+            }
+        }
+    else
+        {
+        // the writer moves a name list that grows to the end of the file
+        if (n_bytes <= names->reserved)
+            {
+            *reload = 1;
+            return GSD_SUCCESS;
+            }
+
+        struct gsd_byte_buffer moved;
+        gsd_util_zero_memory(&moved, sizeof(struct gsd_byte_buffer));
+        int retval = gsd_byte_buffer_allocate(&moved, n_bytes);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+
+        ssize_t bytes_read
+            = gsd_handle_pread(handle, moved.data, n_bytes, header->namelist_location);
+        if (bytes_read == -1 || bytes_read != n_bytes)
+            {
+            gsd_byte_buffer_free(&moved);
+            return GSD_ERROR_IO;
+            }
+
+        // the moved list starts with a copy of the known names
+        if (memcmp(moved.data, names->data, names->size) != 0)
+            {
+            gsd_byte_buffer_free(&moved);
+            *reload = 1;
+            return GSD_SUCCESS;
+            }
+
+        moved.size = names->size;
+        gsd_byte_buffer_free(names);
+        *names = moved;
+        handle->header.namelist_location = header->namelist_location;
+        handle->header.namelist_allocated_entries = header->namelist_allocated_entries;
+        }
+
+    // The name buffer must end in a NULL terminator or else the file is corrupt
+    if (names->data[names->reserved - 1] != 0)
+        {
+        return GSD_ERROR_FILE_CORRUPT;
+        }
+
+    return gsd_scan_names(handle, max_names);
+    }
+
+uint32_t gsd_make_version(unsigned int major, unsigned int minor)
+    {
+    return major << (sizeof(uint32_t) * 4) | minor;
+    }
+
+int gsd_set_allocator(const struct gsd_allocator* allocator)
+    {
+    // memory that is still allocated must be freed by the allocator that made it
+    if (gsd_load_allocations() != 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    if (allocator == NULL)
+        {
+        gsd_allocator.allocate = gsd_default_allocate;
+        gsd_allocator.allocate_zeroed = gsd_default_allocate_zeroed;
+        gsd_allocator.reallocate = gsd_default_reallocate;
+        gsd_allocator.deallocate = gsd_default_deallocate;
+        gsd_allocator.context = NULL;
+        return GSD_SUCCESS;
+        }
+
+    if (allocator->allocate == NULL || allocator->allocate_zeroed == NULL
+        || allocator->reallocate == NULL || allocator->deallocate == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    gsd_allocator = *allocator;
+    return GSD_SUCCESS;
+    }
+
+int gsd_create(const char* fname,
+               const char* application,
+               const char* schema,
+               uint32_t schema_version)
+    {
+    int extra_flags = 0;
+#ifdef _WIN32
+    extra_flags = _O_BINARY;
+#endif
+
+    // create the file
+    int fd = open(fname,
+                  O_RDWR | O_CREAT | O_TRUNC | extra_flags,
+                  S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+    int retval = gsd_initialize_file(fd, application, schema, schema_version);
+    close(fd);
+    return retval;
+    }
+
+int gsd_create_and_open(struct gsd_handle* handle,
+                        const char* fname,
+                        const char* application,
+                        const char* schema,
+                        uint32_t schema_version,
+                        const enum gsd_open_flag flags,
+                        int exclusive_create)
+    {
+    // zero the handle
+    gsd_util_zero_memory(handle, sizeof(struct gsd_handle));
+    handle->keyframe_interval = GSD_DEFAULT_KEYFRAME_INTERVAL;
+    handle->write_buffer_size = GSD_WRITE_BUFFER_SIZE;
+
+    int extra_flags = 0;
+#ifdef _WIN32
+    extra_flags = _O_BINARY;
+#endif
+
+    // set the open flags in the handle
+    if (flags == GSD_OPEN_READWRITE)
+        {
+        handle->open_flags = GSD_OPEN_READWRITE;
+        }
+    else if (flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+    else if (flags == GSD_OPEN_APPEND)
+        {
+        handle->open_flags = GSD_OPEN_APPEND;
+        }
+
+    // set the exclusive create bit
+    if (exclusive_create)
+        {
+        extra_flags |= O_EXCL;
+        }
+
+    // create the file
+    handle->fd = open(fname,
+                      O_RDWR | O_CREAT | O_TRUNC | extra_flags,
+                      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+    int retval = gsd_initialize_file(handle->fd, application, schema, schema_version);
+    if (retval != 0)
+        {
+        close(handle->fd);
+        return retval;
+        }
+
+    retval = gsd_initialize_handle(handle);
+    if (retval != 0)
+        {
+        close(handle->fd);
+        }
+    return retval;
+    }
+
+int gsd_open(struct gsd_handle* handle, const char* fname, const enum gsd_open_flag flags)
+    {
+    // zero the handle
+    gsd_util_zero_memory(handle, sizeof(struct gsd_handle));
+    handle->keyframe_interval = GSD_DEFAULT_KEYFRAME_INTERVAL;
+    handle->write_buffer_size = GSD_WRITE_BUFFER_SIZE;
+
+    int extra_flags = 0;
+#ifdef _WIN32
+    extra_flags = _O_BINARY;
+#endif
+
+    // open the file
+    if (flags == GSD_OPEN_READWRITE)
+        {
+        handle->fd = open(fname, O_RDWR | extra_flags);
+        handle->open_flags = GSD_OPEN_READWRITE;
+        }
+    else if (flags == GSD_OPEN_READONLY)
+        {
+        handle->fd = open(fname, O_RDONLY | extra_flags);
+        handle->open_flags = GSD_OPEN_READONLY;
+        }
+    else if (flags == GSD_OPEN_APPEND)
+        {
+        handle->fd = open(fname, O_RDWR | extra_flags);
+        handle->open_flags = GSD_OPEN_APPEND;
+        }
+
+    int retval = gsd_initialize_handle(handle);
+    if (retval != 0)
+        {
+        close(handle->fd);
+        }
+    return retval;
+    }
+
+int gsd_truncate(struct gsd_handle* handle)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (handle->open_flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+
+#if GSD_USE_MMAP
+    // mapped chunks would point past the end of the truncated file
+    if (gsd_read_map_in_use(handle))
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    gsd_read_map_close(handle);
+#endif
+
+    // complete pending writes, errors in them do not matter as the file is about to be truncated
+    gsd_write_behind_wait(handle);
+    gsd_write_map_release(handle, 0);
+    handle->write_map.allocated = 0;
+
+    int retval = 0;
+
+    // deallocate indices
+    if (handle->frame_names.data.reserved > 0)
+        {
+        retval = gsd_byte_buffer_free(&handle->frame_names.data);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    if (handle->file_names.data.reserved > 0)
+        {
+        retval = gsd_byte_buffer_free(&handle->file_names.data);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    retval = gsd_name_id_map_free(&handle->name_map);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    retval = gsd_index_buffer_free(&handle->file_index);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    if (handle->frame_index.reserved > 0)
+        {
+        retval = gsd_index_buffer_free(&handle->frame_index);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    if (handle->buffer_index.reserved > 0)
+        {
+        retval = gsd_index_buffer_free(&handle->buffer_index);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    if (handle->write_buffer.reserved > 0)
+        {
+        retval = gsd_byte_buffer_free(&handle->write_buffer);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    gsd_frame_directory_free(&handle->frame_directory);
+    gsd_frame_table_free(&handle->frame_table);
+    gsd_keyframe_cache_free(&handle->keyframe_cache);
+
+    // keep a copy of the old header
+    struct gsd_header old_header = handle->header;
+    retval = gsd_initialize_file(handle->fd,
+                                 old_header.application,
+                                 old_header.schema,
+                                 old_header.schema_version);
+
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    return gsd_initialize_handle(handle);
+    }
+
+int gsd_close(struct gsd_handle* handle)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    // save the fd so we can use it after freeing the handle
+    int fd = handle->fd;
+
+#if GSD_USE_MMAP
+    // chunks from gsd_map_chunk() remain valid after the file is closed
+    gsd_read_map_close(handle);
+#endif
+
+    // keep the frame table up to date with the frames added to the file
+    int frame_table_retval = GSD_SUCCESS;
+    if (handle->open_flags != GSD_OPEN_READONLY && handle->frame_table.location != 0
+        && handle->frame_table.n_entries != handle->file_index.size)
+        {
+        frame_table_retval = gsd_write_frame_table(handle);
+        }
+
+    // complete all pending writes before releasing buffers and closing the file
+    int write_behind_retval = gsd_write_behind_stop(handle);
+    if (write_behind_retval == GSD_SUCCESS)
+        {
+        write_behind_retval = frame_table_retval;
+        }
+    if (handle->direct_io)
+        {
+        close(handle->direct_io_fd);
+        handle->direct_io = 0;
+        }
+
+    // drop the preallocated space that no chunk was written to
+    int write_map_retval = gsd_write_map_release(handle, 1);
+    if (write_behind_retval == GSD_SUCCESS)
+        {
+        write_behind_retval = write_map_retval;
+        }
+
+    // sync deferred by the sync policy
+    if (handle->open_flags != GSD_OPEN_READONLY && handle->sync_policy != GSD_SYNC_ALWAYS)
+        {
+        int sync_retval = gsd_sync(handle);
+        if (write_behind_retval == GSD_SUCCESS)
+            {
+            write_behind_retval = sync_retval;
+            }
+        }
+
+    int retval = gsd_index_buffer_free(&handle->file_index);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    if (handle->frame_index.reserved > 0)
+        {
+        retval = gsd_index_buffer_free(&handle->frame_index);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    if (handle->buffer_index.reserved > 0)
+        {
+        retval = gsd_index_buffer_free(&handle->buffer_index);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    if (handle->write_buffer.reserved > 0)
+        {
+        retval = gsd_byte_buffer_free(&handle->write_buffer);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    retval = gsd_name_id_map_free(&handle->name_map);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    gsd_frame_directory_free(&handle->frame_directory);
+    gsd_frame_table_free(&handle->frame_table);
+    gsd_keyframe_cache_free(&handle->keyframe_cache);
+
+    if (handle->frame_names.data.reserved > 0)
+        {
+        handle->frame_names.n_names = 0;
+        retval = gsd_byte_buffer_free(&handle->frame_names.data);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    if (handle->file_names.data.reserved > 0)
+        {
+        handle->file_names.n_names = 0;
+        retval = gsd_byte_buffer_free(&handle->file_names.data);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        }
+
+    // close the file
+    retval = close(fd);
+    if (retval != 0)
+        {
+        return GSD_ERROR_IO;
+        }
+
+    return write_behind_retval;
+    }
+
+/** @internal
+    @brief Complete the current frame
+
+    @param handle Handle to an open writable GSD file.
+
+    Implements gsd_end_frame().
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_commit_frame(struct gsd_handle* handle)
+    {
+    // report errors from the background writer
+    int retval = gsd_write_behind_check(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // increment the frame counter
+    uint64_t committed_frame = handle->cur_frame;
+    handle->cur_frame++;
+
+    // flush the namelist buffer
+    retval = gsd_flush_name_buffer(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // flush the write buffer
+    retval = gsd_flush_write_buffer(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // write the frame index to the file
+    size_t frame_entries = handle->frame_index.size;
+    if (handle->frame_index.size > 0)
+        {
+        // ensure there is enough space in the index
+        if ((handle->file_index.size + handle->frame_index.size) > handle->file_index.reserved)
+            {
+            retval = gsd_expand_file_index(handle,
+                                           handle->file_index.size + handle->frame_index.size);
+            if (retval != GSD_SUCCESS)
+                {
+                return retval;
+                }
+            }
+
+        // sort the index before writing
+        retval = gsd_index_buffer_sort(&handle->frame_index);
+        if (retval != 0)
+            {
+            return retval;
+            }
+
+        // write the frame index entries to the file
+        retval = gsd_write_index_entries(handle,
+                                         handle->frame_index.data,
+                                         handle->frame_index.size,
+                                         handle->file_index.size);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+
+        // add the entries to the file index
+        gsd_index_buffer_store(&handle->file_index,
+                               handle->file_index.size,
+                               handle->frame_index.data,
+                               handle->frame_index.size);
+
+        // update size of file index
+        handle->file_index.size += handle->frame_index.size;
+
+        // clear the frame index
+        handle->frame_index.size = 0;
+        }
+
+    // record the location of the committed frame's entries
+    gsd_frame_directory_commit(&handle->frame_directory,
+                               committed_frame,
+                               handle->file_index.size - frame_entries,
+                               handle->file_index.size);
+
+    return gsd_sync_end_frame(handle);
+    }
+
+int gsd_end_frame(struct gsd_handle* handle)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (handle->open_flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+
+    uint64_t start = gsd_stats_now();
+    int retval = gsd_commit_frame(handle);
+    gsd_stats_add(&handle->stats.end_frame_calls, 1);
+    gsd_stats_add(&handle->stats.end_frame_ns, gsd_stats_now() - start);
+    return retval;
+    }
+
+int gsd_set_write_behind(struct gsd_handle* handle, int enable)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (handle->open_flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+
+    if (enable && handle->write_behind == NULL)
+        {
+        return gsd_write_behind_start(handle);
+        }
+    if (!enable && handle->write_behind != NULL)
+        {
+        return gsd_write_behind_stop(handle);
+        }
+
+    return GSD_SUCCESS;
+    }
+
+int gsd_flush(struct gsd_handle* handle)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    return gsd_write_behind_wait(handle);
+    }
+
+int gsd_set_compression_level(struct gsd_handle* handle, int level)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    handle->compression_level = level;
+    return GSD_SUCCESS;
+    }
+
+int gsd_set_keyframe_interval(struct gsd_handle* handle, uint64_t interval)
+    {
+    if (handle == NULL || interval == 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    handle->keyframe_interval = interval;
+    return GSD_SUCCESS;
+    }
+
+int gsd_set_chained_index(struct gsd_handle* handle, int enable)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
     if (handle->open_flags == GSD_OPEN_READONLY)
         {
         return GSD_ERROR_FILE_MUST_BE_WRITABLE;
         }
 
-    if (handle->file_names.n_names + handle->frame_names.n_names == UINT16_MAX)
+    handle->chained_index = enable;
+    return GSD_SUCCESS;
+    }
+
+int gsd_set_write_buffer_size(struct gsd_handle* handle, size_t size)
+    {
+    if (handle == NULL || size == 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (handle->open_flags == GSD_OPEN_READONLY)
         {
-        // no more names may be added
-        return GSD_ERROR_NAMELIST_FULL;
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
         }
 
-    // Provide the ID of the new name
-    *id = (uint16_t)(handle->file_names.n_names + handle->frame_names.n_names);
+    // write the buffered chunks before replacing the buffer
+    int retval = gsd_flush_write_buffer(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
 
-    if (handle->header.gsd_version < gsd_make_version(2, 0))
+    struct gsd_byte_buffer buf;
+    gsd_util_zero_memory(&buf, sizeof(struct gsd_byte_buffer));
+    retval = gsd_byte_buffer_allocate(&buf, size);
+    if (retval != GSD_SUCCESS)
         {
-        // v1 files always allocate GSD_NAME_SIZE bytes for each name and put a NULL terminator
-        // at address 63
-        char name_v1[GSD_NAME_SIZE];
-        strncpy(name_v1, name, GSD_NAME_SIZE - 1);
-        name_v1[GSD_NAME_SIZE - 1] = 0;
-        gsd_byte_buffer_append(&handle->frame_names.data, name_v1, GSD_NAME_SIZE);
-        handle->frame_names.n_names++;
+        return retval;
+        }
 
-        // update the name/id mapping with the truncated name
-        int retval = gsd_name_id_map_insert(&handle->name_map, name_v1, *id);
-        if (retval != GSD_SUCCESS)
+    retval = gsd_byte_buffer_free(&handle->write_buffer);
+    if (retval != GSD_SUCCESS)
+        {
+        gsd_byte_buffer_free(&buf);
+        return retval;
+        }
+
+    handle->write_buffer = buf;
+    handle->write_buffer_size = size;
+    return GSD_SUCCESS;
+    }
+
+int gsd_set_direct_io(struct gsd_handle* handle, int enable)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (handle->open_flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+
+    int retval = GSD_SUCCESS;
+#if GSD_USE_DIRECT_IO
+    if (enable && !handle->direct_io)
+        {
+        // open a second description of the file, O_DIRECT applies to all users of a description
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/self/fd/%d", handle->fd);
+        int fd = open(path, O_WRONLY | O_DIRECT);
+        if (fd == -1)
             {
-            return retval;
+            return GSD_ERROR_IO;
             }
+
+        handle->direct_io_fd = fd;
+        handle->direct_io = 1;
         }
-    else
+    if (!enable && handle->direct_io)
         {
-        gsd_byte_buffer_append(&handle->frame_names.data, name, strlen(name) + 1);
-        handle->frame_names.n_names++;
+        // queued writes may use the descriptor
+        retval = gsd_write_behind_wait(handle);
+        close(handle->direct_io_fd);
+        handle->direct_io = 0;
+        }
+#else
+    (void)enable;
+#endif
 
-        // update the name/id mapping
-        int retval = gsd_name_id_map_insert(&handle->name_map, name, *id);
+    return retval;
+    }
+
+int gsd_set_write_map_size(struct gsd_handle* handle, size_t size)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (handle->open_flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+
+    // write the buffered chunks before the mapped chunks that follow them
+    int retval = gsd_flush_write_buffer(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // map a region of the new size with the next chunk
+    retval = gsd_write_map_release(handle, size == 0);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    handle->write_map_size = size;
+    return GSD_SUCCESS;
+    }
+
+int gsd_set_sync_policy(struct gsd_handle* handle, enum gsd_sync_policy policy, uint64_t interval)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (policy != GSD_SYNC_ALWAYS && policy != GSD_SYNC_ON_CLOSE
+        && policy != GSD_SYNC_EVERY_N_FRAMES && policy != GSD_SYNC_EVERY_N_SECONDS)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if ((policy == GSD_SYNC_EVERY_N_FRAMES || policy == GSD_SYNC_EVERY_N_SECONDS) && interval == 0)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (handle->open_flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+
+    // complete the syncs deferred by the previous policy
+    if (handle->sync_policy != GSD_SYNC_ALWAYS)
+        {
+        int retval = gsd_sync(handle);
         if (retval != GSD_SUCCESS)
             {
             return retval;
             }
         }
 
+    handle->sync_policy = policy;
+    handle->sync_interval = interval;
+    handle->sync_frame = handle->cur_frame;
+    handle->sync_time = (int64_t)time(NULL);
     return GSD_SUCCESS;
     }
 
-/** @internal
-    @brief Truncate the file and write a new gsd header.
+int gsd_get_stats(struct gsd_handle* handle, struct gsd_stats* stats)
+    {
+    if (handle == NULL || stats == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
 
-    @param fd file descriptor to initialize
-    @param application Generating application name (truncated to 63 chars)
-    @param schema Schema name for data to be written in this GSD file (truncated to 63 chars)
-    @param schema_version Version of the scheme data to be written (make with gsd_make_version())
-*/
-inline static int
-gsd_initialize_file(int fd, const char* application, const char* schema, uint32_t schema_version)
+    const struct gsd_stats* counters = &handle->stats;
+    stats->read_calls = gsd_stats_load(&counters->read_calls);
+    stats->read_bytes = gsd_stats_load(&counters->read_bytes);
+    stats->write_calls = gsd_stats_load(&counters->write_calls);
+    stats->write_bytes = gsd_stats_load(&counters->write_bytes);
+    stats->fsync_calls = gsd_stats_load(&counters->fsync_calls);
+    stats->fsync_ns = gsd_stats_load(&counters->fsync_ns);
+    stats->index_expansions = gsd_stats_load(&counters->index_expansions);
+    stats->write_buffer_flushes = gsd_stats_load(&counters->write_buffer_flushes);
+    stats->name_lookups = gsd_stats_load(&counters->name_lookups);
+    stats->name_probes = gsd_stats_load(&counters->name_probes);
+    stats->name_max_probes = gsd_stats_load(&counters->name_max_probes);
+    stats->end_frame_calls = gsd_stats_load(&counters->end_frame_calls);
+    stats->end_frame_ns = gsd_stats_load(&counters->end_frame_ns);
+    return GSD_SUCCESS;
+    }
+
+int gsd_write_frame_table(struct gsd_handle* handle)
     {
-    // check if the file was created
-    if (fd == -1)
+    if (handle == NULL)
         {
-        return GSD_ERROR_IO;
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (handle->open_flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
         }
 
-    int retval = ftruncate(fd, 0);
-    if (retval != 0)
+    // the table is written at the end of the file, complete all pending writes first
+    int retval = gsd_write_behind_wait(handle);
+    if (retval != GSD_SUCCESS)
         {
-        return GSD_ERROR_IO;
+        return retval;
         }
 
-    // populate header fields
-    struct gsd_header header;
-    gsd_util_zero_memory(&header, sizeof(header));
+    struct gsd_frame_table_header table_header;
+    gsd_util_zero_memory(&table_header, sizeof(struct gsd_frame_table_header));
+    table_header.index_location = handle->header.index_location;
+    table_header.index_allocated_entries = handle->header.index_allocated_entries;
+    if (handle->n_index_segments > 0)
+        {
+        table_header.index_segments_location = handle->header.index_segments_location;
+        }
+    table_header.n_entries = handle->file_index.size;
+    if (handle->file_index.size > 0)
+        {
+        const struct gsd_index_entry* last;
+        retval = gsd_index_buffer_get(&handle->file_index,
+                                      handle,
+                                      handle->file_index.size - 1,
+                                      &last);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        table_header.n_frames = last->frame + 1;
+        }
 
-    header.magic = GSD_MAGIC_ID;
-    header.gsd_version = gsd_make_version(GSD_CURRENT_FILE_VERSION, 0);
-    strncpy(header.application, application, sizeof(header.application) - 1);
-    header.application[sizeof(header.application) - 1] = 0;
-    strncpy(header.schema, schema, sizeof(header.schema) - 1);
-    header.schema[sizeof(header.schema) - 1] = 0;
-    header.schema_version = schema_version;
-    header.index_location = sizeof(header);
-    header.index_allocated_entries = GSD_INITIAL_INDEX_SIZE;
-    header.namelist_location
-        = header.index_location + sizeof(struct gsd_index_entry) * header.index_allocated_entries;
-    header.namelist_allocated_entries = GSD_INITIAL_NAME_BUFFER_SIZE / GSD_NAME_SIZE;
-    gsd_util_zero_memory(header.reserved, sizeof(header.reserved));
+    if (table_header.n_frames
+        > (SIZE_MAX - sizeof(struct gsd_frame_table_header)) / sizeof(uint64_t))
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
 
-    // write the header out
-    ssize_t bytes_written = gsd_io_pwrite_retry(fd, &header, sizeof(header), 0);
-    if (bytes_written != sizeof(header))
+    size_t table_size
+        = sizeof(struct gsd_frame_table_header) + sizeof(uint64_t) * table_header.n_frames;
+    char* table = gsd_malloc(table_size);
+    if (table == NULL)
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    // record the position of the first entry of each frame, frames without entries start at the
+    // entry of the next frame
+    memcpy(table, &table_header, sizeof(struct gsd_frame_table_header));
+    uint64_t* positions = (uint64_t*)(table + sizeof(struct gsd_frame_table_header));
+    size_t pos = 0;
+    uint64_t frame;
+    for (frame = 0; frame < table_header.n_frames; frame++)
+        {
+        while (pos < handle->file_index.size)
+            {
+            const struct gsd_index_entry* entry;
+            retval = gsd_index_buffer_get(&handle->file_index, handle, pos, &entry);
+            if (retval != GSD_SUCCESS)
+                {
+                gsd_free(table);
+                return retval;
+                }
+            if (entry->frame >= frame)
+                {
+                break;
+                }
+            pos++;
+            }
+        positions[frame] = pos;
+        }
+
+    uint64_t table_location = handle->file_size;
+    ssize_t bytes_written = gsd_handle_pwrite(handle, table, table_size, table_location);
+    gsd_free(table);
+    if (bytes_written == -1 || bytes_written != table_size)
         {
         return GSD_ERROR_IO;
         }
+    handle->file_size += table_size;
 
-    // allocate and zero default index memory
-    struct gsd_index_entry index[GSD_INITIAL_INDEX_SIZE];
-    gsd_util_zero_memory(index, sizeof(index));
+    // the table must be on disk before the file refers to it
+    retval = gsd_sync_barrier(handle);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
 
-    // write the empty index out
-    bytes_written = gsd_io_pwrite_retry(fd, index, sizeof(index), sizeof(header));
-    if (bytes_written != sizeof(index))
+    // point the header at the table
+    struct gsd_header header = handle->header;
+    header.frame_table_location = table_location;
+    bytes_written = gsd_handle_pwrite(handle, &header, sizeof(struct gsd_header), 0);
+    if (bytes_written != sizeof(struct gsd_header))
         {
         return GSD_ERROR_IO;
         }
+    handle->header = header;
 
-    // allocate and zero the namelist memory
-    char names[GSD_INITIAL_NAME_BUFFER_SIZE];
-    gsd_util_zero_memory(names, sizeof(char) * GSD_INITIAL_NAME_BUFFER_SIZE);
+    // use the new table for lookups
+    gsd_frame_table_free(&handle->frame_table);
+    handle->frame_table.location = table_location;
+    handle->frame_table.n_entries = table_header.n_entries;
+    handle->frame_table.n_frames = table_header.n_frames;
+    gsd_frame_table_open(handle);
+
+    return GSD_SUCCESS;
+    }
+
+int gsd_write_chunk(struct gsd_handle* handle,
+                    const char* name,
+                    enum gsd_type type,
+                    uint64_t N,
+                    uint32_t M,
+                    uint8_t flags,
+                    const void* data)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    // quantized chunks need a precision, given by gsd_write_quantized_chunk()
+    if (flags & GSD_FLAG_QUANTIZE)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    if (name == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    return gsd_write_encoded_chunk(handle, name, 0, type, N, M, flags, 0, data);
+    }
 
-    // write the namelist out
-    bytes_written = gsd_io_pwrite_retry(fd, names, sizeof(names), sizeof(header) + sizeof(index));
-    if (bytes_written != sizeof(names))
+int gsd_write_chunk_by_id(struct gsd_handle* handle,
+                          uint32_t id,
+                          enum gsd_type type,
+                          uint64_t N,
+                          uint32_t M,
+                          uint8_t flags,
+                          const void* data)
+    {
+    if (handle == NULL)
         {
-        return GSD_ERROR_IO;
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    // sync file
-    retval = fsync(fd);
-    if (retval != 0)
+    // quantized chunks need a precision, given by gsd_write_quantized_chunk()
+    if (flags & GSD_FLAG_QUANTIZE)
         {
-        return GSD_ERROR_IO;
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    return GSD_SUCCESS;
+    return gsd_write_encoded_chunk(handle, NULL, id, type, N, M, flags, 0, data);
     }
 
-/** @internal
-    @brief Read in the file index and initialize the handle.
-
-    @param handle Handle to read the header
-
-    @pre handle->fd is an open file.
-    @pre handle->open_flags is set.
-*/
-inline static int gsd_initialize_handle(struct gsd_handle* handle)
+int gsd_write_quantized_chunk(struct gsd_handle* handle,
+                              const char* name,
+                              uint64_t N,
+                              uint32_t M,
+                              uint8_t flags,
+                              double precision,
+                              const float* data)
     {
-    // check if the file was created
-    if (handle->fd == -1)
+    if (handle == NULL)
         {
-        return GSD_ERROR_IO;
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
-
-    // read the header
-    ssize_t bytes_read
-        = gsd_io_pread_retry(handle->fd, &handle->header, sizeof(struct gsd_header), 0);
-    if (bytes_read == -1)
+    if (!(precision > 0 && precision < DBL_MAX))
         {
-        return GSD_ERROR_IO;
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
-    if (bytes_read != sizeof(struct gsd_header))
+
+    if (name == NULL)
         {
-        return GSD_ERROR_NOT_A_GSD_FILE;
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    // validate the header
-    if (handle->header.magic != GSD_MAGIC_ID)
+    return gsd_write_encoded_chunk(handle,
+                                   name,
+                                   0,
+                                   GSD_TYPE_FLOAT,
+                                   N,
+                                   M,
+                                   flags | GSD_FLAG_QUANTIZE,
+                                   precision,
+                                   data);
+    }
+
+int gsd_reserve_chunk(struct gsd_handle* handle,
+                      const char* name,
+                      enum gsd_type type,
+                      uint64_t N,
+                      uint32_t M,
+                      int64_t* location)
+    {
+    if (handle == NULL || name == NULL || location == NULL)
         {
-        return GSD_ERROR_NOT_A_GSD_FILE;
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
-
-    if (handle->header.gsd_version < gsd_make_version(1, 0)
-        && handle->header.gsd_version != gsd_make_version(0, 3))
+    if (M == 0 || (M > UINT16_MAX && gsd_has_wide_ids(handle)) || gsd_sizeof_type(type) == 0)
         {
-        return GSD_ERROR_INVALID_GSD_FILE_VERSION;
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
-
-    if (handle->header.gsd_version >= gsd_make_version(3, 0))
+    if (handle->open_flags == GSD_OPEN_READONLY)
         {
-        return GSD_ERROR_INVALID_GSD_FILE_VERSION;
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
         }
 
-    // determine the file size
-    handle->file_size = lseek(handle->fd, 0, SEEK_END);
-
-    // validate that the namelist block exists inside the file
-    if (handle->header.namelist_location
-            + (GSD_NAME_SIZE * handle->header.namelist_allocated_entries)
-        > (uint64_t)handle->file_size)
+    // report errors from the background writer
+    int retval = gsd_write_behind_check(handle);
+    if (retval != GSD_SUCCESS)
         {
-        return GSD_ERROR_FILE_CORRUPT;
+        return retval;
         }
 
-    // allocate the hash map
-    int retval = gsd_name_id_map_allocate(&handle->name_map, GSD_NAME_MAP_SIZE);
+    uint32_t id;
+    retval = gsd_get_name_id(handle, name, &id, 0);
+    if (retval == GSD_SUCCESS && id == UINT32_MAX)
+        {
+        // v3.1 files cannot store the chunk, keep the file from converting to add its name
+        if (M > UINT16_MAX
+            && handle->file_names.n_names + handle->frame_names.n_names >= UINT16_MAX)
+            {
+            return GSD_ERROR_NAMELIST_FULL;
+            }
+        retval = gsd_get_name_id(handle, name, &id, 1);
+        }
     if (retval != GSD_SUCCESS)
         {
         return retval;
         }
 
-    // read the namelist block
-    size_t namelist_n_bytes = GSD_NAME_SIZE * handle->header.namelist_allocated_entries;
-    retval = gsd_byte_buffer_allocate(&handle->file_names.data, namelist_n_bytes);
+    struct gsd_index_record* index_entry;
+    retval = gsd_index_buffer_add(&handle->frame_index, &index_entry);
     if (retval != GSD_SUCCESS)
         {
         return retval;
         }
-    bytes_read = gsd_io_pread_retry(handle->fd,
-                                    handle->file_names.data.data,
-                                    namelist_n_bytes,
-                                    handle->header.namelist_location);
 
-    if (bytes_read == -1 || bytes_read != namelist_n_bytes)
+    // the caller writes the data at the end of the file, as gsd_write_entry() does for large chunks
+    gsd_util_zero_memory(index_entry, sizeof(struct gsd_index_record));
+    index_entry->entry.frame = handle->cur_frame;
+    gsd_index_record_set_id(index_entry, id);
+    index_entry->entry.type = (uint8_t)type;
+    index_entry->entry.N = N;
+    index_entry->entry.M = M;
+    index_entry->entry.location = handle->file_size;
+
+    *location = handle->file_size;
+    handle->file_size += N * M * gsd_sizeof_type(type);
+
+    return GSD_SUCCESS;
+    }
+
+uint64_t gsd_get_nframes(struct gsd_handle* handle)
+    {
+    if (handle == NULL)
         {
-        return GSD_ERROR_IO;
+        return 0;
         }
+    return handle->cur_frame;
+    }
 
-    // The name buffer must end in a NULL terminator or else the file is corrupt
-    if (handle->file_names.data.data[handle->file_names.data.reserved - 1] != 0)
+int gsd_refresh(struct gsd_handle* handle)
+    {
+    if (handle == NULL || handle->open_flags != GSD_OPEN_READONLY)
         {
-        return GSD_ERROR_FILE_CORRUPT;
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    // Add the names to the hash map. Also determine the number of used bytes in the namelist.
-    size_t name_start = 0;
-    handle->file_names.n_names = 0;
-    while (name_start < handle->file_names.data.reserved)
+    struct gsd_header header;
+    ssize_t bytes_read = gsd_handle_pread(handle, &header, sizeof(struct gsd_header), 0);
+    if (bytes_read == -1)
         {
-        char* name = handle->file_names.data.data + name_start;
-
-        // an empty name notes the end of the list
-        if (name[0] == 0)
+        return GSD_ERROR_IO;
+        }
+    // a version 2.0 file becomes a version 3.0 file when it starts to chain its index and keeps
+    // its entries in place
+    int chaining = handle->header.gsd_version == gsd_make_version(GSD_CURRENT_FILE_VERSION, 0)
+                   && header.gsd_version == gsd_make_version(GSD_CHAINED_INDEX_FILE_VERSION, 0);
+    int reload = bytes_read != sizeof(struct gsd_header) || header.magic != GSD_MAGIC_ID
+                 || (header.gsd_version != handle->header.gsd_version && !chaining)
+                 || (handle->n_index_segments > 0
+                     && header.index_segments_location != handle->header.index_segments_location);
+
+    // the writer extends the file before it adds a segment to the table of a chained index
+    struct gsd_index_segment segments[GSD_INDEX_SEGMENT_TABLE_SIZE];
+    if (!reload && header.gsd_version >= gsd_make_version(GSD_CHAINED_INDEX_FILE_VERSION, 0)
+        && header.index_segments_location != 0)
+        {
+        size_t table_size = sizeof(struct gsd_index_segment) * GSD_INDEX_SEGMENT_TABLE_SIZE;
+        bytes_read
+            = gsd_handle_pread(handle, segments, table_size, header.index_segments_location);
+        if (bytes_read == -1)
             {
-            break;
+            return GSD_ERROR_IO;
             }
+        reload = bytes_read != table_size;
+        }
 
-        retval
-            = gsd_name_id_map_insert(&handle->name_map, name, (uint16_t)handle->file_names.n_names);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
-        handle->file_names.n_names++;
+    // determine the file size after reading the header and the segment table and before reading
+    // the index, so that the file holds the segments and the data of the entries that are found
+    int64_t file_size = lseek(handle->fd, 0, SEEK_END);
+    if (file_size == -1)
+        {
+        return GSD_ERROR_IO;
+        }
 
-        if (handle->header.gsd_version < gsd_make_version(2, 0))
-            {
-            // gsd v1 stores names in fixed 64 byte segments
-            name_start += GSD_NAME_SIZE;
-            }
-        else
-            {
-            size_t len = strnlen(name, handle->file_names.data.reserved - name_start);
-            name_start += len + 1;
-            }
+    // load the file from scratch when it no longer extends what the handle holds
+    if (reload || file_size < handle->file_size
+        || header.namelist_allocated_entries < handle->header.namelist_allocated_entries)
+        {
+        return gsd_reload_handle(handle);
         }
 
-    handle->file_names.data.size = name_start;
+    handle->file_size = file_size;
 
-    // read in the file index
-    retval = gsd_index_buffer_map(&handle->file_index, handle);
+    size_t end = 0;
+    int retval = gsd_refresh_index(handle, &header, segments, &end, &reload);
     if (retval != GSD_SUCCESS)
         {
         return retval;
         }
-
-    // determine the current frame counter
-    if (handle->file_index.size == 0)
-        {
-        handle->cur_frame = 0;
-        }
-    else
+    if (reload)
         {
-        handle->cur_frame = handle->file_index.data[handle->file_index.size - 1].frame + 1;
+        return gsd_reload_handle(handle);
         }
 
-    // if this is a write mode, allocate the initial frame index and the name buffer
-    if (handle->open_flags != GSD_OPEN_READONLY)
+    // the writer adds names before the entries that refer to them, load only those names so that
+    // a name which is being written is not loaded partially
+    size_t old_size = handle->file_index.size;
+    size_t max_names = handle->file_names.n_names;
+    size_t i;
+    for (i = old_size; i < end; i++)
         {
-        retval = gsd_index_buffer_allocate(&handle->frame_index, GSD_INITIAL_FRAME_INDEX_SIZE);
+        const struct gsd_index_entry* entry;
+        retval = gsd_index_buffer_get(&handle->file_index, handle, i, &entry);
         if (retval != GSD_SUCCESS)
             {
             return retval;
             }
-
-        retval = gsd_index_buffer_allocate(&handle->buffer_index, GSD_INITIAL_FRAME_INDEX_SIZE);
-        if (retval != GSD_SUCCESS)
+        if (gsd_entry_id(handle, entry) >= max_names)
             {
-            return retval;
+            max_names = (size_t)gsd_entry_id(handle, entry) + 1;
             }
+        }
+
+    retval = gsd_refresh_names(handle, &header, max_names, &reload);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+    if (reload)
+        {
+        return gsd_reload_handle(handle);
+        }
 
-        retval = gsd_byte_buffer_allocate(&handle->write_buffer, GSD_WRITE_BUFFER_SIZE);
+    // accept the new entries up to the first one that is invalid, such as an entry that is being
+    // written
+    uint64_t last_frame = old_size > 0 ? handle->cur_frame - 1 : 0;
+    size_t size = old_size;
+    while (size < end)
+        {
+        const struct gsd_index_entry* entry;
+        retval = gsd_index_buffer_get(&handle->file_index, handle, size, &entry);
         if (retval != GSD_SUCCESS)
             {
             return retval;
             }
-
-        handle->frame_names.n_names = 0;
-        retval = gsd_byte_buffer_allocate(&handle->frame_names.data, GSD_NAME_SIZE);
-        if (retval != GSD_SUCCESS)
+        if (!gsd_is_entry_valid(handle, entry) || entry->frame < last_frame)
             {
-            return retval;
+            break;
             }
+        last_frame = entry->frame;
+        size++;
+        }
+
+    if (size > old_size)
+        {
+        // the last known frame may have gained entries, which moves the end of its entries
+        uint64_t old_frames = handle->cur_frame;
+        handle->file_index.size = size;
+        handle->cur_frame = last_frame + 1;
+        gsd_frame_directory_reset(&handle->frame_directory, old_frames, handle->cur_frame + 1);
+        }
+
+    // a writer that closed the file may have written a new frame table
+    if (header.frame_table_location != handle->header.frame_table_location)
+        {
+        gsd_frame_table_free(&handle->frame_table);
+        handle->header.frame_table_location = header.frame_table_location;
+        gsd_frame_table_read(handle);
+        gsd_frame_table_open(handle);
         }
 
     return GSD_SUCCESS;
     }
 
-uint32_t gsd_make_version(unsigned int major, unsigned int minor)
+int gsd_get_name_id(struct gsd_handle* handle, const char* name, uint32_t* id, int append)
     {
-    return major << (sizeof(uint32_t) * 4) | minor;
-    }
+    if (handle == NULL || name == NULL || id == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
 
-int gsd_create(const char* fname,
-               const char* application,
-               const char* schema,
-               uint32_t schema_version)
-    {
-    int extra_flags = 0;
-#ifdef _WIN32
-    extra_flags = _O_BINARY;
-#endif
+    *id = gsd_name_id_map_find(&handle->name_map, name, &handle->stats);
+    if (*id != UINT32_MAX || !append || handle->open_flags == GSD_OPEN_READONLY)
+        {
+        return GSD_SUCCESS;
+        }
 
-    // create the file
-    int fd = open(fname,
-                  O_RDWR | O_CREAT | O_TRUNC | extra_flags,
-                  S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
-    int retval = gsd_initialize_file(fd, application, schema, schema_version);
-    close(fd);
+    // add the name so that it can be written with gsd_write_chunk_by_id()
+    int retval = gsd_append_name(id, handle, name);
+    if (retval != GSD_SUCCESS)
+        {
+        *id = UINT32_MAX;
+        }
     return retval;
     }
 
-int gsd_create_and_open(struct gsd_handle* handle,
-                        const char* fname,
-                        const char* application,
-                        const char* schema,
-                        uint32_t schema_version,
-                        const enum gsd_open_flag flags,
-                        int exclusive_create)
+const struct gsd_index_entry*
+gsd_find_chunk(struct gsd_handle* handle, uint64_t frame, const char* name)
     {
-    // zero the handle
-    gsd_util_zero_memory(handle, sizeof(struct gsd_handle));
-
-    int extra_flags = 0;
-#ifdef _WIN32
-    extra_flags = _O_BINARY;
-#endif
-
-    // set the open flags in the handle
-    if (flags == GSD_OPEN_READWRITE)
+    if (handle == NULL)
         {
-        handle->open_flags = GSD_OPEN_READWRITE;
+        return NULL;
         }
-    else if (flags == GSD_OPEN_READONLY)
+    if (name == NULL)
         {
-        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        return NULL;
         }
-    else if (flags == GSD_OPEN_APPEND)
+    if (frame >= gsd_get_nframes(handle))
         {
-        handle->open_flags = GSD_OPEN_APPEND;
+        return NULL;
         }
-
-    // set the exclusive create bit
-    if (exclusive_create)
+    if (handle->open_flags == GSD_OPEN_APPEND)
         {
-        extra_flags |= O_EXCL;
+        return NULL;
         }
 
-    // create the file
-    handle->fd = open(fname,
-                      O_RDWR | O_CREAT | O_TRUNC | extra_flags,
-                      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
-    int retval = gsd_initialize_file(handle->fd, application, schema, schema_version);
-    if (retval != 0)
+    // find the id for the given name
+    uint32_t match_id = gsd_name_id_map_find(&handle->name_map, name, &handle->stats);
+    if (match_id == UINT32_MAX)
         {
-        close(handle->fd);
-        return retval;
+        return NULL;
         }
 
-    retval = gsd_initialize_handle(handle);
-    if (retval != 0)
-        {
-        close(handle->fd);
-        }
-    return retval;
+    // the mapped index and the pages read from the file miss entries that are not yet written
+    gsd_write_behind_drain(handle);
+
+    return gsd_find_entry(handle, frame, match_id);
     }
 
-int gsd_open(struct gsd_handle* handle, const char* fname, const enum gsd_open_flag flags)
+const struct gsd_index_entry*
+gsd_find_chunk_by_id(struct gsd_handle* handle, uint64_t frame, uint32_t id)
     {
-    // zero the handle
-    gsd_util_zero_memory(handle, sizeof(struct gsd_handle));
-
-    int extra_flags = 0;
-#ifdef _WIN32
-    extra_flags = _O_BINARY;
-#endif
-
-    // open the file
-    if (flags == GSD_OPEN_READWRITE)
+    if (handle == NULL)
         {
-        handle->fd = open(fname, O_RDWR | extra_flags);
-        handle->open_flags = GSD_OPEN_READWRITE;
+        return NULL;
         }
-    else if (flags == GSD_OPEN_READONLY)
+    if (frame >= gsd_get_nframes(handle))
         {
-        handle->fd = open(fname, O_RDONLY | extra_flags);
-        handle->open_flags = GSD_OPEN_READONLY;
+        return NULL;
         }
-    else if (flags == GSD_OPEN_APPEND)
+    if (handle->open_flags == GSD_OPEN_APPEND)
         {
-        handle->fd = open(fname, O_RDWR | extra_flags);
-        handle->open_flags = GSD_OPEN_APPEND;
+        return NULL;
         }
-
-    int retval = gsd_initialize_handle(handle);
-    if (retval != 0)
+    if (id >= handle->file_names.n_names + handle->frame_names.n_names)
         {
-        close(handle->fd);
+        return NULL;
         }
-    return retval;
+
+    // the mapped index and the pages read from the file miss entries that are not yet written
+    gsd_write_behind_drain(handle);
+
+    return gsd_find_entry(handle, frame, id);
     }
 
-int gsd_truncate(struct gsd_handle* handle)
+int gsd_read_chunk(struct gsd_handle* handle, void* data, const struct gsd_index_entry* chunk)
     {
     if (handle == NULL)
         {
         return GSD_ERROR_INVALID_ARGUMENT;
         }
-    if (handle->open_flags == GSD_OPEN_READONLY)
+    if (data == NULL)
         {
-        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
-
-    int retval = 0;
-
-    // deallocate indices
-    if (handle->frame_names.data.reserved > 0)
+    if (chunk == NULL)
         {
-        retval = gsd_byte_buffer_free(&handle->frame_names.data);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
-
-    if (handle->file_names.data.reserved > 0)
+    if (handle->open_flags == GSD_OPEN_APPEND)
         {
-        retval = gsd_byte_buffer_free(&handle->file_names.data);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
+        return GSD_ERROR_FILE_MUST_BE_READABLE;
         }
 
-    retval = gsd_name_id_map_free(&handle->name_map);
-    if (retval != GSD_SUCCESS)
+    size_t size = chunk->N * chunk->M * gsd_sizeof_type((enum gsd_type)chunk->type);
+    if (size == 0)
         {
-        return retval;
+        return GSD_ERROR_FILE_CORRUPT;
         }
-
-    retval = gsd_index_buffer_free(&handle->file_index);
-    if (retval != GSD_SUCCESS)
+    if (chunk->location == 0)
         {
-        return retval;
+        return GSD_ERROR_FILE_CORRUPT;
         }
 
-    if (handle->frame_index.reserved > 0)
-        {
-        retval = gsd_index_buffer_free(&handle->frame_index);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
-        }
+    // complete pending writes before reading
+    gsd_write_behind_drain(handle);
 
-    if (handle->buffer_index.reserved > 0)
+    if (chunk->flags != 0)
         {
-        retval = gsd_index_buffer_free(&handle->buffer_index);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
+        return gsd_read_encoded_chunk(handle, data, chunk);
         }
 
-    if (handle->write_buffer.reserved > 0)
+    // validate that we don't read past the end of the file
+    if ((chunk->location + size) > (uint64_t)handle->file_size)
         {
-        retval = gsd_byte_buffer_free(&handle->write_buffer);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
+        return GSD_ERROR_FILE_CORRUPT;
         }
 
-    // keep a copy of the old header
-    struct gsd_header old_header = handle->header;
-    retval = gsd_initialize_file(handle->fd,
-                                 old_header.application,
-                                 old_header.schema,
-                                 old_header.schema_version);
-
-    if (retval != GSD_SUCCESS)
+    ssize_t bytes_read = gsd_handle_pread(handle, data, size, chunk->location);
+    if (bytes_read == -1 || bytes_read != size)
         {
-        return retval;
+        return GSD_ERROR_IO;
         }
 
-    return gsd_initialize_handle(handle);
+    return GSD_SUCCESS;
     }
 
-int gsd_close(struct gsd_handle* handle)
+int gsd_read_chunk_as(struct gsd_handle* handle,
+                      void* data,
+                      const struct gsd_index_entry* chunk,
+                      enum gsd_type type)
     {
-    if (handle == NULL)
+    if (handle == NULL || data == NULL || chunk == NULL)
         {
         return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    // save the fd so we can use it after freeing the handle
-    int fd = handle->fd;
-
-    int retval = gsd_index_buffer_free(&handle->file_index);
-    if (retval != GSD_SUCCESS)
+    enum gsd_type chunk_type = (enum gsd_type)chunk->type;
+    size_t in_size = gsd_sizeof_type(chunk_type);
+    size_t out_size = gsd_sizeof_type(type);
+    if (out_size == 0)
         {
-        return retval;
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
-
-    if (handle->frame_index.reserved > 0)
+    if (in_size == 0 || type == chunk_type)
         {
-        retval = gsd_index_buffer_free(&handle->frame_index);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
+        return gsd_read_chunk(handle, data, chunk);
         }
 
-    if (handle->buffer_index.reserved > 0)
+    // floating point values do not convert to integers
+    bool float_in = chunk_type == GSD_TYPE_FLOAT || chunk_type == GSD_TYPE_DOUBLE;
+    bool float_out = type == GSD_TYPE_FLOAT || type == GSD_TYPE_DOUBLE;
+    if (float_in && !float_out)
         {
-        retval = gsd_index_buffer_free(&handle->buffer_index);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    if (handle->write_buffer.reserved > 0)
+    // integers convert only to integer types that hold every value of the chunk type
+    if (!float_in && !float_out)
         {
-        retval = gsd_byte_buffer_free(&handle->write_buffer);
-        if (retval != GSD_SUCCESS)
+        bool signed_in = chunk_type >= GSD_TYPE_INT8;
+        bool signed_out = type >= GSD_TYPE_INT8;
+        if ((signed_in && !signed_out) || out_size < in_size
+            || (signed_out && !signed_in && out_size == in_size))
             {
-            return retval;
+            return GSD_ERROR_INVALID_ARGUMENT;
             }
         }
 
-    retval = gsd_name_id_map_free(&handle->name_map);
-    if (retval != GSD_SUCCESS)
-        {
-        return retval;
-        }
-
-    if (handle->frame_names.data.reserved > 0)
+    size_t n = chunk->N * chunk->M;
+    if (out_size >= in_size)
         {
-        handle->frame_names.n_names = 0;
-        retval = gsd_byte_buffer_free(&handle->frame_names.data);
+        // read into the end of the output buffer and convert in place
+        char* stored = (char*)data + n * (out_size - in_size);
+        int retval = gsd_read_chunk(handle, stored, chunk);
         if (retval != GSD_SUCCESS)
             {
             return retval;
             }
+
+        gsd_convert(data, type, stored, chunk_type, n);
+        return GSD_SUCCESS;
         }
 
-    if (handle->file_names.data.reserved > 0)
+    // the stored data does not fit in the output buffer
+    char* stored = gsd_malloc(n * in_size);
+    if (stored == NULL)
         {
-        handle->file_names.n_names = 0;
-        retval = gsd_byte_buffer_free(&handle->file_names.data);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
         }
 
-    // close the file
-    retval = close(fd);
-    if (retval != 0)
+    int retval = gsd_read_chunk(handle, stored, chunk);
+    if (retval == GSD_SUCCESS)
         {
-        return GSD_ERROR_IO;
+        gsd_convert(data, type, stored, chunk_type, n);
         }
 
-    return GSD_SUCCESS;
+    gsd_free(stored);
+    return retval;
     }
 
-int gsd_end_frame(struct gsd_handle* handle)
+int gsd_read_chunks(struct gsd_handle* handle,
+                    size_t n,
+                    const struct gsd_index_entry** chunks,
+                    void** data)
     {
     if (handle == NULL)
         {
         return GSD_ERROR_INVALID_ARGUMENT;
         }
-    if (handle->open_flags == GSD_OPEN_READONLY)
+    if (n == 0)
         {
-        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        return GSD_SUCCESS;
         }
-
-    // increment the frame counter
-    handle->cur_frame++;
-
-    // flush the namelist buffer
-    int retval = gsd_flush_name_buffer(handle);
-    if (retval != GSD_SUCCESS)
+    if (chunks == NULL)
         {
-        return retval;
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (data == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (handle->open_flags == GSD_OPEN_APPEND)
+        {
+        return GSD_ERROR_FILE_MUST_BE_READABLE;
         }
 
-    // flush the write buffer
-    retval = gsd_flush_write_buffer(handle);
-    if (retval != GSD_SUCCESS)
+    struct gsd_read_request* requests = gsd_malloc(sizeof(struct gsd_read_request) * n);
+    if (requests == NULL)
         {
-        return retval;
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
         }
 
-    // write the frame index to the file
-    if (handle->frame_index.size > 0)
+    // validate all requests before reading any data
+    size_t i;
+    size_t n_raw = 0;
+    for (i = 0; i < n; i++)
         {
-        // ensure there is enough space in the index
-        if ((handle->file_index.size + handle->frame_index.size) > handle->file_index.reserved)
+        if (chunks[i] == NULL || data[i] == NULL)
             {
-            gsd_expand_file_index(handle, handle->file_index.size + handle->frame_index.size);
+            gsd_free(requests);
+            return GSD_ERROR_INVALID_ARGUMENT;
             }
 
-        // sort the index before writing
-        retval = gsd_index_buffer_sort(&handle->frame_index);
-        if (retval != 0)
+        size_t size = chunks[i]->N * chunks[i]->M * gsd_sizeof_type((enum gsd_type)chunks[i]->type);
+        if (size == 0 || chunks[i]->location == 0)
             {
-            return retval;
+            gsd_free(requests);
+            return GSD_ERROR_FILE_CORRUPT;
             }
 
-        // write the frame index entries to the file
-        int64_t write_pos = handle->header.index_location
-                            + sizeof(struct gsd_index_entry) * handle->file_index.size;
+        // encoded chunks are read separately
+        if (chunks[i]->flags != 0)
+            {
+            continue;
+            }
 
-        size_t bytes_to_write = sizeof(struct gsd_index_entry) * handle->frame_index.size;
-        ssize_t bytes_written
-            = gsd_io_pwrite_retry(handle->fd, handle->frame_index.data, bytes_to_write, write_pos);
+        if ((chunks[i]->location + size) > (uint64_t)handle->file_size)
+            {
+            gsd_free(requests);
+            return GSD_ERROR_FILE_CORRUPT;
+            }
+
+        requests[n_raw].location = chunks[i]->location;
+        requests[n_raw].size = size;
+        requests[n_raw].data = data[i];
+        n_raw++;
+        }
+
+    // complete pending writes before reading
+    gsd_write_behind_drain(handle);
 
-        if (bytes_written == -1 || bytes_written != bytes_to_write)
+    for (i = 0; i < n; i++)
+        {
+        if (chunks[i]->flags != 0)
             {
-            return GSD_ERROR_IO;
+            int retval = gsd_read_encoded_chunk(handle, data[i], chunks[i]);
+            if (retval != GSD_SUCCESS)
+                {
+                gsd_free(requests);
+                return retval;
+                }
             }
+        }
 
-#if !GSD_USE_MMAP
-        // add the entries to the file index
-        memcpy(handle->file_index.data + handle->file_index.size,
-               handle->frame_index.data,
-               sizeof(struct gsd_index_entry) * handle->frame_index.size);
-#endif
+    // sort by location so that chunks adjacent in the file are adjacent in the list
+    qsort(requests, n_raw, sizeof(struct gsd_read_request), gsd_cmp_read_request);
 
-        // update size of file index
-        handle->file_index.size += handle->frame_index.size;
+    char* buffer = NULL;
+    size_t buffer_size = 0;
+    int retval = GSD_SUCCESS;
 
-        // clear the frame index
-        handle->frame_index.size = 0;
+    i = 0;
+    while (i < n_raw)
+        {
+        // find the run of chunks that starts at i, reading through small gaps between them is
+        // faster than issuing another read
+        size_t run_end = i + 1;
+        size_t run_size = requests[i].size;
+        while (run_end < n_raw
+               && requests[run_end].location
+                      <= requests[i].location + (int64_t)(run_size + GSD_READ_GAP_SIZE))
+            {
+            size_t end = (size_t)(requests[run_end].location - requests[i].location)
+                         + requests[run_end].size;
+            if (end > GSD_READ_BUFFER_SIZE)
+                {
+                break;
+                }
+            if (end > run_size)
+                {
+                run_size = end;
+                }
+            run_end++;
+            }
+
+        if (run_end - i == 1)
+            {
+            // read single chunks directly into the destination
+            ssize_t bytes_read = gsd_handle_pread(handle,
+                                                    requests[i].data,
+                                                    requests[i].size,
+                                                    requests[i].location);
+            if (bytes_read == -1 || bytes_read != requests[i].size)
+                {
+                retval = GSD_ERROR_IO;
+                break;
+                }
+            }
+        else
+            {
+            // read the whole run at once and scatter it to the destinations
+            if (run_size > buffer_size)
+                {
+                char* new_buffer = gsd_realloc(buffer, run_size);
+                if (new_buffer == NULL)
+                    {
+                    retval = GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+                    break;
+                    }
+                buffer = new_buffer;
+                buffer_size = run_size;
+                }
+
+            ssize_t bytes_read
+                = gsd_handle_pread(handle, buffer, run_size, requests[i].location);
+            if (bytes_read == -1 || bytes_read != run_size)
+                {
+                retval = GSD_ERROR_IO;
+                break;
+                }
+
+            size_t j;
+            for (j = i; j < run_end; j++)
+                {
+                memcpy(requests[j].data,
+                       buffer + (requests[j].location - requests[i].location),
+                       requests[j].size);
+                }
+            }
+
+        i = run_end;
         }
 
-    return GSD_SUCCESS;
+    gsd_free(buffer);
+    gsd_free(requests);
+    return retval;
     }
 
-int gsd_write_chunk(struct gsd_handle* handle,
-                    const char* name,
-                    enum gsd_type type,
-                    uint64_t N,
-                    uint32_t M,
-                    uint8_t flags,
-                    const void* data)
+int gsd_read_chunk_series(struct gsd_handle* handle,
+                          const char* name,
+                          uint64_t first,
+                          uint64_t last,
+                          uint64_t stride,
+                          void* data,
+                          size_t size)
     {
-    // validate input
-    if (N > 0 && data == NULL)
-        {
-        return GSD_ERROR_INVALID_ARGUMENT;
-        }
-    if (M == 0)
+    if (handle == NULL || name == NULL || data == NULL || stride == 0)
         {
         return GSD_ERROR_INVALID_ARGUMENT;
         }
-    if (handle->open_flags == GSD_OPEN_READONLY)
+    if (handle->open_flags == GSD_OPEN_APPEND)
         {
-        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        return GSD_ERROR_FILE_MUST_BE_READABLE;
         }
-    if (flags != 0)
+    if (first >= last)
         {
-        return GSD_ERROR_INVALID_ARGUMENT;
+        return GSD_SUCCESS;
         }
-
-    uint16_t id = gsd_name_id_map_find(&handle->name_map, name);
-    if (id == UINT16_MAX)
+    if (last > gsd_get_nframes(handle))
         {
-        // not found, append to the index
-        int retval = gsd_append_name(&id, handle, name);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
-
-        if (id == UINT16_MAX)
-            {
-            // this should never happen
-            return GSD_ERROR_NAMELIST_FULL;
-            }
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    struct gsd_index_entry entry;
-    // populate fields in the entry's data
-    gsd_util_zero_memory(&entry, sizeof(struct gsd_index_entry));
-    entry.frame = handle->cur_frame;
-    entry.id = id;
-    entry.type = (uint8_t)type;
-    entry.N = N;
-    entry.M = M;
-    size_t size = N * M * gsd_sizeof_type(type);
-
-    // decide whether to write this chunk to the buffer or straight to disk
-    if (size < handle->write_buffer.reserved / 2)
+    uint32_t id = gsd_name_id_map_find(&handle->name_map, name, &handle->stats);
+    if (id == UINT32_MAX)
         {
-        // flush the buffer if this entry won't fit
-        if (size > (handle->write_buffer.reserved - handle->write_buffer.size))
-            {
-            gsd_flush_write_buffer(handle);
-            }
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
 
-        entry.location = handle->write_buffer.size;
+    size_t n = (size_t)((last - first - 1) / stride + 1);
+    const struct gsd_index_entry** chunks = gsd_malloc(sizeof(struct gsd_index_entry*) * n);
+    void** chunk_data = gsd_malloc(sizeof(void*) * n);
+    if (chunks == NULL || chunk_data == NULL)
+        {
+        gsd_free(chunks);
+        gsd_free(chunk_data);
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
 
-        // add an entry to the buffer index
-        struct gsd_index_entry* index_entry;
+    // the mapped index and the pages read from the file miss entries that are not yet written
+    gsd_write_behind_drain(handle);
 
-        int retval = gsd_index_buffer_add(&handle->buffer_index, &index_entry);
-        if (retval != GSD_SUCCESS)
+    // every frame must hold a chunk with the type and shape of the first
+    int retval = GSD_SUCCESS;
+    size_t chunk_size = 0;
+    size_t i;
+    for (i = 0; i < n; i++)
+        {
+        chunks[i] = gsd_find_entry(handle, first + i * stride, id);
+        if (chunks[i] == NULL
+            || (i > 0
+                && (chunks[i]->type != chunks[0]->type || chunks[i]->N != chunks[0]->N
+                    || chunks[i]->M != chunks[0]->M)))
             {
-            return retval;
+            retval = GSD_ERROR_INVALID_ARGUMENT;
+            break;
             }
-        *index_entry = entry;
 
-        // add the data to the write buffer
-        if (size > 0)
+        if (i == 0)
             {
-            retval = gsd_byte_buffer_append(&handle->write_buffer, data, size);
-            if (retval != GSD_SUCCESS)
+            chunk_size
+                = chunks[0]->N * chunks[0]->M * gsd_sizeof_type((enum gsd_type)chunks[0]->type);
+            if (chunk_size == 0 || chunk_size > size / n)
                 {
-                return retval;
+                retval = chunk_size == 0 ? GSD_ERROR_FILE_CORRUPT : GSD_ERROR_INVALID_ARGUMENT;
+                break;
                 }
             }
-        }
-    else
-        {
-        // add an entry to the frame index
-        struct gsd_index_entry* index_entry;
-
-        int retval = gsd_index_buffer_add(&handle->frame_index, &index_entry);
-        if (retval != GSD_SUCCESS)
-            {
-            return retval;
-            }
-        *index_entry = entry;
-
-        // find the location at the end of the file for the chunk
-        index_entry->location = handle->file_size;
-
-        // write the data
-        ssize_t bytes_written = gsd_io_pwrite_retry(handle->fd, data, size, index_entry->location);
-        if (bytes_written == -1 || bytes_written != size)
-            {
-            return GSD_ERROR_IO;
-            }
 
-        // update the file_size in the handle
-        handle->file_size += bytes_written;
+        chunk_data[i] = (char*)data + i * chunk_size;
         }
 
-    return GSD_SUCCESS;
-    }
-
-uint64_t gsd_get_nframes(struct gsd_handle* handle)
-    {
-    if (handle == NULL)
+    if (retval == GSD_SUCCESS)
         {
-        return 0;
+        // gsd_read_chunks combines reads of chunks that are close together in the file
+        retval = gsd_read_chunks(handle, n, chunks, chunk_data);
         }
-    return handle->cur_frame;
+
+    gsd_free(chunks);
+    gsd_free(chunk_data);
+    return retval;
     }
 
-const struct gsd_index_entry*
-gsd_find_chunk(struct gsd_handle* handle, uint64_t frame, const char* name)
+int gsd_prefetch_frames(struct gsd_handle* handle, uint64_t first, uint64_t count)
     {
     if (handle == NULL)
         {
-        return NULL;
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
-    if (name == NULL)
+    if (handle->open_flags == GSD_OPEN_APPEND)
         {
-        return NULL;
+        return GSD_ERROR_FILE_MUST_BE_READABLE;
         }
-    if (frame >= gsd_get_nframes(handle))
+
+    uint64_t n_frames = gsd_get_nframes(handle);
+    if (first >= n_frames || count == 0)
         {
-        return NULL;
+        return GSD_SUCCESS;
         }
-    if (handle->open_flags == GSD_OPEN_APPEND)
+    if (count > n_frames - first)
         {
-        return NULL;
+        count = n_frames - first;
         }
 
-    // find the id for the given name
-    uint16_t match_id = gsd_name_id_map_find(&handle->name_map, name);
-    if (match_id == UINT16_MAX)
+    // the mapped index and the pages read from the file miss entries that are not yet written
+    gsd_write_behind_drain(handle);
+
+    // advise one range per frame, combining the ranges of frames that touch in the file
+    int64_t range_start = 0;
+    int64_t range_end = 0;
+    size_t pos = 0;
+    int retval = gsd_frame_directory_get(handle, first, &pos);
+    if (retval != GSD_SUCCESS)
         {
-        return NULL;
+        return retval;
         }
 
-    if (handle->header.gsd_version >= gsd_make_version(2, 0))
+    uint64_t frame;
+    for (frame = first; frame < first + count; frame++)
         {
-        // gsd 2.0 files sort the entire index
-        // binary search for the index entry
-        ssize_t L = 0;
-        ssize_t R = handle->file_index.size - 1;
-        struct gsd_index_entry T;
-        T.frame = frame;
-        T.id = match_id;
+        size_t end = 0;
+        retval = gsd_frame_directory_get(handle, frame + 1, &end);
+        if (retval != GSD_SUCCESS)
+            {
+            return retval;
+            }
+        if (pos == end)
+            {
+            continue;
+            }
 
-        while (L <= R)
+        // the decoded size bounds the stored size of most encoded chunks, use it as an estimate
+        int64_t start = INT64_MAX;
+        int64_t stop = 0;
+        for (; pos < end; pos++)
             {
-            size_t m = (L + R) / 2;
-            int cmp = gsd_cmp_index_entry(handle->file_index.data + m, &T);
-            if (cmp == -1)
-                {
-                L = m + 1;
-                }
-            else if (cmp == 1)
+            const struct gsd_index_entry* entry;
+            retval = gsd_index_buffer_get(&handle->file_index, handle, pos, &entry);
+            if (retval != GSD_SUCCESS)
                 {
-                R = m - 1;
+                return retval;
                 }
-            else
+            int64_t size
+                = (int64_t)(entry->N * entry->M * gsd_sizeof_type((enum gsd_type)entry->type));
+            if (entry->flags != 0)
                 {
-                return &(handle->file_index.data[m]);
+                size += sizeof(struct gsd_chunk_header);
                 }
-            }
-        }
-    else
-        {
-        // gsd 1.0 file: use binary search to find the frame and linear search to find the entry
-        size_t L = 0;
-        size_t R = handle->file_index.size;
-
-        // progressively narrow the search window by halves
-        do
-            {
-            size_t m = (L + R) / 2;
 
-            if (frame < handle->file_index.data[m].frame)
+            if (entry->location < start)
                 {
-                R = m;
+                start = entry->location;
                 }
-            else
+            if (entry->location + size > stop)
                 {
-                L = m;
+                stop = entry->location + size;
                 }
-            } while ((R - L) > 1);
+            }
 
-        // this finds L = the rightmost index with the desired frame
-        int64_t cur_index;
+        if (stop > handle->file_size)
+            {
+            stop = handle->file_size;
+            }
+        if (start >= stop)
+            {
+            continue;
+            }
 
-        // search all index entries with the matching frame
-        for (cur_index = L; (cur_index >= 0) && (handle->file_index.data[cur_index].frame == frame);
-             cur_index--)
+        if (range_end != 0 && start <= range_end && stop >= range_start)
             {
-            // if the frame matches, check the id
-            if (match_id == handle->file_index.data[cur_index].id)
+            range_start = start < range_start ? start : range_start;
+            range_end = stop > range_end ? stop : range_end;
+            }
+        else
+            {
+            if (range_end != 0)
                 {
-                return &(handle->file_index.data[cur_index]);
+                gsd_io_advise_willneed(handle->fd, range_start, range_end - range_start);
                 }
+            range_start = start;
+            range_end = stop;
             }
         }
 
-    // if we got here, we didn't find the specified chunk
-    return NULL;
+    if (range_end != 0)
+        {
+        gsd_io_advise_willneed(handle->fd, range_start, range_end - range_start);
+        }
+
+    return GSD_SUCCESS;
     }
 
-int gsd_read_chunk(struct gsd_handle* handle, void* data, const struct gsd_index_entry* chunk)
+int gsd_map_chunk(struct gsd_handle* handle,
+                  const void** data,
+                  const struct gsd_index_entry* chunk)
     {
     if (handle == NULL)
         {
@@ -2159,18 +8536,113 @@ int gsd_read_chunk(struct gsd_handle* handle, void* data, const struct gsd_index
         return GSD_ERROR_FILE_CORRUPT;
         }
 
-    // validate that we don't read past the end of the file
+    // encoded chunks cannot be mapped, decode them into a buffer owned by the caller
+    if (chunk->flags != 0)
+        {
+        void* buf = gsd_malloc(size);
+        if (buf == NULL)
+            {
+            return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+
+        int retval = gsd_read_chunk(handle, buf, chunk);
+        if (retval != GSD_SUCCESS)
+            {
+            gsd_free(buf);
+            return retval;
+            }
+
+        *data = buf;
+        return GSD_SUCCESS;
+        }
+
+    // validate that we don't map past the end of the file
     if ((chunk->location + size) > (uint64_t)handle->file_size)
         {
         return GSD_ERROR_FILE_CORRUPT;
         }
 
-    ssize_t bytes_read = gsd_io_pread_retry(handle->fd, data, size, chunk->location);
-    if (bytes_read == -1 || bytes_read != size)
+#if GSD_USE_MMAP
+    // the mapped data must be present in the file
+    gsd_write_behind_drain(handle);
+
+    struct gsd_read_map* map;
+    int retval = gsd_read_map_acquire(handle, chunk->location + size, &map);
+    if (retval != GSD_SUCCESS)
         {
-        return GSD_ERROR_IO;
+        return retval;
+        }
+
+    // the caller is about to access the data: ask the kernel to start reading it in now, advice
+    // must start on a page boundary
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    int64_t offset = (chunk->location / page_size) * page_size;
+    posix_madvise(map->data + offset, size + (chunk->location - offset), POSIX_MADV_WILLNEED);
+
+    *data = map->data + chunk->location;
+#else
+    // mmap not supported, read the data into a buffer owned by the caller
+    void* buf = gsd_malloc(size);
+    if (buf == NULL)
+        {
+        return GSD_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+
+    int retval = gsd_read_chunk(handle, buf, chunk);
+    if (retval != GSD_SUCCESS)
+        {
+        gsd_free(buf);
+        return retval;
+        }
+
+    *data = buf;
+#endif
+
+    return GSD_SUCCESS;
+    }
+
+int gsd_unmap_chunk(struct gsd_handle* handle,
+                    const void* data,
+                    const struct gsd_index_entry* chunk)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (data == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (chunk == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    // encoded chunks are decoded into an allocated buffer
+    if (chunk->flags != 0)
+        {
+        gsd_free((void*)data);
+        return GSD_SUCCESS;
+        }
+
+#if GSD_USE_MMAP
+    // find the mapping that the data points into
+    struct gsd_read_map* map = __atomic_load_n(&handle->read_map, __ATOMIC_ACQUIRE);
+    while (map != NULL
+           && ((const char*)data < map->data || (const char*)data >= map->data + map->size))
+        {
+        map = map->next;
+        }
+    if (map == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
         }
 
+    gsd_read_map_release(handle, map);
+#else
+    gsd_free((void*)data);
+#endif
+
     return GSD_SUCCESS;
     }
 
@@ -2224,6 +8696,36 @@ size_t gsd_sizeof_type(enum gsd_type type)
     return val;
     }
 
+bool gsd_is_encoding_available(uint8_t flags)
+    {
+    if (!gsd_is_encoding_valid(flags))
+        {
+        return false;
+        }
+
+    // quantization is always available
+
+    uint8_t codec = flags & GSD_FLAG_CODEC_MASK;
+    if (codec == 0)
+        {
+        return true;
+        }
+#ifdef GSD_USE_ZSTD
+    if (codec == GSD_FLAG_CODEC_ZSTD)
+        {
+        return true;
+        }
+#endif
+#ifdef GSD_USE_ZLIB
+    if (codec == GSD_FLAG_CODEC_DEFLATE)
+        {
+        return true;
+        }
+#endif
+
+    return false;
+    }
+
 const char*
 gsd_find_matching_chunk_name(struct gsd_handle* handle, const char* match, const char* prev)
     {
@@ -2312,56 +8814,14 @@ int gsd_upgrade(struct gsd_handle* handle)
         return GSD_ERROR_INVALID_ARGUMENT;
         }
 
-    if (handle->header.gsd_version < gsd_make_version(2, 0))
+    int write_behind_retval = gsd_write_behind_wait(handle);
+    if (write_behind_retval != GSD_SUCCESS)
         {
-        if (handle->file_index.size > 0)
-            {
-            // make a copy of the file index
-            struct gsd_index_buffer buf;
-            gsd_util_zero_memory(&buf, sizeof(struct gsd_index_buffer));
-            int retval = gsd_index_buffer_allocate(&buf, handle->file_index.size);
-            if (retval != GSD_SUCCESS)
-                {
-                return retval;
-                }
-            memcpy(buf.data,
-                   handle->file_index.data,
-                   sizeof(struct gsd_index_entry) * handle->file_index.size);
-            buf.size = handle->file_index.size;
-
-            // sort the copy and write it back out to the file
-            retval = gsd_index_buffer_sort(&buf);
-            if (retval != GSD_SUCCESS)
-                {
-                gsd_index_buffer_free(&buf);
-                return retval;
-                }
-
-            ssize_t bytes_written = gsd_io_pwrite_retry(handle->fd,
-                                                        buf.data,
-                                                        sizeof(struct gsd_index_entry) * buf.size,
-                                                        handle->header.index_location);
-
-            if (bytes_written == -1 || bytes_written != sizeof(struct gsd_index_entry) * buf.size)
-                {
-                gsd_index_buffer_free(&buf);
-                return GSD_ERROR_IO;
-                }
-
-            retval = gsd_index_buffer_free(&buf);
-            if (retval != GSD_SUCCESS)
-                {
-                return retval;
-                }
-
-            // sync the updated index
-            retval = fsync(handle->fd);
-            if (retval != 0)
-                {
-                return GSD_ERROR_IO;
-                }
-            }
+        return write_behind_retval;
+        }
 
+    if (handle->header.gsd_version < gsd_make_version(2, 0))
+        {
         if (handle->file_names.n_names > 0)
             {
             // compact the name list without changing its size or position on the disk
@@ -2392,7 +8852,7 @@ int gsd_upgrade(struct gsd_handle* handle)
                 }
 
             // write the new names out to disk
-            ssize_t bytes_written = gsd_io_pwrite_retry(handle->fd,
+            ssize_t bytes_written = gsd_handle_pwrite(handle,
                                                         new_name_buf.data,
                                                         new_name_buf.reserved,
                                                         handle->header.namelist_location);
@@ -2411,46 +8871,10 @@ int gsd_upgrade(struct gsd_handle* handle)
                 return retval;
                 }
             handle->file_names.data = new_name_buf;
-
-            // sync the updated name list
-            retval = fsync(handle->fd);
-            if (retval != 0)
-                {
-                gsd_byte_buffer_free(&new_name_buf);
-                return GSD_ERROR_IO;
-                }
-            }
-
-        // label the file as a v2.0 file
-        handle->header.gsd_version = gsd_make_version(GSD_CURRENT_FILE_VERSION, 0);
-
-        // write the new header out
-        ssize_t bytes_written
-            = gsd_io_pwrite_retry(handle->fd, &(handle->header), sizeof(struct gsd_header), 0);
-        if (bytes_written != sizeof(struct gsd_header))
-            {
-            return GSD_ERROR_IO;
-            }
-
-        // sync the updated header
-        int retval = fsync(handle->fd);
-        if (retval != 0)
-            {
-            return GSD_ERROR_IO;
-            }
-
-        // remap the file index
-        retval = gsd_index_buffer_free(&handle->file_index);
-        if (retval != 0)
-            {
-            return retval;
             }
 
-        retval = gsd_index_buffer_map(&handle->file_index, handle);
-        if (retval != 0)
-            {
-            return retval;
-            }
+        // sort the index and label the file as a v2.0 file
+        return gsd_rewrite_index(handle, gsd_make_version(GSD_CURRENT_FILE_VERSION, 0), 1);
         }
 
     return GSD_SUCCESS;
@@ -65,6 +65,22 @@ extern "C"
         GSD_OPEN_APPEND
         };
 
+    /// When to sync written data to the storage device
+    enum gsd_sync_policy
+        {
+        /// Sync whenever the file is about to refer to newly written metadata
+        GSD_SYNC_ALWAYS = 0,
+
+        /// Sync only when closing the file
+        GSD_SYNC_ON_CLOSE,
+
+        /// Sync at the end of every N frames and when closing the file
+        GSD_SYNC_EVERY_N_FRAMES,
+
+        /// Sync at the end of the first frame N seconds after the last sync and when closing
+        GSD_SYNC_EVERY_N_SECONDS
+        };
+
     /// Error return values
     enum gsd_error
         {
@@ -101,6 +117,31 @@ extern "C"
             GSD_OPEN_READWRITE.
         */
         GSD_ERROR_FILE_MUST_BE_READABLE = -9,
+
+        /// The chunk is encoded with a codec that is not available in this build.
+        GSD_ERROR_UNSUPPORTED_ENCODING = -10,
+        };
+
+    /// Chunk encoding flags stored in gsd_index_entry::flags
+    enum gsd_chunk_flag
+        {
+        /// Mask of the bits that select the compression codec.
+        GSD_FLAG_CODEC_MASK = 0x07,
+
+        /// Compress the chunk with zstd.
+        GSD_FLAG_CODEC_ZSTD = 0x01,
+
+        /// Compress the chunk with deflate (zlib).
+        GSD_FLAG_CODEC_DEFLATE = 0x02,
+
+        /// Shuffle the bytes of each element before compressing.
+        GSD_FLAG_SHUFFLE = 0x08,
+
+        /// Store GSD_TYPE_FLOAT values as bit packed multiples of a fixed step (lossy).
+        GSD_FLAG_QUANTIZE = 0x10,
+
+        /// XOR the chunk with the same chunk in an earlier keyframe before compressing.
+        GSD_FLAG_DELTA = 0x20,
         };
 
     enum
@@ -114,7 +155,13 @@ extern "C"
     enum
         {
         /// Reserved bytes in the header structure
-        GSD_RESERVED_BYTES = 80
+        GSD_RESERVED_BYTES = 64
+        };
+
+    enum
+        {
+        /// Number of entries in the index segment table of a file with a chained index
+        GSD_INDEX_SEGMENT_TABLE_SIZE = 64
         };
 
     /** GSD file header
@@ -153,10 +200,62 @@ extern "C"
         /// Name of data schema.
         char schema[GSD_NAME_SIZE];
 
+        /// Location of the index segment table in the file (v3.0 files), 0 when the index is one
+        /// block.
+        uint64_t index_segments_location;
+
+        /// Location of the frame table in the file, 0 when the file has no frame table.
+        uint64_t frame_table_location;
+
         /// Reserved for future use.
         char reserved[GSD_RESERVED_BYTES];
         };
 
+    /** Index segment
+
+        A block of index entries in a file with a chained index. The segment table stores
+        GSD_INDEX_SEGMENT_TABLE_SIZE segments. The first segment is the index block given in the
+        header and a segment with location 0 ends the table. The index is the concatenation of
+        the segments in table order.
+
+        @warning All members are **read-only** to the caller.
+    */
+    struct gsd_index_segment
+        {
+        /// Location of the segment in the file.
+        uint64_t location;
+
+        /// Number of index entries that fit in the segment.
+        uint64_t allocated_entries;
+        };
+
+    /** Frame table header
+
+        Starts the optional frame table, which records the position in the index of the first
+        entry of each frame. The table holds *n_frames* uint64_t positions after this header. The
+        table applies to the index described by the remaining members and readers ignore it when
+        these do not match the file.
+
+        @warning All members are **read-only** to the caller.
+    */
+    struct gsd_frame_table_header
+        {
+        /// Location of the index block when the table was written.
+        uint64_t index_location;
+
+        /// Number of index entries that fit in the index block when the table was written.
+        uint64_t index_allocated_entries;
+
+        /// Location of the index segment table when the table was written.
+        uint64_t index_segments_location;
+
+        /// Number of index entries when the table was written.
+        uint64_t n_entries;
+
+        /// Number of frames in the table.
+        uint64_t n_frames;
+        };
+
     /** Index entry
 
         An index entry for a single chunk of data.
@@ -177,53 +276,121 @@ extern "C"
         /// Number of columns in the chunk.
         uint32_t M;
 
-        /// Index of the chunk name in the name list.
+        /// Index of the chunk name in the name list, UINT16_MAX when the index does not fit in 16
+        /// bits (see gsd_index_record).
         uint16_t id;
 
         /// Data type of the chunk: one of gsd_type.
         uint8_t type;
 
-        /// Flags (for internal use).
+        /// Encoding of the chunk data: a combination of gsd_chunk_flag values.
         uint8_t flags;
         };
 
+    /** Index record
+
+        Index buffers hold their entries as records that pair the gsd_index_entry with the full
+        index of the chunk name. Files with more than UINT16_MAX names are version 3.1 files, which
+        store a 32-bit id followed by a 16-bit M in their index entries.
+    */
+    struct gsd_index_record
+        {
+        /// Index entry of the chunk.
+        struct gsd_index_entry entry;
+
+        /// Index of the chunk name in the name list.
+        uint32_t id;
+        };
+
+    /** Encoded chunk header
+
+        Chunks with non-zero gsd_index_entry::flags start with this header, followed by the
+        encoded data.
+
+        Quantized chunks store the quantization step (the bits of a double) in parameters[0], the
+        minimum multiple of the step (an int64_t) in parameters[1], and the number of bits per
+        packed value in parameters[2].
+
+        Delta encoded chunks store the frame of the keyframe chunk in parameters[0].
+    */
+    struct gsd_chunk_header
+        {
+        /// Number of bytes of encoded data that follow the header.
+        uint64_t encoded_size;
+
+        /// Parameters of the encoding, 0 when unused.
+        uint64_t parameters[3];
+        };
+
     /** Name/id mapping
 
-        A string name paired with an ID. Used for storing sorted name/id mappings in a hash map.
+        One slot of the name/id hash map. Stores the hash of the name next to its id so that probes
+        only compare names when the hashes match.
     */
     struct gsd_name_id_pair
         {
-        /// Pointer to name (actual name storage is allocated in gsd_handle)
-        char* name;
+        /// Name, stored in gsd_name_id_map::names
+        const char* name;
 
-        /// Next name/id pair with the same hash
-        struct gsd_name_id_pair* next;
+        /// Hash of the name
+        uint32_t hash;
 
-        /// Entry id
-        uint16_t id;
+        /// Entry id (UINT32_MAX when the slot is empty)
+        uint32_t id;
+        };
+
+    /// Block of an arena (opaque)
+    struct gsd_arena_block;
+
+    /** Arena of bump allocated memory
+
+        Hands out memory from a chain of large blocks. Allocations are never freed individually:
+        the arena releases all of its blocks at once. Allocations stay at a fixed address while the
+        arena grows.
+    */
+    struct gsd_arena
+        {
+        /// Most recently allocated block (NULL when the arena is empty)
+        struct gsd_arena_block* blocks;
+
+        /// Number of bytes used in the most recent block
+        size_t used;
+
+        /// Number of bytes available in the most recent block
+        size_t reserved;
         };
 
     /** Name/id hash map
 
-        A hash map of string names to integer identifiers.
+        An open addressing hash map of string names to integer identifiers. The map grows as names
+        are added and stores copies of the names in an arena.
     */
     struct gsd_name_id_map
         {
         /// Name/id mappings
         struct gsd_name_id_pair* v;
 
-        /// Number of entries in the mapping
+        /// Number of slots in the mapping (a power of 2)
         size_t size;
+
+        /// Number of names in the mapping
+        size_t n_names;
+
+        /// Storage for the names
+        struct gsd_arena names;
         };
 
     /** Array of index entries
 
-        May point to a mapped location of index entries in the file or an in-memory buffer.
+        An in-memory buffer of index records, or index entries mapped from the file. The file
+        index is mapped when its entries are stored in the gsd_index_entry layout. The file index
+        of a handle that cannot map it is paged instead: *data* is NULL and the entries are read
+        from the file in fixed-size pages the first time they are accessed.
     */
     struct gsd_index_buffer
         {
         /// Indices in the buffer
-        struct gsd_index_entry* data;
+        struct gsd_index_record* data;
 
         /// Number of entries in the buffer
         size_t size;
@@ -231,11 +398,17 @@ extern "C"
         /// Number of entries available in the buffer
         size_t reserved;
 
+        /// Entries mapped from the file (NULL if not mapped)
+        const struct gsd_index_entry* mapped_entries;
+
         /// Pointer to mapped data (NULL if not mapped)
         void* mapped_data;
 
         /// Number of bytes mapped
         size_t mapped_len;
+
+        /// Pages of entries read on demand (NULL when the buffer is not paged)
+        struct gsd_index_record** pages;
         };
 
     /** Byte buffer
@@ -269,6 +442,165 @@ extern "C"
         size_t n_names;
         };
 
+    /// Background writer state (opaque)
+    struct gsd_write_behind;
+
+    /// Read-only mapping of the file for gsd_map_chunk() (opaque)
+    struct gsd_read_map;
+
+    /// Keyframe data of one chunk
+    struct gsd_keyframe
+        {
+        /// Index entry of the keyframe chunk
+        struct gsd_index_entry entry;
+
+        /// Copy of the chunk data (NULL when there is no keyframe)
+        char* data;
+        };
+
+    /** Keyframe cache
+
+        Holds the data of the most recent keyframe of each delta encoded chunk, indexed by chunk id.
+    */
+    struct gsd_keyframe_cache
+        {
+        /// Keyframes
+        struct gsd_keyframe* data;
+
+        /// Number of keyframes in the cache
+        size_t size;
+        };
+
+    /** Frame directory
+
+        Caches the position of the first entry of each frame in the file index. Positions are
+        determined on demand the first time a frame is accessed.
+    */
+    struct gsd_frame_directory
+        {
+        /// Position of the first index entry of each frame plus one (0 when not yet determined)
+        size_t* data;
+
+        /// Number of frame positions in the directory
+        size_t size;
+        };
+
+    /** Frame table
+
+        The frame table of an open file.
+    */
+    struct gsd_frame_table
+        {
+        /// Location of the table in the file (0 when the file has no valid table)
+        uint64_t location;
+
+        /// Number of index entries covered by the table
+        size_t n_entries;
+
+        /// Number of frames in the table
+        uint64_t n_frames;
+
+        /// Mapped positions of the table (NULL when not mapped)
+        const uint64_t* data;
+
+        /// Pointer to the mapped memory
+        void* mapped_data;
+
+        /// Number of bytes mapped
+        size_t mapped_len;
+        };
+
+    /** Mapped write region
+
+        A region at the end of the file that chunk data is copied into directly, see
+        gsd_set_write_map_size().
+    */
+    struct gsd_write_map
+        {
+        /// Pointer to the mapped memory (NULL when no region is mapped)
+        char* data;
+
+        /// Location of the region in the file
+        int64_t offset;
+
+        /// Number of bytes mapped
+        size_t size;
+
+        /// End of the space preallocated in the file for the region (0 when none is)
+        int64_t allocated;
+        };
+
+    /** Memory allocator
+
+        Functions that GSD calls to allocate memory for its handles, see gsd_set_allocator(). Each
+        function receives *context* as its last argument. The functions follow the semantics of
+        malloc(), calloc(), realloc(), and free().
+    */
+    struct gsd_allocator
+        {
+        /// Allocate *size* bytes (like malloc)
+        void* (*allocate)(size_t size, void* context);
+
+        /// Allocate *count* zeroed elements of *size* bytes (like calloc)
+        void* (*allocate_zeroed)(size_t count, size_t size, void* context);
+
+        /// Resize an allocation to *size* bytes (like realloc)
+        void* (*reallocate)(void* ptr, size_t size, void* context);
+
+        /// Free an allocation (like free)
+        void (*deallocate)(void* ptr, void* context);
+
+        /// User data passed to the functions
+        void* context;
+        };
+
+    /** I/O statistics
+
+        Counts the I/O operations on a handle since it was opened, see gsd_get_stats(). Reads and
+        writes count the requests made by the library, which may each take several system calls.
+    */
+    struct gsd_stats
+        {
+        /// Number of read requests
+        uint64_t read_calls;
+
+        /// Number of bytes read
+        uint64_t read_bytes;
+
+        /// Number of write requests, including those made by the write-behind thread
+        uint64_t write_calls;
+
+        /// Number of bytes written
+        uint64_t write_bytes;
+
+        /// Number of calls to fsync
+        uint64_t fsync_calls;
+
+        /// Time spent in fsync (in nanoseconds)
+        uint64_t fsync_ns;
+
+        /// Number of times the index grew by moving it or appending a segment
+        uint64_t index_expansions;
+
+        /// Number of times the write buffer was written to the file
+        uint64_t write_buffer_flushes;
+
+        /// Number of name lookups in the name/id map
+        uint64_t name_lookups;
+
+        /// Total number of slots probed by the name lookups
+        uint64_t name_probes;
+
+        /// Largest number of slots probed by one name lookup
+        uint64_t name_max_probes;
+
+        /// Number of calls to gsd_end_frame()
+        uint64_t end_frame_calls;
+
+        /// Time spent in gsd_end_frame() (in nanoseconds)
+        uint64_t end_frame_ns;
+        };
+
     /** File handle
 
         A handle to an open GSD file.
@@ -276,6 +608,13 @@ extern "C"
         This handle is obtained when opening a GSD file and is passed into every method that
         operates on the file.
 
+        Several threads may call gsd_get_name_id(), gsd_find_chunk(), gsd_find_chunk_by_id(),
+        gsd_read_chunk(), gsd_read_chunks(), gsd_read_chunk_series(), gsd_prefetch_frames(),
+        gsd_map_chunk(), and gsd_unmap_chunk() concurrently on a handle opened in GSD_OPEN_READONLY
+        mode. Reads use pread, which does not move a shared file offset. The caller must serialize
+        all calls on handles opened in other modes, and must not call gsd_close() while other
+        threads use the handle.
+
         @warning All members are **read-only** to the caller.
     */
     struct gsd_handle
@@ -315,6 +654,67 @@ extern "C"
 
         /// Access the names in the namelist
         struct gsd_name_id_map name_map;
+
+        /// Locate the index entries of each frame
+        struct gsd_frame_directory frame_directory;
+
+        /// Background writer (NULL when write-behind is disabled)
+        struct gsd_write_behind* write_behind;
+
+        /// Compression level for encoded chunks (0 selects the codec default)
+        int compression_level;
+
+        /// Maximum number of frames between keyframes of delta encoded chunks
+        uint64_t keyframe_interval;
+
+        /// Reference data for delta encoded chunks
+        struct gsd_keyframe_cache keyframe_cache;
+
+        /// Segments of a chained index (unused when the index is one block)
+        struct gsd_index_segment index_segments[GSD_INDEX_SEGMENT_TABLE_SIZE];
+
+        /// Number of segments in index_segments (0 when the index is one block)
+        size_t n_index_segments;
+
+        /// Non-zero when the index grows by appending segments
+        int chained_index;
+
+        /// Frame table of the file
+        struct gsd_frame_table frame_table;
+
+        /// Size of the write buffer (in bytes)
+        size_t write_buffer_size;
+
+        /// Non-zero when large chunks are written with direct I/O
+        int direct_io;
+
+        /// File descriptor opened for direct I/O (valid when direct_io is non-zero)
+        int direct_io_fd;
+
+        /// Size of the mapped write region (0 when chunks are not written through a map)
+        size_t write_map_size;
+
+        /// Mapped write region at the end of the file
+        struct gsd_write_map write_map;
+
+        /// Mappings of the file that gsd_map_chunk() provides chunks from, newest first (NULL when
+        /// no chunk was mapped)
+        struct gsd_read_map* read_map;
+
+        /// When to sync written data to the storage device
+        enum gsd_sync_policy sync_policy;
+
+        /// Number of frames or seconds between syncs
+        uint64_t sync_interval;
+
+        /// Frame counter at the last sync
+        uint64_t sync_frame;
+
+        /// Time of the last sync (in seconds)
+        int64_t sync_time;
+
+        /// I/O statistics, read them with gsd_get_stats()
+        struct gsd_stats stats;
         };
 
     /** Specify a version
@@ -326,6 +726,27 @@ extern "C"
     */
     uint32_t gsd_make_version(unsigned int major, unsigned int minor);
 
+    /** Set the memory allocator
+
+        @param allocator Allocator to use, or NULL to restore the C library allocator.
+
+        GSD allocates the handle state, the index and frame buffers, the write buffer, the name
+        storage, the write-behind queue, and the codec buffers with *allocator*. The allocator is
+        global: set it before opening any handle. Each allocation must be freed by the allocator
+        that made it, so the allocator cannot change while handles are open or chunks mapped by
+        gsd_map_chunk() are not released. The functions must be thread-safe when write-behind is
+        enabled (see gsd_set_write_behind()) because the write-behind thread frees memory.
+
+        Memory that GSD does not allocate itself is not affected: buffers aligned for direct I/O,
+        mapped file regions, and the internal state of the compression libraries.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_INVALID_ARGUMENT: One of the functions in *allocator* is NULL, or memory
+            allocated by the current allocator is not yet freed.
+    */
+    int gsd_set_allocator(const struct gsd_allocator* allocator);
+
     /** Create a GSD file
 
         @param fname File name.
@@ -413,9 +834,14 @@ extern "C"
         kept. Truncate does not close and reopen the file, so it is suitable for writing restart
         files on Lustre file systems without any metadata access.
 
+        Release the chunks mapped by gsd_map_chunk() before truncating the file.
+
         @return
           - GSD_SUCCESS (0) on success. Negative value on failure:
           - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL, or chunks mapped by gsd_map_chunk() point
+            into the file.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened in read-only mode.
           - GSD_ERROR_NOT_A_GSD_FILE: Not a GSD file.
           - GSD_ERROR_INVALID_GSD_FILE_VERSION: Invalid GSD file version.
           - GSD_ERROR_FILE_CORRUPT: Corrupt file.
@@ -461,14 +887,55 @@ extern "C"
     */
     int gsd_end_frame(struct gsd_handle* handle);
 
+    /** Enable or disable write-behind mode
+
+        @param handle Handle to an open GSD file.
+        @param enable Set to a non-zero value to enable write-behind mode, 0 to disable it.
+
+        @pre *handle* was opened in write or readwrite mode.
+
+        In write-behind mode, gsd_write_chunk() and gsd_end_frame() queue data and index writes to
+        a background thread and return without waiting for them to complete. The queue holds a
+        bounded amount of data: calls block when it is full. Errors that occur on the background
+        thread are reported by the next call to gsd_write_chunk(), gsd_end_frame(), gsd_flush(), or
+        gsd_close(). Calls that read from the file wait for all queued writes to complete.
+
+        Disabling write-behind mode waits for all queued writes to complete. On systems without
+        thread support, all writes are performed synchronously and this call has no effect.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error in a previously queued write (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened in read-only mode.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory or start the thread.
+    */
+    int gsd_set_write_behind(struct gsd_handle* handle, int enable);
+
+    /** Wait for queued writes to complete
+
+        @param handle Handle to an open GSD file.
+
+        @post All data and index writes queued by gsd_write_chunk() and gsd_end_frame() in
+        write-behind mode have been passed to the operating system.
+
+        gsd_flush() returns immediately when write-behind mode is disabled.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error in a queued write (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL.
+    */
+    int gsd_flush(struct gsd_handle* handle);
+
     /** Write a data chunk to the current frame
 
         @param handle Handle to an open GSD file.
         @param name Name of the data chunk.
         @param type type ID that identifies the type of data in *data*.
         @param N Number of rows in the data.
-        @param M Number of columns in the data.
-        @param flags set to 0, non-zero values reserved for future use.
+        @param M Number of columns in the data (at most UINT16_MAX in version 3.1 files).
+        @param flags Encoding of the chunk: 0 or a combination of gsd_chunk_flag values.
         @param data Data buffer.
 
         @pre *handle* was opened by gsd_open().
@@ -483,11 +950,27 @@ extern "C"
 
         @note *N* == 0 is allowed. When *N* is 0, *data* may be NULL.
 
+        @note When *flags* selects a codec, the chunk is compressed with the level set by
+        gsd_set_compression_level(). The chunk is stored without encoding when compression does not
+        reduce its size. gsd_read_chunk() decodes chunks transparently.
+
+        @note GSD_FLAG_DELTA requires a codec. The first chunk with a given name, and every chunk
+        written gsd_set_keyframe_interval() frames after the last keyframe, is stored in full as a
+        keyframe. Other chunks store the XOR with the keyframe data, so gsd_read_chunk() reads at
+        most two chunks. Chunks that change size or type start a new keyframe.
+
+        @note Version 2.0 and 3.0 files store up to UINT16_MAX chunk names. Adding another name
+        writes the index to the end of the file in the version 3.1 layout, which stores 32-bit name
+        ids and at most UINT16_MAX columns per chunk, and converts the file to version 3.1, which
+        older readers do not open. Files with chunks of more than UINT16_MAX columns keep the limit
+        on names.
+
         @return
           - GSD_SUCCESS (0) on success. Negative value on failure:
           - GSD_ERROR_IO: IO error (check errno).
-          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL, *N* == 0, *M* == 0, *type* is invalid, or
-            *flags* != 0.
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL, *N* == 0, *M* == 0, *M* > UINT16_MAX in a
+            version 3.1 file, *type* is invalid, or *flags* is invalid.
+          - GSD_ERROR_UNSUPPORTED_ENCODING: The codec selected by *flags* is not available.
           - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened read-only.
           - GSD_ERROR_NAMELIST_FULL: The file cannot store any additional unique chunk names.
           - GSD_ERROR_MEMORY_ALLOCATION_FAILED: failed to allocate memory.
@@ -500,6 +983,297 @@ extern "C"
                         uint8_t flags,
                         const void* data);
 
+    /** Write a data chunk to the current frame by name id
+
+        @param handle Handle to an open GSD file.
+        @param id Id of the chunk name, from gsd_get_name_id().
+        @param type type ID that identifies the type of data in *data*.
+        @param N Number of rows in the data.
+        @param M Number of columns in the data (at most UINT16_MAX in version 3.1 files).
+        @param flags Encoding of the chunk: 0 or a combination of gsd_chunk_flag values.
+        @param data Data buffer.
+
+        Identical to gsd_write_chunk(), without the name lookup.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL, *id* is not a name id, *M* == 0, *M* >
+            UINT16_MAX in a version 3.1 file, *type* is invalid, or *flags* is invalid.
+          - GSD_ERROR_UNSUPPORTED_ENCODING: The codec selected by *flags* is not available.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened read-only.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: failed to allocate memory.
+    */
+    int gsd_write_chunk_by_id(struct gsd_handle* handle,
+                              uint32_t id,
+                              enum gsd_type type,
+                              uint64_t N,
+                              uint32_t M,
+                              uint8_t flags,
+                              const void* data);
+
+    /** Write a quantized GSD_TYPE_FLOAT data chunk to the current frame
+
+        @param handle Handle to an open GSD file.
+        @param name Name of the data chunk.
+        @param N Number of rows in the data.
+        @param M Number of columns in the data (at most UINT16_MAX in version 3.1 files).
+        @param flags Additional encoding: 0 or a codec from gsd_chunk_flag (without
+            GSD_FLAG_SHUFFLE).
+        @param precision Maximum absolute error of the stored values.
+        @param data Data buffer.
+
+        @pre *handle* was opened by gsd_open().
+        @pre *name* is a unique name for data chunks in the given frame.
+        @pre data is allocated and contains at least `N * M` floats.
+
+        @post The given data chunk is written to the end of the file and its location is updated in
+        the in-memory index.
+
+        @note Values are rounded to the nearest multiple of `2 * precision` and stored as bit packed
+        integers, optionally compressed with the codec in *flags*. gsd_read_chunk() returns the
+        multiples converted to float, which differ from *data* by at most *precision* plus the
+        rounding error of the conversion.
+
+        @note The chunk is stored without quantization when *data* has non-finite values or the
+        quantized values need 32 or more bits.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL, *M* == 0, *M* > UINT16_MAX in a version
+            3.1 file, *precision* is not positive, or *flags* is invalid.
+          - GSD_ERROR_UNSUPPORTED_ENCODING: The codec selected by *flags* is not available.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened read-only.
+          - GSD_ERROR_NAMELIST_FULL: The file cannot store any additional unique chunk names.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: failed to allocate memory.
+    */
+    int gsd_write_quantized_chunk(struct gsd_handle* handle,
+                                  const char* name,
+                                  uint64_t N,
+                                  uint32_t M,
+                                  uint8_t flags,
+                                  double precision,
+                                  const float* data);
+
+    /** Reserve space for a chunk that the caller writes
+
+        @param handle Handle to an open GSD file.
+        @param name Name of the data chunk.
+        @param type type ID that identifies the type of data in *data*.
+        @param N Number of rows in the data.
+        @param M Number of columns in the data (at most UINT16_MAX in version 3.1 files).
+        @param location [out] Location in the file of the reserved bytes.
+
+        @pre *handle* was opened by gsd_open().
+        @pre *name* is a unique name for data chunks in the given frame.
+
+        @post The index of the current frame has an entry for an uncompressed chunk at *location*
+        and `N * M * gsd_sizeof_type(type)` bytes at the end of the file are reserved for its data.
+
+        The caller must write the data to the reserved bytes before gsd_end_frame() writes the
+        index entry. gsd_mpi_write_chunk() uses this to write a chunk from many processes.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_INVALID_ARGUMENT: *handle*, *name*, or *location* is NULL, *M* == 0, *M* >
+            UINT16_MAX in a version 3.1 file, or *type* is invalid.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened read-only.
+          - GSD_ERROR_NAMELIST_FULL: The file cannot store any additional unique chunk names.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: failed to allocate memory.
+    */
+    int gsd_reserve_chunk(struct gsd_handle* handle,
+                          const char* name,
+                          enum gsd_type type,
+                          uint64_t N,
+                          uint32_t M,
+                          int64_t* location);
+
+    /** Set the compression level for encoded chunks
+
+        @param handle Handle to an open GSD file.
+        @param level Compression level passed to the codec. 0 selects the codec's default level.
+
+        @post Chunks written by gsd_write_chunk() with a codec flag use *level*.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL.
+    */
+    int gsd_set_compression_level(struct gsd_handle* handle, int level);
+
+    /** Set the keyframe interval for delta encoded chunks
+
+        @param handle Handle to an open GSD file.
+        @param interval Maximum number of frames between keyframes.
+
+        @post gsd_write_chunk() with GSD_FLAG_DELTA stores a chunk in full (a keyframe) when the
+        previous keyframe of the chunk is *interval* or more frames before the current frame.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL or *interval* is 0.
+    */
+    int gsd_set_keyframe_interval(struct gsd_handle* handle, uint64_t interval);
+
+    /** Grow the index by appending segments
+
+        @param handle Handle to an open GSD file.
+        @param enable Set to non-zero to chain index segments.
+
+        By default, the index is one block and growing it copies the whole index to the end of the
+        file. With a chained index, growing the index appends a new empty segment to the file and
+        records it in the index segment table without copying existing entries. The first segment
+        appended converts a version 2.0 file to version 3.0, which older readers do not open.
+        Version 3.1 files keep their version and version 1.0 files do not chain their index.
+
+        @note Files that already have a chained index always append segments.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened read-only.
+    */
+    int gsd_set_chained_index(struct gsd_handle* handle, int enable);
+
+    /** Set the size of the write buffer
+
+        @param handle Handle to an open GSD file.
+        @param size Size of the write buffer in bytes.
+
+        Chunks smaller than half of the write buffer are copied to the buffer and written to the
+        file together. Larger chunks are written directly. Changing the size writes the chunks in
+        the buffer to the file. The buffer holds 16 MiB by default.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL or *size* is 0.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened read-only.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+    */
+    int gsd_set_write_buffer_size(struct gsd_handle* handle, size_t size);
+
+    /** Write large chunks with direct I/O
+
+        @param handle Handle to an open GSD file.
+        @param enable Non-zero to enable direct I/O, 0 to disable it.
+
+        With direct I/O, chunks that bypass the write buffer (see gsd_set_write_buffer_size()) are
+        written with O_DIRECT from page aligned memory and do not fill the page cache. The
+        unaligned bytes at the start and end of each chunk are written normally. Direct I/O is
+        available on Linux, writes go through the page cache on other systems.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno), such as a file system that does not support
+            O_DIRECT.
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened read-only.
+    */
+    int gsd_set_direct_io(struct gsd_handle* handle, int enable);
+
+    /** Write chunks through a memory mapping of the end of the file
+
+        @param handle Handle to an open GSD file.
+        @param size Size of the mapped region (in bytes), or 0 to write chunks with pwrite.
+
+        With a mapped write region, gsd_write_chunk() copies the chunk data directly into a
+        writable mapping of the file past its current end instead of the write buffer, so that
+        frames of many small chunks need no extra copy and no write system call. Each region is
+        preallocated with posix_fallocate() (or by extending the file where it is unavailable) and
+        mapped *size* bytes at a time, rounded up to the page size. gsd_close() truncates the
+        space that was not used. A file that is not closed may end with preallocated zeros, which
+        readers ignore and later appends skip.
+
+        Chunks written through the map do not use the write buffer, write-behind, or direct I/O,
+        and their copies do not count as write requests in gsd_get_stats(). Mapped writes are
+        available on systems with mmap, chunks are written with pwrite on other systems. Setting
+        the size writes the buffered chunks to the file.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened read-only.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+    */
+    int gsd_set_write_map_size(struct gsd_handle* handle, size_t size);
+
+    /** Set when the file is synced to the storage device
+
+        @param handle Handle to an open GSD file.
+        @param policy When to sync.
+        @param interval Number of frames (GSD_SYNC_EVERY_N_FRAMES) or seconds
+          (GSD_SYNC_EVERY_N_SECONDS) between syncs. Ignored by the other policies.
+
+        GSD_SYNC_ALWAYS (the default) syncs each time the name list, index, or header is about to
+        refer to newly written metadata, so that the file on disk is consistent after a crash. The
+        other policies skip these syncs and sync only at the end of a frame once the interval
+        passes and in gsd_close(). After a crash, all frames completed before the last sync are on
+        disk, but later frames may be lost and the file may not open when the name list or index
+        moved after the last sync. Frames still queued by write-behind are covered by the next
+        sync. Changing the policy syncs the file when the previous policy deferred syncs.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL, *policy* is invalid, or *interval* is 0
+            when *policy* needs an interval.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened in read-only mode.
+    */
+    int gsd_set_sync_policy(struct gsd_handle* handle,
+                            enum gsd_sync_policy policy,
+                            uint64_t interval);
+
+    /** Get the I/O statistics of a handle
+
+        @param handle Handle to an open GSD file.
+        @param stats Statistics to fill out.
+
+        The counters accumulate from the time the handle is opened. Counting costs one relaxed
+        atomic addition per operation. Build with `GSD_ENABLE_STATS=0` to remove the counters, in
+        which case all statistics are 0.
+
+        @note Thread-safe on handles opened in GSD_OPEN_READONLY mode.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* or *stats* is NULL.
+    */
+    int gsd_get_stats(struct gsd_handle* handle, struct gsd_stats* stats);
+
+    /** Write a frame table
+
+        @param handle Handle to an open GSD file.
+
+        Write a table of the position in the index of the first entry of each committed frame to
+        the end of the file and record its location in the header. When opening a file with a
+        valid frame table, gsd_open() takes the number of index entries from the table instead of
+        searching the index. Chunk lookups find the entries of a frame with one access to the table
+        instead of a binary search of the index. Once a file has a frame table, gsd_close()
+        rewrites it when frames were added to the file.
+
+        The frame table is optional. Readers ignore a table that does not match the index, such as
+        the table of a file that an older version of GSD appended frames to.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened read-only.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+    */
+    int gsd_write_frame_table(struct gsd_handle* handle);
+
+    /** Test if a codec is available
+
+        @param flags Encoding flags (a combination of gsd_chunk_flag values).
+
+        @return true when this build can read and write chunks encoded with *flags*.
+    */
+    bool gsd_is_encoding_available(uint8_t flags);
+
     /** Find a chunk in the GSD file
 
         @param handle Handle to an open GSD file
@@ -511,11 +1285,54 @@ extern "C"
         The found entry contains size and type metadata and can be passed to gsd_read_chunk() to
         read the data.
 
+        @note Thread-safe on handles opened in GSD_OPEN_READONLY mode.
+
         @return A pointer to the found chunk, or NULL if not found.
     */
     const struct gsd_index_entry*
     gsd_find_chunk(struct gsd_handle* handle, uint64_t frame, const char* name);
 
+    /** Get the id of a chunk name
+
+        @param handle Handle to an open GSD file
+        @param name Name of the chunk
+        @param id [out] Set to the id of *name*, or UINT32_MAX when the file does not contain
+        *name*.
+        @param append Set to non-zero to add *name* to a writable file that does not contain it.
+
+        @pre *handle* was opened by gsd_open().
+
+        Pass the id to gsd_write_chunk_by_id() and gsd_find_chunk_by_id() to avoid looking up the
+        name on every call. Ids remain valid until gsd_truncate() or gsd_close().
+
+        @note gsd_get_name_id() never adds names to files opened in GSD_OPEN_READONLY mode.
+
+        @note Adding a name past UINT16_MAX names converts a version 2.0 or 3.0 file to version 3.1,
+        as described in gsd_write_chunk().
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_INVALID_ARGUMENT: *handle*, *name*, or *id* is NULL.
+          - GSD_ERROR_NAMELIST_FULL: The file cannot store any additional unique chunk names.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: failed to allocate memory.
+    */
+    int gsd_get_name_id(struct gsd_handle* handle, const char* name, uint32_t* id, int append);
+
+    /** Find a chunk in the GSD file by name id
+
+        @param handle Handle to an open GSD file
+        @param frame Frame to look for chunk
+        @param id Id of the chunk name, from gsd_get_name_id()
+
+        @pre *handle* was opened by gsd_open() in read or readwrite mode.
+
+        @note Thread-safe on handles opened in GSD_OPEN_READONLY mode.
+
+        @return A pointer to the found chunk, or NULL if not found.
+    */
+    const struct gsd_index_entry*
+    gsd_find_chunk_by_id(struct gsd_handle* handle, uint64_t frame, uint32_t id);
+
     /** Read a chunk from the GSD file
 
         @param handle Handle to an open GSD file.
@@ -527,6 +1344,8 @@ extern "C"
         @pre *data* points to an allocated buffer with at least `N * M * gsd_sizeof_type(type)`
        bytes.
 
+        @note Thread-safe on handles opened in GSD_OPEN_READONLY mode.
+
         @return
           - GSD_SUCCESS (0) on success. Negative value on failure:
           - GSD_ERROR_IO: IO error (check errno).
@@ -536,6 +1355,189 @@ extern "C"
     */
     int gsd_read_chunk(struct gsd_handle* handle, void* data, const struct gsd_index_entry* chunk);
 
+    /** Read a chunk from the GSD file and convert it to another type
+
+        @param handle Handle to an open GSD file.
+        @param data Data buffer to read into.
+        @param chunk Chunk to read.
+        @param type Type of the values to store in *data*.
+
+        Read the chunk as gsd_read_chunk() does and convert the values to *type* while they are in
+        the cache. When *type* is at least as large as the chunk type, the chunk is read into the
+        same buffer and converted in place. Integers convert to floating point types and to integer
+        types that represent every value of the chunk type, floating point values convert only to
+        floating point types.
+
+        @pre *handle* was opened in read or readwrite mode.
+        @pre *chunk* was found by gsd_find_chunk().
+        @pre *data* points to an allocated buffer with at least `N * M * gsd_sizeof_type(type)`
+          bytes.
+
+        @note Thread-safe on handles opened in GSD_OPEN_READONLY mode.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL, *data* is NULL, *chunk* is NULL, *type*
+            is invalid, the chunk stores floating point values and *type* is an integer type, or
+            the chunk stores integers and *type* is an integer type that does not represent every
+            value of the chunk type.
+          - GSD_ERROR_FILE_MUST_BE_READABLE: The file was opened in append mode.
+          - GSD_ERROR_FILE_CORRUPT: The GSD file is corrupt.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+    */
+    int gsd_read_chunk_as(struct gsd_handle* handle,
+                          void* data,
+                          const struct gsd_index_entry* chunk,
+                          enum gsd_type type);
+
+    /** Read many chunks from the GSD file
+
+        @param handle Handle to an open GSD file.
+        @param n Number of chunks to read.
+        @param chunks Array of *n* chunks to read.
+        @param data Array of *n* data buffers to read into.
+
+        @pre *handle* was opened in read or readwrite mode.
+        @pre Each of *chunks* was found by gsd_find_chunk().
+        @pre `data[i]` points to an allocated buffer with at least
+       `N * M * gsd_sizeof_type(type)` bytes of `chunks[i]`.
+
+        Read the chunks in the order they are stored in the file. Combine chunks that are
+        contiguous or separated by small gaps in the file into a single read and copy the data to
+        the destination buffers.
+        Chunks written in the same frame are usually contiguous, so reading all the chunks of a
+        frame with one call needs far fewer system calls than calling gsd_read_chunk() on each.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL, *chunks* or *data* is NULL, or one of
+            their elements is NULL.
+          - GSD_ERROR_FILE_MUST_BE_READABLE: The file was opened in append mode.
+          - GSD_ERROR_FILE_CORRUPT: The GSD file is corrupt.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+    */
+    int gsd_read_chunks(struct gsd_handle* handle,
+                        size_t n,
+                        const struct gsd_index_entry** chunks,
+                        void** data);
+
+    /** Read one chunk from a range of frames
+
+        @param handle Handle to an open GSD file.
+        @param name Name of the chunk to read.
+        @param first First frame to read.
+        @param last One past the last frame to read.
+        @param stride Number of frames between frames to read.
+        @param data Data buffer to read into.
+        @param size Size of *data* in bytes.
+
+        @pre *handle* was opened in read or readwrite mode.
+
+        Read the chunk *name* from frames `first`, `first + stride`, ... up to but not including
+        *last* and store them one after another in *data*. Every frame must contain *name* with the
+        same type, N, and M. gsd_read_chunk_series() combines reads of chunks that are close
+        together in the file, which makes reading a time series of small chunks (such as logged
+        quantities) much faster than calling gsd_read_chunk() for each frame.
+
+        @note Thread-safe on handles opened in GSD_OPEN_READONLY mode.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle*, *name*, or *data* is NULL, *stride* is 0, *last*
+            is greater than the number of frames, a frame does not contain *name* or its chunk
+            differs in type or shape, or *data* holds fewer than
+            `n_frames * N * M * gsd_sizeof_type(type)` bytes.
+          - GSD_ERROR_FILE_MUST_BE_READABLE: The file was opened in append mode.
+          - GSD_ERROR_FILE_CORRUPT: The GSD file is corrupt.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+    */
+    int gsd_read_chunk_series(struct gsd_handle* handle,
+                              const char* name,
+                              uint64_t first,
+                              uint64_t last,
+                              uint64_t stride,
+                              void* data,
+                              size_t size);
+
+    /** Prefetch frames from the GSD file
+
+        @param handle Handle to an open GSD file.
+        @param first First frame to prefetch.
+        @param count Number of frames to prefetch.
+
+        @pre *handle* was opened in read or readwrite mode.
+
+        Advise the operating system that the chunks of frames `first` through
+        `first + count - 1` will be read soon. The system reads the byte ranges of these frames into
+        the page cache in the background and gsd_prefetch_frames() returns without waiting for
+        them. Later calls to gsd_read_chunk() then find the data in memory. Frames past the end of
+        the file are ignored. Does nothing on systems that do not support read ahead advice.
+
+        @note Thread-safe on handles opened in GSD_OPEN_READONLY mode.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL.
+          - GSD_ERROR_FILE_MUST_BE_READABLE: The file was opened in append mode.
+    */
+    int gsd_prefetch_frames(struct gsd_handle* handle, uint64_t first, uint64_t count);
+
+    /** Map a chunk from the GSD file into memory
+
+        @param handle Handle to an open GSD file.
+        @param data [out] Set to point to the chunk data.
+        @param chunk Chunk to map.
+
+        @pre *handle* was opened in read or readwrite mode.
+        @pre *chunk* was found by gsd_find_chunk().
+
+        @post *data* points to `N * M * gsd_sizeof_type(type)` read-only bytes of chunk data.
+
+        On systems that support mmap, *data* points directly into a read-only mapping of the file
+        and no copy is made. The handle maps the file once and shares the mapping between chunks. It
+        maps the file again only when the chunk is past the end of the mapping, after the file grew.
+        On other systems, the chunk is read into a newly allocated buffer. Release the data with
+        gsd_unmap_chunk() when it is no longer needed. The mapping does not depend on the file
+        descriptor and remains valid after gsd_close(). The mapping is released by
+        gsd_unmap_chunk() on the same handle, which must not open another file before then.
+        gsd_truncate() fails while mapped chunks are not released.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL, *data* is NULL, or *chunk* is NULL.
+          - GSD_ERROR_FILE_MUST_BE_READABLE: The file was opened in append mode.
+          - GSD_ERROR_FILE_CORRUPT: The GSD file is corrupt.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+    */
+    int gsd_map_chunk(struct gsd_handle* handle,
+                      const void** data,
+                      const struct gsd_index_entry* chunk);
+
+    /** Release chunk data mapped by gsd_map_chunk()
+
+        @param handle Handle that mapped the chunk.
+        @param data Pointer provided by gsd_map_chunk().
+        @param chunk Chunk passed to gsd_map_chunk().
+
+        @pre *data* was provided by gsd_map_chunk() given *chunk*.
+
+        @post *data* is no longer valid.
+
+        @note After gsd_close(), the caller must serialize calls to gsd_unmap_chunk() on the handle.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL, *data* is NULL, *chunk* is NULL, or
+            *data* does not point into a mapping of *handle*.
+    */
+    int gsd_unmap_chunk(struct gsd_handle* handle,
+                        const void* data,
+                        const struct gsd_index_entry* chunk);
+
     /** Get the number of frames in the GSD file
 
         @param handle Handle to an open GSD file
@@ -546,6 +1548,42 @@ extern "C"
     */
     uint64_t gsd_get_nframes(struct gsd_handle* handle);
 
+    /** Load the frames added to the file since it was opened or last refreshed
+
+        @param handle Handle to an open GSD file.
+
+        Follow a file that another process writes. gsd_refresh() reads the header, loads the index
+        entries after the last known entry, and adds the new chunk names to the name map. The cost
+        is proportional to the number of new entries and names, not the size of the file. When
+        the writer moves the index, the new index block is mapped (or read from the last known
+        entry) after checking that it holds the known entries. When the file no longer extends the
+        entries known to the handle, for example after gsd_truncate(), the handle is loaded from
+        the file as in gsd_open().
+
+        Entries of a frame that the writer commits during the call may be partially loaded. The
+        next call loads the rest of the frame.
+
+        Pointers to index entries returned by gsd_find_chunk() and gsd_find_chunk_by_id() before
+        the call are invalid after it. The caller must not call other functions on the handle
+        concurrently with gsd_refresh().
+
+        @pre *handle* was opened by gsd_open() in GSD_OPEN_READONLY mode.
+
+        @post gsd_get_nframes() returns the number of frames in the file. On failure, the handle
+        remains open with the frames found by earlier calls.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL or was not opened in GSD_OPEN_READONLY
+            mode.
+          - GSD_ERROR_NOT_A_GSD_FILE: The file is no longer a GSD file.
+          - GSD_ERROR_INVALID_GSD_FILE_VERSION: The file version is no longer supported.
+          - GSD_ERROR_FILE_CORRUPT: Corrupt file.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+    */
+    int gsd_refresh(struct gsd_handle* handle);
+
     /** Query size of a GSD type ID.
 
         @param type Type ID to query.
@@ -0,0 +1,296 @@
+// Copyright (c) 2016-2021 The Regents of the University of Michigan
+// This file is part of the General Simulation Data (GSD) project, released under the BSD 2-Clause
+// License.
+
+#include <string.h>
+
+#include "gsd_mpi.h"
+
+/** @file gsd_mpi.c
+    @brief Implements the collective write API for MPI programs
+*/
+
+/// Largest number of bytes written by one call to MPI_File_write_at_all
+enum
+    {
+    GSD_MPI_MAX_WRITE_SIZE = 1 << 30
+    };
+
+/** @internal
+    @brief Combine the return values of all ranks
+
+    @param comm Communicator of the ranks.
+    @param retval Return value of this rank.
+
+    @returns GSD_SUCCESS when all ranks succeed, otherwise the error code of one of the ranks.
+*/
+inline static int gsd_mpi_agree(MPI_Comm comm, int retval)
+    {
+    int result = retval;
+    MPI_Allreduce(&retval, &result, 1, MPI_INT, MPI_MIN, comm);
+    return result;
+    }
+
+/** @internal
+    @brief Initialize the handle before opening the file
+
+    @param handle Handle to initialize.
+    @param comm Communicator of the ranks that write to the file.
+*/
+inline static void gsd_mpi_initialize_handle(struct gsd_mpi_handle* handle, MPI_Comm comm)
+    {
+    memset(handle, 0, sizeof(struct gsd_mpi_handle));
+    MPI_Comm_dup(comm, &handle->comm);
+    MPI_Comm_rank(handle->comm, &handle->rank);
+    handle->file = MPI_FILE_NULL;
+    }
+
+/** @internal
+    @brief Open the MPI file on all ranks after rank 0 opened the GSD file
+
+    @param handle Handle to open.
+    @param fname File name.
+    @param retval Return value of opening the GSD file on rank 0.
+
+    @returns GSD_SUCCESS on success, GSD_* error codes on error.
+*/
+inline static int gsd_mpi_open_file(struct gsd_mpi_handle* handle, const char* fname, int retval)
+    {
+    // all ranks learn the result of opening the file on rank 0
+    MPI_Bcast(&retval, 1, MPI_INT, 0, handle->comm);
+    if (retval == GSD_SUCCESS)
+        {
+        int mpi_retval = MPI_File_open(handle->comm,
+                                       (char*)fname,
+                                       MPI_MODE_WRONLY,
+                                       MPI_INFO_NULL,
+                                       &handle->file);
+        retval = mpi_retval == MPI_SUCCESS ? GSD_SUCCESS : GSD_ERROR_IO;
+        retval = gsd_mpi_agree(handle->comm, retval);
+
+        if (retval != GSD_SUCCESS)
+            {
+            if (handle->file != MPI_FILE_NULL)
+                {
+                MPI_File_close(&handle->file);
+                }
+            if (handle->rank == 0)
+                {
+                gsd_close(&handle->handle);
+                }
+            }
+        }
+
+    if (retval != GSD_SUCCESS)
+        {
+        MPI_Comm_free(&handle->comm);
+        }
+
+    return retval;
+    }
+
+int gsd_mpi_create_and_open(struct gsd_mpi_handle* handle,
+                            MPI_Comm comm,
+                            const char* fname,
+                            const char* application,
+                            const char* schema,
+                            uint32_t schema_version,
+                            enum gsd_open_flag flags,
+                            int exclusive_create)
+    {
+    if (handle == NULL || fname == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+
+    gsd_mpi_initialize_handle(handle, comm);
+
+    int retval = GSD_SUCCESS;
+    if (handle->rank == 0)
+        {
+        retval = gsd_create_and_open(&handle->handle,
+                                     fname,
+                                     application,
+                                     schema,
+                                     schema_version,
+                                     flags,
+                                     exclusive_create);
+        }
+
+    return gsd_mpi_open_file(handle, fname, retval);
+    }
+
+int gsd_mpi_open(struct gsd_mpi_handle* handle,
+                 MPI_Comm comm,
+                 const char* fname,
+                 enum gsd_open_flag flags)
+    {
+    if (handle == NULL || fname == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+    if (flags == GSD_OPEN_READONLY)
+        {
+        return GSD_ERROR_FILE_MUST_BE_WRITABLE;
+        }
+
+    gsd_mpi_initialize_handle(handle, comm);
+
+    int retval = GSD_SUCCESS;
+    if (handle->rank == 0)
+        {
+        retval = gsd_open(&handle->handle, fname, flags);
+        }
+
+    return gsd_mpi_open_file(handle, fname, retval);
+    }
+
+int gsd_mpi_write_chunk(struct gsd_mpi_handle* handle,
+                        const char* name,
+                        enum gsd_type type,
+                        uint64_t N,
+                        uint32_t M,
+                        const void* data)
+    {
+    if (handle == NULL || name == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    // validate input
+    size_t type_size = gsd_sizeof_type(type);
+    int retval = GSD_SUCCESS;
+    if (M == 0 || type_size == 0 || (N > 0 && data == NULL))
+        {
+        retval = GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    // the rows of all ranks must have the same shape
+    uint64_t shape[2] = {(uint64_t)type, M};
+    MPI_Bcast(shape, 2, MPI_UINT64_T, 0, handle->comm);
+    if (shape[0] != (uint64_t)type || shape[1] != M)
+        {
+        retval = GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    retval = gsd_mpi_agree(handle->comm, retval);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    // find the range of this rank in the chunk
+    uint64_t size = N * M * type_size;
+    uint64_t offset = 0;
+    MPI_Exscan(&size, &offset, 1, MPI_UINT64_T, MPI_SUM, handle->comm);
+    if (handle->rank == 0)
+        {
+        // MPI_Exscan leaves the result on rank 0 undefined
+        offset = 0;
+        }
+
+    uint64_t total_N = 0;
+    MPI_Reduce(&N, &total_N, 1, MPI_UINT64_T, MPI_SUM, 0, handle->comm);
+
+    // rank 0 reserves the chunk at the end of the file and adds its index entry to the frame
+    int64_t reservation[2] = {GSD_SUCCESS, 0};
+    if (handle->rank == 0)
+        {
+        int64_t location = 0;
+        reservation[0] = gsd_reserve_chunk(&handle->handle, name, type, total_N, M, &location);
+        reservation[1] = location;
+        }
+
+    MPI_Bcast(reservation, 2, MPI_INT64_T, 0, handle->comm);
+    if (reservation[0] != GSD_SUCCESS)
+        {
+        return (int)reservation[0];
+        }
+
+    // all ranks must make the same number of calls to MPI_File_write_at_all
+    uint64_t n_writes = (size + GSD_MPI_MAX_WRITE_SIZE - 1) / GSD_MPI_MAX_WRITE_SIZE;
+    uint64_t max_writes = 0;
+    MPI_Allreduce(&n_writes, &max_writes, 1, MPI_UINT64_T, MPI_MAX, handle->comm);
+
+    const char* ptr = (const char*)data;
+    uint64_t bytes_written = 0;
+    uint64_t i;
+    for (i = 0; i < max_writes; i++)
+        {
+        uint64_t count = size - bytes_written;
+        if (count > GSD_MPI_MAX_WRITE_SIZE)
+            {
+            count = GSD_MPI_MAX_WRITE_SIZE;
+            }
+
+        MPI_Status status;
+        MPI_Offset position = (MPI_Offset)(reservation[1] + offset + bytes_written);
+        int mpi_retval = MPI_File_write_at_all(handle->file,
+                                               position,
+                                               (void*)(ptr + bytes_written),
+                                               (int)count,
+                                               MPI_BYTE,
+                                               &status);
+        if (mpi_retval != MPI_SUCCESS)
+            {
+            retval = GSD_ERROR_IO;
+            }
+
+        bytes_written += count;
+        }
+
+    return gsd_mpi_agree(handle->comm, retval);
+    }
+
+int gsd_mpi_end_frame(struct gsd_mpi_handle* handle)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    // the data of all ranks must be in the file before rank 0 writes the index entries
+    int mpi_retval = MPI_File_sync(handle->file);
+    int retval
+        = gsd_mpi_agree(handle->comm, mpi_retval == MPI_SUCCESS ? GSD_SUCCESS : GSD_ERROR_IO);
+    if (retval != GSD_SUCCESS)
+        {
+        return retval;
+        }
+
+    if (handle->rank == 0)
+        {
+        retval = gsd_end_frame(&handle->handle);
+        }
+
+    MPI_Bcast(&retval, 1, MPI_INT, 0, handle->comm);
+    return retval;
+    }
+
+int gsd_mpi_close(struct gsd_mpi_handle* handle)
+    {
+    if (handle == NULL)
+        {
+        return GSD_ERROR_INVALID_ARGUMENT;
+        }
+
+    int mpi_retval = MPI_File_close(&handle->file);
+    int retval = mpi_retval == MPI_SUCCESS ? GSD_SUCCESS : GSD_ERROR_IO;
+
+    if (handle->rank == 0)
+        {
+        int close_retval = gsd_close(&handle->handle);
+        if (retval == GSD_SUCCESS)
+            {
+            retval = close_retval;
+            }
+        }
+
+    retval = gsd_mpi_agree(handle->comm, retval);
+    MPI_Comm_free(&handle->comm);
+    return retval;
+    }
@@ -0,0 +1,165 @@
+// Copyright (c) 2016-2021 The Regents of the University of Michigan
+// This file is part of the General Simulation Data (GSD) project, released under the BSD 2-Clause
+// License.
+
+#ifndef GSD_MPI_H
+#define GSD_MPI_H
+
+#include <mpi.h>
+
+#include "gsd.h"
+
+#ifdef __cplusplus
+extern "C"
+    {
+#endif
+
+    /*! \file gsd_mpi.h
+        \brief Declare the collective write API for MPI programs
+    */
+
+    /** MPI file handle
+
+        Handle to a GSD file opened by all ranks of a communicator. Rank 0 holds the GSD file handle
+        and writes the index and name list. All ranks write chunk data through the MPI file.
+
+        @warning All members are **read-only** to the caller.
+    */
+    struct gsd_mpi_handle
+        {
+        /// GSD file handle, only open on rank 0
+        struct gsd_handle handle;
+
+        /// Communicator of the ranks that write to the file
+        MPI_Comm comm;
+
+        /// Rank of this process in comm
+        int rank;
+
+        /// MPI file that all ranks write chunk data to
+        MPI_File file;
+        };
+
+    /** Create a GSD file and open it on all ranks
+
+        @param handle Handle to open.
+        @param comm Communicator of the ranks that write to the file.
+        @param fname File name (UTF-8 encoded), the same on all ranks.
+        @param application Generating application name (truncated to 63 chars).
+        @param schema Schema name for data to be written in this GSD file (truncated to 63 chars).
+        @param schema_version Version of the scheme data to be written (make with
+          gsd_make_version()).
+        @param flags Either GSD_OPEN_READWRITE, or GSD_OPEN_APPEND.
+        @param exclusive_create Set to non-zero to force exclusive creation of the file.
+
+        This function is collective over *comm*. Rank 0 creates the file with
+        gsd_create_and_open() and all ranks open it with MPI_File_open().
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: *flags* is GSD_OPEN_READONLY.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+    */
+    int gsd_mpi_create_and_open(struct gsd_mpi_handle* handle,
+                                MPI_Comm comm,
+                                const char* fname,
+                                const char* application,
+                                const char* schema,
+                                uint32_t schema_version,
+                                enum gsd_open_flag flags,
+                                int exclusive_create);
+
+    /** Open a GSD file on all ranks
+
+        @param handle Handle to open.
+        @param comm Communicator of the ranks that write to the file.
+        @param fname File name (UTF-8 encoded), the same on all ranks.
+        @param flags Either GSD_OPEN_READWRITE, or GSD_OPEN_APPEND.
+
+        This function is collective over *comm*. Rank 0 opens the file with gsd_open() and all ranks
+        open it with MPI_File_open().
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_NOT_A_GSD_FILE: Not a GSD file.
+          - GSD_ERROR_INVALID_GSD_FILE_VERSION: Invalid GSD file version.
+          - GSD_ERROR_FILE_CORRUPT: Corrupt file.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: *flags* is GSD_OPEN_READONLY.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+    */
+    int gsd_mpi_open(struct gsd_mpi_handle* handle,
+                     MPI_Comm comm,
+                     const char* fname,
+                     enum gsd_open_flag flags);
+
+    /** Write a data chunk from all ranks to the current frame
+
+        @param handle Handle to an open GSD file.
+        @param name Name of the data chunk, the same on all ranks.
+        @param type type ID that identifies the type of data in *data*, the same on all ranks.
+        @param N Number of rows this rank writes.
+        @param M Number of columns in the data, the same on all ranks (at most UINT16_MAX in version
+        3.1 files).
+        @param data Data buffer with the rows of this rank.
+
+        This function is collective over the communicator. The chunk holds the rows of all ranks in
+        rank order. An exclusive scan over the bytes of each rank gives each rank its range in the
+        chunk and all ranks write their range with MPI_File_write_at_all(). Rank 0 reserves the
+        chunk with gsd_reserve_chunk() so that gsd_mpi_end_frame() writes its index entry. Chunks
+        are stored without encoding. Rank 0 may write chunks that only it holds with
+        gsd_write_chunk() on gsd_mpi_handle::handle.
+
+        @pre *data* is allocated and contains at least `N * M * gsd_sizeof_type(type)` bytes.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* or *name* is NULL, *M* == 0, *M* > UINT16_MAX in a
+            version 3.1 file, *type* is invalid, or *type* and *M* differ between ranks.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened read-only.
+          - GSD_ERROR_NAMELIST_FULL: The file cannot store any additional unique chunk names.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: failed to allocate memory.
+    */
+    int gsd_mpi_write_chunk(struct gsd_mpi_handle* handle,
+                            const char* name,
+                            enum gsd_type type,
+                            uint64_t N,
+                            uint32_t M,
+                            const void* data);
+
+    /** Complete the current frame on all ranks
+
+        @param handle Handle to an open GSD file.
+
+        This function is collective over the communicator. It syncs the MPI file so that the data
+        of all ranks is in the file before rank 0 calls gsd_end_frame().
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL.
+          - GSD_ERROR_FILE_MUST_BE_WRITABLE: The file was opened read-only.
+          - GSD_ERROR_MEMORY_ALLOCATION_FAILED: Unable to allocate memory.
+    */
+    int gsd_mpi_end_frame(struct gsd_mpi_handle* handle);
+
+    /** Close a GSD file on all ranks
+
+        @param handle Handle to an open GSD file.
+
+        This function is collective over the communicator.
+
+        @return
+          - GSD_SUCCESS (0) on success. Negative value on failure:
+          - GSD_ERROR_IO: IO error (check errno).
+          - GSD_ERROR_INVALID_ARGUMENT: *handle* is NULL.
+    */
+    int gsd_mpi_close(struct gsd_mpi_handle* handle);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif // #ifndef GSD_MPI_H
@@ -16,12 +16,16 @@ for full examples.
     * `ConfigurationData` - Store configuration data in a snapshot.
     * `ParticleData` - Store particle data in a snapshot.
     * `BondData` - Store topology data in a snapshot.
+
+* `CacheInfo` - Frame cache statistics of a `HOOMDTrajectory`.
 """
 
 import numpy
-from collections import OrderedDict
+from collections import OrderedDict, deque, namedtuple
+import concurrent.futures
 import logging
 import json
+import os
 
 try:
     from gsd import fl
@@ -607,6 +611,40 @@ class Snapshot(object):
                 raise RuntimeError('Not a valid state: ' + k)
 
 
+CacheInfo = namedtuple('CacheInfo', ['hits', 'misses', 'maxsize', 'currsize'])
+CacheInfo.__doc__ = """Frame cache statistics.
+
+Attributes:
+    hits (int): Number of frames returned from the cache.
+    misses (int): Number of frames read from the file while the cache is
+        enabled.
+    maxsize (int): Maximum number of bytes held by the cache.
+    currsize (int): Number of bytes held by the cache.
+"""
+
+
+def _snapshot_arrays(snap):
+    """Iterate over the numpy arrays in a snapshot."""
+    for path in [
+            'configuration',
+            'particles',
+            'bonds',
+            'angles',
+            'dihedrals',
+            'impropers',
+            'constraints',
+            'pairs',
+    ]:
+        for value in getattr(snap, path).__dict__.values():
+            if isinstance(value, numpy.ndarray):
+                yield value
+
+    for data in (snap.state, snap.log):
+        for value in data.values():
+            if isinstance(value, numpy.ndarray):
+                yield value
+
+
 class _HOOMDTrajectoryIterable(object):
     """Iterable over a HOOMDTrajectory object."""
 
@@ -656,16 +694,51 @@ class HOOMDTrajectory(object):
 
     Args:
         file (`gsd.fl.GSDFile`): File to access.
+        cache_size (int): Maximum number of bytes of decoded frames to keep in
+            memory. Set to 0 to disable the frame cache.
+        fields (list[str]): Names of the chunks to read, or ``None`` to read
+            all chunks.
 
     Open hoomd GSD files with `open`.
+
+    When *fields* is not ``None``, `read_frame` looks up and reads only the
+    chunks named in *fields* and chunks under a path in *fields*. For example,
+    ``fields=['particles/position', 'log']`` reads the particle positions and
+    all logged quantities. ``configuration/step`` is always read. Fields that
+    are not selected are ``None`` in the returned `Snapshot`, and the ``N`` of
+    groups with no selected fields is 0.
+
+    When *cache_size* is non-zero, `read_frame` keeps the most recently read
+    frames and returns the cached `Snapshot` when a frame is read again. The
+    least recently used frames are removed when the numpy arrays of the cached
+    frames exceed *cache_size* bytes. Snapshots in the cache are shared between
+    calls, so their numpy arrays are read-only. Use `cache_info` to size the
+    cache.
     """
 
-    def __init__(self, file):
+    # number of frames to read ahead when frames are read in sequence
+    _prefetch_count = 16
+
+    def __init__(self, file, cache_size=0, fields=None):
         if file.mode == 'ab':
             raise ValueError('Append mode not yet supported')
+        if cache_size < 0:
+            raise ValueError('cache_size must be non-negative')
+        if isinstance(fields, str):
+            raise TypeError('fields must be a list of chunk names')
 
         self._file = file
         self._initial_frame = None
+        self._next_frame = 0
+        self._prefetch_end = 0
+        self._cache = OrderedDict()
+        self._cache_size = int(cache_size)
+        self._cache_nbytes = 0
+        self._cache_hits = 0
+        self._cache_misses = 0
+        self._fields = None
+        if fields is not None:
+            self._fields = frozenset(field.strip('/') for field in fields)
 
         logger.info('opening HOOMDTrajectory: ' + str(self.file))
 
@@ -691,6 +764,55 @@ class HOOMDTrajectory(object):
         """The number of frames in the trajectory."""
         return self.file.nframes
 
+    @property
+    def fields(self):
+        """frozenset[str]: Names of the chunks to read (``None`` for all)."""
+        return self._fields
+
+    def _is_selected(self, name):
+        """Test if a chunk name is in fields or under a path in fields."""
+        if self._fields is None:
+            return True
+
+        path = name
+        while True:
+            if path in self._fields:
+                return True
+            separator = path.rfind('/')
+            if separator == -1:
+                return False
+            path = path[:separator]
+
+    @property
+    def cache_info(self):
+        """CacheInfo: Frame cache statistics."""
+        return CacheInfo(hits=self._cache_hits,
+                         misses=self._cache_misses,
+                         maxsize=self._cache_size,
+                         currsize=self._cache_nbytes)
+
+    def cache_clear(self):
+        """Remove all frames from the frame cache and reset its statistics."""
+        self._cache.clear()
+        self._cache_nbytes = 0
+        self._cache_hits = 0
+        self._cache_misses = 0
+
+    def _cache_insert(self, idx, snap):
+        """Add a frame to the cache and evict the least recently used."""
+        nbytes = sum(array.nbytes for array in _snapshot_arrays(snap))
+        if nbytes > self._cache_size:
+            return
+
+        for array in _snapshot_arrays(snap):
+            array.flags.writeable = False
+
+        self._cache[idx] = (snap, nbytes)
+        self._cache_nbytes += nbytes
+        while self._cache_nbytes > self._cache_size:
+            _, (_, evicted_nbytes) = self._cache.popitem(last=False)
+            self._cache_nbytes -= evicted_nbytes
+
     def append(self, snapshot):
         """Append a snapshot to a hoomd gsd file.
 
@@ -761,11 +883,15 @@ class HOOMDTrajectory(object):
         """Remove all frames from the file."""
         self.file.truncate()
         self._initial_frame = None
+        self._next_frame = 0
+        self._prefetch_end = 0
+        self.cache_clear()
 
     def close(self):
         """Close the file."""
         self.file.close()
         del self._initial_frame
+        self.cache_clear()
 
     def _should_write(self, path, name, snapshot):
         """Test if we should write a given data chunk.
@@ -824,15 +950,54 @@ class HOOMDTrajectory(object):
         from frame 0, or initialize from default values if not in frame 0. Cache
         frame 0 data to avoid file read overhead. Return any default data as
         non-writable numpy arrays.
+
+        When frames are read in sequence, prefetch the following frames with
+        `gsd.fl.GSDFile.prefetch_frames`. When the frame cache is enabled,
+        return the cached `Snapshot` of frames that were read before. Read
+        only the chunks selected by *fields* (see `HOOMDTrajectory`).
         """
         if idx >= len(self):
             raise IndexError
 
-        logger.debug('reading frame ' + str(idx) + ' from: ' + str(self.file))
+        if self._cache_size > 0:
+            cached = self._cache.get(idx)
+            if cached is not None:
+                self._cache.move_to_end(idx)
+                self._cache_hits += 1
+                return cached[0]
+            self._cache_misses += 1
 
         if self._initial_frame is None and idx != 0:
             self.read_frame(0)
 
+        # read ahead while frames are read in sequence so that reads are not
+        # limited by the storage latency
+        if (idx == self._next_frame
+                and idx + self._prefetch_count // 2 >= self._prefetch_end):
+            self.file.prefetch_frames(first=idx, count=self._prefetch_count)
+            self._prefetch_end = idx + self._prefetch_count
+        self._next_frame = idx + 1
+
+        snap = self._read_frame_data(idx)
+
+        # store initial frame
+        if self._initial_frame is None and idx == 0:
+            self._initial_frame = snap
+
+        if self._cache_size > 0:
+            self._cache_insert(idx, snap)
+
+        return snap
+
+    def _read_frame_data(self, idx):
+        """Read a frame from the file into a new `Snapshot`.
+
+        Does not access the frame cache or the read ahead state and only reads
+        ``_initial_frame``, so threads may call it concurrently on a file
+        opened in ``'rb'`` mode once frame 0 is read.
+        """
+        logger.debug('reading frame ' + str(idx) + ' from: ' + str(self.file))
+
         snap = Snapshot()
         # read configuration first
         if self.file.chunk_exists(frame=idx, name='configuration/step'):
@@ -846,27 +1011,36 @@ class HOOMDTrajectory(object):
                 snap.configuration.step = \
                     snap.configuration._default_value['step']
 
-        if self.file.chunk_exists(frame=idx, name='configuration/dimensions'):
-            dimensions_arr = self.file.read_chunk(
-                frame=idx, name='configuration/dimensions')
-            snap.configuration.dimensions = dimensions_arr[0]
-        else:
-            if self._initial_frame is not None:
-                snap.configuration.dimensions = \
-                    self._initial_frame.configuration.dimensions
+        if self._is_selected('configuration/dimensions'):
+            if self.file.chunk_exists(frame=idx,
+                                      name='configuration/dimensions'):
+                dimensions_arr = self.file.read_chunk(
+                    frame=idx, name='configuration/dimensions')
+                snap.configuration.dimensions = dimensions_arr[0]
             else:
-                snap.configuration.dimensions = \
-                    snap.configuration._default_value['dimensions']
+                if self._initial_frame is not None:
+                    snap.configuration.dimensions = \
+                        self._initial_frame.configuration.dimensions
+                else:
+                    snap.configuration.dimensions = \
+                        snap.configuration._default_value['dimensions']
 
-        if self.file.chunk_exists(frame=idx, name='configuration/box'):
-            snap.configuration.box = self.file.read_chunk(
-                frame=idx, name='configuration/box')
-        else:
-            if self._initial_frame is not None:
-                snap.configuration.box = self._initial_frame.configuration.box
+        if self._is_selected('configuration/box'):
+            if self.file.chunk_exists(frame=idx, name='configuration/box'):
+                snap.configuration.box = self.file.read_chunk(
+                    frame=idx, name='configuration/box')
             else:
-                snap.configuration.box = \
-                    snap.configuration._default_value['box']
+                if self._initial_frame is not None:
+                    snap.configuration.box = \
+                        self._initial_frame.configuration.box
+                else:
+                    snap.configuration.box = \
+                        snap.configuration._default_value['box']
+
+        # collect the chunk names of per particle/bond quantities and state
+        # data and read them together
+        read_names = []
+        read_targets = []
 
         # then read all groups that have N, types, etc...
         for path in [
@@ -882,6 +1056,14 @@ class HOOMDTrajectory(object):
             if self._initial_frame is not None:
                 initial_frame_container = getattr(self._initial_frame, path)
 
+            # skip groups that have no selected fields
+            selected = [
+                name for name in container._default_value
+                if name != 'N' and self._is_selected(path + '/' + name)
+            ]
+            if len(selected) == 0 and not self._is_selected(path + '/N'):
+                continue
+
             container.N = 0
             if self.file.chunk_exists(frame=idx, name=path + '/N'):
                 N_arr = self.file.read_chunk(frame=idx, name=path + '/N')
@@ -891,7 +1073,7 @@ class HOOMDTrajectory(object):
                     container.N = initial_frame_container.N
 
             # type names
-            if 'types' in container._default_value:
+            if 'types' in selected:
                 if self.file.chunk_exists(frame=idx, name=path + '/types'):
                     tmp = self.file.read_chunk(frame=idx, name=path + '/types')
                     tmp = tmp.view(dtype=numpy.dtype((bytes, tmp.shape[1])))
@@ -904,8 +1086,7 @@ class HOOMDTrajectory(object):
                         container.types = container._default_value['types']
 
             # type shapes
-            if ('type_shapes' in container._default_value
-                    and path == 'particles'):
+            if 'type_shapes' in selected and path == 'particles':
                 if self.file.chunk_exists(frame=idx,
                                           name=path + '/type_shapes'):
                     tmp = self.file.read_chunk(frame=idx,
@@ -923,14 +1104,14 @@ class HOOMDTrajectory(object):
                         container.type_shapes = \
                             container._default_value['type_shapes']
 
-            for name in container._default_value:
-                if name in ('N', 'types', 'type_shapes'):
+            for name in selected:
+                if name in ('types', 'type_shapes'):
                     continue
 
                 # per particle/bond quantities
                 if self.file.chunk_exists(frame=idx, name=path + '/' + name):
-                    container.__dict__[name] = self.file.read_chunk(
-                        frame=idx, name=path + '/' + name)
+                    read_names.append(path + '/' + name)
+                    read_targets.append((container.__dict__, name))
                 else:
                     if (self._initial_frame is not None
                             and initial_frame_container.N == container.N):
@@ -950,25 +1131,130 @@ class HOOMDTrajectory(object):
 
         # read state data
         for state in snap._valid_state:
+            if not self._is_selected('state/' + state):
+                continue
             if self.file.chunk_exists(frame=idx, name='state/' + state):
-                snap.state[state] = self.file.read_chunk(frame=idx,
-                                                         name='state/' + state)
+                read_names.append('state/' + state)
+                read_targets.append((snap.state, state))
+
+        if len(read_names) > 0:
+            data = self.file.read_chunks(frame=idx, names=read_names)
+            for (target, key), value in zip(read_targets, data):
+                target[key] = value
 
         # read log data
         logged_data_names = self.file.find_matching_chunk_names('log/')
         for log in logged_data_names:
+            if not self._is_selected(log):
+                continue
             if self.file.chunk_exists(frame=idx, name=log):
                 snap.log[log[4:]] = self.file.read_chunk(frame=idx, name=log)
             else:
                 if self._initial_frame is not None:
                     snap.log[log[4:]] = self._initial_frame.log[log[4:]]
 
-        # store initial frame
-        if self._initial_frame is None and idx == 0:
-            self._initial_frame = snap
-
         return snap
 
+    def read_frames(self, indices, workers=None):
+        """Read many frames using a pool of threads.
+
+        Args:
+            indices (iterable[int] or slice): Indices of the frames to read.
+                Negative indices count from the end of the trajectory.
+            workers (int): Number of threads that read frames. ``None`` uses
+                one thread per CPU.
+
+        Yields:
+            `Snapshot` of each frame in the order of *indices*.
+
+        Threads read and decode the following frames while the caller
+        processes the current one. At most ``2 * workers`` frames are read
+        ahead, so memory use does not grow with the number of frames.
+        `gsd.fl.GSDFile` releases the GIL while it reads, so the threads read
+        in parallel. The returned snapshots are the same as those that
+        `read_frame` returns and use the frame cache in the same way.
+
+        Frames are read in the calling thread when the file is not a
+        `gsd.fl.GSDFile` opened in ``'rb'`` mode, as concurrent reads are not
+        safe on other files.
+
+        Example::
+
+            with gsd.hoomd.open('trajectory.gsd') as traj:
+                for snap in traj.read_frames(range(len(traj)), workers=8):
+                    analyze(snap)
+        """
+        if isinstance(indices, slice):
+            indices = range(*indices.indices(len(self)))
+
+        nframes = len(self)
+        frames = []
+        for idx in indices:
+            idx = int(idx)
+            if idx < 0:
+                idx += nframes
+            if idx >= nframes or idx < 0:
+                raise IndexError()
+            frames.append(idx)
+
+        if workers is None:
+            workers = os.cpu_count() or 1
+        if workers < 1:
+            raise ValueError('workers must be positive')
+
+        return self._read_frames(frames, workers)
+
+    def _read_frames(self, frames, workers):
+        """Generate the snapshots of read_frames."""
+        parallel = (fl is not None and isinstance(self.file, fl.GSDFile)
+                    and self.file.mode == 'rb')
+        if not parallel or workers == 1 or len(frames) <= 1:
+            for idx in frames:
+                yield self.read_frame(idx)
+            return
+
+        # the workers share frame 0 to fill in chunks missing in other frames
+        if self._initial_frame is None:
+            self.read_frame(0)
+
+        max_pending = 2 * workers
+        pending = deque()
+        next_frame = 0
+        with concurrent.futures.ThreadPoolExecutor(
+                max_workers=workers) as executor:
+            try:
+                while next_frame < len(frames) or len(pending) > 0:
+                    while (next_frame < len(frames)
+                           and len(pending) < max_pending):
+                        idx = frames[next_frame]
+                        next_frame += 1
+                        cached = None
+                        if self._cache_size > 0:
+                            cached = self._cache.get(idx)
+                        if cached is not None:
+                            # count the hit now, the frame may be evicted before
+                            # it is yielded
+                            self._cache.move_to_end(idx)
+                            self._cache_hits += 1
+                            pending.append((idx, None, cached[0]))
+                        else:
+                            future = executor.submit(self._read_frame_data,
+                                                     idx)
+                            pending.append((idx, future, None))
+
+                    idx, future, snap = pending.popleft()
+                    if future is not None:
+                        snap = future.result()
+                        if self._cache_size > 0:
+                            self._cache_misses += 1
+                            self._cache_insert(idx, snap)
+                    yield snap
+            finally:
+                # stop reading ahead when the caller stops early
+                for _, future, _ in pending:
+                    if future is not None:
+                        future.cancel()
+
     def __getitem__(self, key):
         """Index trajectory frames.
 
@@ -1004,7 +1290,7 @@ class HOOMDTrajectory(object):
         self.file.close()
 
 
-def open(name, mode='rb'):
+def open(name, mode='rb', cache_size=0, fields=None):
     """Open a hoomd schema GSD file.
 
     The return value of `open` can be used as a context manager.
@@ -1012,6 +1298,10 @@ def open(name, mode='rb'):
     Args:
         name (str): File name to open.
         mode (str): File open mode.
+        cache_size (int): Maximum number of bytes of decoded frames that the
+            `HOOMDTrajectory` keeps in memory (0 disables the frame cache).
+        fields (list[str]): Names of the chunks that the `HOOMDTrajectory`
+            reads, or ``None`` to read all chunks.
 
     Returns:
         An `HOOMDTrajectory` instance that accesses the file *name* with the
@@ -1061,4 +1351,4 @@ def open(name, mode='rb'):
                          schema='hoomd',
                          schema_version=[1, 4])
 
-    return HOOMDTrajectory(gsdfileobj)
+    return HOOMDTrajectory(gsdfileobj, cache_size=cache_size, fields=fields)
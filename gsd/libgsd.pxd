@@ -23,6 +23,12 @@ cdef extern from "gsd.h" nogil:
         GSD_OPEN_READONLY
         GSD_OPEN_APPEND
 
+    cdef enum gsd_sync_policy:
+        GSD_SYNC_ALWAYS = 0
+        GSD_SYNC_ON_CLOSE
+        GSD_SYNC_EVERY_N_FRAMES
+        GSD_SYNC_EVERY_N_SECONDS
+
     cdef enum gsd_error:
         GSD_SUCCESS = 0
         GSD_ERROR_IO = -1
@@ -34,6 +40,15 @@ cdef extern from "gsd.h" nogil:
         GSD_ERROR_NAMELIST_FULL = -7
         GSD_ERROR_FILE_MUST_BE_WRITABLE = -8
         GSD_ERROR_FILE_MUST_BE_READABLE = -9
+        GSD_ERROR_UNSUPPORTED_ENCODING = -10
+
+    cdef enum gsd_chunk_flag:
+        GSD_FLAG_CODEC_MASK = 0x07
+        GSD_FLAG_CODEC_ZSTD = 0x01
+        GSD_FLAG_CODEC_DEFLATE = 0x02
+        GSD_FLAG_SHUFFLE = 0x08
+        GSD_FLAG_QUANTIZE = 0x10
+        GSD_FLAG_DELTA = 0x20
 
     cdef struct gsd_header:
         uint64_t magic
@@ -45,7 +60,9 @@ cdef extern from "gsd.h" nogil:
         uint64_t index_allocated_entries
         uint64_t namelist_location
         uint64_t namelist_allocated_entries
-        char reserved[80]
+        uint64_t index_segments_location
+        uint64_t frame_table_location
+        char reserved[64]
 
     cdef struct gsd_index_entry:
         uint64_t frame
@@ -59,12 +76,18 @@ cdef extern from "gsd.h" nogil:
     cdef struct gsd_namelist_entry:
         char name[64]
 
+    cdef struct gsd_index_record:
+        gsd_index_entry entry
+        uint32_t id
+
     cdef struct gsd_index_buffer:
-        gsd_index_entry *data
+        gsd_index_record *data
         size_t size
         size_t reserved
+        const gsd_index_entry *mapped_entries
         void *mapped_data
         size_t mapped_len
+        gsd_index_record **pages
 
     cdef struct gsd_name_id_map:
         void *v
@@ -75,6 +98,30 @@ cdef extern from "gsd.h" nogil:
         size_t size
         size_t reserved
 
+    cdef struct gsd_frame_directory:
+        size_t *data
+        size_t size
+
+    cdef struct gsd_frame_table:
+        uint64_t location
+        size_t n_entries
+        uint64_t n_frames
+
+    cdef struct gsd_stats:
+        uint64_t read_calls
+        uint64_t read_bytes
+        uint64_t write_calls
+        uint64_t write_bytes
+        uint64_t fsync_calls
+        uint64_t fsync_ns
+        uint64_t index_expansions
+        uint64_t write_buffer_flushes
+        uint64_t name_lookups
+        uint64_t name_probes
+        uint64_t name_max_probes
+        uint64_t end_frame_calls
+        uint64_t end_frame_ns
+
     cdef struct gsd_handle:
         int fd
         gsd_header header
@@ -89,6 +136,18 @@ cdef extern from "gsd.h" nogil:
         gsd_open_flag open_flags
         gsd_name_id_map name_map
         uint64_t namelist_written_entries
+        gsd_frame_directory frame_directory
+        int compression_level
+        uint64_t keyframe_interval
+        size_t n_index_segments
+        int chained_index
+        gsd_frame_table frame_table
+        size_t write_buffer_size
+        int direct_io
+        size_t write_map_size
+        gsd_sync_policy sync_policy
+        uint64_t sync_interval
+        gsd_stats stats
 
     uint32_t gsd_make_version(unsigned int major, unsigned int minor)
     int gsd_create(const char *fname,
@@ -105,20 +164,67 @@ cdef extern from "gsd.h" nogil:
     int gsd_open(gsd_handle* handle, const char *fname,
                  const gsd_open_flag flags)
     int gsd_truncate(gsd_handle* handle)
+    int gsd_refresh(gsd_handle* handle)
     int gsd_close(gsd_handle* handle)
     int gsd_end_frame(gsd_handle* handle)
+    int gsd_set_write_behind(gsd_handle* handle, int enable)
+    int gsd_flush(gsd_handle* handle)
+    int gsd_set_compression_level(gsd_handle* handle, int level)
+    int gsd_set_keyframe_interval(gsd_handle* handle, uint64_t interval)
+    int gsd_set_chained_index(gsd_handle* handle, int enable)
+    int gsd_set_write_buffer_size(gsd_handle* handle, size_t size)
+    int gsd_set_direct_io(gsd_handle* handle, int enable)
+    int gsd_set_write_map_size(gsd_handle* handle, size_t size)
+    int gsd_set_sync_policy(gsd_handle* handle,
+                            gsd_sync_policy policy,
+                            uint64_t interval)
+    int gsd_get_stats(gsd_handle* handle, gsd_stats* stats)
+    int gsd_write_frame_table(gsd_handle* handle)
+    bint gsd_is_encoding_available(uint8_t flags)
     int gsd_write_chunk(gsd_handle* handle,
                         const char *name,
                         gsd_type type,
                         uint64_t N,
-                        uint8_t M,
+                        uint32_t M,
                         uint8_t flags,
                         const void *data)
+    int gsd_write_quantized_chunk(gsd_handle* handle,
+                                  const char *name,
+                                  uint64_t N,
+                                  uint32_t M,
+                                  uint8_t flags,
+                                  double precision,
+                                  const float *data)
+    int gsd_write_chunk_by_id(gsd_handle* handle,
+                              uint32_t id,
+                              gsd_type type,
+                              uint64_t N,
+                              uint32_t M,
+                              uint8_t flags,
+                              const void *data)
     const gsd_index_entry* gsd_find_chunk(gsd_handle* handle,
                                           uint64_t frame,
                                           const char *name)
+    int gsd_get_name_id(gsd_handle* handle, const char *name, uint32_t *id,
+                        int append)
+    const gsd_index_entry* gsd_find_chunk_by_id(gsd_handle* handle,
+                                                uint64_t frame,
+                                                uint32_t id)
     int gsd_read_chunk(gsd_handle* handle, void* data,
                        const gsd_index_entry* chunk)
+    int gsd_read_chunk_as(gsd_handle* handle, void* data,
+                          const gsd_index_entry* chunk, gsd_type type)
+    int gsd_read_chunks(gsd_handle* handle, size_t n,
+                        const gsd_index_entry** chunks, void** data)
+    int gsd_read_chunk_series(gsd_handle* handle, const char* name,
+                              uint64_t first, uint64_t last, uint64_t stride,
+                              void* data, size_t size)
+    int gsd_prefetch_frames(gsd_handle* handle, uint64_t first,
+                            uint64_t count)
+    int gsd_map_chunk(gsd_handle* handle, const void** data,
+                      const gsd_index_entry* chunk)
+    int gsd_unmap_chunk(gsd_handle* handle, const void* data,
+                        const gsd_index_entry* chunk)
     uint64_t gsd_get_nframes(gsd_handle* handle)
     size_t gsd_sizeof_type(gsd_type type)
     const char *gsd_find_matching_chunk_name(gsd_handle* handle,
@@ -36,9 +36,15 @@ from __future__ import division
 import logging
 import numpy
 import struct
+import zlib
 from collections import namedtuple
 import sys
 
+try:
+    import zstandard
+except ImportError:
+    zstandard = None
+
 __version__ = "2.4.1"
 
 logger = logging.getLogger('gsd.pygsd')
@@ -48,14 +54,32 @@ gsd_header = namedtuple(
     'magic index_location index_allocated_entries '
     'namelist_location namelist_allocated_entries '
     'schema_version gsd_version application '
-    'schema reserved',
+    'schema index_segments_location frame_table_location reserved',
 )
-gsd_header_struct = struct.Struct('QQQQQII64s64s80s')
+gsd_header_struct = struct.Struct('QQQQQII64s64sQQ64s')
+
+gsd_index_segment_struct = struct.Struct('QQ')
+GSD_INDEX_SEGMENT_TABLE_SIZE = 64
 
 gsd_index_entry = namedtuple('gsd_index_entry',
-                             'frame N location M id type flags')
+                             'frame N location id M type flags')
 gsd_index_entry_struct = struct.Struct('QQqIHBB')
 
+# v3.0 and earlier files swap the widths of id and M
+gsd_index_entry_v2 = namedtuple('gsd_index_entry_v2',
+                                'frame N location M id type flags')
+
+gsd_chunk_header_struct = struct.Struct('Q24s')
+gsd_quantize_parameters_struct = struct.Struct('dqQ')
+gsd_delta_parameters_struct = struct.Struct('Q16x')
+
+GSD_FLAG_CODEC_MASK = 0x07
+GSD_FLAG_CODEC_ZSTD = 0x01
+GSD_FLAG_CODEC_DEFLATE = 0x02
+GSD_FLAG_SHUFFLE = 0x08
+GSD_FLAG_QUANTIZE = 0x10
+GSD_FLAG_DELTA = 0x20
+
 gsd_type_mapping = {
     1: numpy.dtype('uint8'),
     2: numpy.dtype('uint16'),
@@ -130,7 +154,7 @@ class GSDFile(object):
                 and self.__header.gsd_version != (0 << 16 | 3)):
             raise RuntimeError("Unsupported GSD file version: "
                                + str(self.__file))
-        if self.__header.gsd_version >= (3 << 16):
+        if self.__header.gsd_version > (3 << 16 | 1):
             raise RuntimeError("Unsupported GSD file version: "
                                + str(self.__file))
 
@@ -152,29 +176,66 @@ class GSDFile(object):
                 self.__namelist[sname] = c
                 c = c + 1
 
-        # read the index block. Since this is a read-only implementation, only
-        # read in the used entries
-        self.__index = []
-        self.__file.seek(self.__header.index_location, 0)
-        for i in range(self.__header.index_allocated_entries):
-            index_entry_raw = self.__file.read(gsd_index_entry_struct.size)
-            if len(index_entry_raw) != gsd_index_entry_struct.size:
+        # read the index segment table of files with a chained index
+        segments = [(self.__header.index_location,
+                     self.__header.index_allocated_entries)]
+        if (self.__header.gsd_version >= (3 << 16)
+                and self.__header.index_segments_location != 0):
+            self.__file.seek(self.__header.index_segments_location, 0)
+            table_raw = self.__file.read(gsd_index_segment_struct.size
+                                         * GSD_INDEX_SEGMENT_TABLE_SIZE)
+            if len(table_raw) != (gsd_index_segment_struct.size
+                                  * GSD_INDEX_SEGMENT_TABLE_SIZE):
                 raise IOError
 
-            idx = gsd_index_entry._make(
-                gsd_index_entry_struct.unpack(index_entry_raw))
+            segments = []
+            for segment in gsd_index_segment_struct.iter_unpack(table_raw):
+                if segment[0] == 0:
+                    break
+                segments.append(segment)
 
-            # 0 location signifies end of index
-            if idx.location == 0:
-                break
-
-            if not self.__is_entry_valid(idx):
+            if (len(segments) == 0 or segments[0] !=
+                (self.__header.index_location,
+                 self.__header.index_allocated_entries)):
                 raise RuntimeError("Corrupt GSD file: " + str(self.__file))
 
-            if i > 0 and idx.frame < self.__index[i - 1].frame:
-                raise RuntimeError("Corrupt GSD file: " + str(self.__file))
+        self.__index_allocated_entries = sum(n for _, n in segments)
 
-            self.__index.append(idx)
+        entry_type = gsd_index_entry
+        if self.__header.gsd_version < (3 << 16 | 1):
+            entry_type = gsd_index_entry_v2
+
+        # read the index block. Since this is a read-only implementation, only
+        # read in the used entries
+        self.__index = []
+        for location, allocated_entries in segments:
+            self.__file.seek(location, 0)
+            for i in range(allocated_entries):
+                index_entry_raw = self.__file.read(gsd_index_entry_struct.size)
+                if len(index_entry_raw) != gsd_index_entry_struct.size:
+                    raise IOError
+
+                idx = entry_type._make(
+                    gsd_index_entry_struct.unpack(index_entry_raw))
+
+                # 0 location signifies end of index
+                if idx.location == 0:
+                    break
+
+                if not self.__is_entry_valid(idx):
+                    raise RuntimeError("Corrupt GSD file: "
+                                       + str(self.__file))
+
+                if (len(self.__index) > 0
+                        and idx.frame < self.__index[-1].frame):
+                    raise RuntimeError("Corrupt GSD file: "
+                                       + str(self.__file))
+
+                self.__index.append(idx)
+            else:
+                # the segment is full, continue with the next segment
+                continue
+            break
 
         self.__is_open = True
 
@@ -186,13 +247,25 @@ class GSDFile(object):
         if entry.M == 0:
             return False
 
-        if entry.frame >= self.__header.index_allocated_entries:
+        if entry.frame >= self.__index_allocated_entries:
             return False
 
         if entry.id >= len(self.__namelist):
             return False
 
-        if entry.flags != 0:
+        codec = entry.flags & GSD_FLAG_CODEC_MASK
+        if entry.flags & ~(GSD_FLAG_CODEC_MASK | GSD_FLAG_SHUFFLE
+                           | GSD_FLAG_QUANTIZE | GSD_FLAG_DELTA):
+            return False
+
+        if codec not in (0, GSD_FLAG_CODEC_ZSTD, GSD_FLAG_CODEC_DEFLATE):
+            return False
+
+        if (entry.flags & (GSD_FLAG_SHUFFLE | GSD_FLAG_DELTA)) and (
+                codec == 0 or entry.flags & GSD_FLAG_QUANTIZE):
+            return False
+
+        if entry.flags & GSD_FLAG_QUANTIZE and entry.type != 9:
             return False
 
         return True
@@ -232,6 +305,9 @@ class GSDFile(object):
         else:
             return None
 
+        return self.__find_entry(frame, match_id)
+
+    def __find_entry(self, frame, match_id):
         # TODO: optimize for v2.0 files
         # binary search for the first index entry at the requested frame
         L = 0
@@ -341,7 +417,10 @@ class GSDFile(object):
             return numpy.array([], dtype=gsd_type_mapping[chunk.type])
 
         self.__file.seek(chunk.location, 0)
-        data_raw = self.__file.read(size)
+        if chunk.flags != 0:
+            data_raw = self.__read_encoded(chunk, size, name)
+        else:
+            data_raw = self.__file.read(size)
 
         if len(data_raw) != size:
             raise IOError
@@ -354,6 +433,170 @@ class GSDFile(object):
         else:
             return data_npy.reshape([chunk.N, chunk.M])
 
+    def __read_encoded(self, chunk, size, name):
+        """Read and decode an encoded chunk at the current file position."""
+        header_raw = self.__file.read(gsd_chunk_header_struct.size)
+        if len(header_raw) != gsd_chunk_header_struct.size:
+            raise IOError
+        encoded_size, parameters = gsd_chunk_header_struct.unpack(header_raw)
+
+        encoded = self.__file.read(encoded_size)
+        if len(encoded) != encoded_size:
+            raise IOError
+
+        n = chunk.N * chunk.M
+        stage_size = size
+        if chunk.flags & GSD_FLAG_QUANTIZE:
+            step, q_min, bits = gsd_quantize_parameters_struct.unpack(
+                parameters)
+            if bits >= 32:
+                raise RuntimeError("Corrupt chunk: " + name + " in file "
+                                   + str(self.__file))
+            stage_size = (n * bits + 7) // 8
+
+        codec = chunk.flags & GSD_FLAG_CODEC_MASK
+        if codec == 0:
+            data_raw = encoded
+        elif codec == GSD_FLAG_CODEC_DEFLATE:
+            data_raw = zlib.decompress(encoded)
+        elif codec == GSD_FLAG_CODEC_ZSTD and zstandard is not None:
+            data_raw = zstandard.ZstdDecompressor().decompress(
+                encoded, max_output_size=stage_size)
+        else:
+            raise RuntimeError("Unsupported chunk encoding: " + name
+                               + " in file " + str(self.__file))
+
+        if len(data_raw) != stage_size:
+            raise RuntimeError("Corrupt chunk: " + name + " in file "
+                               + str(self.__file))
+
+        if chunk.flags & GSD_FLAG_QUANTIZE:
+            # unpack the little endian bit stream of multiples of step
+            values = numpy.zeros(n, dtype=numpy.int64)
+            if bits > 0:
+                # unpackbits gives the most significant bit of each byte
+                # first, reverse the bits of each byte
+                bytes_bits = numpy.unpackbits(
+                    numpy.frombuffer(data_raw, dtype=numpy.uint8))
+                bit_array = bytes_bits.reshape([-1, 8])[:, ::-1].reshape(
+                    [-1])[:n * bits].reshape([n, bits])
+                values = bit_array.astype(numpy.int64).dot(
+                    numpy.left_shift(1, numpy.arange(bits, dtype=numpy.int64)))
+            data = (values + q_min).astype(numpy.float64) * step
+            return data.astype(numpy.float32).tobytes()
+
+        itemsize = gsd_type_mapping[chunk.type].itemsize
+        if chunk.flags & GSD_FLAG_SHUFFLE and itemsize > 1:
+            planes = numpy.frombuffer(data_raw, dtype=numpy.uint8)
+            data_raw = planes.reshape([itemsize, size // itemsize]).T.tobytes()
+
+        if chunk.flags & GSD_FLAG_DELTA:
+            data_raw = self.__apply_delta(chunk, size, name, parameters,
+                                          data_raw)
+
+        return data_raw
+
+    def __apply_delta(self, chunk, size, name, parameters, delta):
+        """Combine delta encoded data with its keyframe."""
+        keyframe_frame, = gsd_delta_parameters_struct.unpack(parameters)
+        keyframe = None
+        if keyframe_frame < chunk.frame:
+            keyframe = self.__find_entry(keyframe_frame, chunk.id)
+
+        if (keyframe is None or keyframe.type != chunk.type
+                or keyframe.N != chunk.N or keyframe.M != chunk.M
+                or keyframe.flags & GSD_FLAG_DELTA):
+            raise RuntimeError("Corrupt chunk: " + name + " in file "
+                               + str(self.__file))
+
+        self.__file.seek(keyframe.location, 0)
+        if keyframe.flags != 0:
+            keyframe_raw = self.__read_encoded(keyframe, size, name)
+        else:
+            keyframe_raw = self.__file.read(size)
+
+        if len(keyframe_raw) != size:
+            raise IOError
+
+        return numpy.bitwise_xor(numpy.frombuffer(delta, dtype=numpy.uint8),
+                                 numpy.frombuffer(keyframe_raw,
+                                                  dtype=numpy.uint8)).tobytes()
+
+    def read_chunks(self, frame, names):
+        """Read several data chunks from one frame.
+
+        Args:
+            frame (int): Index of the frame to read
+            names (list[str]): Names of the chunks
+
+        Returns:
+            list[`numpy.ndarray`]: Data read from file, in the same order as
+            *names*.
+        """
+        return [self.read_chunk(frame=frame, name=name) for name in names]
+
+    def read_chunk_series(self, name, first=0, last=None, stride=1):
+        """Read one data chunk from a range of frames.
+
+        Args:
+            name (str): Name of the chunk
+            first (int): Index of the first frame to read
+            last (int): Index one past the last frame to read (``None`` reads
+                to the end of the file)
+            stride (int): Read every *stride* frames
+
+        Returns:
+            `numpy.ndarray`: Data read from file. The first dimension indexes
+            the frames ``range(nframes)[first:last:stride]``.
+
+        See `gsd.fl.GSDFile.read_chunk_series`.
+        """
+        if not self.__is_open:
+            raise ValueError("File is not open")
+
+        if stride <= 0:
+            raise ValueError("stride must be positive")
+
+        frames = range(self.nframes)[first:last:stride]
+        if len(frames) == 0:
+            # an empty range takes the type and shape from the nearest frame
+            shape_frame = min(slice(first, last, stride).indices(
+                self.nframes)[0], self.nframes - 1)
+            if shape_frame < 0:
+                raise KeyError("frame 0 / chunk " + name + " not found in: "
+                               + str(self.__file))
+            value = self.read_chunk(frame=shape_frame, name=name)
+            return numpy.empty(shape=(0,) + value.shape, dtype=value.dtype)
+
+        data = [self.read_chunk(frame=frames[0], name=name)]
+        for frame in frames[1:]:
+            if not self.chunk_exists(frame=frame, name=name):
+                raise KeyError("frame " + str(frame) + " / chunk " + name
+                               + " not found in: " + str(self.__file))
+            value = self.read_chunk(frame=frame, name=name)
+            if (value.dtype != data[0].dtype
+                    or value.shape != data[0].shape):
+                raise ValueError("chunk " + name + " does not have the same "
+                                 "type and shape in every frame: "
+                                 + str(self.__file))
+            data.append(value)
+
+        return numpy.stack(data)
+
+    def prefetch_frames(self, first, count):
+        """Prefetch frames from the file.
+
+        Args:
+            first (int): Index of the first frame to prefetch
+            count (int): Number of frames to prefetch
+
+        Provided for compatibility with `gsd.fl.GSDFile.prefetch_frames`.
+        :py:mod:`gsd.pygsd` reads through a Python file object and does not
+        prefetch.
+        """
+        if not self.__is_open:
+            raise ValueError("File is not open")
+
     def find_matching_chunk_names(self, match):
         """Find chunk names in the file that start with the string *match*.
 
@@ -13,6 +13,9 @@ import random
 import pathlib
 import os
 import shutil
+import concurrent.futures
+import ctypes
+import gc
 
 test_path = pathlib.Path(os.path.realpath(__file__)).parent
 
@@ -88,6 +91,1098 @@ def test_dtype(tmp_path, typ):
         numpy.testing.assert_array_equal(data2d, read_data2d)
 
 
+def test_read_chunk_nocopy(tmp_path, open_mode):
+    """Test read-only views of chunk data."""
+    data1d = numpy.arange(10000, dtype=numpy.float32)
+    data2d = numpy.arange(30000, dtype=numpy.int64).reshape([10000, 3])
+    data_zero = numpy.array([], dtype=numpy.uint16)
+
+    with gsd.fl.open(name=tmp_path / 'test_nocopy.gsd',
+                     mode=open_mode.write,
+                     application='test_nocopy',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        for i in range(3):
+            f.write_chunk(name='data1d', data=data1d + i)
+            f.write_chunk(name='data2d', data=data2d + i)
+            f.write_chunk(name='data_zero', data=data_zero)
+            f.end_frame()
+
+    with gsd.fl.open(name=tmp_path / 'test_nocopy.gsd',
+                     mode=open_mode.read,
+                     application='test_nocopy',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        views = []
+        for i in range(3):
+            read_data1d = f.read_chunk(frame=i, name='data1d', copy=False)
+            read_data2d = f.read_chunk(frame=i, name='data2d', copy=False)
+            read_data_zero = f.read_chunk(frame=i, name='data_zero', copy=False)
+
+            assert not read_data1d.flags.writeable
+            assert not read_data2d.flags.writeable
+            assert read_data1d.dtype == data1d.dtype
+            assert read_data2d.dtype == data2d.dtype
+            assert read_data_zero.shape == (0,)
+            numpy.testing.assert_array_equal(read_data1d, data1d + i)
+            numpy.testing.assert_array_equal(read_data2d, data2d + i)
+
+            with pytest.raises(ValueError):
+                read_data1d[0] = 1
+
+            views.append((read_data1d, read_data2d))
+
+    # views remain valid after the file is closed
+    for i, (read_data1d, read_data2d) in enumerate(views):
+        numpy.testing.assert_array_equal(read_data1d, data1d + i)
+        numpy.testing.assert_array_equal(read_data2d, data2d + i)
+
+
+def test_read_chunk_dtype(tmp_path, open_mode):
+    """Test converting chunks to another type as they are read."""
+    data_float = numpy.arange(3000, dtype=numpy.float32).reshape([1000, 3])
+    data_int = numpy.arange(-500, 500, dtype=numpy.int16)
+
+    with gsd.fl.open(name=tmp_path / 'test_read_chunk_dtype.gsd',
+                     mode=open_mode.write,
+                     application='test_read_chunk_dtype',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        f.write_chunk(name='float', data=data_float)
+        f.write_chunk(name='int', data=data_int)
+        f.write_chunk(name='compressed', data=data_int, compression='zstd')
+        f.end_frame()
+
+    with gsd.fl.open(name=tmp_path / 'test_read_chunk_dtype.gsd',
+                     mode=open_mode.read) as f:
+        read_data = f.read_chunk(frame=0, name='float', dtype=numpy.float64)
+        assert read_data.dtype == numpy.float64
+        assert read_data.shape == (1000, 3)
+        numpy.testing.assert_array_equal(read_data, data_float)
+
+        dtypes = [numpy.int32, numpy.int64, numpy.float32, numpy.float64]
+        for name in ['int', 'compressed']:
+            for dtype in dtypes:
+                read_data = f.read_chunk(frame=0, name=name, dtype=dtype)
+                assert read_data.dtype == dtype
+                numpy.testing.assert_array_equal(read_data,
+                                                 data_int.astype(dtype))
+
+            # integer types that do not hold every int16 value
+            for dtype in [numpy.int8, numpy.uint16, numpy.uint64]:
+                with pytest.raises(ValueError):
+                    f.read_chunk(frame=0, name=name, dtype=dtype)
+
+        read_data = f.read_chunk(frame=0, name='int', dtype=numpy.int16)
+        numpy.testing.assert_array_equal(read_data, data_int)
+
+        with pytest.raises(ValueError):
+            f.read_chunk(frame=0, name='float', dtype=numpy.int32)
+        with pytest.raises(ValueError):
+            f.read_chunk(frame=0, name='int', dtype=numpy.int32, copy=False)
+        with pytest.raises(ValueError):
+            f.read_chunk(frame=0, name='int', dtype=numpy.complex64)
+
+
+def test_read_chunks(tmp_path, open_mode):
+    """Test reading many chunks at once."""
+    data = {
+        'uint8': numpy.arange(100, dtype=numpy.uint8),
+        'int32': numpy.arange(300, dtype=numpy.int32).reshape([100, 3]),
+        'float64': numpy.linspace(0, 1, 1000, dtype=numpy.float64),
+        'zero': numpy.array([], dtype=numpy.uint16),
+        'large': numpy.arange(3000000, dtype=numpy.float32),
+    }
+
+    with gsd.fl.open(name=tmp_path / 'test_read_chunks.gsd',
+                     mode=open_mode.write,
+                     application='test_read_chunks',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        for i in range(3):
+            for name, value in data.items():
+                f.write_chunk(name=name, data=value + i)
+            f.end_frame()
+
+    names = ['large', 'uint8', 'zero', 'float64', 'int32', 'uint8']
+
+    with gsd.fl.open(name=tmp_path / 'test_read_chunks.gsd',
+                     mode=open_mode.read,
+                     application='test_read_chunks',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        for i in range(3):
+            result = f.read_chunks(frame=i, names=names)
+            assert len(result) == len(names)
+            for name, value in zip(names, result):
+                assert value.dtype == data[name].dtype
+                assert value.shape == data[name].shape
+                numpy.testing.assert_array_equal(value, data[name] + i)
+
+        assert f.read_chunks(frame=0, names=[]) == []
+
+        with pytest.raises(KeyError):
+            f.read_chunks(frame=0, names=['uint8', 'missing'])
+
+        with pytest.raises(KeyError):
+            f.read_chunks(frame=3, names=['uint8'])
+
+    # test again with pygsd
+    with gsd.pygsd.GSDFile(file=open(str(tmp_path / 'test_read_chunks.gsd'),
+                                     mode='rb')) as f:
+        result = f.read_chunks(frame=1, names=names)
+        for name, value in zip(names, result):
+            numpy.testing.assert_array_equal(value, data[name] + 1)
+
+
+def test_read_chunk_series(tmp_path, open_mode):
+    """Test reading one chunk from many frames."""
+    with gsd.fl.open(name=tmp_path / 'test_read_chunk_series.gsd',
+                     mode=open_mode.write,
+                     application='test_read_chunk_series',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        for i in range(20):
+            f.write_chunk(name='log/value',
+                          data=numpy.array([i], dtype=numpy.float64))
+            f.write_chunk(name='position',
+                          data=numpy.full((10, 3), i, dtype=numpy.float32))
+            if i % 3 != 0:
+                f.write_chunk(name='sparse', data=numpy.array([i]))
+            if i == 5:
+                f.write_chunk(name='shape', data=numpy.arange(2))
+            else:
+                f.write_chunk(name='shape', data=numpy.arange(3))
+            f.end_frame()
+
+    for f in (gsd.fl.open(name=tmp_path / 'test_read_chunk_series.gsd',
+                          mode=open_mode.read),
+              gsd.pygsd.GSDFile(file=open(
+                  str(tmp_path / 'test_read_chunk_series.gsd'), mode='rb'))):
+        with f:
+            series = f.read_chunk_series(name='log/value')
+            assert series.dtype == numpy.float64
+            assert series.shape == (20, 1)
+            numpy.testing.assert_array_equal(series[:, 0], numpy.arange(20))
+
+            series = f.read_chunk_series(name='position',
+                                         first=2,
+                                         last=-3,
+                                         stride=4)
+            assert series.shape == (4, 10, 3)
+            for j, frame in enumerate(range(2, 17, 4)):
+                numpy.testing.assert_array_equal(series[j],
+                                                 numpy.full((10, 3), frame))
+
+            series = f.read_chunk_series(name='sparse', first=1, last=3)
+            numpy.testing.assert_array_equal(series, [[1], [2]])
+
+            with pytest.raises(KeyError):
+                f.read_chunk_series(name='sparse')
+            with pytest.raises(KeyError):
+                f.read_chunk_series(name='missing')
+            with pytest.raises(KeyError, match='frame 3 '):
+                f.read_chunk_series(name='sparse', first=1, last=4)
+            with pytest.raises(ValueError):
+                f.read_chunk_series(name='shape')
+            with pytest.raises(ValueError):
+                f.read_chunk_series(name='log/value', stride=0)
+
+            # empty ranges follow slice semantics
+            series = f.read_chunk_series(name='log/value', first=10, last=5)
+            assert series.dtype == numpy.float64
+            assert series.shape == (0, 1)
+            series = f.read_chunk_series(name='position', first=30)
+            assert series.dtype == numpy.float32
+            assert series.shape == (0, 10, 3)
+
+
+def test_frame_directory(tmp_path, open_mode):
+    """Test finding chunks in frames with different numbers of chunks."""
+    names = ['chunk{}'.format(k) for k in range(7)]
+
+    def n_chunks(frame):
+        # frames 0, 7, 14, ... have no chunks
+        return (frame * 3) % 7
+
+    def write_frames(f, first, last):
+        for i in range(first, last):
+            for k in range(n_chunks(i)):
+                f.write_chunk(name=names[k],
+                              data=numpy.array([i * 10 + k],
+                                               dtype=numpy.int64))
+            f.end_frame()
+
+    def check_frames(f, frames):
+        for i in frames:
+            for k, name in enumerate(names):
+                assert f.chunk_exists(frame=i, name=name) == (k < n_chunks(i))
+                if k < n_chunks(i):
+                    assert f.read_chunk(frame=i, name=name)[0] == i * 10 + k
+
+    with gsd.fl.open(name=tmp_path / 'test_frame_directory.gsd',
+                     mode=open_mode.write,
+                     application='test_frame_directory',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        write_frames(f, 0, 200)
+
+    # the directory locates frames on demand in any order
+    frames = list(range(200))
+    random.Random(5).shuffle(frames)
+    with gsd.fl.open(name=tmp_path / 'test_frame_directory.gsd',
+                     mode=open_mode.read) as f:
+        assert f.nframes == 200
+        check_frames(f, frames)
+        check_frames(f, reversed(range(200)))
+        assert not f.chunk_exists(frame=200, name='chunk0')
+        assert not f.chunk_exists(frame=100000, name='chunk0')
+
+        if open_mode.read == 'rb+':
+            # frames appended after the directory is filled
+            write_frames(f, 200, 300)
+            assert f.nframes == 300
+            check_frames(f, range(190, 300))
+            check_frames(f, frames)
+
+            # truncate empties the directory
+            f.truncate()
+            assert not f.chunk_exists(frame=1, name='chunk0')
+            write_frames(f, 0, 3)
+            assert f.nframes == 3
+            check_frames(f, range(3))
+            assert not f.chunk_exists(frame=3, name='chunk0')
+
+
+def test_frame_table(tmp_path, open_mode):
+    """Test reading files with a frame table."""
+    with gsd.fl.open(name=tmp_path / 'test_frame_table.gsd',
+                     mode=open_mode.write,
+                     application='test_frame_table',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        assert not f.has_frame_table
+        for i in range(100):
+            f.write_chunk(name='a', data=numpy.array([i], dtype=numpy.int64))
+            if i % 3 == 0:
+                f.write_chunk(name='b', data=numpy.array([i],
+                                                         dtype=numpy.int64))
+            f.end_frame()
+        f.write_frame_table()
+        assert f.has_frame_table
+
+    with gsd.fl.open(name=tmp_path / 'test_frame_table.gsd',
+                     mode=open_mode.read) as f:
+        assert f.has_frame_table
+        assert f.nframes == 100
+        for i in reversed(range(100)):
+            assert f.read_chunk(frame=i, name='a')[0] == i
+            assert f.chunk_exists(frame=i, name='b') == (i % 3 == 0)
+
+        if open_mode.read == 'rb':
+            with pytest.raises(RuntimeError):
+                f.write_frame_table()
+
+    # close updates the table after appending frames
+    with gsd.fl.open(name=tmp_path / 'test_frame_table.gsd', mode='ab') as f:
+        assert f.has_frame_table
+        for i in range(100, 1000):
+            f.write_chunk(name='a', data=numpy.array([i], dtype=numpy.int64))
+            f.end_frame()
+
+    with gsd.fl.open(name=tmp_path / 'test_frame_table.gsd',
+                     mode=open_mode.read) as f:
+        assert f.has_frame_table
+        assert f.nframes == 1000
+        for i in range(1000):
+            assert f.read_chunk(frame=i, name='a')[0] == i
+
+    with gsd.pygsd.GSDFile(file=open(str(tmp_path / 'test_frame_table.gsd'),
+                                     mode='rb')) as f:
+        assert f.nframes == 1000
+        assert f.read_chunk(frame=999, name='a')[0] == 999
+        assert f.read_chunk(frame=99, name='b')[0] == 99
+
+
+def test_copy(tmp_path):
+    """Test copying frames to a new file."""
+    with gsd.fl.open(name=tmp_path / 'test_copy.gsd',
+                     mode='wb',
+                     application='test_copy',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        for i in range(20):
+            f.write_chunk(name='a/x', data=numpy.array([i], dtype=numpy.int64))
+            f.write_chunk(name='a/y',
+                          data=numpy.full((4, 3), i, dtype=numpy.float32))
+            if i % 2 == 0:
+                f.write_chunk(name='b', data=numpy.array([i],
+                                                         dtype=numpy.int8))
+            f.end_frame()
+
+    assert gsd.fl.copy(source=tmp_path / 'test_copy.gsd',
+                       destination=tmp_path / 'test_copy_all.gsd') == 20
+
+    with gsd.fl.open(name=tmp_path / 'test_copy_all.gsd', mode='rb') as f:
+        assert f.application == 'test_copy'
+        assert f.schema == 'none'
+        assert f.schema_version == (1, 2)
+        assert f.nframes == 20
+        for i in range(20):
+            assert f.read_chunk(frame=i, name='a/x')[0] == i
+            y = f.read_chunk(frame=i, name='a/y')
+            assert y.shape == (4, 3) and y.dtype == numpy.float32
+            numpy.testing.assert_array_equal(y, i)
+            assert f.chunk_exists(frame=i, name='b') == (i % 2 == 0)
+
+    compression = gsd.fl.codecs[0] if len(gsd.fl.codecs) > 0 else None
+    assert gsd.fl.copy(source=tmp_path / 'test_copy.gsd',
+                       destination=tmp_path / 'test_copy_some.gsd',
+                       frames=slice(1, None, 3),
+                       names=['a/'],
+                       compression=compression) == 7
+
+    with gsd.fl.open(name=tmp_path / 'test_copy_some.gsd', mode='rb') as f:
+        assert f.nframes == 7
+        assert f.find_matching_chunk_names('') == ['a/x', 'a/y']
+        for i in range(7):
+            assert f.read_chunk(frame=i, name='a/x')[0] == 1 + 3 * i
+
+    assert gsd.fl.copy(source=tmp_path / 'test_copy.gsd',
+                       destination=tmp_path / 'test_copy_order.gsd',
+                       frames=[5, 2, 9]) == 3
+
+    with gsd.fl.open(name=tmp_path / 'test_copy_order.gsd', mode='rb') as f:
+        assert [f.read_chunk(frame=i, name='a/x')[0] for i in range(3)
+                ] == [5, 2, 9]
+
+    # frames without the chunk are not stored
+    assert gsd.fl.copy(source=tmp_path / 'test_copy.gsd',
+                       destination=tmp_path / 'test_copy_sparse.gsd',
+                       frames=range(1, 20),
+                       names=['b']) == 9
+
+    with gsd.fl.open(name=tmp_path / 'test_copy_sparse.gsd', mode='rb') as f:
+        assert f.nframes == 9
+        assert [f.read_chunk(frame=i, name='b')[0] for i in range(9)
+                ] == list(range(2, 20, 2))
+
+    with pytest.raises(IndexError):
+        gsd.fl.copy(source=tmp_path / 'test_copy.gsd',
+                    destination=tmp_path / 'test_copy_bad.gsd',
+                    frames=[20])
+
+    with pytest.raises(ValueError):
+        gsd.fl.copy(source=tmp_path / 'test_copy.gsd',
+                    destination=tmp_path / 'test_copy_bad.gsd',
+                    compression='invalid')
+
+
+def test_write_buffer(tmp_path, open_mode):
+    """Test writing with a small write buffer and direct I/O."""
+    sizes = [1, 100, 5000, 4096, 70000, 1 << 20]
+    with gsd.fl.open(name=tmp_path / 'test_write_buffer.gsd',
+                     mode=open_mode.write,
+                     application='test_write_buffer',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        assert f.write_buffer_size == 16 * 1024 * 1024
+        assert not f.direct_io
+        with pytest.raises(ValueError):
+            f.write_buffer_size = 0
+
+        f.write_buffer_size = 4096
+        assert f.write_buffer_size == 4096
+        try:
+            f.direct_io = True
+        except OSError:
+            # the file system does not support direct I/O
+            pass
+
+        for i in range(10):
+            for j, size in enumerate(sizes):
+                f.write_chunk(name=str(j),
+                              data=numpy.arange(size, dtype=numpy.int8) + i)
+            f.end_frame()
+            if i == 5:
+                f.direct_io = False
+                assert not f.direct_io
+
+    with gsd.fl.open(name=tmp_path / 'test_write_buffer.gsd',
+                     mode=open_mode.read) as f:
+        assert f.nframes == 10
+        for i in range(10):
+            for j, size in enumerate(sizes):
+                numpy.testing.assert_array_equal(
+                    f.read_chunk(frame=i, name=str(j)),
+                    numpy.arange(size, dtype=numpy.int8) + i)
+
+
+def test_write_map(tmp_path, open_mode):
+    """Test writing chunks through a mapped write region."""
+    sizes = [1, 100, 5000, 4096, 70000, 1 << 20]
+    with gsd.fl.open(name=tmp_path / 'test_write_map.gsd',
+                     mode=open_mode.write,
+                     application='test_write_map',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        assert f.write_map_size == 0
+        with pytest.raises(ValueError):
+            f.write_map_size = -1
+
+        f.write_map_size = 256 * 1024
+        assert f.write_map_size == 256 * 1024
+
+        for i in range(10):
+            for j, size in enumerate(sizes):
+                f.write_chunk(name=str(j),
+                              data=numpy.arange(size, dtype=numpy.int8) + i)
+            f.end_frame()
+            if i == 5:
+                f.write_map_size = 0
+            if i == 7:
+                f.write_map_size = 4096
+
+    # closing removes the preallocated space
+    nbytes = (tmp_path / 'test_write_map.gsd').stat().st_size
+    with gsd.fl.open(name=tmp_path / 'test_write_map.gsd',
+                     mode=open_mode.read) as f:
+        assert f.nframes == 10
+        for i in range(10):
+            for j, size in enumerate(sizes):
+                numpy.testing.assert_array_equal(
+                    f.read_chunk(frame=i, name=str(j)),
+                    numpy.arange(size, dtype=numpy.int8) + i)
+
+    with gsd.fl.open(name=tmp_path / 'test_write_map.gsd',
+                     mode='ab') as f:
+        f.write_map_size = 1 << 20
+        f.write_chunk(name='0', data=numpy.arange(10, dtype=numpy.int8))
+        f.end_frame()
+    assert (tmp_path / 'test_write_map.gsd').stat().st_size < nbytes + 4096
+
+    with gsd.fl.open(name=tmp_path / 'test_write_map.gsd',
+                     mode=open_mode.read) as f:
+        assert f.nframes == 11
+        numpy.testing.assert_array_equal(f.read_chunk(frame=10, name='0'),
+                                         numpy.arange(10, dtype=numpy.int8))
+
+
+def test_sync_policy(tmp_path, open_mode):
+    """Test writing with deferred syncs."""
+    with gsd.fl.open(name=tmp_path / 'test_sync_policy.gsd',
+                     mode=open_mode.write,
+                     application='test_sync_policy',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        assert f.sync_policy == 'always'
+        with pytest.raises(ValueError):
+            f.set_sync_policy('sometimes')
+        with pytest.raises(ValueError):
+            f.set_sync_policy('frames', 0)
+
+        for i, (policy, interval) in enumerate([('close', 0), ('frames', 3),
+                                                ('seconds', 1),
+                                                ('always', 0)]):
+            f.set_sync_policy(policy, interval)
+            assert f.sync_policy == policy
+            for j in range(5):
+                # new names grow the name list and many chunks grow the index
+                data = numpy.array([i * 5 + j], dtype=numpy.int64)
+                for k in range(100):
+                    f.write_chunk(name='chunk{}_{}'.format(i, k), data=data)
+                f.end_frame()
+
+    with gsd.fl.open(name=tmp_path / 'test_sync_policy.gsd',
+                     mode=open_mode.read) as f:
+        assert f.nframes == 20
+        for i in range(4):
+            for j in range(5):
+                numpy.testing.assert_array_equal(
+                    f.read_chunk(frame=i * 5 + j, name='chunk{}_99'.format(i)),
+                    [i * 5 + j])
+
+
+def test_stats(tmp_path, open_mode):
+    """Test the I/O statistics."""
+    with gsd.fl.open(name=tmp_path / 'test_stats.gsd',
+                     mode=open_mode.write,
+                     application='test_stats',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        stats = f.stats
+        assert stats['write_calls'] == 0
+        assert stats['end_frame_calls'] == 0
+
+        for i in range(10):
+            data = numpy.array([i], dtype=numpy.int64)
+            # many chunks grow the index
+            for k in range(100):
+                f.write_chunk(name='chunk{}'.format(k), data=data)
+            f.end_frame()
+        f.flush()
+
+        stats = f.stats
+        assert stats['write_calls'] > 0
+        assert stats['write_bytes'] >= 10 * 100 * 8
+        assert stats['fsync_calls'] > 0
+        assert stats['fsync_seconds'] >= 0
+        assert stats['index_expansions'] > 0
+        assert stats['write_buffer_flushes'] >= 10
+        assert stats['end_frame_calls'] == 10
+        assert stats['end_frame_seconds'] > 0
+
+    with gsd.fl.open(name=tmp_path / 'test_stats.gsd',
+                     mode=open_mode.read) as f:
+        stats = f.stats
+        read_calls = stats['read_calls']
+        assert read_calls > 0
+        assert stats['write_calls'] == 0
+
+        for i in range(10):
+            numpy.testing.assert_array_equal(
+                f.read_chunk(frame=i, name='chunk99'), [i])
+
+        stats = f.stats
+        assert stats['read_calls'] >= read_calls + 10
+        assert stats['read_bytes'] >= 10 * 8
+        assert stats['name_lookups'] >= 1
+        assert stats['name_probes'] >= stats['name_lookups']
+        assert stats['name_max_probes'] >= 1
+
+    with pytest.raises(ValueError):
+        f.stats
+
+
+def test_prefetch_frames(tmp_path, open_mode):
+    """Test prefetching frames."""
+    with gsd.fl.open(name=tmp_path / 'test_prefetch_frames.gsd',
+                     mode=open_mode.write,
+                     application='test_prefetch_frames',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        for i in range(10):
+            f.write_chunk(name='a', data=numpy.arange(1000) + i)
+            if i % 2 == 0 and 'deflate' in gsd.fl.codecs:
+                f.write_chunk(name='b',
+                              data=numpy.full(100, i, dtype=numpy.int8),
+                              compression='deflate')
+            f.end_frame()
+
+    with gsd.fl.open(name=tmp_path / 'test_prefetch_frames.gsd',
+                     mode=open_mode.read) as f:
+        f.prefetch_frames(first=0, count=4)
+        f.prefetch_frames(first=8, count=100)
+        f.prefetch_frames(first=100, count=1)
+        f.prefetch_frames(first=3, count=0)
+        for i in range(10):
+            numpy.testing.assert_array_equal(f.read_chunk(frame=i, name='a'),
+                                             numpy.arange(1000) + i)
+
+        with pytest.raises(ValueError):
+            f.prefetch_frames(first=-1, count=1)
+
+    with pytest.raises(ValueError):
+        f.prefetch_frames(first=0, count=1)
+
+    with gsd.fl.open(name=tmp_path / 'test_prefetch_frames.gsd',
+                     mode='ab') as f:
+        with pytest.raises(RuntimeError):
+            f.prefetch_frames(first=0, count=1)
+
+    with gsd.pygsd.GSDFile(file=open(
+            str(tmp_path / 'test_prefetch_frames.gsd'), mode='rb')) as f:
+        f.prefetch_frames(first=0, count=4)
+
+
+def test_write_behind(tmp_path, open_mode):
+    """Test writing with a background thread."""
+    data_small = numpy.arange(100, dtype=numpy.int32)
+    data_large = numpy.arange(3000000, dtype=numpy.float64)
+
+    with gsd.fl.open(name=tmp_path / 'test_write_behind.gsd',
+                     mode=open_mode.write,
+                     application='test_write_behind',
+                     schema='none',
+                     schema_version=[1, 2],
+                     write_behind=True) as f:
+        for i in range(20):
+            f.write_chunk(name='small', data=data_small + i)
+            f.write_chunk(name='large', data=data_large + i)
+            f.end_frame()
+
+            if i == 10:
+                f.flush()
+
+    with gsd.fl.open(name=tmp_path / 'test_write_behind.gsd',
+                     mode=open_mode.read) as f:
+        assert f.nframes == 20
+        for i in range(20):
+            numpy.testing.assert_array_equal(
+                f.read_chunk(frame=i, name='small'), data_small + i)
+            numpy.testing.assert_array_equal(
+                f.read_chunk(frame=i, name='large'), data_large + i)
+
+        f.flush()
+
+    with pytest.raises(ValueError):
+        gsd.fl.open(name=tmp_path / 'test_write_behind.gsd',
+                    mode='rb',
+                    write_behind=True)
+
+
+@pytest.mark.parametrize('compression', ['zstd', 'deflate'])
+def test_compression(tmp_path, open_mode, compression):
+    """Test reading and writing compressed chunks."""
+    if compression not in gsd.fl.codecs:
+        pytest.skip(compression + ' is not available')
+
+    data_float = numpy.tile(numpy.arange(1000, dtype=numpy.float32),
+                            300).reshape([100000, 3])
+    data_int = numpy.arange(100000, dtype=numpy.int64) % 7
+    data_random = numpy.random.RandomState(1).randint(0,
+                                                      256,
+                                                      size=10000,
+                                                      dtype=numpy.uint8)
+
+    with gsd.fl.open(name=tmp_path / 'test_compression.gsd',
+                     mode=open_mode.write,
+                     application='test_compression',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        f.compression_level = 5
+        assert f.compression_level == 5
+        for i in range(3):
+            f.write_chunk(name='float',
+                          data=data_float + i,
+                          compression=compression)
+            f.write_chunk(name='int', data=data_int, compression=compression)
+            f.write_chunk(name='random',
+                          data=data_random,
+                          compression=compression)
+            f.write_chunk(name='raw', data=data_int)
+            f.end_frame()
+
+        with pytest.raises(ValueError):
+            f.write_chunk(name='float', data=data_float, compression='lzma')
+
+    assert os.path.getsize(tmp_path / 'test_compression.gsd') \
+        < 3 * (data_float.nbytes + 2 * data_int.nbytes)
+
+    with gsd.fl.open(name=tmp_path / 'test_compression.gsd',
+                     mode=open_mode.read) as f:
+        for i in range(3):
+            numpy.testing.assert_array_equal(
+                f.read_chunk(frame=i, name='float'), data_float + i)
+            numpy.testing.assert_array_equal(
+                f.read_chunk(frame=i, name='float', copy=False),
+                data_float + i)
+            float_, int_, random_, raw = f.read_chunks(
+                frame=i, names=['float', 'int', 'random', 'raw'])
+            numpy.testing.assert_array_equal(float_, data_float + i)
+            numpy.testing.assert_array_equal(int_, data_int)
+            numpy.testing.assert_array_equal(random_, data_random)
+            numpy.testing.assert_array_equal(raw, data_int)
+
+    if compression == 'deflate' or gsd.pygsd.zstandard is not None:
+        with open(tmp_path / 'test_compression.gsd', 'rb') as file, \
+                gsd.pygsd.GSDFile(file) as f:
+            for i in range(3):
+                numpy.testing.assert_array_equal(
+                    f.read_chunk(frame=i, name='float'), data_float + i)
+                numpy.testing.assert_array_equal(
+                    f.read_chunk(frame=i, name='random'), data_random)
+
+
+@pytest.mark.parametrize('compression', [None, 'zstd', 'deflate'])
+def test_quantize(tmp_path, open_mode, compression):
+    """Test reading and writing quantized chunks."""
+    if compression is not None and compression not in gsd.fl.codecs:
+        pytest.skip(compression + ' is not available')
+
+    position = numpy.random.RandomState(2).uniform(-25, 25, size=(10000, 3))
+    position = position.astype(numpy.float32)
+    precision = 1e-3
+
+    with gsd.fl.open(name=tmp_path / 'test_quantize.gsd',
+                     mode=open_mode.write,
+                     application='test_quantize',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        f.write_chunk(name='position',
+                      data=position,
+                      compression=compression,
+                      precision=precision)
+        f.write_chunk(name='raw', data=position)
+        f.write_chunk(name='nan',
+                      data=numpy.array([1, numpy.nan], dtype=numpy.float32),
+                      precision=precision)
+        with pytest.raises(ValueError):
+            f.write_chunk(name='double',
+                          data=position.astype(numpy.float64),
+                          precision=precision)
+        with pytest.raises(ValueError):
+            f.write_chunk(name='zero', data=position, precision=0)
+        f.end_frame()
+
+    with gsd.fl.open(name=tmp_path / 'test_quantize.gsd',
+                     mode=open_mode.read) as f:
+        data = f.read_chunk(frame=0, name='position')
+        assert data.dtype == numpy.float32
+        assert data.shape == position.shape
+        numpy.testing.assert_allclose(data,
+                                      position,
+                                      rtol=0,
+                                      atol=precision * 1.001)
+        numpy.testing.assert_array_equal(f.read_chunk(frame=0, name='raw'),
+                                         position)
+        nan = f.read_chunk(frame=0, name='nan')
+        assert nan[0] == 1 and numpy.isnan(nan[1])
+
+    if compression != 'zstd' or gsd.pygsd.zstandard is not None:
+        with open(tmp_path / 'test_quantize.gsd', 'rb') as file, \
+                gsd.pygsd.GSDFile(file) as f:
+            numpy.testing.assert_array_equal(
+                f.read_chunk(frame=0, name='position'), data)
+
+
+@pytest.mark.parametrize('compression', ['zstd', 'deflate'])
+def test_delta(tmp_path, open_mode, compression):
+    """Test reading and writing delta encoded chunks."""
+    if compression not in gsd.fl.codecs:
+        pytest.skip(compression + ' is not available')
+
+    rng = numpy.random.RandomState(3)
+    image = numpy.zeros((10000, 3), dtype=numpy.int32)
+    expected = []
+
+    with gsd.fl.open(name=tmp_path / 'test_delta.gsd',
+                     mode=open_mode.write,
+                     application='test_delta',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        f.keyframe_interval = 4
+        assert f.keyframe_interval == 4
+
+        with pytest.raises(ValueError):
+            f.write_chunk(name='image', data=image, delta=True)
+        with pytest.raises(ValueError):
+            f.keyframe_interval = 0
+
+        for i in range(10):
+            image[rng.randint(0, image.shape[0], size=10),
+                  rng.randint(0, 3, size=10)] += 1
+            # change the shape to force a new keyframe
+            data = image[:5000] if i == 6 else image
+            expected.append(data.copy())
+            f.write_chunk(name='image',
+                          data=data,
+                          compression=compression,
+                          delta=True)
+            f.end_frame()
+
+    with gsd.fl.open(name=tmp_path / 'test_delta.gsd',
+                     mode=open_mode.read) as f:
+        for i in reversed(range(10)):
+            numpy.testing.assert_array_equal(
+                f.read_chunk(frame=i, name='image'), expected[i])
+        data, = f.read_chunks(frame=3, names=['image'])
+        numpy.testing.assert_array_equal(data, expected[3])
+
+    if compression == 'deflate' or gsd.pygsd.zstandard is not None:
+        with open(tmp_path / 'test_delta.gsd', 'rb') as file, \
+                gsd.pygsd.GSDFile(file) as f:
+            for i in range(10):
+                numpy.testing.assert_array_equal(
+                    f.read_chunk(frame=i, name='image'), expected[i])
+
+
+def test_chained_index(tmp_path, open_mode):
+    """Test growing the index by appending segments."""
+    with gsd.fl.open(name=tmp_path / 'test_chained.gsd',
+                     mode=open_mode.write,
+                     application='test_chained',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        assert not f.chained_index
+        f.chained_index = True
+        assert f.chained_index
+
+        for i in range(1000):
+            f.write_chunk(name='a', data=numpy.array([i], dtype=numpy.int64))
+            if i % 3 == 0:
+                f.write_chunk(name='b', data=numpy.array([i],
+                                                         dtype=numpy.int64))
+            f.end_frame()
+
+        assert f.gsd_version == (3, 0)
+
+    with gsd.fl.open(name=tmp_path / 'test_chained.gsd', mode='ab') as f:
+        assert f.chained_index
+        for i in range(1000, 2000):
+            f.write_chunk(name='a', data=numpy.array([i], dtype=numpy.int64))
+            f.end_frame()
+
+    with gsd.fl.open(name=tmp_path / 'test_chained.gsd',
+                     mode=open_mode.read) as f:
+        assert f.nframes == 2000
+        for i in range(2000):
+            assert f.read_chunk(frame=i, name='a')[0] == i
+            assert f.chunk_exists(frame=i, name='b') == (i < 1000
+                                                          and i % 3 == 0)
+
+    with gsd.pygsd.GSDFile(file=open(str(tmp_path / 'test_chained.gsd'),
+                                     mode='rb')) as f:
+        assert f.gsd_version == (3, 0)
+        assert f.nframes == 2000
+        assert f.read_chunk(frame=1999, name='a')[0] == 1999
+        assert f.read_chunk(frame=999, name='b')[0] == 999
+
+
+class _Allocator(ctypes.Structure):
+    _fields_ = [
+        ('allocate',
+         ctypes.CFUNCTYPE(ctypes.c_void_p, ctypes.c_size_t, ctypes.c_void_p)),
+        ('allocate_zeroed',
+         ctypes.CFUNCTYPE(ctypes.c_void_p, ctypes.c_size_t, ctypes.c_size_t,
+                          ctypes.c_void_p)),
+        ('reallocate',
+         ctypes.CFUNCTYPE(ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t,
+                          ctypes.c_void_p)),
+        ('deallocate',
+         ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.c_void_p)),
+        ('context', ctypes.c_void_p),
+    ]
+
+
+# allocators stay referenced so that memory freed after a failed test does not
+# call a released callback
+_allocators = []
+
+
+@pytest.mark.skipif(platform.system() == 'Windows',
+                    reason='the C API is not exported on Windows')
+def test_allocator(tmp_path):
+    """Test that GSD allocates memory with the allocator of gsd_set_allocator.
+
+    Every allocation (handle state, index pages, the write-behind queue, and
+    codec buffers) must be freed through the allocator that made it, and the
+    allocator cannot change while memory from it is in use.
+    """
+    lib = ctypes.CDLL(gsd.fl.__file__)
+    lib.gsd_set_allocator.argtypes = [ctypes.POINTER(_Allocator)]
+    libc = ctypes.CDLL(None)
+    libc.malloc.restype = ctypes.c_void_p
+    libc.malloc.argtypes = [ctypes.c_size_t]
+    libc.calloc.restype = ctypes.c_void_p
+    libc.calloc.argtypes = [ctypes.c_size_t, ctypes.c_size_t]
+    libc.realloc.restype = ctypes.c_void_p
+    libc.realloc.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+    libc.free.argtypes = [ctypes.c_void_p]
+
+    live = set()
+    unknown = []
+    counts = {'allocate': 0}
+
+    def track(ptr):
+        if ptr:
+            live.add(ptr)
+            counts['allocate'] += 1
+        return ptr
+
+    def untrack(ptr):
+        if ptr in live:
+            live.remove(ptr)
+        else:
+            unknown.append(ptr)
+
+    def allocate(size, context):
+        return track(libc.malloc(size))
+
+    def allocate_zeroed(count, size, context):
+        return track(libc.calloc(count, size))
+
+    def reallocate(ptr, size, context):
+        if ptr:
+            untrack(ptr)
+        return track(libc.realloc(ptr, size))
+
+    def deallocate(ptr, context):
+        untrack(ptr)
+        libc.free(ptr)
+
+    types = dict(_Allocator._fields_)
+    allocator = _Allocator(types['allocate'](allocate),
+                           types['allocate_zeroed'](allocate_zeroed),
+                           types['reallocate'](reallocate),
+                           types['deallocate'](deallocate),
+                           None)
+    _allocators.append(allocator)
+
+    gc.collect()
+    assert lib.gsd_set_allocator(ctypes.byref(allocator)) == 0
+
+    data = numpy.tile(numpy.arange(10, dtype=numpy.float64), 10000)
+    compression = gsd.fl.codecs[0] if len(gsd.fl.codecs) > 0 else None
+    try:
+        with gsd.fl.open(name=tmp_path / 'test_allocator.gsd',
+                         mode='wb',
+                         application='test_allocator',
+                         schema='none',
+                         schema_version=[1, 2],
+                         write_behind=True) as f:
+            assert lib.gsd_set_allocator(None) != 0
+            f.chained_index = True
+            for i in range(1100):
+                f.write_chunk(name='a',
+                              data=numpy.array([i], dtype=numpy.int64))
+                if i % 100 == 0:
+                    f.write_chunk(name='data',
+                                  data=data + i,
+                                  compression=compression)
+                f.end_frame()
+
+        assert len(live) == 0
+        assert unknown == []
+        n_written = counts['allocate']
+        assert n_written > 0
+
+        with gsd.fl.open(name=tmp_path / 'test_allocator.gsd',
+                         mode='rb') as f:
+            assert f.nframes == 1100
+            for i in range(0, 1100, 50):
+                assert f.read_chunk(frame=i, name='a')[0] == i
+            numpy.testing.assert_array_equal(
+                f.read_chunk(frame=1000, name='data'), data + 1000)
+            view = f.read_chunk(frame=1000, name='a', copy=False)
+
+        # the mapped chunk holds memory until it is released
+        assert lib.gsd_set_allocator(None) != 0
+        assert view[0] == 1000
+        del view
+
+        assert len(live) == 0
+        assert unknown == []
+        assert counts['allocate'] > n_written
+    finally:
+        gc.collect()
+        assert lib.gsd_set_allocator(None) == 0
+
+
+def test_name_ids(tmp_path):
+    """Test that cached name ids remain valid across frames and truncate."""
+    with gsd.fl.open(name=tmp_path / 'test_name_ids.gsd',
+                     mode='wb+',
+                     application='test_name_ids',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        assert not f.chunk_exists(frame=0, name='missing')
+        for i in range(3):
+            f.write_chunk(name='a', data=numpy.array([i], dtype=numpy.int64))
+            if i != 1:
+                f.write_chunk(name='b', data=numpy.array([i], dtype=numpy.int8))
+            f.end_frame()
+
+        assert f.read_chunk(frame=2, name='a')[0] == 2
+        assert not f.chunk_exists(frame=1, name='b')
+        assert f.chunk_exists(frame=2, name='b')
+
+        f.truncate()
+        f.write_chunk(name='b', data=numpy.array([5], dtype=numpy.int8))
+        f.end_frame()
+        assert f.read_chunk(frame=0, name='b')[0] == 5
+        assert not f.chunk_exists(frame=0, name='a')
+
+    with gsd.fl.open(name=tmp_path / 'test_name_ids.gsd', mode='rb') as f:
+        assert f.find_matching_chunk_names('') == ['b']
+        assert f.read_chunk(frame=0, name='b')[0] == 5
+        assert not f.chunk_exists(frame=0, name='missing')
+        with pytest.raises(KeyError):
+            f.read_chunk(frame=0, name='missing')
+
+
+def test_wide_name_ids(tmp_path):
+    """Test files with more names than fit in 16-bit ids."""
+    n_names = 70000
+    with gsd.fl.open(name=tmp_path / 'test_wide_name_ids.gsd',
+                     mode='wb',
+                     application='test_wide_name_ids',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        for i in range(n_names):
+            if i == 65535:
+                assert f.gsd_version == (2, 0)
+            f.write_chunk(name=str(i), data=numpy.array([i], dtype=numpy.int32))
+        f.end_frame()
+        assert f.gsd_version == (3, 1)
+
+        with pytest.raises(RuntimeError):
+            f.write_chunk(name='wide',
+                          data=numpy.zeros((1, 65536), dtype=numpy.int8))
+
+    with gsd.fl.open(name=tmp_path / 'test_wide_name_ids.gsd',
+                     mode='rb') as f:
+        assert f.gsd_version == (3, 1)
+        for i in (0, 65534, 65535, 65536, n_names - 1):
+            assert f.read_chunk(frame=0, name=str(i))[0] == i
+
+    with gsd.pygsd.GSDFile(file=open(
+            str(tmp_path / 'test_wide_name_ids.gsd'), mode='rb')) as f:
+        for i in (0, 65535, n_names - 1):
+            assert f.read_chunk(frame=0, name=str(i))[0] == i
+
+
+def test_wide_chunk(tmp_path):
+    """Test chunks with more columns than fit in a version 3.1 index."""
+    data = numpy.arange(140000) % 256
+    data = data.astype(numpy.uint8).reshape([2, 70000])
+    with gsd.fl.open(name=tmp_path / 'test_wide_chunk.gsd',
+                     mode='wb',
+                     application='test_wide_chunk',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        f.write_chunk(name='wide', data=data)
+        f.end_frame()
+
+    with gsd.fl.open(name=tmp_path / 'test_wide_chunk.gsd', mode='rb') as f:
+        assert f.gsd_version == (2, 0)
+        numpy.testing.assert_array_equal(f.read_chunk(frame=0, name='wide'),
+                                         data)
+
+    with gsd.pygsd.GSDFile(
+            file=open(str(tmp_path / 'test_wide_chunk.gsd'), mode='rb')) as f:
+        numpy.testing.assert_array_equal(f.read_chunk(frame=0, name='wide'),
+                                         data)
+
+
+def test_concurrent_read(tmp_path):
+    """Test reading from one file with many threads."""
+    n_frames = 200
+    with gsd.fl.open(name=tmp_path / 'test_concurrent_read.gsd',
+                     mode='wb',
+                     application='test_concurrent_read',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        for i in range(n_frames):
+            f.write_chunk(name='a',
+                          data=numpy.full(1000, i, dtype=numpy.int64))
+            f.write_chunk(name='b', data=numpy.array([i], dtype=numpy.int32))
+            f.end_frame()
+
+    def read(f, frame):
+        a = f.read_chunk(frame=frame, name='a')
+        b, = f.read_chunks(frame=frame, names=['b'])
+        return (numpy.all(a == frame) and b[0] == frame
+                and f.chunk_exists(frame=frame, name='a'))
+
+    with gsd.fl.open(name=tmp_path / 'test_concurrent_read.gsd',
+                     mode='rb') as f:
+        frames = list(range(n_frames)) * 4
+        random.shuffle(frames)
+        with concurrent.futures.ThreadPoolExecutor(max_workers=8) as pool:
+            assert all(pool.map(lambda frame: read(f, frame), frames))
+
+
 def test_metadata(tmp_path, open_mode):
     """Test file metadata."""
     data = numpy.array([1, 2, 3, 4, 5, 10012], dtype=numpy.int64)
@@ -396,6 +1491,146 @@ def test_truncate(tmp_path):
         assert f.nframes == 1
 
 
+def test_truncate_mapped_chunk(tmp_path):
+    """Test that truncate refuses to run while chunks are mapped."""
+    data = numpy.arange(100000, dtype=numpy.float64)
+    with gsd.fl.open(name=tmp_path / 'test_truncate_mapped_chunk.gsd',
+                     mode='wb+',
+                     application='test_truncate_mapped_chunk',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        for i in range(3):
+            f.write_chunk(name='data', data=data + i)
+            f.end_frame()
+
+        view = f.read_chunk(frame=2, name='data', copy=False)
+        if platform.system() != "Windows":
+            # the view points into the file
+            with pytest.raises(RuntimeError):
+                f.truncate()
+            assert f.nframes == 3
+            numpy.testing.assert_array_equal(view, data + 2)
+
+        del view
+        f.truncate()
+        assert f.nframes == 0
+
+        f.write_chunk(name='data', data=data[:10])
+        f.end_frame()
+        view = f.read_chunk(frame=0, name='data', copy=False)
+        numpy.testing.assert_array_equal(view, data[:10])
+
+
+@pytest.mark.parametrize('chained', [False, True])
+def test_refresh(tmp_path, chained):
+    """Test that refresh loads frames added by another file object."""
+    writer = gsd.fl.open(name=tmp_path / 'test_refresh.gsd',
+                         mode='wb',
+                         application='test_refresh',
+                         schema='none',
+                         schema_version=[1, 2])
+    writer.chained_index = chained
+    with pytest.raises(RuntimeError):
+        writer.refresh()
+
+    def write_frames(first, last):
+        for i in range(first, last):
+            # new names in some frames and many chunks grow the index
+            for k in range(i % 50):
+                writer.write_chunk(name='chunk{}'.format(k),
+                                   data=numpy.array([i * 100 + k]))
+            writer.end_frame()
+
+    write_frames(0, 3)
+    with gsd.fl.open(name=tmp_path / 'test_refresh.gsd', mode='rb') as f:
+        assert f.nframes == 3
+        f.refresh()
+        assert f.nframes == 3
+        assert not f.chunk_exists(frame=2, name='chunk2')
+
+        for last in [4, 10, 200]:
+            write_frames(f.nframes, last)
+            f.refresh()
+            assert f.nframes == last
+            for i in range(last):
+                for k in range(50):
+                    exists = f.chunk_exists(frame=i, name='chunk{}'.format(k))
+                    assert exists == (k < i % 50)
+                if i % 50 > 0:
+                    numpy.testing.assert_array_equal(
+                        f.read_chunk(frame=i,
+                                     name='chunk{}'.format(i % 50 - 1)),
+                        [i * 100 + i % 50 - 1])
+
+        # the reader loads the file again after it is truncated
+        writer.truncate()
+        writer.write_chunk(name='other', data=numpy.array([1]))
+        writer.end_frame()
+        writer.close()
+        f.refresh()
+        assert f.nframes == 1
+        assert f.chunk_exists(frame=0, name='other')
+        assert not f.chunk_exists(frame=0, name='chunk0')
+
+    with pytest.raises(ValueError):
+        f.refresh()
+
+
+@pytest.mark.parametrize('mode', ['rb', 'rb+'])
+def test_index_pages(tmp_path, mode):
+    """Test reading and refreshing a chained index across page boundaries."""
+    names = ['a', 'b', 'c']
+
+    def write_frames(f, first, last):
+        for i in range(first, last):
+            for k, name in enumerate(names):
+                f.write_chunk(name=name, data=numpy.array([i * 10 + k]))
+            f.end_frame()
+
+    def check_frames(f, frames):
+        for i in frames:
+            for k, name in enumerate(names):
+                numpy.testing.assert_array_equal(
+                    f.read_chunk(frame=i, name=name), [i * 10 + k])
+
+    # a chained index is read in pages of 1024 entries, 3 entries per frame
+    # place frames across the page boundaries
+    with gsd.fl.open(name=tmp_path / 'test_index_pages.gsd',
+                     mode='wb',
+                     application='test_index_pages',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        f.chained_index = True
+        write_frames(f, 0, 1500)
+
+    boundaries = [0, 340, 341, 342, 682, 683, 1023, 1024, 1365, 1366, 1499]
+    with gsd.fl.open(name=tmp_path / 'test_index_pages.gsd', mode=mode) as f:
+        assert f.nframes == 1500
+        check_frames(f, boundaries)
+        check_frames(f, range(0, 1500, 7))
+
+        if mode == 'rb+':
+            # entries added to loaded pages and to pages not yet read
+            write_frames(f, 1500, 2100)
+            assert f.nframes == 2100
+            check_frames(f, range(1495, 2100))
+
+    with gsd.fl.open(name=tmp_path / 'test_index_pages.gsd', mode='rb') as f:
+        nframes = f.nframes
+        with gsd.fl.open(name=tmp_path / 'test_index_pages.gsd',
+                         mode='ab') as writer:
+            # refresh with the last known entry in the middle of a page and at
+            # its end
+            for last in [nframes + 1, nframes + 300, nframes + 1025, 5000]:
+                write_frames(writer, f.nframes, last)
+                writer.flush()
+                f.refresh()
+                assert f.nframes == last
+                check_frames(f, range(max(0, f.nframes - 400), f.nframes))
+
+        check_frames(f, range(0, 5000, 11))
+
+
 def test_namelen(tmp_path, open_mode):
     """Test that long names are truncated as documented."""
     app_long = 'abcdefga' * 100
@@ -610,6 +1845,101 @@ def test_many_names(tmp_path, open_mode):
                 numpy.testing.assert_array_equal(data, data_read)
 
 
+def test_frame_sort(tmp_path, open_mode):
+    """Test finding chunks that are written out of order in a frame."""
+    # ids of 300 names span two bytes of the radix sort
+    names = ['chunk{}'.format(i) for i in range(300)]
+    shuffled = list(range(300))
+    random.Random(11).shuffle(shuffled)
+    almost_sorted = list(range(300))
+    almost_sorted[298], almost_sorted[299] = 299, 298
+    high = [i for i in shuffled if i >= 256]
+    frames = [
+        list(range(300)),
+        list(reversed(range(300))),
+        shuffled,
+        almost_sorted,
+        high,
+        [7],
+    ]
+
+    with gsd.fl.open(name=tmp_path / 'test_frame_sort.gsd',
+                     mode=open_mode.write,
+                     application='test_frame_sort',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        for frame, order in enumerate(frames):
+            for i in order:
+                f.write_chunk(name=names[i],
+                              data=numpy.array([frame * 1000 + i],
+                                               dtype=numpy.int32))
+            f.end_frame()
+
+    with gsd.fl.open(name=tmp_path / 'test_frame_sort.gsd',
+                     mode=open_mode.read) as f:
+        for frame, order in enumerate(frames):
+            written = set(order)
+            for i, name in enumerate(names):
+                assert f.chunk_exists(frame=frame, name=name) == (i in written)
+                if i in written:
+                    assert f.read_chunk(frame=frame,
+                                        name=name)[0] == frame * 1000 + i
+
+    with gsd.pygsd.GSDFile(file=open(str(tmp_path / 'test_frame_sort.gsd'),
+                                     mode='rb')) as f:
+        for frame, order in enumerate(frames):
+            for i in order:
+                assert f.read_chunk(frame=frame,
+                                    name=names[i])[0] == frame * 1000 + i
+
+
+def test_name_map(tmp_path, open_mode):
+    """Test looking up chunk names while the name map grows."""
+    # names with shared prefixes and many lengths, and enough names to grow
+    # the map several times
+    names = (['n' * length for length in range(1, 101)]
+             + ['log/{}'.format(i) for i in range(3000)])
+    missing = ['n' * 101, 'log/', 'log/3000', 'new/0']
+
+    with gsd.fl.open(name=tmp_path / 'test_name_map.gsd',
+                     mode=open_mode.write,
+                     application='test_name_map',
+                     schema='none',
+                     schema_version=[1, 2]) as f:
+        for i, name in enumerate(names):
+            f.write_chunk(name=name, data=numpy.array([i], dtype=numpy.int32))
+        f.end_frame()
+
+        # existing names keep their ids in later frames
+        for i in reversed(range(0, len(names), 3)):
+            f.write_chunk(name=names[i],
+                          data=numpy.array([-i], dtype=numpy.int32))
+        f.end_frame()
+
+    with gsd.fl.open(name=tmp_path / 'test_name_map.gsd',
+                     mode=open_mode.read) as f:
+        for i, name in enumerate(names):
+            assert f.read_chunk(frame=0, name=name)[0] == i
+            assert f.chunk_exists(frame=1, name=name) == (i % 3 == 0)
+        for name in missing:
+            assert not f.chunk_exists(frame=0, name=name)
+
+        if open_mode.read == 'rb+':
+            # names added to the map loaded from the file
+            for i, name in enumerate(names[::10] + ['new/0', 'new/1']):
+                f.write_chunk(name=name, data=numpy.array([i],
+                                                          dtype=numpy.int32))
+            f.end_frame()
+            assert f.read_chunk(frame=2, name='new/1')[0] == 311
+            assert f.read_chunk(frame=2, name='log/2990')[0] == 309
+            assert not f.chunk_exists(frame=2, name='log/1')
+
+    with gsd.pygsd.GSDFile(file=open(str(tmp_path / 'test_name_map.gsd'),
+                                     mode='rb')) as f:
+        assert f.read_chunk(frame=0, name='n' * 100)[0] == 99
+        assert f.read_chunk(frame=1, name='log/2999')[0] == -3099
+
+
 def test_gsd_v1_read():
     """Test that the GSD v2 API can read v1 files."""
     values = list(range(127))
@@ -645,6 +645,217 @@ def test_view_slicing_and_iteration(tmp_path, open_mode):
                     - 1].configuration.step == view[-1].configuration.step
 
 
+def test_frame_cache(tmp_path, open_mode):
+    """Test the LRU frame cache."""
+    snap = gsd.hoomd.Snapshot()
+    snap.particles.N = 100
+
+    with gsd.hoomd.open(name=tmp_path / "test_frame_cache.gsd",
+                        mode=open_mode.write) as hf:
+        for i in range(10):
+            snap.configuration.step = i
+            snap.particles.position = numpy.full((100, 3),
+                                                 i,
+                                                 dtype=numpy.float32)
+            hf.append(snap)
+
+    # disabled by default
+    with gsd.hoomd.open(name=tmp_path / "test_frame_cache.gsd",
+                        mode=open_mode.read) as hf:
+        assert hf[3] is not hf[3]
+        assert hf.cache_info == (0, 0, 0, 0)
+
+    # every frame holds the same arrays
+    with gsd.hoomd.open(name=tmp_path / "test_frame_cache.gsd",
+                        mode=open_mode.read,
+                        cache_size=2**30) as hf:
+        hf[3]
+        frame_nbytes = hf.cache_info.currsize // 2
+
+    with gsd.hoomd.open(name=tmp_path / "test_frame_cache.gsd",
+                        mode=open_mode.read,
+                        cache_size=frame_nbytes * 3 + frame_nbytes // 2) as hf:
+        s3 = hf[3]
+        assert s3.configuration.step == 3
+        assert not s3.particles.position.flags.writeable
+        # reading frame 3 first reads frame 0
+        assert hf.cache_info.hits == 0
+        assert hf.cache_info.misses == 2
+
+        assert hf[3] is s3
+        assert hf.cache_info.hits == 1
+
+        # frames 0 and 3 are cached, reading 4 and 5 evicts 0
+        hf[4]
+        hf[5]
+        assert hf.cache_info.currsize <= hf.cache_info.maxsize
+        assert hf[3] is s3
+        assert hf.cache_info.hits == 2
+        hits = hf.cache_info.hits
+        assert hf[0].configuration.step == 0
+        assert hf.cache_info.hits == hits
+        numpy.testing.assert_array_equal(hf[5].particles.position,
+                                         numpy.full((100, 3), 5))
+
+        hf.cache_clear()
+        assert hf.cache_info == (0, 0, hf.cache_info.maxsize, 0)
+        assert hf[3] is not s3
+
+    # frames larger than the cache are not cached
+    with gsd.hoomd.open(name=tmp_path / "test_frame_cache.gsd",
+                        mode=open_mode.read,
+                        cache_size=16) as hf:
+        assert hf[3] is not hf[3]
+        assert hf.cache_info.currsize == 0
+
+    with gsd.fl.open(name=tmp_path / "test_frame_cache.gsd",
+                     mode=open_mode.read) as f:
+        with pytest.raises(ValueError):
+            gsd.hoomd.HOOMDTrajectory(f, cache_size=-1)
+
+
+def test_fields(tmp_path, open_mode):
+    """Test reading a subset of the chunks in each frame."""
+    snap = gsd.hoomd.Snapshot()
+    snap.particles.N = 4
+    snap.particles.types = ['A', 'B']
+    snap.particles.typeid = [0, 1, 0, 1]
+    snap.bonds.N = 2
+    snap.bonds.group = [[0, 1], [2, 3]]
+    snap.state['hpmc/sphere/radius'] = [2.0]
+
+    with gsd.hoomd.open(name=tmp_path / "test_fields.gsd",
+                        mode=open_mode.write) as hf:
+        for i in range(3):
+            snap.configuration.step = i
+            snap.configuration.box = [i + 1, i + 1, i + 1, 0, 0, 0]
+            snap.particles.position = numpy.full((4, 3), i, numpy.float32)
+            snap.log['value'] = [i]
+            snap.log['other/value'] = [i * 2]
+            hf.append(snap)
+
+    with gsd.hoomd.open(name=tmp_path / "test_fields.gsd",
+                        mode=open_mode.read,
+                        fields=['particles/position', 'log/other']) as hf:
+        assert hf.fields == {'particles/position', 'log/other'}
+        for i in range(3):
+            s = hf[i]
+            assert s.configuration.step == i
+            assert s.configuration.box is None
+            assert s.configuration.dimensions is None
+            assert s.particles.N == 4
+            numpy.testing.assert_array_equal(s.particles.position,
+                                             numpy.full((4, 3), i))
+            assert s.particles.types is None
+            assert s.particles.typeid is None
+            assert s.bonds.N == 0
+            assert s.bonds.group is None
+            assert s.state == {}
+            assert list(s.log.keys()) == ['other/value']
+            assert s.log['other/value'][0] == i * 2
+
+    with gsd.hoomd.open(name=tmp_path / "test_fields.gsd",
+                        mode=open_mode.read,
+                        fields=['configuration', 'bonds/', 'state']) as hf:
+        s = hf[2]
+        numpy.testing.assert_array_equal(s.configuration.box,
+                                         [3, 3, 3, 0, 0, 0])
+        assert s.particles.N == 0
+        assert s.particles.position is None
+        assert s.bonds.N == 2
+        assert s.bonds.types == []
+        numpy.testing.assert_array_equal(s.bonds.group, [[0, 1], [2, 3]])
+        numpy.testing.assert_array_equal(s.state['hpmc/sphere/radius'], [2.0])
+        assert s.log == {}
+
+    with gsd.hoomd.open(name=tmp_path / "test_fields.gsd",
+                        mode=open_mode.read,
+                        fields=[]) as hf:
+        s = hf[1]
+        assert s.configuration.step == 1
+        assert s.particles.N == 0
+        assert s.log == {}
+
+    with gsd.fl.open(name=tmp_path / "test_fields.gsd",
+                     mode=open_mode.read) as f:
+        with pytest.raises(TypeError):
+            gsd.hoomd.HOOMDTrajectory(f, fields='particles/position')
+
+
+@pytest.mark.parametrize('workers', [1, 4])
+def test_read_frames(tmp_path, open_mode, workers):
+    """Test reading frames with a pool of threads."""
+    snap = gsd.hoomd.Snapshot()
+    snap.particles.N = 10
+    snap.particles.types = ['A']
+
+    with gsd.hoomd.open(name=tmp_path / "test_read_frames.gsd",
+                        mode=open_mode.write) as hf:
+        for i in range(20):
+            snap.configuration.step = i
+            snap.particles.position = numpy.full((10, 3), i, numpy.float32)
+            snap.log['value'] = [i]
+            hf.append(snap)
+
+    with gsd.hoomd.open(name=tmp_path / "test_read_frames.gsd",
+                        mode=open_mode.read) as hf:
+        indices = [5, 0, 19, -1, 7, 7, 12]
+        snaps = list(hf.read_frames(indices, workers=workers))
+        assert len(snaps) == len(indices)
+        for s, i in zip(snaps, indices):
+            i = i % 20
+            assert s.configuration.step == i
+            assert s.particles.types == ['A']
+            numpy.testing.assert_array_equal(s.particles.position,
+                                             numpy.full((10, 3), i))
+            assert s.log['value'][0] == i
+
+        steps = [
+            s.configuration.step
+            for s in hf.read_frames(slice(2, 18, 3), workers=workers)
+        ]
+        assert steps == list(range(2, 18, 3))
+
+        # stop before reading all frames
+        frames = hf.read_frames(range(20), workers=workers)
+        assert next(frames).configuration.step == 0
+        frames.close()
+
+        with pytest.raises(IndexError):
+            hf.read_frames([20])
+        with pytest.raises(ValueError):
+            hf.read_frames([0], workers=0)
+
+    # frames read by the threads use the frame cache
+    with gsd.hoomd.open(name=tmp_path / "test_read_frames.gsd",
+                        mode=open_mode.read,
+                        cache_size=2**30) as hf:
+        first = list(hf.read_frames(range(10), workers=workers))
+        assert hf.cache_info.misses == 10
+        hits = hf.cache_info.hits
+        second = list(hf.read_frames(range(10), workers=workers))
+        assert hf.cache_info.hits == hits + 10
+        assert hf.cache_info.misses == 10
+        for a, b in zip(first, second):
+            assert a is b
+        frame_nbytes = hf.cache_info.currsize // 10
+
+    # in the threads, a cached frame may be evicted by an earlier frame
+    # before it is yielded
+    with gsd.hoomd.open(name=tmp_path / "test_read_frames.gsd",
+                        mode='rb',
+                        cache_size=frame_nbytes + frame_nbytes // 2) as hf:
+        s5 = hf[5]
+        hits = hf.cache_info.hits
+        misses = hf.cache_info.misses
+        snaps = list(hf.read_frames([6, 5], workers=2))
+        assert [s.configuration.step for s in snaps] == [6, 5]
+        assert snaps[1] is s5
+        assert hf.cache_info.hits == hits + 1
+        assert hf.cache_info.misses == misses + 1
+        assert 5 not in hf._cache
+
+
 def test_truncate(tmp_path):
     """Test the truncate API."""
     with gsd.hoomd.open(name=tmp_path / "test_iteration.gsd", mode='wb') as hf:
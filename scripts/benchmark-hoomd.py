@@ -1,5 +1,7 @@
 """Benchmark GSD HOOMD file read/write."""
 
+import argparse
+import json
 import time
 import gsd.fl
 import gsd.pygsd
@@ -91,7 +93,14 @@ def compute_actual_size(N, nframes):
 # Run all benchmarks with the given options
 
 
-def run_benchmarks(N, size):
+def drop_caches(enable):
+    """Sync the file system and drop the page cache (requires sudo)."""
+    if enable:
+        call(['sudo', '/bin/sync'])
+        call(['sudo', '/sbin/sysctl', 'vm.drop_caches=3'], stdout=PIPE)
+
+
+def run_benchmarks(N, size, cold):
     """Run all the benchmarks."""
     bmark_read_size = 0.25 * 1024**3
 
@@ -107,6 +116,12 @@ def run_benchmarks(N, size):
         nframes_read = nframes
         bmark_read_size = actual_size
 
+    timings['N'] = N
+    timings['frames'] = nframes
+    timings['file_bytes'] = actual_size
+    timings['frames_read'] = nframes_read
+    timings['cache'] = 'cold' if cold else 'warm'
+
     # first, write the file and time how long it takes
     print("Writing file: ", file=sys.stderr, flush=True)
 
@@ -123,8 +138,7 @@ def run_benchmarks(N, size):
         write_file(hf, nframes, N, position, orientation)
 
     # ensure that all writes to disk are completed and drop file system cache
-    call(['sudo', '/bin/sync'])
-    call(['sudo', '/sbin/sysctl', 'vm.drop_caches=3'], stdout=PIPE)
+    drop_caches(cold)
 
     end = time.time()
 
@@ -150,8 +164,7 @@ def run_benchmarks(N, size):
         timings['seq_read'] = bmark_read_size / 1024**2 / (end - start)
 
         # drop the file system cache
-        call(['sudo', '/bin/sync'])
-        call(['sudo', '/sbin/sysctl', 'vm.drop_caches=3'], stdout=PIPE)
+        drop_caches(cold)
 
         # Read the file randomly and measure the time taken
         print("Random read file:", file=sys.stderr, flush=True)
@@ -166,44 +179,62 @@ def run_benchmarks(N, size):
     return timings
 
 
-def run_sweep(size, size_str):
-    """Run a single sweep of benchmarks."""
-    # if size < 10*1024**3:
-    if True:
-        result = run_benchmarks(32 * 32, size)
+def parse_size(value):
+    """Parse a file size such as 128MiB or 1GiB."""
+    units = {'KiB': 1024, 'MiB': 1024**2, 'GiB': 1024**3, 'TiB': 1024**4}
+    for unit, multiplier in units.items():
+        if value.endswith(unit):
+            return int(float(value[:-len(unit)]) * multiplier)
+    return int(value)
+
+
+def parse_list(value):
+    """Parse a comma separated list of particle counts such as 1e3,1e6."""
+    return [int(float(n)) for n in value.split(',')]
+
+
+parser = argparse.ArgumentParser(
+    description='Benchmark reading and writing HOOMD trajectories.')
+parser.add_argument('--N',
+                    type=parse_list,
+                    default=[32 * 32, 128 * 128, 1024 * 1024],
+                    help='comma separated particle counts')
+parser.add_argument('--size',
+                    type=lambda value: value.split(','),
+                    default=['128MiB', '1GiB'],
+                    help='comma separated file sizes')
+parser.add_argument('--drop-caches',
+                    action='store_true',
+                    help='drop the page cache before reads (requires sudo)')
+parser.add_argument('--json',
+                    metavar='FILE',
+                    help='write the results to FILE as JSON')
+args = parser.parse_args()
 
-        print("{0:<7} {1:<6} {2:<9.4g} {3:<12.4g} "
+print("""
+======= ========= ========= ============ =========== ============= ===========
+Size    N         Open (ms) Write (MB/s) Read (MB/s) Random (MB/s) Random (ms)
+======= ========= ========= ============ =========== ============= ===========""")
+
+results = []
+for size_str in args.size:
+    for N in args.N:
+        result = run_benchmarks(N, parse_size(size_str), args.drop_caches)
+        result['size'] = size_str
+        results.append(result)
+
+        print("{0:<7} {1:<9} {2:<9.4g} {3:<12.4g} "
               "{4:<11.4g} {5:<13.4g} {6:<11.3g}".format(
-                  size_str, "32^2", result['open_time'] * 1000, result['write'],
-                  result['seq_read'], result['random_read'],
-                  result['random_read_time']))
+                  size_str, N, result['open_time'] * 1000,
+                  result['write'], result['seq_read'],
+                  result['random_read'], result['random_read_time']))
         sys.stdout.flush()
 
-    result = run_benchmarks(128 * 128, size)
-
-    print("{0:<7} {1:<6} {2:<9.4g} {3:<12.4g} {4:<11.4g} {5:<13.4g} {6:<11.3g}"
-          .format(size_str, "128^2", result['open_time'] * 1000,
-                  result['write'], result['seq_read'], result['random_read'],
-                  result['random_read_time']))
-    sys.stdout.flush()
-
-    result = run_benchmarks(1024 * 1024, size)
-
-    print("{0:<7} {1:<6} {2:<9.4g} {3:<12.4g} {4:<11.4g} {5:<13.4g} {6:<11.3g}"
-          .format(size_str, "1024^2", result['open_time'] * 1000,
-                  result['write'], result['seq_read'], result['random_read'],
-                  result['random_read_time']))
-    sys.stdout.flush()
-
-
-print("""
-======= ====== ========= ============ =========== ============= ===========
-Size    N      Open (ms) Write (MB/s) Read (MB/s) Random (MB/s) Random (ms)
-======= ====== ========= ============ =========== ============= ===========""")
-
-run_sweep(128 * 1024**2, "128 MiB")
-run_sweep(1 * 1024**3, "1 GiB")
-# run_sweep(128*1024**3, "128 GiB");
-
-print("======= ====== ========= ============ "
+print("======= ========= ========= ============ "
       "=========== ============= ===========")
+
+if args.json is not None:
+    with open(args.json, 'w') as f:
+        json.dump({'gsd_version': gsd.__version__,
+                   'timestamp': int(time.time()),
+                   'results': results}, f, indent=2)
@@ -0,0 +1,114 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <mpi.h>
+
+#include "gsd_mpi.h"
+
+int main(int argc, char** argv) // NOLINT
+    {
+    MPI_Init(&argc, &argv);
+
+    int rank = 0;
+    int n_ranks = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &n_ranks);
+
+    const size_t n_particles = 1000000;
+    const size_t n_frames = 20;
+
+    // each rank holds the particles of its domain
+    std::vector<float> position(n_particles * 3, float(rank));
+    std::vector<uint32_t> tag(n_particles);
+    for (size_t i = 0; i < n_particles; i++)
+        {
+        tag[i] = uint32_t(rank * n_particles + i);
+        }
+
+    if (rank == 0)
+        {
+        std::cout << "Writing test.gsd with: " << n_ranks << " ranks, " << n_particles
+                  << " particles per rank, and " << n_frames << " frames" << std::endl;
+        }
+
+    gsd_mpi_handle handle;
+    gsd_mpi_create_and_open(&handle,
+                            MPI_COMM_WORLD,
+                            "test.gsd",
+                            "app",
+                            "schema",
+                            0,
+                            GSD_OPEN_APPEND,
+                            0);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    for (size_t frame = 0; frame < n_frames; frame++)
+        {
+        if (rank == 0)
+            {
+            uint64_t step = frame;
+            gsd_write_chunk(&handle.handle, "configuration/step", GSD_TYPE_UINT64, 1, 1, 0, &step);
+            }
+        gsd_mpi_write_chunk(&handle,
+                            "particles/position",
+                            GSD_TYPE_FLOAT,
+                            n_particles,
+                            3,
+                            position.data());
+        gsd_mpi_write_chunk(&handle,
+                            "particles/tag",
+                            GSD_TYPE_UINT32,
+                            n_particles,
+                            1,
+                            tag.data());
+        gsd_mpi_end_frame(&handle);
+        }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    gsd_mpi_close(&handle);
+
+    if (rank == 0)
+        {
+        std::chrono::duration<double> time_span
+            = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1);
+        double time_per_frame = time_span.count() / double(n_frames);
+        double bytes_per_frame = double(n_ranks) * double(n_particles) * 4 * sizeof(float);
+
+        const double ms = 1e-3;
+        const double MiB = 1024.0 * 1024.0;
+        std::cout << "Write time: " << time_per_frame / ms << " milliseconds/frame." << std::endl;
+        std::cout << "Bandwidth: " << bytes_per_frame / time_per_frame / MiB << " MiB/s."
+                  << std::endl;
+
+        gsd_handle read_handle;
+        gsd_open(&read_handle, "test.gsd", GSD_OPEN_READONLY);
+        std::cout << "Frames: " << gsd_get_nframes(&read_handle) << std::endl;
+
+        // the slices of the ranks follow each other in rank order
+        std::vector<uint32_t> all_tags(n_ranks * n_particles);
+        const gsd_index_entry* entry
+            = gsd_find_chunk(&read_handle, n_frames - 1, "particles/tag");
+        bool valid = entry != nullptr && entry->N == all_tags.size()
+                     && gsd_read_chunk(&read_handle, all_tags.data(), entry) == GSD_SUCCESS;
+        for (size_t i = 0; valid && i < all_tags.size(); i++)
+            {
+            valid = all_tags[i] == i;
+            }
+        gsd_close(&read_handle);
+
+        if (!valid)
+            {
+            std::cerr << "particles/tag in the last frame does not match the written tags"
+                      << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+
+    MPI_Finalize();
+    }
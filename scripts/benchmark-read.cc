@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <iostream>
+#include <numeric>
+#include <random>
 #include <sstream>
 #include <vector>
 
@@ -21,7 +24,11 @@ int main(int argc, char** argv) // NOLINT
         }
 
     gsd_handle handle;
-    gsd_open(&handle, "test.gsd", GSD_OPEN_READONLY);
+    if (gsd_open(&handle, "test.gsd", GSD_OPEN_READONLY) != GSD_SUCCESS)
+        {
+        std::cerr << "Unable to open test.gsd, write it with benchmark-write first." << std::endl;
+        return 1;
+        }
     size_t n_frames = gsd_get_nframes(&handle);
     size_t n_read = n_frames;
     if (n_read > max_frames)
@@ -57,5 +64,31 @@ int main(int argc, char** argv) // NOLINT
     const double us = 1e-6;
     std::cout << "Sequential read time: " << time_per_key / us << " microseconds/key." << std::endl;
 
+    // read frames in a random order
+    std::vector<size_t> frames(n_frames);
+    std::iota(frames.begin(), frames.end(), 0);
+    std::mt19937 rng(42);
+    std::shuffle(frames.begin(), frames.end(), rng);
+    frames.resize(n_read);
+
+    t1 = std::chrono::high_resolution_clock::now();
+
+    for (auto frame : frames)
+        {
+        for (auto const& name : names)
+            {
+            const gsd_index_entry* e;
+            e = gsd_find_chunk(&handle, frame, name.c_str());
+            gsd_read_chunk(&handle, &data[0], e);
+            }
+        }
+
+    t2 = std::chrono::high_resolution_clock::now();
+
+    time_span = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1);
+    time_per_key = time_span.count() / double(n_keys) / double(n_read);
+
+    std::cout << "Random read time: " << time_per_key / us << " microseconds/key." << std::endl;
+
     gsd_close(&handle);
     }
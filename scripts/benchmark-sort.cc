@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gsd.h"
+
+int main(int argc, char** argv) // NOLINT
+    {
+    const size_t n_keys = 65534;
+    const size_t n_frames = 100;
+
+    std::cout << "Writing test.gsd with: " << n_keys << " keys and " << n_frames
+              << " frames per key order" << std::endl;
+
+    gsd_handle handle;
+    gsd_create_and_open(&handle, "test.gsd", "app", "schema", 0, GSD_OPEN_APPEND, 0);
+
+    // name ids are assigned in the order names are first added
+    std::vector<uint32_t> ids(n_keys);
+    for (size_t i = 0; i < n_keys; i++)
+        {
+        std::ostringstream s;
+        s << "log/hpmc/integrate/Sphere/quantity/" << i;
+        gsd_get_name_id(&handle, s.str().c_str(), &ids[i], 1);
+        }
+
+    std::vector<uint32_t> reversed(ids.rbegin(), ids.rend());
+    std::vector<uint32_t> shuffled(ids);
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+    const std::vector<std::pair<std::string, const std::vector<uint32_t>*>> orders
+        = {{"sorted", &ids}, {"reversed", &reversed}, {"shuffled", &shuffled}};
+
+    double value = 0;
+    const double us = 1e-6;
+    for (auto const& order : orders)
+        {
+        std::chrono::duration<double> end_frame_time(0);
+        for (size_t frame = 0; frame < n_frames; frame++)
+            {
+            for (auto id : *order.second)
+                {
+                gsd_write_chunk_by_id(&handle, id, GSD_TYPE_DOUBLE, 1, 1, 0, &value);
+                }
+
+            auto t1 = std::chrono::high_resolution_clock::now();
+            gsd_end_frame(&handle);
+            auto t2 = std::chrono::high_resolution_clock::now();
+            end_frame_time += std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1);
+            }
+
+        double time_per_frame = end_frame_time.count() / double(n_frames);
+        std::cout << "End frame time (" << order.first << "): " << time_per_frame / us
+                  << " microseconds/frame." << std::endl;
+        }
+
+    gsd_close(&handle);
+    }
@@ -0,0 +1,621 @@
+// Copyright (c) 2016-2021 The Regents of the University of Michigan
+// This file is part of the General Simulation Data (GSD) project, released under the BSD 2-Clause
+// License.
+
+// Benchmark the GSD C API on HOOMD and log shaped files and write the results as JSON.
+//
+// Run with --help for the options. Cold cache timings drop the pages of the file from the page
+// cache with posix_fadvise() after syncing it, which needs no privileges but is only a hint to the
+// OS. The results record whether the hint was available.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#define fsync _commit
+#else // linux / mac
+#include <unistd.h>
+#endif
+
+#include "gsd.h"
+
+namespace
+    {
+/// Options selected on the command line
+struct Options
+    {
+    /// File to write and read
+    std::string file = "benchmark.gsd";
+
+    /// File to write the JSON results to (empty for stdout)
+    std::string output;
+
+    /// Number of particles in the HOOMD benchmarks
+    std::vector<uint64_t> N = {1000, 100000, 1000000};
+
+    /// Target size of the files written by the HOOMD benchmarks (in bytes)
+    uint64_t hoomd_size = 256 * 1024 * 1024;
+
+    /// Number of frames read by each read benchmark (at most)
+    uint64_t n_read = 100;
+
+    /// Number of keys in each frame of the log benchmark
+    uint64_t n_keys = 10000;
+
+    /// Number of frames in the log benchmark
+    uint64_t n_log_frames = 100;
+
+    /// Number of frames in each file of the open time benchmark
+    std::vector<uint64_t> open_frames = {100, 1000, 10000, 100000};
+
+    /// Benchmarks to run
+    bool run_hoomd = true;
+    bool run_log = true;
+    bool run_open = true;
+    };
+
+/// One benchmark result, an ordered list of JSON fields
+class Result
+    {
+    public:
+    explicit Result(const std::string& benchmark)
+        {
+        add("benchmark", benchmark);
+        }
+
+    void add(const std::string& key, const std::string& value)
+        {
+        set(key, quote(value));
+        }
+
+    void add(const std::string& key, const char* value)
+        {
+        add(key, std::string(value));
+        }
+
+    void add(const std::string& key, double value)
+        {
+        std::ostringstream s;
+        s << std::setprecision(9) << value;
+        set(key, s.str());
+        }
+
+    void add(const std::string& key, uint64_t value)
+        {
+        set(key, std::to_string(value));
+        }
+
+    void add(const std::string& key, bool value)
+        {
+        set(key, value ? "true" : "false");
+        }
+
+    std::string json() const
+        {
+        std::string out = "{";
+        for (size_t i = 0; i < m_fields.size(); i++)
+            {
+            if (i > 0)
+                {
+                out += ", ";
+                }
+            out += quote(m_fields[i].first) + ": " + m_fields[i].second;
+            }
+        return out + "}";
+        }
+
+    static std::string quote(const std::string& value)
+        {
+        std::string out = "\"";
+        for (char c : value)
+            {
+            if (c == '"' || c == '\\')
+                {
+                out += '\\';
+                }
+            out += c;
+            }
+        return out + "\"";
+        }
+
+    private:
+    /// Replace the value of an existing field or append a new field
+    void set(const std::string& key, const std::string& json_value)
+        {
+        for (auto& field : m_fields)
+            {
+            if (field.first == key)
+                {
+                field.second = json_value;
+                return;
+                }
+            }
+        m_fields.emplace_back(key, json_value);
+        }
+
+    std::vector<std::pair<std::string, std::string>> m_fields;
+    };
+
+/// Chunk written in each frame of a benchmark file
+struct ChunkSpec
+    {
+    std::string name;
+    gsd_type type;
+    uint64_t N;
+    uint32_t M;
+    };
+
+/// Seconds elapsed since the given time point
+double seconds_since(std::chrono::steady_clock::time_point start)
+    {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+/// Abort the benchmark when a GSD call fails
+void check(int retval, const char* what)
+    {
+    if (retval != GSD_SUCCESS)
+        {
+        std::cerr << "error: " << what << " returned " << retval << std::endl;
+        std::exit(1);
+        }
+    }
+
+/// Sync the file and drop its pages from the page cache
+/** @returns true when the OS supports dropping the cached pages of one file. */
+bool drop_cache(const std::string& fname)
+    {
+#if defined(_WIN32) || !defined(POSIX_FADV_DONTNEED)
+    (void)fname;
+    return false;
+#else
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd == -1)
+        {
+        return false;
+        }
+    fsync(fd);
+    bool dropped = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return dropped;
+#endif
+    }
+
+/// Size of the file in bytes
+uint64_t file_size(const std::string& fname)
+    {
+    std::ifstream f(fname, std::ios::binary | std::ios::ate);
+    return static_cast<uint64_t>(f.tellg());
+    }
+
+/// Number of bytes of data in one frame
+uint64_t frame_bytes(const std::vector<ChunkSpec>& chunks)
+    {
+    uint64_t bytes = 0;
+    for (auto const& chunk : chunks)
+        {
+        bytes += chunk.N * chunk.M * gsd_sizeof_type(chunk.type);
+        }
+    return bytes;
+    }
+
+/// Write a file with the given chunks in every frame
+/** Chunks are written through a mapped write region of *write_map_size* bytes when it is non-zero.
+    @returns the time in seconds to write the frames, close, and sync the file. */
+double write_file(const std::string& fname,
+                  const std::vector<ChunkSpec>& chunks,
+                  uint64_t n_frames,
+                  std::vector<std::vector<char>>& buffers,
+                  size_t write_map_size = 0)
+    {
+    gsd_handle handle;
+    auto start = std::chrono::steady_clock::now();
+    check(gsd_create_and_open(&handle, fname.c_str(), "benchmark", "hoomd", 0, GSD_OPEN_APPEND, 0),
+          "gsd_create_and_open");
+    check(gsd_set_write_map_size(&handle, write_map_size), "gsd_set_write_map_size");
+    for (uint64_t frame = 0; frame < n_frames; frame++)
+        {
+        for (size_t i = 0; i < chunks.size(); i++)
+            {
+            // change the data in each frame
+            buffers[i][0] = static_cast<char>(frame);
+            check(gsd_write_chunk(&handle,
+                                  chunks[i].name.c_str(),
+                                  chunks[i].type,
+                                  chunks[i].N,
+                                  chunks[i].M,
+                                  0,
+                                  buffers[i].data()),
+                  "gsd_write_chunk");
+            }
+        check(gsd_end_frame(&handle), "gsd_end_frame");
+        }
+    check(gsd_close(&handle), "gsd_close");
+
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd != -1)
+        {
+        fsync(fd);
+        close(fd);
+        }
+    return seconds_since(start);
+    }
+
+/// Read the given chunks from the given frames
+/** @returns the time in seconds to find and read all chunks. */
+double read_frames(gsd_handle& handle,
+                   const std::vector<ChunkSpec>& chunks,
+                   const std::vector<uint64_t>& frames,
+                   std::vector<std::vector<char>>& buffers)
+    {
+    auto start = std::chrono::steady_clock::now();
+    for (auto frame : frames)
+        {
+        for (size_t i = 0; i < chunks.size(); i++)
+            {
+            const gsd_index_entry* entry = gsd_find_chunk(&handle, frame, chunks[i].name.c_str());
+            if (entry == nullptr)
+                {
+                std::cerr << "error: chunk " << chunks[i].name << " not found" << std::endl;
+                std::exit(1);
+                }
+            check(gsd_read_chunk(&handle, buffers[i].data(), entry), "gsd_read_chunk");
+            }
+        }
+    return seconds_since(start);
+    }
+
+/// Frames read by the sequential and random access benchmarks
+std::vector<uint64_t>
+select_frames(uint64_t n_frames, uint64_t n_read, bool random, std::mt19937_64& rng)
+    {
+    std::vector<uint64_t> frames(n_frames);
+    std::iota(frames.begin(), frames.end(), 0);
+    if (random)
+        {
+        std::shuffle(frames.begin(), frames.end(), rng);
+        }
+    frames.resize(std::min(n_frames, n_read));
+    return frames;
+    }
+
+/// Time reads of a written file with each access pattern, cold and then warm
+void benchmark_reads(const std::string& name,
+                     const Options& options,
+                     const std::vector<ChunkSpec>& chunks,
+                     uint64_t n_frames,
+                     std::vector<std::vector<char>>& buffers,
+                     const Result& base,
+                     std::vector<Result>& results)
+    {
+    std::mt19937_64 rng(42);
+    for (bool random : {false, true})
+        {
+        std::vector<uint64_t> frames = select_frames(n_frames, options.n_read, random, rng);
+        bool cold = drop_cache(options.file);
+
+        for (const char* cache : {"cold", "warm"})
+            {
+            gsd_handle handle;
+            auto start = std::chrono::steady_clock::now();
+            check(gsd_open(&handle, options.file.c_str(), GSD_OPEN_READONLY), "gsd_open");
+            double open_seconds = seconds_since(start);
+            double seconds = read_frames(handle, chunks, frames, buffers);
+            check(gsd_close(&handle), "gsd_close");
+
+            Result result = base;
+            result.add("benchmark", name);
+            result.add("access", random ? "random" : "sequential");
+            result.add("cache", cache);
+            result.add("cache_dropped", std::strcmp(cache, "cold") == 0 && cold);
+            result.add("frames_read", static_cast<uint64_t>(frames.size()));
+            result.add("open_seconds", open_seconds);
+            result.add("seconds", seconds);
+            result.add("MiB_per_second",
+                       double(frames.size() * frame_bytes(chunks)) / (1024.0 * 1024.0) / seconds);
+            result.add("ms_per_frame", seconds / double(frames.size()) * 1e3);
+            result.add("us_per_chunk", seconds / double(frames.size() * chunks.size()) * 1e6);
+            results.push_back(result);
+            }
+        }
+    }
+
+/// Allocate and fill a buffer for each chunk
+std::vector<std::vector<char>> make_buffers(const std::vector<ChunkSpec>& chunks)
+    {
+    std::mt19937_64 rng(7);
+    std::vector<std::vector<char>> buffers;
+    for (auto const& chunk : chunks)
+        {
+        buffers.emplace_back(chunk.N * chunk.M * gsd_sizeof_type(chunk.type));
+        for (auto& c : buffers.back())
+            {
+            c = static_cast<char>(rng());
+            }
+        }
+    return buffers;
+    }
+
+/// Benchmark files with the per-particle chunks of HOOMD trajectories
+void benchmark_hoomd(const Options& options, std::vector<Result>& results)
+    {
+    for (auto N : options.N)
+        {
+        std::vector<ChunkSpec> chunks = {{"configuration/step", GSD_TYPE_UINT64, 1, 1},
+                                         {"particles/N", GSD_TYPE_UINT32, 1, 1},
+                                         {"particles/position", GSD_TYPE_FLOAT, N, 3},
+                                         {"particles/orientation", GSD_TYPE_FLOAT, N, 4},
+                                         {"particles/typeid", GSD_TYPE_UINT32, N, 1}};
+        std::vector<std::vector<char>> buffers = make_buffers(chunks);
+        uint64_t bytes = frame_bytes(chunks);
+        uint64_t n_frames = std::max<uint64_t>(2, options.hoomd_size / bytes);
+
+        std::cerr << "hoomd: N=" << N << ", " << n_frames << " frames" << std::endl;
+        double seconds = write_file(options.file, chunks, n_frames, buffers);
+
+        Result base("hoomd_write");
+        base.add("N", N);
+        base.add("frames", n_frames);
+        base.add("file_bytes", file_size(options.file));
+
+        Result result = base;
+        result.add("seconds", seconds);
+        result.add("MiB_per_second", double(n_frames * bytes) / (1024.0 * 1024.0) / seconds);
+        result.add("ms_per_frame", seconds / double(n_frames) * 1e3);
+        results.push_back(result);
+
+        benchmark_reads("hoomd_read", options, chunks, n_frames, buffers, base, results);
+        }
+    }
+
+/// Benchmark files with many small logged quantities in each frame
+void benchmark_log(const Options& options, std::vector<Result>& results)
+    {
+    std::vector<ChunkSpec> chunks;
+    for (uint64_t i = 0; i < options.n_keys; i++)
+        {
+        chunks.push_back({"log/hpmc/integrate/Sphere/quantity/" + std::to_string(i),
+                          GSD_TYPE_DOUBLE,
+                          1,
+                          1});
+        }
+    std::vector<std::vector<char>> buffers = make_buffers(chunks);
+
+    std::cerr << "log: " << options.n_keys << " keys, " << options.n_log_frames << " frames"
+              << std::endl;
+    double seconds = write_file(options.file, chunks, options.n_log_frames, buffers);
+
+    Result base("log_write");
+    base.add("keys", options.n_keys);
+    base.add("frames", options.n_log_frames);
+    base.add("file_bytes", file_size(options.file));
+
+    Result result = base;
+    result.add("seconds", seconds);
+    result.add("us_per_chunk", seconds / double(options.n_log_frames * options.n_keys) * 1e6);
+    results.push_back(result);
+
+    benchmark_reads("log_read", options, chunks, options.n_log_frames, buffers, base, results);
+
+    // write the same frames through a mapped write region
+    seconds = write_file(options.file, chunks, options.n_log_frames, buffers, 64 * 1024 * 1024);
+    Result mapped("log_write_mapped");
+    mapped.add("keys", options.n_keys);
+    mapped.add("frames", options.n_log_frames);
+    mapped.add("file_bytes", file_size(options.file));
+    mapped.add("seconds", seconds);
+    mapped.add("us_per_chunk", seconds / double(options.n_log_frames * options.n_keys) * 1e6);
+    results.push_back(mapped);
+    }
+
+/// Benchmark the time to open files with a growing number of frames
+void benchmark_open(const Options& options, std::vector<Result>& results)
+    {
+    std::vector<ChunkSpec> chunks = {{"configuration/step", GSD_TYPE_UINT64, 1, 1},
+                                     {"log/potential_energy", GSD_TYPE_DOUBLE, 1, 1},
+                                     {"log/pressure", GSD_TYPE_DOUBLE, 1, 1},
+                                     {"log/temperature", GSD_TYPE_DOUBLE, 1, 1},
+                                     {"particles/position", GSD_TYPE_FLOAT, 16, 3}};
+    std::vector<std::vector<char>> buffers = make_buffers(chunks);
+
+    for (auto n_frames : options.open_frames)
+        {
+        std::cerr << "open: " << n_frames << " frames" << std::endl;
+        write_file(options.file, chunks, n_frames, buffers);
+        bool cold = drop_cache(options.file);
+
+        for (const char* cache : {"cold", "warm"})
+            {
+            gsd_handle handle;
+            auto start = std::chrono::steady_clock::now();
+            check(gsd_open(&handle, options.file.c_str(), GSD_OPEN_READONLY), "gsd_open");
+            double open_seconds = seconds_since(start);
+
+            // the first lookup in the last frame
+            start = std::chrono::steady_clock::now();
+            const gsd_index_entry* entry
+                = gsd_find_chunk(&handle, n_frames - 1, "particles/position");
+            double find_seconds = seconds_since(start);
+            if (entry == nullptr)
+                {
+                std::cerr << "error: chunk not found" << std::endl;
+                std::exit(1);
+                }
+            uint64_t n_entries = handle.file_index.size;
+            check(gsd_close(&handle), "gsd_close");
+
+            Result result("open");
+            result.add("frames", n_frames);
+            result.add("index_entries", n_entries);
+            result.add("file_bytes", file_size(options.file));
+            result.add("cache", cache);
+            result.add("cache_dropped", std::strcmp(cache, "cold") == 0 && cold);
+            result.add("open_seconds", open_seconds);
+            result.add("find_seconds", find_seconds);
+            results.push_back(result);
+            }
+        }
+    }
+
+/// Version of the GSD file format written by this build of the library
+std::string file_version(const std::string& fname)
+    {
+    gsd_handle handle;
+    if (gsd_open(&handle, fname.c_str(), GSD_OPEN_READONLY) != GSD_SUCCESS)
+        {
+        return "unknown";
+        }
+    uint32_t version = handle.header.gsd_version;
+    gsd_close(&handle);
+    return std::to_string(version >> 16) + "." + std::to_string(version & 0xffff);
+    }
+
+/// Parse a comma separated list of numbers
+std::vector<uint64_t> parse_list(const std::string& value)
+    {
+    std::vector<uint64_t> out;
+    std::istringstream s(value);
+    std::string item;
+    while (std::getline(s, item, ','))
+        {
+        // accept 1e6 style values
+        out.push_back(static_cast<uint64_t>(std::stod(item)));
+        }
+    return out;
+    }
+
+void usage()
+    {
+    std::cerr << "usage: benchmark-suite [options]\n"
+                 "  --file PATH         file to benchmark (default benchmark.gsd)\n"
+                 "  --output PATH       write the JSON results to PATH (default stdout)\n"
+                 "  --benchmarks LIST   any of hoomd,log,open (default all)\n"
+                 "  --N LIST            particle counts (default 1e3,1e5,1e6)\n"
+                 "  --hoomd-size MIB    size of the HOOMD files (default 256)\n"
+                 "  --frames-read N     frames read in each read benchmark (default 100)\n"
+                 "  --keys N            keys per frame in the log benchmark (default 10000)\n"
+                 "  --log-frames N      frames in the log benchmark (default 100)\n"
+                 "  --open-frames LIST  frames in the open benchmark (default 1e2,1e3,1e4,1e5)\n";
+    }
+
+Options parse_options(int argc, char** argv)
+    {
+    Options options;
+    for (int i = 1; i < argc; i++)
+        {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+            {
+            usage();
+            std::exit(0);
+            }
+        if (i + 1 >= argc)
+            {
+            usage();
+            std::exit(1);
+            }
+
+        std::string value = argv[++i];
+        if (arg == "--file")
+            {
+            options.file = value;
+            }
+        else if (arg == "--output")
+            {
+            options.output = value;
+            }
+        else if (arg == "--benchmarks")
+            {
+            options.run_hoomd = value.find("hoomd") != std::string::npos;
+            options.run_log = value.find("log") != std::string::npos;
+            options.run_open = value.find("open") != std::string::npos;
+            }
+        else if (arg == "--N")
+            {
+            options.N = parse_list(value);
+            }
+        else if (arg == "--hoomd-size")
+            {
+            options.hoomd_size = static_cast<uint64_t>(std::stod(value) * 1024 * 1024);
+            }
+        else if (arg == "--frames-read")
+            {
+            options.n_read = std::stoull(value);
+            }
+        else if (arg == "--keys")
+            {
+            options.n_keys = std::stoull(value);
+            }
+        else if (arg == "--log-frames")
+            {
+            options.n_log_frames = std::stoull(value);
+            }
+        else if (arg == "--open-frames")
+            {
+            options.open_frames = parse_list(value);
+            }
+        else
+            {
+            usage();
+            std::exit(1);
+            }
+        }
+    return options;
+    }
+    } // namespace
+
+int main(int argc, char** argv) // NOLINT
+    {
+    Options options = parse_options(argc, argv);
+
+    std::vector<Result> results;
+    if (options.run_hoomd)
+        {
+        benchmark_hoomd(options, results);
+        }
+    if (options.run_log)
+        {
+        benchmark_log(options, results);
+        }
+    if (options.run_open)
+        {
+        benchmark_open(options, results);
+        }
+    std::string version = file_version(options.file);
+    std::remove(options.file.c_str());
+
+    std::ofstream output_file;
+    if (!options.output.empty())
+        {
+        output_file.open(options.output);
+        }
+    std::ostream& out = options.output.empty() ? std::cout : output_file;
+
+    out << "{\n";
+    out << "  \"gsd_file_version\": " << Result::quote(version) << ",\n";
+    out << "  \"timestamp\": " << static_cast<uint64_t>(std::time(nullptr)) << ",\n";
+    out << "  \"file\": " << Result::quote(options.file) << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+        {
+        out << "    " << results[i].json() << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+    out << "  ]\n";
+    out << "}\n";
+    }